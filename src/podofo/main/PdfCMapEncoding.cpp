@@ -7,7 +7,12 @@
 #include <podofo/private/PdfDeclarationsPrivate.h>
 #include "PdfCMapEncoding.h"
 
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 #include <utf8cpp/utf8.h>
+#include <podofo/private/OpenSSLInternal.h>
 
 #include "PdfDictionary.h"
 #include "PdfObjectStream.h"
@@ -25,6 +30,52 @@ struct CodeLimits
     unsigned char MaxCodeSize = 0;
 };
 
+namespace
+{
+    /** A parsed CMap, immutable after creation
+     */
+    struct ParsedCMap
+    {
+        shared_ptr<PdfCharCodeMap> Map;         // nullptr if the CMap is an identity
+        PdfEncodingLimits Limits;
+        size_t Size = 0;                        // Approximate memory size in bytes
+    };
+
+    /** A process wide bounded cache of parsed CMaps, keyed by the hash
+     * of their content. The least recently used CMaps are evicted first
+     */
+    class CMapCache final
+    {
+    public:
+        CMapCache();
+
+    public:
+        shared_ptr<const ParsedCMap> Find(const string& hash);
+        void Insert(const string& hash, const shared_ptr<const ParsedCMap>& cmap);
+        void SetMaxSize(size_t maxSize);
+        void Clear();
+        bool IsEnabled() const { return m_maxSize.load(memory_order_relaxed) != 0; }
+
+    private:
+        void remove(const string& hash);
+        void trim(size_t maxSize);
+
+    private:
+        struct CachedCMap
+        {
+            shared_ptr<const ParsedCMap> CMap;
+            list<string>::iterator Position;
+        };
+
+    private:
+        atomic<size_t> m_maxSize;
+        size_t m_size;
+        unordered_map<string, CachedCMap> m_cmaps;
+        list<string> m_usage;   // Most recently used first
+        mutex m_mutex;
+    };
+}
+
 static void readNextVariantSequence(PdfPostScriptTokenizer& tokenizer, InputStreamDevice& device,
     PdfVariant& variant, const string_view& endSequenceKeyword, bool& endOfSequence);
 static uint32_t getCodeFromVariant(const PdfVariant& var, CodeLimits& limits);
@@ -36,7 +87,10 @@ static void handleRangeMapping(PdfCharCodeMap& map,
     unsigned char codeSize, unsigned rangeSize);
 static vector<char32_t> handleUtf8String(const string& str);
 static void pushMapping(PdfCharCodeMap& map, const PdfCharCode& codeUnit, const std::vector<char32_t>& codePoints);
-static PdfCharCodeMap parseCMapObject(const PdfObjectStream& stream, CodeLimits& limits);
+static shared_ptr<const ParsedCMap> parseCMap(const bufferview& buffer);
+static PdfCharCodeMap parseCMapObject(const bufferview& buffer, CodeLimits& limits);
+
+static CMapCache s_cache;
 
 PdfCMapEncoding::PdfCMapEncoding(PdfCharCodeMap&& map)
     : PdfCMapEncoding(std::move(map), map.GetLimits()) { }
@@ -44,10 +98,63 @@ PdfCMapEncoding::PdfCMapEncoding(PdfCharCodeMap&& map)
 PdfCMapEncoding::PdfCMapEncoding(PdfCharCodeMap&& map, const PdfEncodingLimits& limits)
     : PdfEncodingMapBase(std::move(map), PdfEncodingMapType::CMap), m_Limits(limits) { }
 
+PdfCMapEncoding::PdfCMapEncoding(const shared_ptr<PdfCharCodeMap>& map, const PdfEncodingLimits& limits)
+    : PdfEncodingMapBase(map, PdfEncodingMapType::CMap), m_Limits(limits) { }
+
 unique_ptr<PdfEncodingMap> PdfCMapEncoding::CreateFromObject(const PdfObject& cmapObj)
+{
+    charbuff streamBuffer;
+    cmapObj.MustGetStream().CopyTo(streamBuffer);
+
+    shared_ptr<const ParsedCMap> cmap;
+    string hash;
+    if (s_cache.IsEnabled())
+    {
+        hash = ssl::ComputeHash(streamBuffer, PdfHashingAlgorithm::SHA256);
+        cmap = s_cache.Find(hash);
+    }
+
+    if (cmap == nullptr)
+    {
+        cmap = parseCMap(streamBuffer);
+        if (s_cache.IsEnabled())
+            s_cache.Insert(hash, cmap);
+    }
+
+    if (cmap->Map == nullptr)
+    {
+        return unique_ptr<PdfIdentityEncoding>(new PdfIdentityEncoding(
+            PdfEncodingMapType::CMap, cmap->Limits, PdfIdentityOrientation::Unkwnown));
+    }
+
+    return unique_ptr<PdfCMapEncoding>(new PdfCMapEncoding(cmap->Map, cmap->Limits));
+}
+
+void PdfCMapEncoding::setCacheSize(size_t maxSize)
+{
+    s_cache.SetMaxSize(maxSize);
+}
+
+void PdfCMapEncoding::clearCache()
+{
+    s_cache.Clear();
+}
+
+const PdfEncodingLimits& PdfCMapEncoding::GetLimits() const
+{
+    return m_Limits;
+}
+
+bool PdfCMapEncoding::HasLigaturesSupport() const
+{
+    // CMap encodings may have ligatures
+    return true;
+}
+
+shared_ptr<const ParsedCMap> parseCMap(const bufferview& buffer)
 {
     CodeLimits codeLimits;
-    auto map = parseCMapObject(cmapObj.MustGetStream(), codeLimits);
+    auto map = parseCMapObject(buffer, codeLimits);
     auto mapLimits = map.GetLimits();
     // NOTE: In some cases the encoding is degenerate and has no code
     // entries at all, but the CMap may still encode the code size
@@ -57,6 +164,9 @@ unique_ptr<PdfEncodingMap> PdfCMapEncoding::CreateFromObject(const PdfObject& cm
     if (codeLimits.MaxCodeSize > mapLimits.MaxCodeSize)
         mapLimits.MaxCodeSize = codeLimits.MaxCodeSize;
 
+    auto ret = std::make_shared<ParsedCMap>();
+    ret->Limits = mapLimits;
+    ret->Size = sizeof(ParsedCMap);
     if (map.GetSize() != 0
         && mapLimits.MinCodeSize == mapLimits.MaxCodeSize)
     {
@@ -81,33 +191,22 @@ unique_ptr<PdfEncodingMap> PdfCMapEncoding::CreateFromObject(const PdfObject& cm
         } while (it != end);
 
         if (identity)
-        {
-            return unique_ptr<PdfIdentityEncoding>(new PdfIdentityEncoding(
-                PdfEncodingMapType::CMap, mapLimits, PdfIdentityOrientation::Unkwnown));
-        }
+            return ret;
     }
 
-    return unique_ptr<PdfCMapEncoding>(new PdfCMapEncoding(std::move(map), mapLimits));
-}
+    // Estimate the size of the map nodes and of the lookup structures
+    for (auto& pair : map)
+        ret->Size += sizeof(pair) + 4 * sizeof(void*) + pair.second.size() * sizeof(codepoint) * 2;
+    ret->Size += map.GetLookupTablesSize();
 
-const PdfEncodingLimits& PdfCMapEncoding::GetLimits() const
-{
-    return m_Limits;
-}
-
-bool PdfCMapEncoding::HasLigaturesSupport() const
-{
-    // CMap encodings may have ligatures
-    return true;
+    ret->Map = std::make_shared<PdfCharCodeMap>(std::move(map));
+    return ret;
 }
 
-PdfCharCodeMap parseCMapObject(const PdfObjectStream& stream, CodeLimits& limits)
+PdfCharCodeMap parseCMapObject(const bufferview& buffer, CodeLimits& limits)
 {
     PdfCharCodeMap ret;
-    charbuff streamBuffer;
-    stream.CopyTo(streamBuffer);
-
-    SpanStreamDevice device(streamBuffer);
+    SpanStreamDevice device(buffer);
     // NOTE: Found a CMap like this
     // /CIDSystemInfo
     // <<
@@ -452,3 +551,72 @@ void readNextVariantSequence(PdfPostScriptTokenizer& tokenizer, InputStreamDevic
         }
     }
 }
+
+CMapCache::CMapCache() :
+    m_maxSize(0),
+    m_size(0)
+{
+}
+
+shared_ptr<const ParsedCMap> CMapCache::Find(const string& hash)
+{
+    unique_lock<mutex> lock(m_mutex);
+    auto found = m_cmaps.find(hash);
+    if (found == m_cmaps.end())
+        return nullptr;
+
+    // Mark the CMap as the most recently used
+    m_usage.splice(m_usage.begin(), m_usage, found->second.Position);
+    return found->second.CMap;
+}
+
+void CMapCache::Insert(const string& hash, const shared_ptr<const ParsedCMap>& cmap)
+{
+    unique_lock<mutex> lock(m_mutex);
+    size_t maxSize = m_maxSize.load(memory_order_relaxed);
+    if (cmap->Size > maxSize)
+        return;
+
+    // Another thread may have cached the same CMap meanwhile
+    remove(hash);
+    trim(maxSize - cmap->Size);
+    m_usage.push_front(hash);
+    m_cmaps[hash] = { cmap, m_usage.begin() };
+    m_size += cmap->Size;
+}
+
+void CMapCache::SetMaxSize(size_t maxSize)
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_maxSize.store(maxSize, memory_order_relaxed);
+    trim(maxSize);
+}
+
+void CMapCache::Clear()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_cmaps.clear();
+    m_usage.clear();
+    m_size = 0;
+}
+
+void CMapCache::remove(const string& hash)
+{
+    auto found = m_cmaps.find(hash);
+    if (found == m_cmaps.end())
+        return;
+
+    m_size -= found->second.CMap->Size;
+    m_usage.erase(found->second.Position);
+    m_cmaps.erase(found);
+}
+
+// Evict the least recently used CMaps until the size fits
+void CMapCache::trim(size_t maxSize)
+{
+    while (m_size > maxSize)
+    {
+        string leastUsed = m_usage.back();
+        remove(leastUsed);
+    }
+}
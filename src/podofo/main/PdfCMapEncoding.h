@@ -17,6 +17,8 @@ namespace PoDoFo
     class PODOFO_API PdfCMapEncoding final : public PdfEncodingMapBase
     {
         friend class PdfEncodingMap;
+        friend class PdfCommon;
+        friend class PdfEncodingMapFactory;
 
     public:
         /** Construct a PdfCMapEncoding from a map
@@ -25,11 +27,18 @@ namespace PoDoFo
 
     public:
         /** Construct an encoding map from an object
+         * \remarks The parsed CMap may come from the process wide
+         * cache of CMaps, if enabled
+         * \see PdfCommon::SetCMapCacheSize()
          */
         static std::unique_ptr<PdfEncodingMap> CreateFromObject(const PdfObject& cmapObj);
 
     private:
         PdfCMapEncoding(PdfCharCodeMap&& map, const PdfEncodingLimits& limits);
+        PdfCMapEncoding(const std::shared_ptr<PdfCharCodeMap>& map, const PdfEncodingLimits& limits);
+
+        static void setCacheSize(size_t maxSize);
+        static void clearCache();
 
     public:
         bool HasLigaturesSupport() const override;
@@ -8,13 +8,34 @@
 #include "PdfCharCodeMap.h"
 #include <random>
 #include <algorithm>
+#include <mutex>
 #include <utf8cpp/utf8.h>
 
 using namespace std;
 using namespace PoDoFo;
 
+// Markers in the code unit table
+constexpr codepoint NoCodePoint = numeric_limits<codepoint>::max();
+constexpr codepoint MultiCodePoint = NoCodePoint - 1;     // Look in the map, the code unit maps to a ligature
+
+constexpr unsigned NoBlock = numeric_limits<unsigned>::max();
+constexpr unsigned CodePointBlockSize = 256;
+
+// The direct indexed tables are used if they are at most this
+// many times larger than the count of the mappings, or if they
+// are small anyway
+constexpr unsigned MaxTableSparsity = 4;
+constexpr unsigned MinCodeUnitTableSize = 256;
+constexpr unsigned MinCodePointTableSize = 4096;
+
+// Enough to cover all the unicode planes
+constexpr unsigned MaxCodePointBlockCount = 0x1100;
+
+// Guards the lazy revision of maps shared between threads
+static mutex s_reviseMutex;
+
 PdfCharCodeMap::PdfCharCodeMap()
-    : m_MapDirty(false), m_codePointMapHead(nullptr), m_depth(0) { }
+    : m_MapDirty(false), m_codePointMapHead(nullptr), m_depth(0), m_firstCodePointBlock(0) { }
 
 PdfCharCodeMap::PdfCharCodeMap(PdfCharCodeMap&& map) noexcept
 {
@@ -37,6 +58,14 @@ unsigned PdfCharCodeMap::GetSize() const
     return (unsigned)m_CodeUnitMap.size();
 }
 
+size_t PdfCharCodeMap::GetLookupTablesSize() const
+{
+    const_cast<PdfCharCodeMap&>(*this).reviseMaps();
+    return m_codeUnitTable.size() * sizeof(codepoint)
+        + m_codePointBlocks.size() * sizeof(unsigned)
+        + m_codePointTable.size() * sizeof(PdfCharCode);
+}
+
 const PdfEncodingLimits& PdfCharCodeMap::GetLimits() const
 {
     return m_Limits;
@@ -46,9 +75,13 @@ void PdfCharCodeMap::move(PdfCharCodeMap& map) noexcept
 {
     m_CodeUnitMap = std::move(map.m_CodeUnitMap);
     utls::move(map.m_Limits, m_Limits);
-    utls::move(map.m_MapDirty, m_MapDirty);
+    m_MapDirty.store(map.m_MapDirty.exchange(false));
     utls::move(map.m_codePointMapHead, m_codePointMapHead);
     utls::move(map.m_depth, m_depth);
+    m_codeUnitTable = std::move(map.m_codeUnitTable);
+    m_codePointBlocks = std::move(map.m_codePointBlocks);
+    utls::move(map.m_firstCodePointBlock, m_firstCodePointBlock);
+    m_codePointTable = std::move(map.m_codePointTable);
 }
 
 void PdfCharCodeMap::PushMapping(const PdfCharCode& codeUnit, const codepointview& codePoints)
@@ -68,26 +101,72 @@ void PdfCharCodeMap::PushMapping(const PdfCharCode& codeUnit, codepoint codePoin
 
 bool PdfCharCodeMap::TryGetCodePoints(const PdfCharCode& codeUnit, vector<codepoint>& codePoints) const
 {
-    auto found = m_CodeUnitMap.find(codeUnit);
-    if (found == m_CodeUnitMap.end())
+    const_cast<PdfCharCodeMap&>(*this).reviseMaps();
+    if (m_codeUnitTable.size() != 0)
     {
-        codePoints.clear();
-        return false;
+        // NOTE: Like in the map, the code space size is not considered
+        if (codeUnit.Code < m_Limits.FirstChar.Code || codeUnit.Code > m_Limits.LastChar.Code)
+            goto NotFound;
+
+        codepoint codePoint = m_codeUnitTable[codeUnit.Code - m_Limits.FirstChar.Code];
+        if (codePoint == NoCodePoint)
+            goto NotFound;
+
+        if (codePoint != MultiCodePoint)
+        {
+            codePoints.clear();
+            codePoints.push_back(codePoint);
+            return true;
+        }
     }
 
-    codePoints = found->second;
-    return true;
+    {
+        auto found = m_CodeUnitMap.find(codeUnit);
+        if (found == m_CodeUnitMap.end())
+            goto NotFound;
+
+        codePoints = found->second;
+        return true;
+    }
+
+NotFound:
+    codePoints.clear();
+    return false;
 }
 
 bool PdfCharCodeMap::TryGetNextCharCode(string_view::iterator& it, const string_view::iterator& end, PdfCharCode& code) const
 {
-    const_cast<PdfCharCodeMap&>(*this).reviseCPMap();
-    return tryFindNextCharacterId(m_codePointMapHead, it, end, code);
+    const_cast<PdfCharCodeMap&>(*this).reviseMaps();
+    if (m_codePointBlocks.size() == 0)
+        return tryFindNextCharacterId(m_codePointMapHead, it, end, code);
+
+    PODOFO_INVARIANT(it != end);
+    codepoint codePoint = (codepoint)utf8::next(it, end);
+    if (m_codePointMapHead != nullptr && it != end)
+    {
+        // The BST has only ligatures: try to find them first, saving
+        // a temporary iterator in case the search in unsuccessful
+        auto node = findNode(m_codePointMapHead, codePoint);
+        if (node != nullptr)
+        {
+            auto curr = it;
+            if (tryFindNextCharacterId(node->Ligatures, curr, end, code))
+            {
+                it = curr;
+                return true;
+            }
+        }
+    }
+
+    return tryGetTableCharCode(codePoint, code);
 }
 
 bool PdfCharCodeMap::TryGetCharCode(const codepointview& codePoints, PdfCharCode& codeUnit) const
 {
-    const_cast<PdfCharCodeMap&>(*this).reviseCPMap();
+    const_cast<PdfCharCodeMap&>(*this).reviseMaps();
+    if (codePoints.size() == 1 && m_codePointBlocks.size() != 0)
+        return tryGetTableCharCode(codePoints[0], codeUnit);
+
     auto it = codePoints.begin();
     auto end = codePoints.end();
     const CPMapNode* node = m_codePointMapHead;
@@ -126,7 +205,10 @@ NotFound:
 
 bool PdfCharCodeMap::TryGetCharCode(codepoint codePoint, PdfCharCode& code) const
 {
-    const_cast<PdfCharCodeMap&>(*this).reviseCPMap();
+    const_cast<PdfCharCodeMap&>(*this).reviseMaps();
+    if (m_codePointBlocks.size() != 0)
+        return tryGetTableCharCode(codePoint, code);
+
     auto node = findNode(m_codePointMapHead, codePoint);
     if (node == nullptr)
     {
@@ -155,7 +237,31 @@ void PdfCharCodeMap::pushMapping(const PdfCharCode& codeUnit, vector<codepoint>&
     if (codeUnit.Code > m_Limits.LastChar.Code)
         m_Limits.LastChar = codeUnit;
 
-    m_MapDirty = true;
+    m_MapDirty.store(true, memory_order_relaxed);
+}
+
+bool PdfCharCodeMap::tryGetTableCharCode(codepoint codePoint, PdfCharCode& codeUnit) const
+{
+    unsigned block = (unsigned)(codePoint / CodePointBlockSize);
+    if (block < m_firstCodePointBlock || block - m_firstCodePointBlock >= m_codePointBlocks.size())
+        goto NotFound;
+
+    {
+        unsigned offset = m_codePointBlocks[block - m_firstCodePointBlock];
+        if (offset == NoBlock)
+            goto NotFound;
+
+        auto& found = m_codePointTable[offset + codePoint % CodePointBlockSize];
+        if (found.CodeSpaceSize == 0)
+            goto NotFound;
+
+        codeUnit = found;
+        return true;
+    }
+
+NotFound:
+    codeUnit = { };
+    return false;
 }
 
 bool PdfCharCodeMap::tryFindNextCharacterId(const CPMapNode* node, string_view::iterator& it,
@@ -209,9 +315,13 @@ const PdfCharCodeMap::CPMapNode* PdfCharCodeMap::findNode(const CPMapNode* node,
         return findNode(node->Right, codePoint);
 }
 
-void PdfCharCodeMap::reviseCPMap()
+void PdfCharCodeMap::reviseMaps()
 {
-    if (!m_MapDirty)
+    if (!m_MapDirty.load(memory_order_acquire))
+        return;
+
+    lock_guard<mutex> lock(s_reviseMutex);
+    if (!m_MapDirty.load(memory_order_relaxed))
         return;
 
     if (m_codePointMapHead != nullptr)
@@ -220,39 +330,130 @@ void PdfCharCodeMap::reviseCPMap()
         m_codePointMapHead = nullptr;
     }
 
-    // Randomize items in the map in a separate list
-    // so BST creation will be more balanced
+    buildCodeUnitTable();
+    buildCodePointTable();
+    m_MapDirty.store(false, memory_order_release);
+}
+
+void PdfCharCodeMap::buildCodeUnitTable()
+{
+    m_codeUnitTable.clear();
+    if (m_CodeUnitMap.size() == 0)
+        return;
+
+    size_t tableSize = (size_t)m_Limits.LastChar.Code - m_Limits.FirstChar.Code + 1;
+    if (tableSize > std::max((size_t)MinCodeUnitTableSize, m_CodeUnitMap.size() * MaxTableSparsity))
+        return;
+
+    m_codeUnitTable.resize(tableSize, NoCodePoint);
+    for (auto& pair : m_CodeUnitMap)
+    {
+        auto& codePoints = pair.second;
+        m_codeUnitTable[pair.first.Code - m_Limits.FirstChar.Code] =
+            codePoints.size() == 1 && codePoints[0] < MultiCodePoint ? codePoints[0] : MultiCodePoint;
+    }
+}
+
+void PdfCharCodeMap::buildCodePointTable()
+{
+    m_codePointBlocks.clear();
+    m_codePointTable.clear();
+    m_firstCodePointBlock = 0;
+
+    // Determine the range of the blocks of the single code points
+    unsigned firstBlock = numeric_limits<unsigned>::max();
+    unsigned lastBlock = 0;
+    size_t singleCount = 0;
+    for (auto& pair : m_CodeUnitMap)
+    {
+        if (pair.second.size() != 1)
+            continue;
+
+        unsigned block = (unsigned)(pair.second[0] / CodePointBlockSize);
+        firstBlock = std::min(firstBlock, block);
+        lastBlock = std::max(lastBlock, block);
+        singleCount++;
+    }
+
+    if (singleCount != 0 && lastBlock - firstBlock < MaxCodePointBlockCount)
+    {
+        m_codePointBlocks.resize(lastBlock - firstBlock + 1, NoBlock);
+        unsigned tableSize = 0;
+        for (auto& pair : m_CodeUnitMap)
+        {
+            if (pair.second.size() != 1)
+                continue;
+
+            auto& offset = m_codePointBlocks[pair.second[0] / CodePointBlockSize - firstBlock];
+            if (offset == NoBlock)
+            {
+                offset = tableSize;
+                tableSize += CodePointBlockSize;
+            }
+        }
+
+        if (tableSize > std::max((size_t)MinCodePointTableSize, singleCount * MaxTableSparsity))
+        {
+            // Too sparse, use the BST for everything
+            m_codePointBlocks.clear();
+        }
+        else
+        {
+            m_firstCodePointBlock = firstBlock;
+            m_codePointTable.resize(tableSize);
+            for (auto& pair : m_CodeUnitMap)
+            {
+                if (pair.second.size() != 1)
+                    continue;
+
+                // If more code units map to the same code
+                // point, the first one is chosen
+                codepoint codePoint = pair.second[0];
+                auto& codeUnit = m_codePointTable[m_codePointBlocks[codePoint / CodePointBlockSize - firstBlock]
+                    + codePoint % CodePointBlockSize];
+                if (codeUnit.CodeSpaceSize == 0)
+                    codeUnit = pair.first;
+            }
+        }
+    }
+
+    // Add the remaining mappings to the BST, randomizing
+    // their order so BST creation will be more balanced
     // https://en.wikipedia.org/wiki/Random_binary_tree
     // TODO: Create a perfectly balanced BST
-    vector<pair<PdfCharCode, vector<codepoint>>> pairs;
-    pairs.reserve(m_CodeUnitMap.size());
-    std::copy(m_CodeUnitMap.begin(), m_CodeUnitMap.end(), std::back_inserter(pairs));
+    vector<const CodeUnitMap::value_type*> pairs;
+    for (auto& pair : m_CodeUnitMap)
+    {
+        if (m_codePointBlocks.size() == 0 || pair.second.size() != 1)
+            pairs.push_back(&pair);
+    }
+
     std::mt19937 e(random_device{}());
     std::shuffle(pairs.begin(), pairs.end(), e);
+    for (auto pair : pairs)
+        addCodePointNode(pair->first, pair->second);
+}
 
-    for (auto& pair : pairs)
+void PdfCharCodeMap::addCodePointNode(const PdfCharCode& codeUnit, const vector<codepoint>& codePoints)
+{
+    CPMapNode** curr = &m_codePointMapHead;      // Node root being searched
+    CPMapNode* found;                     // Last found node
+    auto it = codePoints.begin();
+    auto end = codePoints.end();
+    PODOFO_INVARIANT(it != end);
+    while (true)
     {
-        CPMapNode** curr = &m_codePointMapHead;      // Node root being searched
-        CPMapNode* found;                     // Last found node
-        auto it = pair.second.begin();
-        auto end = pair.second.end();
-        PODOFO_INVARIANT(it != end);
-        while (true)
-        {
-            found = findOrAddNode(*curr, *it);
-            it++;
-            if (it == end)
-                break;
-
-            // We add subsequent codepoints to ligatures
-            curr = &found->Ligatures;
-        }
+        found = findOrAddNode(*curr, *it);
+        it++;
+        if (it == end)
+            break;
 
-        // Finally set the char code on the last found/added node
-        found->CodeUnit = pair.first;
+        // We add subsequent codepoints to ligatures
+        curr = &found->Ligatures;
     }
 
-    m_MapDirty = false;
+    // Finally set the char code on the last found/added node
+    found->CodeUnit = codeUnit;
 }
 
 PdfCharCodeMap::CPMapNode* PdfCharCodeMap::findOrAddNode(CPMapNode*& node, codepoint codePoint)
@@ -10,6 +10,8 @@
 #include "PdfDeclarations.h"
 #include "PdfEncodingCommon.h"
 
+#include <atomic>
+
 namespace PoDoFo
 {
     /** A convenient typedef for an unspecified codepoint
@@ -28,6 +30,10 @@ namespace PoDoFo
      * in CID keyed fonts. For generic terminology see
      * https://en.wikipedia.org/wiki/Character_encoding#Terminology
      * See also 5014.CIDFont_Spec, 2.1 Terminology
+     * \remarks Lookups use direct indexed tables when the codes
+     * and the code points are dense enough, as it happens with
+     * one byte encodings and most CID ranges. Ligatures and maps
+     * that are too sparse are handled with slower structures
      */
     class PODOFO_API PdfCharCodeMap final
     {
@@ -71,6 +77,11 @@ namespace PoDoFo
 
         unsigned GetSize() const;
 
+        /** Get the approximate memory size in bytes of the direct
+         * lookup tables, building them if needed
+         */
+        size_t GetLookupTablesSize() const;
+
         const PdfEncodingLimits& GetLimits() const;
 
     private:
@@ -92,7 +103,11 @@ namespace PoDoFo
         PdfCharCodeMap& operator=(const PdfCharCodeMap&) = delete;
 
     private:
-        void reviseCPMap();
+        void reviseMaps();
+        void buildCodeUnitTable();
+        void buildCodePointTable();
+        void addCodePointNode(const PdfCharCode& codeUnit, const std::vector<codepoint>& codePoints);
+        bool tryGetTableCharCode(codepoint codePoint, PdfCharCode& codeUnit) const;
         static bool tryFindNextCharacterId(const CPMapNode* node, std::string_view::iterator &it,
             const std::string_view::iterator& end, PdfCharCode& cid);
         static const CPMapNode* findNode(const CPMapNode* node, codepoint codePoint);
@@ -112,9 +127,13 @@ namespace PoDoFo
     private:
         PdfEncodingLimits m_Limits;
         CodeUnitMap m_CodeUnitMap;
-        bool m_MapDirty;
-        CPMapNode* m_codePointMapHead;           // Head of a BST to lookup code points
+        std::atomic<bool> m_MapDirty;
+        CPMapNode* m_codePointMapHead;           // Head of a BST to lookup code points, or only ligatures when the code point table is used
         int m_depth;
+        std::vector<codepoint> m_codeUnitTable;  // Code points by code unit, starting from m_Limits.FirstChar
+        std::vector<unsigned> m_codePointBlocks; // Offsets in m_codePointTable of the blocks of 256 code points
+        unsigned m_firstCodePointBlock;
+        std::vector<PdfCharCode> m_codePointTable;
     };
 }
 
@@ -8,6 +8,7 @@
 #include "podofo/private/OpenSSLInternal.h"
 #include "PdfCommon.h"
 #include "PdfFontManager.h"
+#include "PdfCMapEncoding.h"
 
 using namespace std;
 using namespace PoDoFo;
@@ -39,6 +40,31 @@ void PdfCommon::AddFontDirectory(const string_view& path)
     PdfFontManager::AddFontDirectory(path);
 }
 
+void PdfCommon::SetFontIndexFile(const string_view& filepath)
+{
+    PdfFontManager::setFontIndexFile(filepath);
+}
+
+void PdfCommon::SetCMapCacheSize(size_t maxSize)
+{
+    PdfCMapEncoding::setCacheSize(maxSize);
+}
+
+void PdfCommon::ClearCMapCache()
+{
+    PdfCMapEncoding::clearCache();
+}
+
+void PdfCommon::SetFontCacheSize(size_t maxSize)
+{
+    PdfFontManager::setCacheSize(maxSize);
+}
+
+void PdfCommon::ClearFontCache()
+{
+    PdfFontManager::clearCache();
+}
+
 void PdfCommon::SetLogMessageCallback(const LogMessageCallback& logMessageCallback)
 {
     s_LogMessageCallback = logMessageCallback;
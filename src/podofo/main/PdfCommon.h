@@ -17,6 +17,44 @@ class PODOFO_API PdfCommon final
 public:
     static void AddFontDirectory(const std::string_view& path);
 
+    /** Set a file where to persist an index of the fonts found in the
+     * directories added with AddFontDirectory(). The font files are opened
+     * only when the index is first built, later only the files whose size
+     * or modification time changed are read again. Searches of fonts by
+     * name consult the index first, and the directories are scanned by
+     * fontconfig only when a font is not found in it. Must be called
+     * before adding the directories
+     * \param filepath path of the index file. Empty disables the index, which is the default
+     */
+    static void SetFontIndexFile(const std::string_view& filepath);
+
+    /** Set the approximate maximum memory size of the process wide
+     * cache of parsed CMaps, shared by the fonts of all the documents.
+     * CMaps are cached by their content, so identical ToUnicode or
+     * Encoding CMaps embedded in many fonts are parsed only once
+     * \param maxSize size in bytes. 0 disables the cache, which is the default
+     */
+    static void SetCMapCacheSize(size_t maxSize);
+
+    /** Remove all the CMaps from the process wide cache
+     */
+    static void ClearCMapCache();
+
+    /** Set the approximate maximum memory size of the process wide
+     * cache of font metrics, shared by all the documents. Fonts loaded
+     * from the same file, or from the same buffer, share the font data,
+     * the FreeType face and the metrics, and the results of the searches
+     * of fonts by name are cached as well. The metrics in use by any
+     * document are always reused, the most recently used ones are
+     * also kept alive up to the given size
+     * \param maxSize size in bytes. 0 disables the cache, which is the default
+     */
+    static void SetFontCacheSize(size_t maxSize);
+
+    /** Remove all the fonts metrics and the font searches from the process wide cache
+     */
+    static void ClearFontCache();
+
     /** Set a global static LogMessageCallback functor to replace stderr output in LogMessageInternal.
      *  \param logMessageCallback the pointer to the new callback functor object
      *  \returns the pointer to the previous callback functor object
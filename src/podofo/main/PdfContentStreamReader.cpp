@@ -12,6 +12,8 @@
 #include "PdfCanvasInputDevice.h"
 #include "PdfData.h"
 #include "PdfDictionary.h"
+#include "PdfDocument.h"
+#include <podofo/private/PdfXObjectFormCacheEntry.h>
 
 using namespace std;
 using namespace PoDoFo;
@@ -48,6 +50,14 @@ bool PdfContentStreamReader::TryReadNext(PdfContent& content)
         if (m_inputs.size() == 0)
             goto Eof;
 
+        if (m_inputs.back().Cached != nullptr)
+        {
+            if (!tryReadNextCachedContent(content))
+                goto PopDevice;
+
+            goto HandleContent;
+        }
+
         if (m_readingInlineImgData)
         {
             if (m_args.InlineImageHandler == nullptr)
@@ -57,6 +67,7 @@ bool PdfContentStreamReader::TryReadNext(PdfContent& content)
 
                 content.Type = PdfContentType::ImageData;
                 m_readingInlineImgData = false;
+                recordContent(content);
                 afterReadClear(content);
                 return true;
             }
@@ -92,6 +103,7 @@ bool PdfContentStreamReader::TryReadNext(PdfContent& content)
 
     PopDevice:
         PODOFO_INVARIANT(m_inputs.size() != 0);
+        commitRecording(content);
         m_inputs.pop_back();
         if (m_inputs.size() == 0)
             goto Eof;
@@ -130,6 +142,7 @@ bool PdfContentStreamReader::tryReadNextContent(PdfContent& content)
                 if (!TryGetPdfOperator(content.Keyword, content.Operator))
                 {
                     content.Type = PdfContentType::UnexpectedKeyword;
+                    recordContent(content);
                     return true;
                 }
 
@@ -143,9 +156,17 @@ bool PdfContentStreamReader::tryReadNextContent(PdfContent& content)
                         content.Warnings |= PdfContentWarnings::SpuriousStackContent;
                 }
 
+                // NOTE: Record the content before handling it,
+                // except for inline images that read the dictionary
+                if (content.Operator != PdfOperator::BI)
+                    recordContent(content);
+
                 if (!tryHandleOperator(content))
                     return false;
 
+                if (content.Operator == PdfOperator::BI)
+                    recordContent(content);
+
                 return true;
             }
             case PdfPostScriptTokenType::Variant:
@@ -157,6 +178,7 @@ bool PdfContentStreamReader::tryReadNextContent(PdfContent& content)
             case PdfPostScriptTokenType::ProcedureExit:
             {
                 content.Type = PdfContentType::UnexpectedKeyword;
+                recordContent(content);
                 return true;
             }
             default:
@@ -167,6 +189,94 @@ bool PdfContentStreamReader::tryReadNextContent(PdfContent& content)
     }
 }
 
+// Returns false in case of end of the cached form
+bool PdfContentStreamReader::tryReadNextCachedContent(PdfContent& content)
+{
+    auto& input = m_inputs.back();
+    auto& contents = input.Cached->Contents;
+    if (input.CachedIndex == contents.size())
+        return false;
+
+    auto& cached = contents[input.CachedIndex];
+    input.CachedIndex++;
+    content.Stack = cached.Stack;
+    if (cached.Type == PdfContentType::Unknown)
+    {
+        // Operands found at the end of the form
+        return false;
+    }
+
+    content.Type = cached.Type;
+    content.Warnings |= cached.Warnings;
+    content.Operator = cached.Operator;
+    content.Keyword = cached.Keyword;
+    switch (cached.Type)
+    {
+        case PdfContentType::Operator:
+            // NOTE: Inline images are cached with the dictionary
+            // already read, so this just follows XObjects
+            (void)tryHandleOperator(content);
+            break;
+        case PdfContentType::ImageDictionary:
+            content.InlineImageDictionary = cached.InlineImageDictionary;
+            break;
+        case PdfContentType::ImageData:
+            content.InlineImageData = cached.InlineImageData;
+            break;
+        default:
+            break;
+    }
+
+    return true;
+}
+
+// Record the content of a form being read, to be cached
+void PdfContentStreamReader::recordContent(const PdfContent& content)
+{
+    auto& input = m_inputs.back();
+    if (input.Recording == nullptr)
+        return;
+
+    auto& cached = input.Recording->Contents.emplace_back();
+    cached.Type = content.Type;
+    cached.Warnings = content.Warnings;
+    cached.Stack = content.Stack;
+    cached.Operator = content.Operator;
+    cached.Keyword = content.Keyword;
+    if (content.Type == PdfContentType::ImageDictionary)
+        cached.InlineImageDictionary = content.InlineImageDictionary;
+    else if (content.Type == PdfContentType::ImageData)
+        cached.InlineImageData = content.InlineImageData;
+
+    input.Recording->Size += sizeof(PdfCachedContent)
+        + cached.Stack.GetSize() * sizeof(PdfVariant)
+        + cached.Keyword.size()
+        + cached.InlineImageDictionary.GetSize() * (sizeof(PdfName) + sizeof(PdfObject))
+        + cached.InlineImageData.size();
+
+    // Stop recording forms that can't fit the cache
+    if (input.Recording->Size > input.Cache->GetMaxSize())
+        input.Recording = nullptr;
+}
+
+void PdfContentStreamReader::commitRecording(const PdfContent& content)
+{
+    auto& input = m_inputs.back();
+    if (input.Recording == nullptr)
+        return;
+
+    if (content.Stack.GetSize() != 0)
+    {
+        auto& cached = input.Recording->Contents.emplace_back();
+        cached.Stack = content.Stack;
+        input.Recording->Size += sizeof(PdfCachedContent)
+            + cached.Stack.GetSize() * sizeof(PdfVariant);
+    }
+
+    input.Cache->insert(input.Form->GetObject().GetIndirectReference(), input.Recording);
+    input.Recording = nullptr;
+}
+
 void PdfContentStreamReader::beforeReadReset(PdfContent& content)
 {
     content.Stack.Clear();
@@ -344,10 +454,29 @@ void PdfContentStreamReader::tryFollowXObject(PdfContent& content)
     if (content.XObject->GetType() == PdfXObjectType::Form
         && (m_args.Flags & PdfContentReaderFlags::DontFollowXObjectForms) == PdfContentReaderFlags::None)
     {
-        m_inputs.push_back({
-            content.XObject,
-            std::make_shared<PdfCanvasInputDevice>(static_cast<const PdfXObjectForm&>(*content.XObject)),
-            dynamic_cast<const PdfCanvas*>(content.XObject.get()) });
+        Input input{ content.XObject, nullptr, dynamic_cast<const PdfCanvas*>(content.XObject.get()) };
+
+        // Custom inline image handlers read from the device, so
+        // the cache can't be used with them
+        // NOTE: Hold the cache, so it stays valid even if
+        // the document cache is replaced while reading
+        shared_ptr<PdfXObjectFormCache> cache;
+        if (m_args.InlineImageHandler == nullptr
+            && xobjraw->IsIndirect()
+            && (cache = content.XObject->GetDocument().m_FormCache) != nullptr)
+        {
+            input.Cached = cache->find(xobjraw->GetIndirectReference());
+            if (input.Cached == nullptr)
+            {
+                input.Recording = std::make_shared<PdfXObjectFormCacheEntry>();
+                input.Cache = std::move(cache);
+            }
+        }
+
+        if (input.Cached == nullptr)
+            input.Device = std::make_shared<PdfCanvasInputDevice>(static_cast<const PdfXObjectForm&>(*content.XObject));
+
+        m_inputs.push_back(std::move(input));
     }
 }
 
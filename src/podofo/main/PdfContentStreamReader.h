@@ -16,6 +16,9 @@
 
 namespace PoDoFo {
 
+class PdfXObjectFormCache;
+struct PdfXObjectFormCacheEntry;
+
 /** Type of the content read from a content stream
  */
 enum class PdfContentType
@@ -75,6 +78,9 @@ struct PODOFO_API PdfContentReaderArgs final
 };
 
 /** Reader class to read content streams
+ * \remarks When the document has a XObject form cache enabled, followed
+ * forms are read from the cache, unless a custom inline image handler is set
+ * \see PdfDocument::SetXObjectFormCacheSize()
  */
 class PODOFO_API PdfContentStreamReader final
 {
@@ -97,6 +103,12 @@ private:
 
     bool tryReadNextContent(PdfContent& content);
 
+    bool tryReadNextCachedContent(PdfContent& content);
+
+    void recordContent(const PdfContent& content);
+
+    void commitRecording(const PdfContent& content);
+
     bool tryHandleOperator(PdfContent& content);
 
     bool tryReadInlineImgDict(PdfContent& content);
@@ -122,7 +134,15 @@ private:
     {
         std::shared_ptr<const PdfXObject> Form;
         std::shared_ptr<InputStreamDevice> Device;
-        const PdfCanvas* Canvas;
+        const PdfCanvas* Canvas = nullptr;
+
+        // Form contents read from the cache
+        std::shared_ptr<const PdfXObjectFormCacheEntry> Cached = { };
+        size_t CachedIndex = 0;
+
+        // Form contents being recorded to be cached
+        std::shared_ptr<PdfXObjectFormCacheEntry> Recording = { };
+        std::shared_ptr<PdfXObjectFormCache> Cache = { };
     };
 
 private:
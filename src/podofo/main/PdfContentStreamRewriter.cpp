@@ -0,0 +1,103 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#include <podofo/private/PdfDeclarationsPrivate.h>
+#include "PdfContentStreamRewriter.h"
+
+#include "PdfDocument.h"
+
+using namespace std;
+using namespace PoDoFo;
+
+PdfContentStreamRewriter::PdfContentStreamRewriter(const PdfContentRewriteHandler& handler,
+        PdfContentReaderFlags flags) :
+    m_handler(handler),
+    m_flags(flags)
+{
+    if (m_handler == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Handler must be non null");
+}
+
+void PdfContentStreamRewriter::Rewrite(PdfCanvas& canvas)
+{
+    auto contents = canvas.GetContentsObject();
+    if (contents == nullptr)
+        return;
+
+    // NOTE: The reader decodes all the contents at
+    // construction, so the streams can be overwritten
+    PdfContentStreamViewReader reader(canvas, m_flags);
+    auto& element = canvas.GetElement();
+    auto cache = element.GetDocument().GetXObjectFormCache();
+    if (cache != nullptr)
+        cache->Remove(element.GetObject().GetIndirectReference());
+
+    PdfObject* target;
+    PdfArray* arr;
+    if (contents->TryGetArray(arr))
+    {
+        target = &element.GetDocument().GetObjects().CreateDictionaryObject();
+        arr->Clear();
+        arr->Add(target->GetIndirectReference());
+    }
+    else
+    {
+        target = contents;
+    }
+
+    auto output = target->GetOrCreateStream().GetOutputStream();
+    rewrite(reader, output);
+}
+
+void PdfContentStreamRewriter::Rewrite(const bufferview& contents, OutputStream& output)
+{
+    PdfContentStreamViewReader reader(contents, m_flags);
+    rewrite(reader, output);
+}
+
+void PdfContentStreamRewriter::rewrite(PdfContentStreamViewReader& reader, OutputStream& output)
+{
+    auto& buffer = reader.m_buffer;
+    PdfContentView content;
+    size_t copyStart = 0;
+    auto dropImageData = false;
+    while (reader.TryReadNext(content))
+    {
+        size_t start = content.RawData.data() - buffer.data();
+        size_t end = start + content.RawData.size();
+        PdfContentRewriteAction action;
+        m_output.Clear();
+        if (content.Type == PdfContentType::ImageData)
+        {
+            // The image data follows the action of its dictionary
+            action = dropImageData ? PdfContentRewriteAction::Drop : PdfContentRewriteAction::Keep;
+        }
+        else
+        {
+            action = m_handler(content, m_output);
+            dropImageData = content.Type == PdfContentType::ImageDictionary
+                && action == PdfContentRewriteAction::Drop;
+        }
+
+        if (m_output.GetSize() != 0)
+        {
+            // Flush the untouched contents preceding this
+            // one before inserting the handler output
+            output.Write(buffer.data() + copyStart, start - copyStart);
+            output.Write(m_output.GetString());
+            output.Write('\n');
+            copyStart = start;
+        }
+
+        if (action == PdfContentRewriteAction::Drop)
+        {
+            output.Write(buffer.data() + copyStart, start - copyStart);
+            copyStart = end;
+        }
+    }
+
+    output.Write(buffer.data() + copyStart, buffer.size() - copyStart);
+}
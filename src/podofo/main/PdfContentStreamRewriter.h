@@ -0,0 +1,64 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef PDF_CONTENT_STREAM_REWRITER_H
+#define PDF_CONTENT_STREAM_REWRITER_H
+
+#include "PdfContentStreamViewReader.h"
+#include "PdfStringStream.h"
+
+namespace PoDoFo {
+
+/** Action to perform on a content read by PdfContentStreamRewriter
+ */
+enum class PdfContentRewriteAction
+{
+    Keep = 0,  ///< Keep the content as it is
+    Drop,      ///< Remove the content
+};
+
+/** Handler for the contents read by PdfContentStreamRewriter
+ * \param content the content read. Inline images are reported
+ *  with the ImageDictionary content only, and their data follows
+ *  the same action
+ * \param output anything written here is inserted in place of the
+ *  content, before it when it's kept, or replacing it when dropped
+ */
+using PdfContentRewriteHandler = std::function<PdfContentRewriteAction(
+    const PdfContentView& content, PdfStringStream& output)>;
+
+/** Rewrite content streams by filtering the operators through an handler.
+ * Contents that are kept are copied verbatim to the output
+ */
+class PODOFO_API PdfContentStreamRewriter final
+{
+public:
+    PdfContentStreamRewriter(const PdfContentRewriteHandler& handler,
+        PdfContentReaderFlags flags = PdfContentReaderFlags::None);
+
+public:
+    /** Rewrite the contents of the canvas in place. The output
+     * is Flate compressed, and multiple content streams are
+     * merged into a single one
+     */
+    void Rewrite(PdfCanvas& canvas);
+
+    /** Rewrite the given decoded content buffer into the output stream
+     */
+    void Rewrite(const bufferview& contents, OutputStream& output);
+
+private:
+    void rewrite(PdfContentStreamViewReader& reader, OutputStream& output);
+
+private:
+    PdfContentRewriteHandler m_handler;
+    PdfContentReaderFlags m_flags;
+    PdfStringStream m_output;
+};
+
+};
+
+#endif // PDF_CONTENT_STREAM_REWRITER_H
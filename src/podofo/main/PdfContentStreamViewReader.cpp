@@ -0,0 +1,614 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#include <podofo/private/PdfDeclarationsPrivate.h>
+#include "PdfContentStreamViewReader.h"
+
+#include <podofo/auxiliary/StreamDevice.h>
+#include "PdfOperatorUtils.h"
+#include "PdfCanvasInputDevice.h"
+
+using namespace std;
+using namespace PoDoFo;
+
+static bool isOctalChar(char ch);
+static void decodeName(charbuff& buffer, const string_view& data);
+static void decodeString(charbuff& buffer, const string_view& data);
+static void decodeHexString(charbuff& buffer, const string_view& data);
+
+PdfContentStreamViewReader::PdfContentStreamViewReader(const PdfCanvas& canvas,
+        PdfContentReaderFlags flags) :
+    m_position(0),
+    m_flags(flags),
+    m_depth(0),
+    m_operandCount(0),
+    m_readingInlineImgData(false),
+    m_skippedOperand(false)
+{
+    PdfCanvasInputDevice input(canvas);
+    BufferStreamDevice output(m_contents);
+    input.CopyTo(output);
+    m_buffer = m_contents;
+}
+
+PdfContentStreamViewReader::PdfContentStreamViewReader(const bufferview& buffer,
+        PdfContentReaderFlags flags) :
+    m_buffer(buffer),
+    m_position(0),
+    m_flags(flags),
+    m_depth(0),
+    m_operandCount(0),
+    m_readingInlineImgData(false),
+    m_skippedOperand(false)
+{
+}
+
+bool PdfContentStreamViewReader::TryReadNext(PdfContentView& content)
+{
+    content.Warnings = PdfContentWarnings::None;
+    content.InlineImageData = { };
+    m_operands.clear();
+    m_depth = 0;
+    m_operandCount = 0;
+    m_skippedOperand = false;
+
+    if (m_readingInlineImgData)
+    {
+        size_t start = m_position;
+        m_readingInlineImgData = false;
+        if (!tryReadInlineImgData(content))
+            content.Warnings |= PdfContentWarnings::MissingEndImage;
+
+        content.Type = PdfContentType::ImageData;
+        content.Operator = PdfOperator::Unknown;
+        content.Keyword = { };
+        content.Operands = { };
+        content.RawData = bufferview(m_buffer.data() + start, m_position - start);
+        handleWarnings(content);
+        return true;
+    }
+
+    bool eof = !skipWhitespaces();
+    size_t start = m_position;
+    if (eof || !tryReadNextContent(content))
+    {
+        content.Type = PdfContentType::Unknown;
+        content.Operator = PdfOperator::Unknown;
+        content.Keyword = { };
+        content.Operands = { };
+        content.RawData = { };
+        return false;
+    }
+
+    content.Operands = m_operands;
+    content.RawData = bufferview(m_buffer.data() + start, m_position - start);
+    handleWarnings(content);
+    return true;
+}
+
+// Returns false in case of EOF
+bool PdfContentStreamViewReader::tryReadNextContent(PdfContentView& content)
+{
+    string_view keyword;
+    while (true)
+    {
+        if (!tryReadOperand(keyword))
+            return false;
+
+        if (keyword.length() != 0)
+            break;
+    }
+
+    content.Keyword = keyword;
+    if (!TryGetPdfOperator(keyword, content.Operator))
+    {
+        content.Type = PdfContentType::UnexpectedKeyword;
+        return true;
+    }
+
+    content.Type = PdfContentType::Operator;
+    if (m_depth != 0 || m_skippedOperand)
+        content.Warnings |= PdfContentWarnings::InvalidOperator;
+
+    int operandCount = PoDoFo::GetOperandCount(content.Operator);
+    if (operandCount != -1 && m_operandCount != (unsigned)operandCount)
+    {
+        if (m_operandCount < (unsigned)operandCount)
+            content.Warnings |= PdfContentWarnings::InvalidOperator;
+        else // m_operandCount > operandCount
+            content.Warnings |= PdfContentWarnings::SpuriousStackContent;
+    }
+
+    if (content.Operator == PdfOperator::BI)
+        return tryReadInlineImgDict(content);
+
+    return true;
+}
+
+// Read either an operand, which is pushed to the operand
+// list, or a keyword. Returns false in case of EOF
+bool PdfContentStreamViewReader::tryReadOperand(string_view& keyword)
+{
+    keyword = { };
+    if (!skipWhitespaces())
+        return false;
+
+    size_t start = m_position;
+    switch (m_buffer[m_position])
+    {
+        case '/':
+        {
+            m_position++;
+            pushOperand(PdfContentOperandType::Name, readRegularToken());
+            return true;
+        }
+        case '(':
+        {
+            // Find the end of the string, skipping escaped
+            // characters and balanced parenthesis
+            m_position++;
+            start = m_position;
+            unsigned balanceCount = 0;
+            while (m_position < m_buffer.size())
+            {
+                char ch = m_buffer[m_position];
+                if (ch == '\\')
+                {
+                    m_position += 2;
+                    continue;
+                }
+
+                if (ch == '(')
+                {
+                    balanceCount++;
+                }
+                else if (ch == ')')
+                {
+                    if (balanceCount == 0)
+                        break;
+
+                    balanceCount--;
+                }
+
+                m_position++;
+            }
+
+            m_position = std::min(m_position, m_buffer.size());
+            pushOperand(PdfContentOperandType::String,
+                string_view(m_buffer.data() + start, m_position - start));
+
+            // Skip the closing parenthesis
+            if (m_position < m_buffer.size())
+                m_position++;
+
+            return true;
+        }
+        case '<':
+        {
+            if (m_position + 1 < m_buffer.size() && m_buffer[m_position + 1] == '<')
+            {
+                m_position += 2;
+                pushOperand(PdfContentOperandType::DictionaryBegin);
+                m_depth++;
+                return true;
+            }
+
+            m_position++;
+            start = m_position;
+            while (m_position < m_buffer.size() && m_buffer[m_position] != '>')
+                m_position++;
+
+            pushOperand(PdfContentOperandType::HexString,
+                string_view(m_buffer.data() + start, m_position - start));
+
+            // Skip the closing angle bracket
+            if (m_position < m_buffer.size())
+                m_position++;
+
+            return true;
+        }
+        case '>':
+        {
+            if (m_position + 1 < m_buffer.size() && m_buffer[m_position + 1] == '>')
+            {
+                m_position += 2;
+                if (m_depth != 0)
+                {
+                    m_depth--;
+                    pushOperand(PdfContentOperandType::DictionaryEnd);
+                    return true;
+                }
+            }
+            else
+            {
+                m_position++;
+            }
+
+            keyword = string_view(m_buffer.data() + start, m_position - start);
+            return true;
+        }
+        case '[':
+        {
+            m_position++;
+            pushOperand(PdfContentOperandType::ArrayBegin);
+            m_depth++;
+            return true;
+        }
+        case ']':
+        {
+            m_position++;
+            if (m_depth != 0)
+            {
+                m_depth--;
+                pushOperand(PdfContentOperandType::ArrayEnd);
+                return true;
+            }
+
+            keyword = string_view(m_buffer.data() + start, 1);
+            return true;
+        }
+        case '{':
+        case '}':
+        case ')':
+        {
+            // PostScript procedure delimiters or stray
+            // delimiters, report them as unexpected keywords
+            m_position++;
+            keyword = string_view(m_buffer.data() + start, 1);
+            return true;
+        }
+        default:
+        {
+            auto token = readRegularToken();
+            if (token == "null")
+            {
+                pushOperand(PdfContentOperandType::Null, token);
+                return true;
+            }
+            else if (token == "true" || token == "false")
+            {
+                pushOperand(PdfContentOperandType::Bool, token);
+                m_operands.back().Bool = token[0] == 't';
+                return true;
+            }
+
+            auto type = PdfContentOperandType::Number;
+            for (char ch : token)
+            {
+                if (ch == '.')
+                {
+                    type = PdfContentOperandType::Real;
+                }
+                else if (!(std::isdigit((unsigned char)ch) || ch == '-' || ch == '+'))
+                {
+                    // Not a number, assume we have a keyword
+                    keyword = token;
+                    return true;
+                }
+            }
+
+            // NOTE: std::from_chars doesn't accept a leading plus sign
+            auto numberStr = token;
+            if (numberStr.length() > 1 && numberStr[0] == '+')
+                numberStr = numberStr.substr(1);
+
+            double real = 0;
+            int64_t number = 0;
+            if (type == PdfContentOperandType::Real
+                ? !utls::TryParse(numberStr, real)
+                : !utls::TryParse(numberStr, number))
+            {
+                // Skip malformed numbers, such as "--1", and
+                // flag the operator that should consume them
+                PoDoFo::LogMessage(PdfLogSeverity::Warning, "Skipping invalid number {}", token);
+                m_skippedOperand = true;
+                return true;
+            }
+
+            pushOperand(type, token);
+            auto& operand = m_operands.back();
+            if (type == PdfContentOperandType::Real)
+                operand.Real = real;
+            else
+                operand.Number = number;
+
+            return true;
+        }
+    }
+}
+
+// Returns false in case of EOF
+bool PdfContentStreamViewReader::tryReadInlineImgDict(PdfContentView& content)
+{
+    // The dictionary replaces the operands of the BI operator
+    m_operands.clear();
+    m_depth = 0;
+    m_operandCount = 0;
+
+    string_view keyword;
+    while (true)
+    {
+        if (!tryReadOperand(keyword))
+            return false;
+
+        if (keyword.length() == 0)
+            continue;
+
+        // Try to find end of dictionary
+        if (keyword == "ID")
+            break;
+
+        content.Warnings |= PdfContentWarnings::InvalidImageDictionaryContent;
+    }
+
+    // Check the dictionary is made of name/value pairs
+    unsigned depth = 0;
+    unsigned index = 0;
+    for (auto& operand : m_operands)
+    {
+        switch (operand.Type)
+        {
+            case PdfContentOperandType::ArrayEnd:
+            case PdfContentOperandType::DictionaryEnd:
+                depth--;
+                continue;
+            default:
+                break;
+        }
+
+        if (depth == 0)
+        {
+            if (index % 2 == 0 && operand.Type != PdfContentOperandType::Name)
+                content.Warnings |= PdfContentWarnings::InvalidImageDictionaryContent;
+
+            index++;
+        }
+
+        if (operand.Type == PdfContentOperandType::ArrayBegin
+            || operand.Type == PdfContentOperandType::DictionaryBegin)
+        {
+            depth++;
+        }
+    }
+
+    if (index % 2 != 0 || m_depth != 0)
+        content.Warnings |= PdfContentWarnings::InvalidImageDictionaryContent;
+
+    content.Type = PdfContentType::ImageDictionary;
+    content.Operator = PdfOperator::Unknown;
+    content.Keyword = { };
+    m_readingInlineImgData = true;
+    return true;
+}
+
+// Returns false if the EI end image operator was not found
+bool PdfContentStreamViewReader::tryReadInlineImgData(PdfContentView& content)
+{
+    // Consume one whitespace between ID and data
+    if (m_position < m_buffer.size())
+        m_position++;
+
+    // NOTE: Same heuristic of PdfContentStreamReader, that
+    // is look for "EI" followed by a whitespace, with the
+    // addition of accepting "EI" at the end of the buffer
+    size_t start = m_position;
+    for (size_t i = start; i + 1 < m_buffer.size(); i++)
+    {
+        if (m_buffer[i] == 'E' && m_buffer[i + 1] == 'I'
+            && (i + 2 == m_buffer.size() || PdfTokenizer::IsWhitespace(m_buffer[i + 2])))
+        {
+            content.InlineImageData = bufferview(m_buffer.data() + start, i - start);
+            m_position = std::min(i + 3, m_buffer.size());
+            return true;
+        }
+    }
+
+    content.InlineImageData = bufferview(m_buffer.data() + start, m_buffer.size() - start);
+    m_position = m_buffer.size();
+    return false;
+}
+
+// Skip whitespaces and comments. Returns false in case of EOF
+bool PdfContentStreamViewReader::skipWhitespaces()
+{
+    while (m_position < m_buffer.size())
+    {
+        char ch = m_buffer[m_position];
+        if (ch == '%')
+        {
+            // Skip the comment until the end of line
+            while (m_position < m_buffer.size()
+                && m_buffer[m_position] != '\n' && m_buffer[m_position] != '\r')
+            {
+                m_position++;
+            }
+
+            continue;
+        }
+
+        if (!PdfTokenizer::IsWhitespace(ch))
+            return true;
+
+        m_position++;
+    }
+
+    return false;
+}
+
+string_view PdfContentStreamViewReader::readRegularToken()
+{
+    size_t start = m_position;
+    while (m_position < m_buffer.size() && PdfTokenizer::IsRegular(m_buffer[m_position]))
+        m_position++;
+
+    return string_view(m_buffer.data() + start, m_position - start);
+}
+
+void PdfContentStreamViewReader::pushOperand(PdfContentOperandType type, const string_view& data)
+{
+    if (m_depth == 0 && type != PdfContentOperandType::ArrayEnd
+        && type != PdfContentOperandType::DictionaryEnd)
+    {
+        m_operandCount++;
+    }
+
+    auto& operand = m_operands.emplace_back();
+    operand.Type = type;
+    operand.Data = data;
+}
+
+void PdfContentStreamViewReader::handleWarnings(const PdfContentView& content)
+{
+    if (content.Warnings != PdfContentWarnings::None
+        && (m_flags & PdfContentReaderFlags::ThrowOnWarnings) != PdfContentReaderFlags::None)
+    {
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidContentStream, "Unsupported PostScript content");
+    }
+}
+
+double PdfContentOperand::GetReal() const
+{
+    switch (Type)
+    {
+        case PdfContentOperandType::Number:
+            return (double)Number;
+        case PdfContentOperandType::Real:
+            return Real;
+        default:
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "The operand is not a number");
+    }
+}
+
+void PdfContentOperand::DecodeTo(charbuff& buffer) const
+{
+    buffer.clear();
+    switch (Type)
+    {
+        case PdfContentOperandType::Name:
+            decodeName(buffer, Data);
+            break;
+        case PdfContentOperandType::String:
+            decodeString(buffer, Data);
+            break;
+        case PdfContentOperandType::HexString:
+            decodeHexString(buffer, Data);
+            break;
+        default:
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "The operand is not a name or a string");
+    }
+}
+
+bool isOctalChar(char ch)
+{
+    return ch >= '0' && ch <= '7';
+}
+
+void decodeName(charbuff& buffer, const string_view& data)
+{
+    unsigned char hi;
+    unsigned char lo;
+    for (size_t i = 0; i < data.length(); i++)
+    {
+        if (data[i] == '#' && i + 2 < data.length()
+            && utls::TryGetHexValue(data[i + 1], hi)
+            && utls::TryGetHexValue(data[i + 2], lo))
+        {
+            buffer.push_back((char)((hi << 4) | lo));
+            i += 2;
+        }
+        else
+        {
+            buffer.push_back(data[i]);
+        }
+    }
+}
+
+// NOTE: Same handling of escape sequences of PdfTokenizer::ReadString()
+void decodeString(charbuff& buffer, const string_view& data)
+{
+    for (size_t i = 0; i < data.length(); i++)
+    {
+        char ch = data[i];
+        if (ch != '\\')
+        {
+            buffer.push_back(ch);
+            continue;
+        }
+
+        i++;
+        if (i == data.length())
+            break;
+
+        ch = data[i];
+        if (isOctalChar(ch))
+        {
+            // Octal escape sequences have up to 3 digits
+            char octValue = (ch - '0') & 0x07;
+            for (unsigned count = 1; count < 3 && i + 1 < data.length() && isOctalChar(data[i + 1]); count++)
+            {
+                i++;
+                octValue <<= 3;
+                octValue |= (data[i] - '0') & 0x07;
+            }
+
+            buffer.push_back(octValue);
+            continue;
+        }
+
+        switch (ch)
+        {
+            case 'n':
+                buffer.push_back('\n');
+                break;
+            case 'r':
+                buffer.push_back('\r');
+                break;
+            case 't':
+                buffer.push_back('\t');
+                break;
+            case 'b':
+                buffer.push_back('\b');
+                break;
+            case 'f':
+                buffer.push_back('\f');
+                break;
+            case '(':
+            case ')':
+            case '\\':
+                buffer.push_back(ch);
+                break;
+            case '\r':
+            {
+                // Ignore end of line characters when reading escaped sequences
+                if (i + 1 < data.length() && data[i + 1] == '\n')
+                    i++;
+                break;
+            }
+            default:
+                // Unknown escape sequences and escaped
+                // line feeds are ignored
+                break;
+        }
+    }
+}
+
+void decodeHexString(charbuff& buffer, const string_view& data)
+{
+    unsigned char value;
+    bool high = true;
+    for (char ch : data)
+    {
+        if (!utls::TryGetHexValue(ch, value))
+            continue;
+
+        if (high)
+            buffer.push_back((char)(value << 4));
+        else
+            buffer.back() |= (char)value;
+
+        high = !high;
+    }
+}
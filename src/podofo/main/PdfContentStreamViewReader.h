@@ -0,0 +1,138 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef PDF_CONTENT_STREAM_VIEW_READER_H
+#define PDF_CONTENT_STREAM_VIEW_READER_H
+
+#include "PdfContentStreamReader.h"
+
+namespace PoDoFo {
+
+/** Type of an operand read by PdfContentStreamViewReader
+ */
+enum class PdfContentOperandType
+{
+    Unknown = 0,
+    Null,
+    Bool,
+    Number,
+    Real,
+    Name,
+    String,
+    HexString,
+    ArrayBegin,      ///< Start of an array. The items follow as separate operands
+    ArrayEnd,
+    DictionaryBegin, ///< Start of a dictionary. Keys and values follow as separate operands
+    DictionaryEnd,
+};
+
+/** Operand as a view into the content buffer
+ * \remarks Arrays and dictionaries are flattened in the operand list
+ * and delimited by begin/end markers
+ */
+struct PODOFO_API PdfContentOperand final
+{
+    PdfContentOperandType Type = PdfContentOperandType::Unknown;
+    bool Bool = false;
+    int64_t Number = 0;
+    double Real = 0;
+
+    /** Raw token data. It's the name without the leading slash, or the
+     * string without the delimiters. Escape sequences are not resolved
+     */
+    std::string_view Data;
+
+    /** Get the value of a Number or Real operand as a real
+     */
+    double GetReal() const;
+
+    /** Resolve the escape sequences of a Name, String or HexString
+     * operand into the given buffer, which can be reused between calls
+     */
+    void DecodeTo(charbuff& buffer) const;
+};
+
+/** Content as read by PdfContentStreamViewReader
+ * \remarks All the views are valid until the next read
+ * and as long as the content buffer is alive
+ */
+struct PODOFO_API PdfContentView final
+{
+    PdfContentType Type = PdfContentType::Unknown;
+    PdfContentWarnings Warnings = PdfContentWarnings::None;
+    PdfOperator Operator = PdfOperator::Unknown;
+    std::string_view Keyword;
+
+    /** Operator operands, or the inline image dictionary keys and
+     * values when Type is ImageDictionary
+     */
+    cspan<PdfContentOperand> Operands;
+    bufferview InlineImageData;
+
+    /** Raw bytes of the content in the buffer, from the first
+     * operand to the end of the operator
+     */
+    bufferview RawData;
+};
+
+/** Lightweight reader for content streams, that operates on
+ * the fully decoded content buffer and yields the operands as
+ * typed views into it. After the first few operators no
+ * allocation is performed anymore while reading
+ * \remarks Unlike PdfContentStreamReader, XObject forms are not
+ * followed and Do operators are always reported as such
+ */
+class PODOFO_API PdfContentStreamViewReader final
+{
+    friend class PdfContentStreamRewriter;
+
+public:
+    /** Read the contents of the canvas, decoding all its content streams at once
+     */
+    PdfContentStreamViewReader(const PdfCanvas& canvas,
+        PdfContentReaderFlags flags = PdfContentReaderFlags::None);
+
+    /** Read the given decoded content buffer
+     * \remarks The buffer must be kept alive during reading
+     */
+    PdfContentStreamViewReader(const bufferview& buffer,
+        PdfContentReaderFlags flags = PdfContentReaderFlags::None);
+
+public:
+    bool TryReadNext(PdfContentView& content);
+
+private:
+    bool tryReadNextContent(PdfContentView& content);
+
+    bool tryReadOperand(std::string_view& keyword);
+
+    bool tryReadInlineImgDict(PdfContentView& content);
+
+    bool tryReadInlineImgData(PdfContentView& content);
+
+    bool skipWhitespaces();
+
+    std::string_view readRegularToken();
+
+    void pushOperand(PdfContentOperandType type, const std::string_view& data = { });
+
+    void handleWarnings(const PdfContentView& content);
+
+private:
+    charbuff m_contents;
+    bufferview m_buffer;
+    size_t m_position;
+    PdfContentReaderFlags m_flags;
+    std::vector<PdfContentOperand> m_operands;
+    unsigned m_depth;
+    unsigned m_operandCount;
+    bool m_readingInlineImgData;
+    bool m_skippedOperand;
+};
+
+};
+
+#endif // PDF_CONTENT_STREAM_VIEW_READER_H
@@ -409,10 +409,17 @@ chrono::seconds getSecondsFromEpoch()
 int getLocalOffesetFromUTCMinutes()
 {
     time_t t = time(nullptr);
-    struct tm* locg = localtime(&t);
+    // NOTE: Use the reentrant versions, as
+    // documents may be created in many threads
+    struct tm locg;
+#if _WIN32
+    localtime_s(&locg, &t);
+#else
+    localtime_r(&t, &locg);
+#endif
     struct tm locl;
-    memcpy(&locl, locg, sizeof(struct tm));
-    return (int)(timegm(locg) - mktime(&locl)) / 60;
+    memcpy(&locl, &locg, sizeof(struct tm));
+    return (int)(timegm(&locg) - mktime(&locl)) / 60;
 }
 
 bool tryReadShiftChar(const char*& in, int& zoneShift)
@@ -444,6 +444,10 @@ enum class PdfSaveOptions
      */
     NoMetadataUpdate = 16,
     Clean = 32,
+    /** Optimize the content streams of all the pages before saving
+     * \see PdfPage::OptimizeContents()
+     */
+    OptimizeContents = 64,
 
     /**
       * \deprecated Use NoMetadataUpdate instead
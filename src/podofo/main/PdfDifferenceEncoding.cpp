@@ -25,11 +25,32 @@ using namespace PoDoFo;
 // specification and attempt to implement it better
 // https://github.com/adobe-type-tools/agl-specification
 // https://github.com/adobe-type-tools/agl-aglfn/
-static struct
+
+namespace
 {
-    char32_t u;
-    const char* name;
-} nameToUnicodeTab[] = {
+    struct GlyphNameEntry
+    {
+        char32_t u;
+        const char* name;
+    };
+
+    // A perfect hash table, built with the "hash and displace"
+    // method: keys are first distributed in buckets, then every
+    // bucket gets a displacement that moves all its keys to
+    // free slots, starting with the largest buckets
+    template <size_t BucketCount, size_t SlotCount>
+    struct GlyphHashTable
+    {
+        static_assert((BucketCount & (BucketCount - 1)) == 0 && (SlotCount & (SlotCount - 1)) == 0,
+            "The sizes of the table must be powers of two");
+
+        std::array<uint16_t, BucketCount> Displacements;
+        std::array<uint16_t, SlotCount> Slots;     // Indices of the entries, or EmptySlot
+        bool IsPerfect;
+    };
+}
+
+static constexpr GlyphNameEntry nameToUnicodeTab[] = {
   {0x0021, "!"},
   {0x0023, "#"},
   {0x0024, "$"},
@@ -1320,13 +1341,9 @@ static struct
   {0x275C, "a98"},
   {0x275D, "a99"},
   {0x2720, "a9"},
-  { 0, nullptr }
 };
 
-static struct {
-    char32_t u;
-    const char* name;
-} UnicodeToNameTab[] = {
+static constexpr GlyphNameEntry UnicodeToNameTab[] = {
     {0x0000, ".notdef"},
     {0x0020, "space"},
     {0x0021, "exclam"},
@@ -2379,9 +2396,187 @@ static struct {
     {0xFB2B, "afii57695"},
     {0xFB35, "afii57723"},
     {0xFB4B, "afii57700"},
-    {0xFFFF, nullptr}
 };
 
+static constexpr uint16_t EmptySlot = numeric_limits<uint16_t>::max();
+static constexpr uint16_t MaxDisplacement = numeric_limits<uint16_t>::max();
+static constexpr size_t NameEntryCount = size(nameToUnicodeTab);
+static constexpr size_t CodePointEntryCount = size(UnicodeToNameTab) + size(nameToUnicodeTab);
+
+// Keys of the tables are identified by a 32 bit hash: FNV-1a for the names,
+// that are all different, and the code point itself for the code points
+static constexpr uint32_t hashGlyphName(const string_view& name)
+{
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < name.length(); i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+// Finalizer of MurmurHash3, used to compute the
+// slot of a key with the displacement of its bucket
+static constexpr uint32_t mixHash(uint32_t hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6BU;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35U;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static constexpr uint32_t getBucket(uint32_t hash, size_t bucketCount)
+{
+    return mixHash(hash) & (uint32_t)(bucketCount - 1);
+}
+
+static constexpr uint32_t getSlot(uint32_t hash, uint16_t displacement, size_t slotCount)
+{
+    return mixHash(hash ^ (displacement * 0x9E3779B9U)) & (uint32_t)(slotCount - 1);
+}
+
+// Build the table for the given key hashes. Keys with the same
+// hash are the same key: only the first occurrence is inserted
+template <size_t BucketCount, size_t SlotCount, size_t KeyCount>
+static constexpr GlyphHashTable<BucketCount, SlotCount> createGlyphHashTable(const array<uint32_t, KeyCount>& hashes)
+{
+    GlyphHashTable<BucketCount, SlotCount> ret{ };
+    for (size_t i = 0; i < SlotCount; i++)
+        ret.Slots[i] = EmptySlot;
+
+    // Sort the keys by bucket, preserving their order
+    array<uint16_t, BucketCount + 1> bucketStarts{ };
+    for (size_t i = 0; i < KeyCount; i++)
+        bucketStarts[getBucket(hashes[i], BucketCount) + 1]++;
+
+    size_t maxBucketSize = 0;
+    for (size_t i = 0; i < BucketCount; i++)
+    {
+        if (bucketStarts[i + 1] > maxBucketSize)
+            maxBucketSize = bucketStarts[i + 1];
+
+        bucketStarts[i + 1] += bucketStarts[i];
+    }
+
+    array<uint16_t, KeyCount> keys{ };
+    array<uint16_t, BucketCount> bucketFills{ };
+    for (size_t i = 0; i < KeyCount; i++)
+    {
+        uint32_t bucket = getBucket(hashes[i], BucketCount);
+        keys[bucketStarts[bucket] + bucketFills[bucket]] = (uint16_t)i;
+        bucketFills[bucket]++;
+    }
+
+    ret.IsPerfect = true;
+    for (size_t bucketSize = maxBucketSize; bucketSize != 0; bucketSize--)
+    {
+        for (size_t bucket = 0; bucket < BucketCount; bucket++)
+        {
+            size_t start = bucketStarts[bucket];
+            size_t end = bucketStarts[bucket + 1];
+            if (end - start != bucketSize)
+                continue;
+
+            uint16_t displacement = 0;
+            while (true)
+            {
+                // Tentatively occupy the slots of the keys of the bucket,
+                // releasing them if there's a collision
+                size_t placed = start;
+                for (; placed < end; placed++)
+                {
+                    uint32_t hash = hashes[keys[placed]];
+                    bool duplicate = false;
+                    for (size_t prev = start; prev < placed; prev++)
+                    {
+                        if (hashes[keys[prev]] == hash)
+                        {
+                            duplicate = true;
+                            break;
+                        }
+                    }
+
+                    if (duplicate)
+                        continue;
+
+                    uint32_t slot = getSlot(hash, displacement, SlotCount);
+                    if (ret.Slots[slot] != EmptySlot)
+                        break;
+
+                    ret.Slots[slot] = keys[placed];
+                }
+
+                if (placed == end)
+                    break;
+
+                for (size_t i = start; i < placed; i++)
+                {
+                    uint32_t slot = getSlot(hashes[keys[i]], displacement, SlotCount);
+                    if (ret.Slots[slot] == keys[i])
+                        ret.Slots[slot] = EmptySlot;
+                }
+
+                if (displacement == MaxDisplacement)
+                {
+                    ret.IsPerfect = false;
+                    return ret;
+                }
+
+                displacement++;
+            }
+
+            ret.Displacements[bucket] = displacement;
+        }
+    }
+
+    return ret;
+}
+
+static constexpr array<uint32_t, NameEntryCount> getNameHashes()
+{
+    array<uint32_t, NameEntryCount> ret{ };
+    for (size_t i = 0; i < NameEntryCount; i++)
+        ret[i] = hashGlyphName(nameToUnicodeTab[i].name);
+
+    return ret;
+}
+
+// The entries of the canonical table come first, so
+// they take precedence over the complete list
+static constexpr const GlyphNameEntry& getCodePointEntry(size_t index)
+{
+    if (index < size(UnicodeToNameTab))
+        return UnicodeToNameTab[index];
+    else
+        return nameToUnicodeTab[index - size(UnicodeToNameTab)];
+}
+
+static constexpr array<uint32_t, CodePointEntryCount> getCodePointHashes()
+{
+    array<uint32_t, CodePointEntryCount> ret{ };
+    for (size_t i = 0; i < CodePointEntryCount; i++)
+        ret[i] = (uint32_t)getCodePointEntry(i).u;
+
+    return ret;
+}
+
+static constexpr auto s_nameHashTable = createGlyphHashTable<512, 2048>(getNameHashes());
+static_assert(s_nameHashTable.IsPerfect, "Could not build the glyph name perfect hash table");
+
+static constexpr auto s_codePointHashTable = createGlyphHashTable<1024, 4096>(getCodePointHashes());
+static_assert(s_codePointHashTable.IsPerfect, "Could not build the code point perfect hash table");
+
+// Get the index of the only entry that may match the key with given hash
+template <size_t BucketCount, size_t SlotCount>
+static uint16_t findGlyphEntry(const GlyphHashTable<BucketCount, SlotCount>& table, uint32_t hash)
+{
+    return table.Slots[getSlot(hash, table.Displacements[getBucket(hash, BucketCount)], SlotCount)];
+}
+
 PdfDifferenceList::PdfDifferenceList() { }
 
 void PdfDifferenceList::AddDifference(unsigned char code, char32_t codePoint)
@@ -2650,11 +2845,9 @@ char32_t PdfDifferenceEncoding::NameToCodePoint(const PdfName& name)
 
 char32_t PdfDifferenceEncoding::NameToCodePoint(const string_view& name)
 {
-    for (unsigned i = 0; nameToUnicodeTab[i].name != nullptr; i++)
-    {
-        if (nameToUnicodeTab[i].name == name)
-            return nameToUnicodeTab[i].u;
-    }
+    uint16_t index = findGlyphEntry(s_nameHashTable, hashGlyphName(name));
+    if (index != EmptySlot && nameToUnicodeTab[index].name == name)
+        return nameToUnicodeTab[index].u;
 
     // if we get here, then we might be looking up an undefined codepoint
     // so try looking for our special format..
@@ -2674,18 +2867,10 @@ char32_t PdfDifferenceEncoding::NameToCodePoint(const string_view& name)
 
 PdfName PdfDifferenceEncoding::CodePointToName(char32_t inCodePoint)
 {
-    for (unsigned i = 0; UnicodeToNameTab[i].name; i++)
-    {
-        if (UnicodeToNameTab[i].u == inCodePoint)
-            return PdfName(UnicodeToNameTab[i].name);
-    }
-
-    // if we can't find in the canonical list, look in the complete list
-    for (unsigned i = 0; nameToUnicodeTab[i].name; i++)
-    {
-        if (nameToUnicodeTab[i].u == inCodePoint)
-            return PdfName(nameToUnicodeTab[i].name);
-    }
+    // Look in the canonical list first, then in the complete list
+    uint16_t index = findGlyphEntry(s_codePointHashTable, (uint32_t)inCodePoint);
+    if (index != EmptySlot && getCodePointEntry(index).u == inCodePoint)
+        return PdfName(getCodePointEntry(index).name);
 
     // if we get here, then we are looking up an undefined codepoint
     // so we'll just give it an arbitrary name..
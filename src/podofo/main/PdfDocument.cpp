@@ -6,9 +6,11 @@
 
 #include <podofo/private/PdfDeclarationsPrivate.h>
 #include <podofo/private/XMPUtils.h>
+#include <podofo/private/ParallelUtils.h>
 #include "PdfDocument.h"
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
 
 #include "PdfArray.h"
@@ -32,6 +34,9 @@
 using namespace std;
 using namespace PoDoFo;
 
+template <typename TWorkerState, typename TProcess>
+static void processPagesParallel(unsigned pageCount, unsigned threadCount, const TProcess& process);
+
 PdfDocument::PdfDocument(bool empty) :
     m_Objects(*this),
     m_Metadata(*this),
@@ -79,6 +84,9 @@ void PdfDocument::Clear()
     m_AcroForm = nullptr;
     m_Outlines = nullptr;
     m_NameTree = nullptr;
+    if (m_FormCache != nullptr)
+        m_FormCache->Clear();
+
     m_Objects.Clear();
     m_Objects.SetCanReuseObjectNumbers(true);
     clear();
@@ -496,6 +504,64 @@ void PdfDocument::fixObjectReferences(PdfObject& obj, int difference)
 void PdfDocument::CollectGarbage()
 {
     m_Objects.CollectGarbage();
+
+    // Object numbers of removed forms may be reused
+    if (m_FormCache != nullptr)
+        m_FormCache->Clear();
+}
+
+void PdfDocument::SetXObjectFormCacheSize(size_t maxSize)
+{
+    if (maxSize == 0)
+        m_FormCache = nullptr;
+    else
+        m_FormCache.reset(new PdfXObjectFormCache(maxSize));
+}
+
+void PdfDocument::ExtractTextTo(vector<PdfTextEntry>& entries, const PdfTextExtractParams& params,
+    unsigned threadCount) const
+{
+    ExtractTextTo(entries, { }, params, threadCount);
+}
+
+void PdfDocument::ExtractTextTo(vector<PdfTextEntry>& entries, const string_view& pattern,
+    const PdfTextExtractParams& params, unsigned threadCount) const
+{
+    // NOTE: Get the page count first, so the lazily
+    // loaded page tree is initialized on this thread
+    auto& pages = GetPages();
+    unsigned pageCount = pages.GetCount();
+    vector<vector<PdfTextEntry>> pageEntries(pageCount);
+    // Every worker loads its own fonts, since
+    // they lazily initialize internal state
+    processPagesParallel<PdfPage::FontCache>(pageCount, threadCount,
+        [&](unsigned i, PdfPage::FontCache& fonts) {
+            pages.GetPageAt(i).extractTextTo(pageEntries[i], pattern, params, &fonts);
+        });
+
+    for (auto& page : pageEntries)
+    {
+        entries.insert(entries.end(), std::make_move_iterator(page.begin()),
+            std::make_move_iterator(page.end()));
+    }
+}
+
+void PdfDocument::SearchTextTo(vector<PdfTextMatch>& matches, const PdfTextMatcher& matcher,
+    const PdfTextExtractParams& params, unsigned threadCount) const
+{
+    auto& pages = GetPages();
+    unsigned pageCount = pages.GetCount();
+    vector<vector<PdfTextMatch>> pageMatches(pageCount);
+    processPagesParallel<PdfPage::FontCache>(pageCount, threadCount,
+        [&](unsigned i, PdfPage::FontCache& fonts) {
+            pages.GetPageAt(i).searchTextTo(pageMatches[i], matcher, params, &fonts);
+        });
+
+    for (auto& page : pageMatches)
+    {
+        matches.insert(matches.end(), std::make_move_iterator(page.begin()),
+            std::make_move_iterator(page.end()));
+    }
 }
 
 PdfOutlines& PdfDocument::GetOrCreateOutlines()
@@ -691,3 +757,38 @@ unique_ptr<PdfFileSpec> PdfDocument::CreateFileSpec()
 {
     return unique_ptr<PdfFileSpec>(new PdfFileSpec(*this));
 }
+
+// Process the pages concurrently, with a state local to every worker.
+// The error of the first failing page is rethrown, if any, so the
+// outcome doesn't depend on thread scheduling
+template <typename TWorkerState, typename TProcess>
+void processPagesParallel(unsigned pageCount, unsigned threadCount, const TProcess& process)
+{
+    vector<exception_ptr> errors(pageCount);
+    atomic<unsigned> next(0);
+    threadCount = std::min(utls::GetWorkerThreadCount(threadCount), std::max(pageCount, 1u));
+    utls::ParallelFor(threadCount, threadCount, [&](size_t) {
+        TWorkerState state;
+        while (true)
+        {
+            unsigned i = next.fetch_add(1, memory_order_relaxed);
+            if (i >= pageCount)
+                break;
+
+            try
+            {
+                process(i, state);
+            }
+            catch (...)
+            {
+                errors[i] = current_exception();
+            }
+        }
+    });
+
+    for (unsigned i = 0; i < pageCount; i++)
+    {
+        if (errors[i] != nullptr)
+            rethrow_exception(errors[i]);
+    }
+}
@@ -17,6 +17,7 @@
 #include "PdfNameTree.h"
 #include "PdfXObjectForm.h"
 #include "PdfImage.h"
+#include "PdfXObjectFormCache.h"
 
 namespace PoDoFo {
 
@@ -47,6 +48,7 @@ class PODOFO_API PdfDocument
     friend class PdfMetadata;
     friend class PdfXObjectForm;
     friend class PdfPageCollection;
+    friend class PdfContentStreamReader;
 
 public:
     /** Close down/destruct the PdfDocument
@@ -293,6 +295,46 @@ public:
 
     PdfFontManager& GetFonts() { return m_FontManager; }
 
+    /** Enable a cache of the tokenized contents of XObject forms,
+     * used by all the PdfContentStreamReader instances reading the
+     * contents of this document, e.g. during text extraction. Forms
+     * invoked many times, like letterheads or stamps, are then
+     * parsed only once
+     * \param maxSize approximate maximum memory size of the cache
+     *  in bytes. 0 disables the cache, which is the default
+     * \remarks Forms are cached by reference, so the cache must be
+     *  cleared with PdfXObjectFormCache::Clear() if forms are modified
+     */
+    void SetXObjectFormCacheSize(size_t maxSize);
+
+    /** Get the XObject form cache, or nullptr if not enabled
+     */
+    PdfXObjectFormCache* GetXObjectFormCache() const { return m_FormCache.get(); }
+
+    void ExtractTextTo(std::vector<PdfTextEntry>& entries, const PdfTextExtractParams& params,
+        unsigned threadCount = 0) const;
+
+    /** Extract the text of all the pages, processing them concurrently
+     * \param entries the extracted entries are appended here, in page order
+     * \param threadCount number of threads to use, including the calling
+     *  one. 0 means the number of hardware threads available
+     * \remarks The document must not be modified during the extraction.
+     *  The XObject form cache, if enabled, is shared by all the threads
+     * \see PdfPage::ExtractTextTo()
+     */
+    void ExtractTextTo(std::vector<PdfTextEntry>& entries, const std::string_view& pattern = { },
+        const PdfTextExtractParams& params = { }, unsigned threadCount = 0) const;
+
+    /** Search all the keywords of the matcher in all the pages,
+     * processing them concurrently
+     * \param matches the occurrences are appended here, in page order
+     * \param threadCount number of threads to use, including the calling
+     *  one. 0 means the number of hardware threads available
+     * \see PdfPage::SearchTextTo()
+     */
+    void SearchTextTo(std::vector<PdfTextMatch>& matches, const PdfTextMatcher& matcher,
+        const PdfTextExtractParams& params = { }, unsigned threadCount = 0) const;
+
 protected:
     /** Construct a new (empty) PdfDocument
      *  \param empty if true NO default objects (such as catalog) are created.
@@ -374,6 +416,7 @@ private:
     std::unique_ptr<PdfAcroForm> m_AcroForm;
     std::unique_ptr<PdfOutlines> m_Outlines;
     std::unique_ptr<PdfNameTree> m_NameTree;
+    std::shared_ptr<PdfXObjectFormCache> m_FormCache;
 };
 
 template<typename Taction>
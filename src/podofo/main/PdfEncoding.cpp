@@ -8,6 +8,7 @@
 #include "PdfEncoding.h"
 
 #include <atomic>
+#include <bitset>
 #include <utf8cpp/utf8.h>
 
 #include <podofo/private/PdfEncodingPrivate.h>
@@ -26,9 +27,37 @@ namespace PoDoFo
     public:
         PdfDynamicEncodingMap(const shared_ptr<PdfCharCodeMap>& map);
     };
+
+    /** Precomputed conversions of an encoding with one byte codes,
+     * so strings can be converted without querying the maps
+     */
+    struct PdfOneByteConversionTable
+    {
+        // The UTF-8 text of every code is Utf8Data[Utf8Offsets[code], Utf8Offsets[code + 1])
+        uint32_t Utf8Offsets[257];
+        string Utf8Data;
+        bitset<256> Unmapped;           // Codes decoded with the fallback
+        int16_t Latin1Codes[256];       // Codes of the code points up to U+00FF, or -1
+        vector<pair<char32_t, unsigned char>> OtherCodes; // Codes of the other code points, sorted
+        bool CanEncode;                 // False if some code point maps to a multi byte code
+
+        int GetCode(char32_t codePoint) const
+        {
+            if (codePoint < 256)
+                return Latin1Codes[codePoint];
+
+            auto found = std::lower_bound(OtherCodes.begin(), OtherCodes.end(), codePoint,
+                [](const pair<char32_t, unsigned char>& entry, char32_t cp) { return entry.first < cp; });
+            if (found == OtherCodes.end() || found->first != codePoint)
+                return -1;
+
+            return found->second;
+        }
+    };
 }
 
 static PdfCharCode fetchFallbackCharCode(string_view::iterator& it, const string_view::iterator& end, const PdfEncodingLimits& limits);
+static void buildOneByteTable(const PdfEncodingMap& map, PdfOneByteConversionTable& table);
 
 PdfEncoding::PdfEncoding()
     : PdfEncoding(NullEncodingId, PdfEncodingMapFactory::GetNullEncodingMap(), nullptr)
@@ -43,7 +72,7 @@ PdfEncoding::PdfEncoding(const PdfEncodingMapConstPtr& encoding, const PdfToUnic
 }
 
 PdfEncoding::PdfEncoding(unsigned id, const PdfEncodingMapConstPtr& encoding, const PdfEncodingMapConstPtr& toUnicode)
-    : m_Id(id), m_Font(nullptr), m_Encoding(encoding), m_ToUnicode(toUnicode)
+    : m_Id(id), m_Font(nullptr), m_Encoding(encoding), m_ToUnicode(toUnicode), m_OneByteTableInit(false)
 {
     if (encoding == nullptr)
         PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Main encoding must be not null");
@@ -51,7 +80,8 @@ PdfEncoding::PdfEncoding(unsigned id, const PdfEncodingMapConstPtr& encoding, co
 
 PdfEncoding::PdfEncoding(unsigned id, const PdfEncodingLimits& limits, PdfFont* font,
         const PdfEncodingMapConstPtr& encoding, const PdfEncodingMapConstPtr& toUnicode)
-    : m_Id(id), m_ParsedLimits(limits), m_Font(font), m_Encoding(encoding), m_ToUnicode(toUnicode)
+    : m_Id(id), m_ParsedLimits(limits), m_Font(font), m_Encoding(encoding), m_ToUnicode(toUnicode),
+    m_OneByteTableInit(false)
 {
 }
 
@@ -133,6 +163,22 @@ bool PdfEncoding::TryConvertToEncoded(const string_view& str, charbuff& encoded)
 
         auto it = str.begin();
         auto end = str.end();
+        auto table = getOneByteTable();
+        if (table != nullptr && table->CanEncode && !toUnicode->HasLigaturesSupport())
+        {
+            encoded.reserve(str.size());
+            while (it != end)
+            {
+                int code = table->GetCode((char32_t)utf8::next(it, end));
+                if (code < 0)
+                    return false;
+
+                encoded.push_back((char)code);
+            }
+
+            return true;
+        }
+
         while (it != end)
         {
             PdfCharCode code;
@@ -152,6 +198,29 @@ bool PdfEncoding::TryConvertToEncoded(const string_view& str, charbuff& encoded)
         auto& metrics = m_Font->GetMetrics();
         auto it = str.begin();
         auto end = str.end();
+        auto table = getOneByteTable();
+        if (table != nullptr && table->CanEncode && !m_Font->IsSubsettingEnabled())
+        {
+            // The code points are mapped one by one to the
+            // codes of the encoding, no need to collect them
+            encoded.reserve(str.size());
+            while (it != end)
+            {
+                char32_t cp = utf8::next(it, end);
+                unsigned gid;
+                if (!metrics.TryGetGID(cp, gid))
+                    return false;
+
+                int code = table->GetCode(cp);
+                if (code < 0)
+                    return false;
+
+                encoded.push_back((char)code);
+            }
+
+            return true;
+        }
+
         vector<unsigned> gids;
         vector<char32_t> cps;   // Code points
         while (it != end)
@@ -219,6 +288,22 @@ bool PdfEncoding::tryConvertEncodedToUtf8(const string_view& encoded, string& st
     if (encoded.empty())
         return true;
 
+    auto table = getOneByteTable();
+    if (table != nullptr)
+    {
+        str.reserve(encoded.size());
+        bool unmapped = false;
+        for (char ch : encoded)
+        {
+            unsigned code = (unsigned char)ch;
+            unsigned offset = table->Utf8Offsets[code];
+            str.append(table->Utf8Data.data() + offset, table->Utf8Offsets[code + 1] - offset);
+            unmapped |= table->Unmapped[code];
+        }
+
+        return !unmapped;
+    }
+
     auto& map = GetToUnicodeMapSafe();
     auto& limits = map.GetLimits();
     bool success = true;
@@ -248,6 +333,27 @@ bool PdfEncoding::tryConvertEncodedToUtf8(const string_view& encoded, string& st
     return success;
 }
 
+const PdfOneByteConversionTable* PdfEncoding::getOneByteTable() const
+{
+    if (!m_OneByteTableInit)
+    {
+        // Dynamic encodings can still change, and maps
+        // with longer codes don't fit the table
+        auto& map = GetToUnicodeMapSafe();
+        if (!IsDynamicEncoding() && map.GetLimits().MinCodeSize == 1
+            && map.GetLimits().MaxCodeSize == 1)
+        {
+            auto table = std::make_shared<PdfOneByteConversionTable>();
+            buildOneByteTable(map, *table);
+            m_OneByteTable = std::move(table);
+        }
+
+        m_OneByteTableInit = true;
+    }
+
+    return m_OneByteTable.get();
+}
+
 vector<PdfCID> PdfEncoding::ConvertToCIDs(const PdfString& encodedStr) const
 {
     // Just ignore failures
@@ -759,3 +865,53 @@ bool PdfStringScanContext::TryScan(PdfCID& cid, string& utf8str, vector<codepoin
 
 PdfDynamicEncodingMap::PdfDynamicEncodingMap(const shared_ptr<PdfCharCodeMap>& map)
     : PdfEncodingMapBase(map, PdfEncodingMapType::CMap) { }
+
+// Precompute the same conversions done by the map, with the
+// same fallback of tryConvertEncodedToUtf8() for unmapped codes
+void buildOneByteTable(const PdfEncodingMap& map, PdfOneByteConversionTable& table)
+{
+    std::fill(std::begin(table.Latin1Codes), std::end(table.Latin1Codes), (int16_t)-1);
+    table.CanEncode = true;
+    vector<char32_t> codePoints;
+    PdfCharCode codeUnit;
+    for (unsigned code = 0; code < 256; code++)
+    {
+        table.Utf8Offsets[code] = (uint32_t)table.Utf8Data.size();
+        if (!map.TryGetCodePoints(PdfCharCode(code, 1), codePoints))
+        {
+            table.Unmapped[code] = true;
+            codePoints.clear();
+            codePoints.push_back((char32_t)code);
+        }
+
+        for (size_t i = 0; i < codePoints.size(); i++)
+        {
+            char32_t codePoint = codePoints[i];
+            if (codePoint != U'\0' && utf8::internal::is_code_point_valid(codePoint))
+                utf8::unchecked::append((uint32_t)codePoint, std::back_inserter(table.Utf8Data));
+        }
+
+        // The reverse mappings are the ones of the map itself,
+        // for all the code points mapped by some code
+        if (table.Unmapped[code] || codePoints.size() != 1
+            || !map.TryGetCharCode(codePoints[0], codeUnit))
+        {
+            continue;
+        }
+
+        if (codeUnit.CodeSpaceSize != 1 || codeUnit.Code > 0xFF)
+        {
+            table.CanEncode = false;
+            continue;
+        }
+
+        if (codePoints[0] < 256)
+            table.Latin1Codes[codePoints[0]] = (int16_t)codeUnit.Code;
+        else
+            table.OtherCodes.push_back({ codePoints[0], (unsigned char)codeUnit.Code });
+    }
+
+    table.Utf8Offsets[256] = (uint32_t)table.Utf8Data.size();
+    std::sort(table.OtherCodes.begin(), table.OtherCodes.end());
+    table.OtherCodes.erase(std::unique(table.OtherCodes.begin(), table.OtherCodes.end()), table.OtherCodes.end());
+}
@@ -16,6 +16,7 @@ namespace PoDoFo
     class PdfFont;
     class PdfEncoding;
     class PdfFontSimple;
+    struct PdfOneByteConversionTable;
 
     /** A PDF string context to iteratively scan a string
      * and collect both CID and unicode codepoints
@@ -23,6 +24,7 @@ namespace PoDoFo
     class PODOFO_API PdfStringScanContext
     {
         friend class PdfEncoding;
+        friend class PdfFont;
 
     private:
         PdfStringScanContext(const std::string_view& encodedstr, const PdfEncoding& encoding);
@@ -57,6 +59,7 @@ namespace PoDoFo
         friend class PdfFont;
         friend class PdfFontCID;
         friend class PdfFontCIDTrueType;
+        friend class PdfFontCIDType1;
         friend class PdfFontSimple;
 
     public:
@@ -216,6 +219,7 @@ namespace PoDoFo
         void writeCIDMapping(PdfObject& cmapObj, const PdfFont& font, const std::string_view& baseFont) const;
         void writeToUnicodeCMap(PdfObject& cmapObj) const;
         bool tryGetCharCode(PdfFont& font, unsigned gid, const unicodeview& codePoints, PdfCharCode& unit) const;
+        const PdfOneByteConversionTable* getOneByteTable() const;
 
     private:
         unsigned m_Id;
@@ -223,6 +227,9 @@ namespace PoDoFo
         PdfFont* m_Font;
         PdfEncodingMapConstPtr m_Encoding;
         PdfEncodingMapConstPtr m_ToUnicode;
+        // Lazily built conversion table, for one byte ToUnicode maps
+        mutable std::shared_ptr<const PdfOneByteConversionTable> m_OneByteTable;
+        mutable bool m_OneByteTableInit;
     };
 }
 
@@ -11,6 +11,7 @@
 
 #include "PdfObject.h"
 #include "PdfDictionary.h"
+#include "PdfArray.h"
 #include "PdfEncodingMapFactory.h"
 #include "PdfIdentityEncoding.h"
 #include "PdfDifferenceEncoding.h"
@@ -28,15 +29,19 @@ PdfEncoding PdfEncodingFactory::CreateEncoding(const PdfObject& fontObj, const P
 
     auto encodingObj = fontObj.GetDictionary().FindKey("Encoding");
     if (encodingObj != nullptr)
+    {
         encoding = createEncodingMap(*encodingObj, metrics);
 
+        // Other names can be predefined CJK CMaps, which are
+        // valid only as /Encoding and never as /ToUnicode
+        if (encoding == nullptr && encodingObj->IsName())
+            encoding = PdfEncodingMapFactory::GetPredefinedCMap(encodingObj->GetName());
+    }
+
     PdfEncodingMapConstPtr implicitEncoding;
     if (encoding == nullptr && metrics.TryGetImplicitEncoding(implicitEncoding))
         encoding = implicitEncoding;
 
-    // TODO: Implement full text extraction, including search in predefined
-    // CMap(s) as described in Pdf Reference and here https://stackoverflow.com/a/26910569/213871
-
     // The /ToUnicode CMap is the main entry to search
     // for text extraction
     PdfEncodingMapConstPtr toUnicode;
@@ -44,6 +49,14 @@ PdfEncoding PdfEncodingFactory::CreateEncoding(const PdfObject& fontObj, const P
     if (toUnicodeObj != nullptr)
         toUnicode = createEncodingMap(*toUnicodeObj, metrics);
 
+    if (toUnicode == nullptr && encodingObj != nullptr && encodingObj->IsName())
+    {
+        // Search the predefined CMap(s) as described in Pdf Reference
+        // 1.7 "5.9.1 Mapping Character Codes to Unicode Values" and
+        // here https://stackoverflow.com/a/26910569/213871
+        toUnicode = getPredefinedToUnicodeMap(fontObj, encodingObj->GetName());
+    }
+
     if (encoding == nullptr)
     {
         if (toUnicode == nullptr)
@@ -107,6 +120,48 @@ PdfEncodingMapConstPtr PdfEncodingFactory::createEncodingMap(
     return nullptr;
 }
 
+PdfEncodingMapConstPtr PdfEncodingFactory::getPredefinedToUnicodeMap(
+    const PdfObject& fontObj, const PdfName& encodingName)
+{
+    if (encodingName != "Identity-H" && encodingName != "Identity-V")
+        return PdfEncodingMapFactory::GetPredefinedToUnicodeMap(encodingName);
+
+    // The codes of the identity CMaps are the CIDs of the descendant
+    // font. If they belong to an Adobe character collection, they
+    // can be mapped with the "Adobe-<Ordering>-UCS2" CMap
+    auto descendantsObj = fontObj.GetDictionary().FindKey("DescendantFonts");
+    const PdfArray* descendants;
+    if (descendantsObj == nullptr
+        || !descendantsObj->TryGetArray(descendants)
+        || descendants->GetSize() == 0)
+    {
+        return nullptr;
+    }
+
+    auto descendantObj = descendants->FindAt(0);
+    const PdfDictionary* descendant;
+    if (descendantObj == nullptr || !descendantObj->TryGetDictionary(descendant))
+        return nullptr;
+
+    auto cidSystemInfoObj = descendant->FindKey("CIDSystemInfo");
+    const PdfDictionary* cidSystemInfo;
+    if (cidSystemInfoObj == nullptr || !cidSystemInfoObj->TryGetDictionary(cidSystemInfo))
+        return nullptr;
+
+    auto registryObj = cidSystemInfo->FindKey("Registry");
+    auto orderingObj = cidSystemInfo->FindKey("Ordering");
+    const PdfString* registry;
+    const PdfString* ordering;
+    if (registryObj == nullptr || !registryObj->TryGetString(registry)
+        || orderingObj == nullptr || !orderingObj->TryGetString(ordering)
+        || registry->GetString() != "Adobe")
+    {
+        return nullptr;
+    }
+
+    return PdfEncodingMapFactory::GetPredefinedCMap(utls::Format("Adobe-{}-UCS2", ordering->GetString()));
+}
+
 PdfEncoding PdfEncodingFactory::CreateWinAnsiEncoding()
 {
     return PdfEncoding(WinAnsiEncodingId, PdfEncodingMapFactory::WinAnsiEncodingInstance());
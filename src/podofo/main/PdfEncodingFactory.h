@@ -58,6 +58,9 @@ private:
     static PdfEncodingMapConstPtr createEncodingMap(
         const PdfObject& obj, const PdfFontMetrics& metrics);
 
+    static PdfEncodingMapConstPtr getPredefinedToUnicodeMap(
+        const PdfObject& fontObj, const PdfName& encodingName);
+
 private:
     PdfEncodingFactory() = delete;
 };
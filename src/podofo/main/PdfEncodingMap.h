@@ -212,7 +212,7 @@ public:
 
     const PdfEncodingLimits& GetLimits() const override;
 
-private:
+protected:
     PdfEncodingMapBase(const std::shared_ptr<PdfCharCodeMap>& map, PdfEncodingMapType type);
 
 private:
@@ -9,6 +9,11 @@
 #include "PdfPredefinedEncoding.h"
 #include "PdfIdentityEncoding.h"
 #include "PdfDifferenceEncoding.h"
+#include "PdfCMapEncoding.h"
+
+#include <mutex>
+
+#include <podofo/private/PdfPredefinedCMapData.h>
 
 using namespace std;
 using namespace PoDoFo;
@@ -115,6 +120,81 @@ PdfEncodingMapConstPtr PdfEncodingMapFactory::GetStandard14FontEncodingMap(PdfSt
     }
 }
 
+PdfEncodingMapConstPtr PdfEncodingMapFactory::GetPredefinedCMap(const string_view& name)
+{
+    if (name == "Identity-H")
+        return TwoBytesHorizontalIdentityEncodingInstance();
+    else if (name == "Identity-V")
+        return TwoBytesVerticalIdentityEncodingInstance();
+
+    unsigned index;
+    if (!TryGetPredefinedCMap(name, index))
+        return nullptr;
+
+    return getPredefinedCMap(index);
+}
+
+PdfEncodingMapConstPtr PdfEncodingMapFactory::GetPredefinedToUnicodeMap(const string_view& cmapName)
+{
+    unsigned index;
+    if (!TryGetPredefinedCMap(cmapName, index))
+        return nullptr;
+
+    auto& info = GetPredefinedCMaps()[index];
+    unsigned cidToUnicodeIndex;
+    if (!TryGetPredefinedCMap(utls::Format("Adobe-{}-UCS2", info.Ordering), cidToUnicodeIndex)
+        || cidToUnicodeIndex == index)
+    {
+        // The CMap already maps to unicode
+        return nullptr;
+    }
+
+    static mutex s_mutex;
+    static unordered_map<unsigned, PdfEncodingMapConstPtr> s_maps;
+    unique_lock<mutex> lock(s_mutex);
+    auto found = s_maps.find(index);
+    if (found != s_maps.end())
+        return found->second;
+
+    // Compose the mappings from the codes to the CIDs
+    // of the collection with the ones from the CIDs to unicode
+    auto& cidMap = static_cast<const PdfCMapEncoding&>(*getPredefinedCMap(index)).GetCharMap();
+    auto& cidToUnicodeMap = static_cast<const PdfCMapEncoding&>(*getPredefinedCMap(cidToUnicodeIndex)).GetCharMap();
+    PdfCharCodeMap map;
+    vector<codepoint> codePoints;
+    for (auto& pair : cidMap)
+    {
+        if (pair.second.size() != 1
+            || !cidToUnicodeMap.TryGetCodePoints(PdfCharCode((unsigned)pair.second[0], 2), codePoints))
+        {
+            continue;
+        }
+
+        map.PushMapping(pair.first, codePoints);
+    }
+
+    auto charMap = std::make_shared<PdfCharCodeMap>(std::move(map));
+    PdfEncodingMapConstPtr ret(new PdfCMapEncoding(charMap, charMap->GetLimits()));
+    s_maps[index] = ret;
+    return ret;
+}
+
+PdfEncodingMapConstPtr PdfEncodingMapFactory::getPredefinedCMap(unsigned index)
+{
+    // NOTE: The predefined CMaps are decoded on first use
+    static mutex s_mutex;
+    static unordered_map<unsigned, PdfEncodingMapConstPtr> s_cmaps;
+    unique_lock<mutex> lock(s_mutex);
+    auto found = s_cmaps.find(index);
+    if (found != s_cmaps.end())
+        return found->second;
+
+    auto map = std::make_shared<PdfCharCodeMap>(DecodePredefinedCMap(index));
+    PdfEncodingMapConstPtr ret(new PdfCMapEncoding(map, map->GetLimits()));
+    s_cmaps[index] = ret;
+    return ret;
+}
+
 // https://en.wikipedia.org/wiki/PostScript_Latin_1_Encoding
 AppleLatin1Encoding::AppleLatin1Encoding()
     : PdfBuiltInEncoding("ISOLatin1Encoding")
@@ -58,6 +58,15 @@ public:
      */
     static PdfEncodingMapConstPtr TwoBytesVerticalIdentityEncodingInstance();
 
+    /** Get a global instance of the predefined CMap with the given name,
+     * such as "UniJIS-UTF16-H" or "90ms-RKSJ-H", mapping character codes
+     * to CIDs, or "Adobe-Japan1-UCS2", mapping CIDs to unicode
+     *
+     *  \returns global instance of the CMap or nullptr if the name is unknown
+     *  \remarks The mappings are bundled in a compact form and decoded on first use
+     */
+    static PdfEncodingMapConstPtr GetPredefinedCMap(const std::string_view& name);
+
     /** Return the encoding map for the given standard font type or nullptr for unknown
      */
     static PdfEncodingMapConstPtr GetStandard14FontEncodingMap(PdfStandard14FontType stdFont);
@@ -76,6 +85,14 @@ private:
     static PdfBuiltInEncodingConstPtr AppleLatin1EncodingInstance();
 
     static PdfEncodingMapConstPtr GetNullEncodingMap();
+
+    /** Get a global instance of the map from the character codes of
+     * the predefined CMap with the given name to unicode, through the
+     * CIDs of its Adobe character collection, or nullptr if not available
+     */
+    static PdfEncodingMapConstPtr GetPredefinedToUnicodeMap(const std::string_view& cmapName);
+
+    static PdfEncodingMapConstPtr getPredefinedCMap(unsigned index);
 };
 
 }
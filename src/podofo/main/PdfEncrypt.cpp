@@ -129,6 +129,9 @@ private:
 #define AES_IV_LENGTH 16
 #define AES_BLOCK_SIZE 16
 
+// Size of the chunks processed at once by encryption streams
+#define STREAM_CHUNK_SIZE 4096
+
 namespace PoDoFo
 {
 
@@ -155,31 +158,6 @@ private:
     EVP_CIPHER_CTX *aes;
 };
 
-// A class that holds the RC4 Crypto object
-// Either CCCrpytor or EVP_CIPHER_CTX
-class RC4CryptoEngine
-{
-public:
-
-    RC4CryptoEngine()
-    {
-        rc4 = EVP_CIPHER_CTX_new();
-    }
-
-    EVP_CIPHER_CTX* getEngine()
-    {
-        return rc4;
-    }
-
-    ~RC4CryptoEngine()
-    {
-        EVP_CIPHER_CTX_free(rc4);
-    }
-
-private:
-    EVP_CIPHER_CTX* rc4;
-};
-    
 /** A class that can encrypt/decrpyt streamed data block wise
  *  This is used in the input and output stream encryption implementation.
  *  Only the RC4 encryption algorithm is supported
@@ -187,34 +165,23 @@ private:
 class PdfRC4Stream
 {
 public:
-    PdfRC4Stream(unsigned char rc4key[256], unsigned char rc4last[256],
-        unsigned char* key, unsigned keylen) :
+    PdfRC4Stream(const unsigned char* key, unsigned keylen) :
         m_a(0), m_b(0)
     {
         size_t i;
         size_t j;
         size_t t;
 
-        if (std::memcmp(key, rc4key, keylen) != 0)
-        {
-            for (i = 0; i < 256; i++)
-                m_rc4[i] = static_cast<unsigned char>(i);
-
-            j = 0;
-            for (i = 0; i < 256; i++)
-            {
-                t = static_cast<size_t>(m_rc4[i]);
-                j = (j + t + static_cast<size_t>(key[i % keylen])) % 256;
-                m_rc4[i] = m_rc4[j];
-                m_rc4[j] = static_cast<unsigned char>(t);
-            }
+        for (i = 0; i < 256; i++)
+            m_rc4[i] = static_cast<unsigned char>(i);
 
-            std::memcpy(rc4key, key, keylen);
-            std::memcpy(rc4last, m_rc4, 256);
-        }
-        else
+        j = 0;
+        for (i = 0; i < 256; i++)
         {
-            std::memcpy(m_rc4, rc4last, 256);
+            t = static_cast<size_t>(m_rc4[i]);
+            j = (j + t + static_cast<size_t>(key[i % keylen])) % 256;
+            m_rc4[i] = m_rc4[j];
+            m_rc4[j] = static_cast<unsigned char>(t);
         }
     }
 
@@ -263,27 +230,52 @@ private:
 /** An OutputStream that encrypt all data written
  *  using the RC4 encryption algorithm
  */
-class PdfRC4OutputStream : public OutputStream
+class PdfRC4OutputStream : public PdfEncryptOutputStream
 {
 public:
-    PdfRC4OutputStream(OutputStream& outputStream, unsigned char rc4key[256],
-        unsigned char rc4last[256], unsigned char* key, unsigned keylen) :
-        m_OutputStream(&outputStream), m_stream(rc4key, rc4last, key, keylen)
+    PdfRC4OutputStream(OutputStream& outputStream, const unsigned char* key, unsigned keylen) :
+        m_OutputStream(&outputStream), m_stream(key, keylen), m_closed(false)
+    {
+    }
+
+    void Close() override
+    {
+        // RC4 has no final data to write
+        m_closed = true;
+    }
+
+protected:
+    void checkWrite() const override
     {
+        if (m_closed)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Can't write to a closed encryption stream");
     }
 
     void writeBuffer(const char* buffer, size_t size) override
     {
-        charbuff outputBuffer(size);
-        std::memcpy(outputBuffer.data(), buffer, size);
+        // Encrypt in fixed size chunks, so we never allocate
+        // a copy of the whole written data
+        while (size != 0)
+        {
+            size_t chunkSize = std::min(size, (size_t)STREAM_CHUNK_SIZE);
+            std::memcpy(m_buffer, buffer, chunkSize);
+            m_stream.Encrypt(m_buffer, chunkSize);
+            m_OutputStream->Write(m_buffer, chunkSize);
+            buffer += chunkSize;
+            size -= chunkSize;
+        }
+    }
 
-        m_stream.Encrypt(outputBuffer.data(), size);
-        m_OutputStream->Write(outputBuffer.data(), size);
+    void flush() override
+    {
+        Flush(*m_OutputStream);
     }
 
 private:
     OutputStream* m_OutputStream;
     PdfRC4Stream m_stream;
+    bool m_closed;
+    char m_buffer[STREAM_CHUNK_SIZE];
 };
 
 /** An InputStream that decrypts all data read
@@ -292,11 +284,10 @@ private:
 class PdfRC4InputStream : public InputStream
 {
 public:
-    PdfRC4InputStream(InputStream& inputStream, size_t inputLen, unsigned char rc4key[256], unsigned char rc4last[256],
-        unsigned char* key, unsigned keylen) :
+    PdfRC4InputStream(InputStream& inputStream, size_t inputLen, const unsigned char* key, unsigned keylen) :
         m_InputStream(&inputStream),
         m_inputLen(inputLen),
-        m_stream(rc4key, rc4last, key, keylen) { }
+        m_stream(key, keylen) { }
 
 protected:
     size_t readBuffer(char* buffer, size_t size, bool& eof) override
@@ -316,19 +307,39 @@ private:
     PdfRC4Stream m_stream;
 };
 
+static const EVP_CIPHER* getAESCipher(unsigned keyLen)
+{
+    switch (keyLen)
+    {
+        case (unsigned)PdfKeyLength::L128 / 8:
+            return s_SSL.Aes128;
+#ifdef PODOFO_HAVE_LIBIDN
+        case (unsigned)PdfKeyLength::L256 / 8:
+            return s_SSL.Aes256;
+#endif
+        default:
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Invalid AES key length");
+    }
+}
+
 /** A PdfAESInputStream that decrypts all data read
  *  using the AES encryption algorithm
+ *
+ *  Data is decrypted block wise in fixed size chunks: only
+ *  the last block, which contains the padding, is held back
+ *  by the cipher until the input is exhausted
  */
 class PdfAESInputStream : public InputStream
 {
 public:
-    PdfAESInputStream(InputStream& inputStream, size_t inputLen, unsigned char* key, unsigned keylen) :
+    PdfAESInputStream(InputStream& inputStream, size_t inputLen, const unsigned char* key, unsigned keylen) :
         m_InputStream(&inputStream),
         m_inputLen(inputLen),
         m_inputEof(false),
         m_init(true),
         m_keyLen(keylen),
-        m_drainLeft(0)
+        m_outputOffset(0),
+        m_outputLen(0)
     {
         m_ctx = EVP_CIPHER_CTX_new();
         if (m_ctx == nullptr)
@@ -340,47 +351,22 @@ public:
     ~PdfAESInputStream()
     {
         EVP_CIPHER_CTX_free(m_ctx);
+        OPENSSL_cleanse(m_key, sizeof(m_key));
     }
 
 protected:
     size_t readBuffer(char* buffer, size_t len, bool& eof) override
     {
-        int outlen = 0;
-        size_t drainLen;
-        size_t read;
-        if (m_inputEof)
-            goto DrainBuffer;
-
-        int rc;
         if (m_init)
         {
             // Read the initialization vector separately first
-            char iv[AES_IV_LENGTH];
+            unsigned char iv[AES_IV_LENGTH];
             bool streameof;
-            read = ReadBuffer(*m_InputStream, iv, AES_IV_LENGTH, streameof);
+            size_t read = ReadBuffer(*m_InputStream, (char*)iv, AES_IV_LENGTH, streameof);
             if (read != AES_IV_LENGTH)
                 PODOFO_RAISE_ERROR_INFO(PdfErrorCode::UnexpectedEOF, "Can't read enough bytes for AES IV");
 
-            const EVP_CIPHER* cipher;
-            switch (m_keyLen)
-            {
-                case (size_t)PdfKeyLength::L128 / 8:
-                {
-                    cipher = s_SSL.Aes128;
-                    break;
-                }
-#ifdef PODOFO_HAVE_LIBIDN
-                case (size_t)PdfKeyLength::L256 / 8:
-                {
-                    cipher = s_SSL.Aes256;
-                    break;
-                }
-#endif
-                default:
-                    PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Invalid AES key length");
-            }
-
-            rc = EVP_DecryptInit_ex(m_ctx, cipher, nullptr, m_key, (unsigned char*)iv);
+            int rc = EVP_DecryptInit_ex(m_ctx, getAESCipher(m_keyLen), nullptr, m_key, iv);
             if (rc != 1)
                 PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing AES encryption engine");
 
@@ -388,48 +374,43 @@ protected:
             m_init = false;
         }
 
+        // Refill the decrypted chunk buffer only when it has been fully drained
+        while (m_outputOffset == m_outputLen && !m_inputEof)
+            decryptNextChunk();
+
+        size_t count = std::min(len, m_outputLen - m_outputOffset);
+        std::memcpy(buffer, m_outputBuffer + m_outputOffset, count);
+        m_outputOffset += count;
+        eof = m_inputEof && m_outputOffset == m_outputLen;
+        return count;
+    }
+
+private:
+    void decryptNextChunk()
+    {
         bool streameof;
-        read = ReadBuffer(*m_InputStream, buffer, std::min(len, m_inputLen), streameof);
+        size_t read = ReadBuffer(*m_InputStream, (char*)m_inputBuffer,
+            std::min((size_t)STREAM_CHUNK_SIZE, m_inputLen), streameof);
         m_inputLen -= read;
 
         // Quote openssl.org: "the decrypted data buffer out passed to EVP_DecryptUpdate() should have sufficient room
         //  for (inl + cipher_block_size) bytes unless the cipher block size is 1 in which case inl bytes is sufficient."
-        // So we need to create a buffer that is bigger than len.
-        m_tempBuffer.resize(len + AES_BLOCK_SIZE);
-        rc = EVP_DecryptUpdate(m_ctx, m_tempBuffer.data(), &outlen, (unsigned char*)buffer, (int)read);
-
+        int outlen;
+        int rc = EVP_DecryptUpdate(m_ctx, m_outputBuffer, &outlen, m_inputBuffer, (int)read);
         if (rc != 1)
             PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error AES-decryption data");
 
-        PODOFO_ASSERT((size_t)outlen <= len);
-        std::memcpy(buffer, m_tempBuffer.data(), (size_t)outlen);
-
+        m_outputOffset = 0;
+        m_outputLen = (size_t)outlen;
         if (m_inputLen == 0 || streameof)
         {
             m_inputEof = true;
-
-            int drainLeft;
-            rc = EVP_DecryptFinal_ex(m_ctx, m_tempBuffer.data(), &drainLeft);
+            rc = EVP_DecryptFinal_ex(m_ctx, m_outputBuffer + m_outputLen, &outlen);
             if (rc != 1)
                 PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error AES-decryption data padding");
 
-            m_drainLeft = (size_t)drainLeft;
-            goto DrainBuffer;
+            m_outputLen += (size_t)outlen;
         }
-
-        eof = false;
-        return outlen;
-
-    DrainBuffer:
-        drainLen = std::min(len - outlen, m_drainLeft);
-        std::memcpy(buffer + outlen, m_tempBuffer.data(), drainLen);
-        m_drainLeft -= (int)drainLen;
-        if (m_drainLeft == 0)
-            eof = true;
-        else
-            eof = false;
-
-        return outlen + drainLen;
     }
 
 private:
@@ -440,22 +421,184 @@ private:
     bool m_init;
     unsigned char m_key[32];
     unsigned m_keyLen;
-    vector<unsigned char> m_tempBuffer;
-    size_t m_drainLeft;
+    unsigned char m_inputBuffer[STREAM_CHUNK_SIZE];
+    unsigned char m_outputBuffer[STREAM_CHUNK_SIZE + 2 * AES_BLOCK_SIZE];
+    size_t m_outputOffset;
+    size_t m_outputLen;
+};
+
+/** An OutputStream that encrypts all data written
+ *  using the AES encryption algorithm
+ *
+ *  The initialization vector is written first, then data is
+ *  encrypted block wise in fixed size chunks. The cipher holds
+ *  back at most one incomplete block, that is padded and
+ *  written when the stream is closed
+ */
+class PdfAESOutputStream : public PdfEncryptOutputStream
+{
+public:
+    PdfAESOutputStream(OutputStream& outputStream, const unsigned char* key, unsigned keylen,
+        const unsigned char iv[AES_IV_LENGTH]) :
+        m_OutputStream(&outputStream), m_closed(false)
+    {
+        m_ctx = EVP_CIPHER_CTX_new();
+        if (m_ctx == nullptr)
+            PODOFO_RAISE_ERROR(PdfErrorCode::OutOfMemory);
+
+        int rc = EVP_EncryptInit_ex(m_ctx, getAESCipher(keylen), nullptr, key, iv);
+        if (rc != 1)
+        {
+            EVP_CIPHER_CTX_free(m_ctx);
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing AES encryption engine");
+        }
+
+        m_OutputStream->Write((const char*)iv, AES_IV_LENGTH);
+    }
+
+    ~PdfAESOutputStream()
+    {
+        EVP_CIPHER_CTX_free(m_ctx);
+    }
+
+    void Close() override
+    {
+        if (m_closed)
+            return;
+
+        // Write the last block with the padding
+        m_closed = true;
+        int outlen;
+        if (EVP_EncryptFinal_ex(m_ctx, m_outputBuffer, &outlen) != 1)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error AES-encrypting data");
+
+        m_OutputStream->Write((const char*)m_outputBuffer, (size_t)outlen);
+    }
+
+protected:
+    void checkWrite() const override
+    {
+        if (m_closed)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Can't write to a closed encryption stream");
+    }
+
+    void writeBuffer(const char* buffer, size_t size) override
+    {
+        while (size != 0)
+        {
+            size_t chunkSize = std::min(size, (size_t)STREAM_CHUNK_SIZE);
+            int outlen;
+            int rc = EVP_EncryptUpdate(m_ctx, m_outputBuffer, &outlen, (const unsigned char*)buffer, (int)chunkSize);
+            if (rc != 1)
+                PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error AES-encrypting data");
+
+            m_OutputStream->Write((const char*)m_outputBuffer, (size_t)outlen);
+            buffer += chunkSize;
+            size -= chunkSize;
+        }
+    }
+
+    void flush() override
+    {
+        Flush(*m_OutputStream);
+    }
+
+private:
+    EVP_CIPHER_CTX* m_ctx;
+    OutputStream* m_OutputStream;
+    bool m_closed;
+    unsigned char m_outputBuffer[STREAM_CHUNK_SIZE + AES_BLOCK_SIZE];
 };
 
 }
 
-PdfEncrypt::~PdfEncrypt() { }
+PdfEncryptionKey::PdfEncryptionKey(PdfEncryptAlgorithm algorithm, const bufferview& key)
+    : m_Algorithm(algorithm), m_key{ }, m_keyLength((unsigned)key.size())
+{
+    if (key.size() == 0 || key.size() > sizeof(m_key))
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid encryption key length");
+
+    std::memcpy(m_key, key.data(), key.size());
+}
+
+PdfEncryptionKey::PdfEncryptionKey(const PdfEncryptionKey& rhs)
+    : m_Algorithm(rhs.m_Algorithm), m_keyLength(rhs.m_keyLength)
+{
+    std::memcpy(m_key, rhs.m_key, sizeof(m_key));
+}
+
+PdfEncryptionKey::~PdfEncryptionKey()
+{
+    OPENSSL_cleanse(m_key, sizeof(m_key));
+}
+
+PdfEncryptionKey& PdfEncryptionKey::operator=(const PdfEncryptionKey& rhs)
+{
+    m_Algorithm = rhs.m_Algorithm;
+    m_keyLength = rhs.m_keyLength;
+    std::memcpy(m_key, rhs.m_key, sizeof(m_key));
+    return *this;
+}
+
+PdfEncrypt::~PdfEncrypt()
+{
+    OPENSSL_cleanse(m_encryptionKey, sizeof(m_encryptionKey));
+}
 
 void PdfEncrypt::GenerateEncryptionKey(const PdfString& documentId)
 {
-    GenerateEncryptionKey(documentId.GetRawData());
+    auto& documentIdData = documentId.GetRawData();
+    if (m_IsKeyAuthenticated)
+    {
+        // The passwords are unknown, so the encryption values can't
+        // be generated again. Keep the original ones and the file key,
+        // which the writer checks with the original document ID
+        if (!CheckEncryptionKey(m_encryptionKey, documentIdData))
+        {
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidEncryptionDict,
+                "The file encryption key is not valid for the document ID");
+        }
+
+        m_documentId = documentIdData;
+        m_IsAuthenticated = true;
+        return;
+    }
+
+    GenerateEncryptionKey(documentIdData);
+    m_IsAuthenticated = true;
 }
 
 bool PdfEncrypt::Authenticate(const string_view& password, const PdfString& documentId)
 {
-    return Authenticate(password, documentId.GetRawData());
+    m_IsAuthenticated = Authenticate(password, documentId.GetRawData());
+    if (m_IsAuthenticated)
+        m_IsKeyAuthenticated = false;
+
+    return m_IsAuthenticated;
+}
+
+bool PdfEncrypt::Authenticate(const PdfEncryptionKey& key, const PdfString& documentId)
+{
+    if (key.m_Algorithm != m_Algorithm || key.m_keyLength != m_keyLength)
+        return false;
+
+    auto& documentIdData = documentId.GetRawData();
+    if (!CheckEncryptionKey(key.m_key, documentIdData))
+        return false;
+
+    std::memcpy(m_encryptionKey, key.m_key, m_keyLength);
+    m_documentId = documentIdData;
+    m_IsAuthenticated = true;
+    m_IsKeyAuthenticated = true;
+    return true;
+}
+
+PdfEncryptionKey PdfEncrypt::ExportEncryptionKey() const
+{
+    if (!m_IsAuthenticated)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The encryption key is available only after authentication");
+
+    return PdfEncryptionKey(m_Algorithm, bufferview((const char*)m_encryptionKey, m_keyLength));
 }
 
 PdfEncryptAlgorithm PdfEncrypt::GetEnabledEncryptionAlgorithms()
@@ -632,7 +775,9 @@ PdfEncrypt::PdfEncrypt() :
     m_keyLength(0),
     m_rValue(0),
     m_pValue(PdfPermissions::None),
-    m_EncryptMetadata(true)
+    m_EncryptMetadata(true),
+    m_IsAuthenticated(false),
+    m_IsKeyAuthenticated(false)
 {
     memset(m_uValue, 0, 48);
     memset(m_oValue, 0, 48);
@@ -653,6 +798,8 @@ PdfEncrypt::PdfEncrypt(const PdfEncrypt& rhs)
     m_userPass = rhs.m_userPass;
     m_ownerPass = rhs.m_ownerPass;
     m_EncryptMetadata = rhs.m_EncryptMetadata;
+    m_IsAuthenticated = false;
+    m_IsKeyAuthenticated = rhs.m_IsKeyAuthenticated;
 }
 
 bool PdfEncrypt::CheckKey(unsigned char key1[32], unsigned char key2[32])
@@ -665,10 +812,7 @@ bool PdfEncrypt::CheckKey(unsigned char key1[32], unsigned char key2[32])
     return success;
 }
 
-PdfEncryptMD5Base::PdfEncryptMD5Base()
-    : m_rc4key{ }, m_rc4last{ }
-{
-}
+PdfEncryptMD5Base::PdfEncryptMD5Base() { }
 
 PdfEncryptMD5Base::PdfEncryptMD5Base(const PdfEncrypt& rhs) : PdfEncrypt(rhs)
 {
@@ -679,8 +823,6 @@ PdfEncryptMD5Base::PdfEncryptMD5Base(const PdfEncrypt& rhs) : PdfEncrypt(rhs)
 
     std::memcpy(m_encryptionKey, rhs.GetEncryptionKey(), sizeof(unsigned char) * 16);
 
-    std::memcpy(m_rc4key, static_cast<const PdfEncryptMD5Base*>(ptr)->m_rc4key, sizeof(unsigned char) * 16);
-    std::memcpy(m_rc4last, static_cast<const PdfEncryptMD5Base*>(ptr)->m_rc4last, sizeof(unsigned char) * 256);
     m_EncryptMetadata = static_cast<const PdfEncryptMD5Base*>(ptr)->m_EncryptMetadata;
 }
 
@@ -850,36 +992,44 @@ void PdfEncryptMD5Base::ComputeEncryptionKey(const string_view& documentId,
     std::memcpy(m_encryptionKey, digest, m_keyLength);
 
     // Setup user key
+    ComputeUserKey(m_encryptionKey, documentId, revision, userKey);
+}
+
+void PdfEncryptMD5Base::ComputeUserKey(const unsigned char encryptionKey[], const string_view& documentId,
+    int revision, unsigned char userKey[32]) const
+{
     if (revision == 3 || revision == 4)
     {
-        rc = EVP_DigestInit_ex(ctx.get(), s_SSL.MD5, nullptr);
-        if (rc != 1)
+        int rc;
+        unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+        if (ctx == nullptr || (rc = EVP_DigestInit_ex(ctx.get(), s_SSL.MD5, nullptr)) != 1)
             PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing MD5 hashing engine");
 
         rc = EVP_DigestUpdate(ctx.get(), padding, 32);
         if (rc != 1)
             PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error MD5-hashing data");
 
-        if (docId.size() != 0)
+        if (documentId.length() != 0)
         {
-            rc = EVP_DigestUpdate(ctx.get(), docId.data(), docIdLength);
+            rc = EVP_DigestUpdate(ctx.get(), documentId.data(), documentId.length());
             if (rc != 1)
                 PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error MD5-hashing data");
         }
 
+        unsigned char digest[MD5_DIGEST_LENGTH];
         rc = EVP_DigestFinal_ex(ctx.get(), digest, nullptr);
         if (rc != 1)
             PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error MD5-hashing data");
 
         std::memcpy(userKey, digest, 16);
-        for (k = 16; k < 32; k++)
+        for (unsigned k = 16; k < 32; k++)
             userKey[k] = 0;
 
-        for (k = 0; k < 20; k++)
+        for (unsigned k = 0; k < 20; k++)
         {
-            for (j = 0; j < m_keyLength; j++)
+            for (unsigned j = 0; j < m_keyLength; j++)
             {
-                digest[j] = static_cast<unsigned char>(m_encryptionKey[j] ^ k);
+                digest[j] = static_cast<unsigned char>(encryptionKey[j] ^ k);
             }
 
             RC4(digest, m_keyLength, userKey, 16, userKey, 16);
@@ -887,10 +1037,19 @@ void PdfEncryptMD5Base::ComputeEncryptionKey(const string_view& documentId,
     }
     else
     {
-        RC4(m_encryptionKey, m_keyLength, padding, 32, userKey, 32);
+        RC4(encryptionKey, m_keyLength, padding, 32, userKey, 32);
     }
 }
 
+bool PdfEncryptMD5Base::CheckEncryptionKey(const unsigned char key[32], const string_view& documentId)
+{
+    // The U value is derived only from the file encryption key and
+    // the document ID, so it's a cheap and complete validation
+    unsigned char userKey[32];
+    ComputeUserKey(key, documentId, m_rValue, userKey);
+    return CheckKey(userKey, m_uValue);
+}
+
 void PdfEncryptMD5Base::CreateObjKey(unsigned char objkey[16], unsigned& pnKeyLen, const PdfReference& objref) const
 {
     const unsigned n = static_cast<unsigned>(objref.ObjectNumber());
@@ -921,15 +1080,6 @@ void PdfEncryptMD5Base::CreateObjKey(unsigned char objkey[16], unsigned& pnKeyLe
     pnKeyLen = (m_keyLength <= 11) ? m_keyLength + 5 : 16;
 }
 
-PdfEncryptRC4Base::PdfEncryptRC4Base()
-{
-    m_rc4 = new RC4CryptoEngine();
-}
-
-PdfEncryptRC4Base::~PdfEncryptRC4Base()
-{
-    delete m_rc4;
-}
     
 /**
  * RC4 is the standard encryption algorithm used in PDF format
@@ -939,8 +1089,13 @@ void PdfEncryptRC4Base::RC4(const unsigned char* key, unsigned keylen,
     const unsigned char* textin, size_t textlen,
     unsigned char* textout, size_t textoutlen) const
 {
-    EVP_CIPHER_CTX* rc4 = m_rc4->getEngine();
+    // Use a context local to this call, so streams
+    // can be decrypted concurrently
+    unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    if (ctx == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::OutOfMemory, "Error initializing RC4 encryption engine");
 
+    EVP_CIPHER_CTX* rc4 = ctx.get();
     if (textlen != textoutlen)
         PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing RC4 encryption engine");
 
@@ -1123,13 +1278,13 @@ void PdfEncryptRC4::Decrypt(const char* inStr, size_t inLen, const PdfReference&
     Encrypt(inStr, inLen, objref, outStr, outLen);
 }
 
-unique_ptr<InputStream> PdfEncryptRC4::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref)
+unique_ptr<InputStream> PdfEncryptRC4::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const
 {
     (void)inputLen;
     unsigned char objkey[MD5_DIGEST_LENGTH];
     unsigned keylen;
     this->CreateObjKey(objkey, keylen, objref);
-    return unique_ptr<InputStream>(new PdfRC4InputStream(inputStream, inputLen, m_rc4key, m_rc4last, objkey, keylen));
+    return unique_ptr<InputStream>(new PdfRC4InputStream(inputStream, inputLen, objkey, keylen));
 }
 
 PdfEncryptRC4::PdfEncryptRC4(PdfString oValue, PdfString uValue, PdfPermissions pValue, int rValue,
@@ -1154,8 +1309,6 @@ PdfEncryptRC4::PdfEncryptRC4(PdfString oValue, PdfString uValue, PdfPermissions
     std::memcpy(m_uValue, uValueData.data(), 32);
 
     // Init buffers
-    std::memset(m_rc4key, 0, 16);
-    std::memset(m_rc4last, 0, 256);
     std::memset(m_encryptionKey, 0, 32);
 }
 
@@ -1197,10 +1350,8 @@ PdfEncryptRC4::PdfEncryptRC4(const string_view& userPassword, const string_view&
     }
 
     // Init buffers
-    std::memset(m_rc4key, 0, 16);
     std::memset(m_oValue, 0, 48);
     std::memset(m_uValue, 0, 48);
-    std::memset(m_rc4last, 0, 256);
     std::memset(m_encryptionKey, 0, 32);
 
     // Compute P value
@@ -1210,12 +1361,12 @@ PdfEncryptRC4::PdfEncryptRC4(const string_view& userPassword, const string_view&
 PdfEncryptRC4::PdfEncryptRC4(const PdfEncrypt& rhs)
     : PdfEncryptMD5Base(rhs) {}
 
-unique_ptr<OutputStream> PdfEncryptRC4::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref)
+unique_ptr<PdfEncryptOutputStream> PdfEncryptRC4::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const
 {
     unsigned char objkey[MD5_DIGEST_LENGTH];
     unsigned keylen;
     this->CreateObjKey(objkey, keylen, objref);
-    return unique_ptr<OutputStream>(new PdfRC4OutputStream(outputStream, m_rc4key, m_rc4last, objkey, keylen));
+    return unique_ptr<PdfEncryptOutputStream>(new PdfRC4OutputStream(outputStream, objkey, keylen));
 }
     
 PdfEncryptAESBase::PdfEncryptAESBase()
@@ -1235,7 +1386,13 @@ void PdfEncryptAESBase::BaseDecrypt(const unsigned char* key, unsigned keyLen, c
     if ((textlen % 16) != 0)
         PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error AES-decryption data length not a multiple of 16");
 
-    EVP_CIPHER_CTX* aes = m_aes->getEngine();
+    // Use a context local to this call, so streams
+    // can be decrypted concurrently
+    unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    if (ctx == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::OutOfMemory, "Error initializing AES decryption engine");
+
+    EVP_CIPHER_CTX* aes = ctx.get();
 
     int rc;
     if (keyLen == (int)PdfKeyLength::L128 / 8)
@@ -1390,8 +1547,6 @@ PdfEncryptAESV2::PdfEncryptAESV2(const string_view& userPassword, const string_v
     m_keyLength = (int)PdfKeyLength::L128 / 8;
 
     // Init buffers
-    std::memset(m_rc4key, 0, 16);
-    std::memset(m_rc4last, 0, 256);
     std::memset(m_oValue, 0, 48);
     std::memset(m_uValue, 0, 48);
     std::memset(m_encryptionKey, 0, 32);
@@ -1425,8 +1580,6 @@ PdfEncryptAESV2::PdfEncryptAESV2(PdfString oValue, PdfString uValue, PdfPermissi
     std::memcpy(m_uValue, uValueData.data(), 32);
 
     // Init buffers
-    std::memset(m_rc4key, 0, 16);
-    std::memset(m_rc4last, 0, 256);
     std::memset(m_encryptionKey, 0, 32);
 }
 
@@ -1439,7 +1592,7 @@ size_t PdfEncryptAESV2::CalculateStreamLength(size_t length) const
     return realLength;
 }
     
-unique_ptr<InputStream> PdfEncryptAESV2::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref)
+unique_ptr<InputStream> PdfEncryptAESV2::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const
 {
     unsigned char objkey[MD5_DIGEST_LENGTH];
     unsigned keylen;
@@ -1447,16 +1600,14 @@ unique_ptr<InputStream> PdfEncryptAESV2::CreateEncryptionInputStream(InputStream
     return unique_ptr<InputStream>(new PdfAESInputStream(inputStream, inputLen, objkey, keylen));
 }
     
-unique_ptr<OutputStream> PdfEncryptAESV2::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref)
+unique_ptr<PdfEncryptOutputStream> PdfEncryptAESV2::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const
 {
-    (void)outputStream;
-    (void)objref;
-    /*unsigned char objkey[MD5_DIGEST_LENGTH];
-     int keylen;
-
-     this->CreateObjKey( objkey, &keylen );*/
-
-    PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "CreateEncryptionOutputStream does not yet support AESV2");
+    unsigned char objkey[MD5_DIGEST_LENGTH];
+    unsigned keylen;
+    this->CreateObjKey(objkey, keylen, objref);
+    unsigned char iv[AES_IV_LENGTH];
+    this->GenerateInitialVector(iv);
+    return unique_ptr<PdfEncryptOutputStream>(new PdfAESOutputStream(outputStream, objkey, keylen, iv));
 }
     
 #ifdef PODOFO_HAVE_LIBIDN
@@ -1871,6 +2022,36 @@ bool PdfEncryptAESV3::Authenticate(const string_view& password, const string_vie
     return success;
 }
 
+bool PdfEncryptAESV3::CheckEncryptionKey(const unsigned char key[32], const string_view& documentId)
+{
+    (void)documentId;
+
+    // ISO 32000-2 Algorithm 2.A: decrypt the /Perms value with the file
+    // encryption key using AES-256 in ECB mode. Bytes 9-11 must be "adb"
+    // and the first 4 bytes must match the /P value. NOTE: ECB on a single
+    // block is equivalent to CBC with a zero initialization vector
+    int rc;
+    unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> aes(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    if (aes == nullptr || (rc = EVP_DecryptInit_ex(aes.get(), s_SSL.Aes256, nullptr, key, nullptr)) != 1)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error initializing AES decryption engine");
+
+    EVP_CIPHER_CTX_set_padding(aes.get(), 0); // disable padding
+
+    unsigned char perms[16 + AES_BLOCK_SIZE];
+    int dataOutMoved;
+    rc = EVP_DecryptUpdate(aes.get(), perms, &dataOutMoved, m_permsValue, 16);
+    if (rc != 1 || dataOutMoved != 16)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Error AES-decryption data");
+
+    bool success = perms[9] == 'a' && perms[10] == 'd' && perms[11] == 'b';
+    unsigned pValue = (unsigned)m_pValue;
+    for (unsigned i = 0; success && i < 4; i++)
+        success = perms[i] == static_cast<unsigned char>((pValue >> (8 * i)) & 0xFF);
+
+    OPENSSL_cleanse(perms, sizeof(perms));
+    return success;
+}
+
 size_t PdfEncryptAESV3::CalculateStreamOffset() const
 {
     return AES_IV_LENGTH;
@@ -1972,17 +2153,18 @@ size_t PdfEncryptAESV3::CalculateStreamLength(size_t length) const
     return realLength;
 }
 
-unique_ptr<InputStream> PdfEncryptAESV3::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref)
+unique_ptr<InputStream> PdfEncryptAESV3::CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const
 {
     (void)objref;
     return unique_ptr<InputStream>(new PdfAESInputStream(inputStream, inputLen, m_encryptionKey, 32));
 }
 
-unique_ptr<OutputStream> PdfEncryptAESV3::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref)
+unique_ptr<PdfEncryptOutputStream> PdfEncryptAESV3::CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const
 {
-    (void)outputStream;
     (void)objref;
-    PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "CreateEncryptionOutputStream does not yet support AESV3");
+    unsigned char iv[AES_IV_LENGTH];
+    this->GenerateInitialVector(iv);
+    return unique_ptr<PdfEncryptOutputStream>(new PdfAESOutputStream(outputStream, m_encryptionKey, 32, iv));
 }
     
 #endif // PODOFO_HAVE_LIBIDN
@@ -1999,13 +2181,28 @@ void PdfEncrypt::EncryptTo(charbuff& out, const bufferview& view, const PdfRefer
     this->Encrypt(view.data(), view.size(), objref, out.data(), outputLen);
 }
 
+void PdfEncrypt::EncryptTo(OutputStream& out, const bufferview& view, const PdfReference& objref) const
+{
+    auto stream = this->CreateEncryptionOutputStream(out, objref);
+    stream->Write(view.data(), view.size());
+    stream->Close();
+}
+
 void PdfEncrypt::DecryptTo(charbuff& out, const bufferview& view, const PdfReference& objref) const
 {
     // FIX-ME: The following clearly seems hardcoded for AES
     // It was found like this in PdfString and PdfTokenizer
     // Fix it so it will allocate the exact amount of memory
     // needed, including RC4
-    size_t outBufferLen = view.size() - this->CalculateStreamOffset();
+    size_t offset = this->CalculateStreamOffset();
+    if (view.size() <= offset)
+    {
+        // Is empty
+        out.clear();
+        return;
+    }
+
+    size_t outBufferLen = view.size() - offset;
     out.resize(outBufferLen + 16 - (outBufferLen % 16));
     this->Decrypt(view.data(), view.size(), objref, out.data(), outBufferLen);
     out.resize(outBufferLen);
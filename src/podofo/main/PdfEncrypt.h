@@ -11,15 +11,15 @@
 #include "PdfString.h"
 #include "PdfReference.h"
 
+#include <podofo/auxiliary/OutputStream.h>
+
 namespace PoDoFo
 {
 
 class PdfDictionary;
 class InputStream;
 class PdfObject;
-class OutputStream;
 class AESCryptoEngine;
-class RC4CryptoEngine;
 
 /* Class representing PDF encryption methods. (For internal use only)
  * Based on code from Ulrich Telle: http://wxcode.sourceforge.net/components/wxpdfdoc/
@@ -97,6 +97,53 @@ enum class PdfEncryptAlgorithm
 #endif //PODOFO_HAVE_LIBIDN
 };
 
+/** A file encryption key derived by a successful authentication
+ *
+ *  It can be exported from an authenticated PdfEncrypt and used
+ *  later to open the same document again without running the
+ *  password based key derivation, which is deliberately expensive
+ *  with AESV3. The key bytes are zeroed on destruction
+ *
+ *  \see PdfEncrypt::ExportEncryptionKey
+ */
+class PODOFO_API PdfEncryptionKey final
+{
+    friend class PdfEncrypt;
+
+public:
+    PdfEncryptionKey(PdfEncryptAlgorithm algorithm, const bufferview& key);
+    PdfEncryptionKey(const PdfEncryptionKey& rhs);
+    ~PdfEncryptionKey();
+
+public:
+    PdfEncryptionKey& operator=(const PdfEncryptionKey& rhs);
+
+public:
+    /** The encryption algorithm the key was derived for
+     */
+    PdfEncryptAlgorithm GetAlgorithm() const { return m_Algorithm; }
+
+    /** The raw bytes of the file encryption key
+     */
+    bufferview GetKey() const { return bufferview((const char*)m_key, m_keyLength); }
+
+private:
+    PdfEncryptAlgorithm m_Algorithm;
+    unsigned char m_key[32];
+    unsigned m_keyLength;
+};
+
+/** An OutputStream that encrypts all data written to it
+ */
+class PODOFO_API PdfEncryptOutputStream : public OutputStream
+{
+public:
+    /** Write the final encrypted data, if any. Nothing
+     *  can be written to the stream after
+     */
+    virtual void Close() = 0;
+};
+
 /** A class that is used to encrypt a PDF file and
  *  set document permissions on the PDF file.
  *
@@ -186,6 +233,10 @@ public:
     static bool IsEncryptionEnabled(PdfEncryptAlgorithm algorithm);
 
     /** Generate encryption key from user and owner passwords and protection key
+     *
+     *  If the object was authenticated with a file encryption key, the
+     *  passwords are unknown: the original encryption values and key are
+     *  kept instead, and it throws if they are not valid for documentId
      *
      *  \param documentId the documentId of the current document
      */
@@ -203,26 +254,29 @@ public:
     /** Create an InputStream that decrypts all data read from
      *  it using the current settings of the PdfEncrypt object.
      *
-     *  Warning: Currently only RC4 based encryption is supported using output streams!
+     *  Data is decrypted in fixed size chunks as it's read, so
+     *  memory usage doesn't depend on the stream length
      *
      *  \param inputStream the created InputStream reads all decrypted
      *         data to this input stream.
      *
      *  \returns an InputStream that decrypts all data.
      */
-    virtual std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) = 0;
+    virtual std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const = 0;
 
     /** Create an OutputStream that encrypts all data written to
      *  it using the current settings of the PdfEncrypt object.
      *
-     *  Warning: Currently only RC4 based encryption is supported using output streams!
+     *  Data is encrypted in fixed size chunks as it's written.
+     *  PdfEncryptOutputStream::Close() must be called after the
+     *  last write. With AES it writes the trailing padding block
      *
      *  \param outputStream the created OutputStream writes all encrypted
      *         data to this output stream.
      *
      *  \returns a OutputStream that encrypts all data.
      */
-    virtual std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) = 0;
+    virtual std::unique_ptr<PdfEncryptOutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const = 0;
 
     /**
      * Tries to authenticate a user using either the user or owner password
@@ -234,11 +288,38 @@ public:
      */
     bool Authenticate(const std::string_view& password, const PdfString& documentId);
 
+    /**
+     * Tries to authenticate using a file encryption key previously
+     * exported from this document, skipping the password based
+     * key derivation. The key is validated against the encryption
+     * dictionary values
+     *
+     * \param key a key obtained with ExportEncryptionKey()
+     * \param documentId the documentId of the PDF file
+     *
+     * \returns true if the key is valid for this document
+     */
+    bool Authenticate(const PdfEncryptionKey& key, const PdfString& documentId);
+
+    /** Export the file encryption key derived by the last successful
+     *  authentication or key generation
+     *
+     *  \remarks throws if the object has not been authenticated yet
+     *  \see Authenticate
+     */
+    PdfEncryptionKey ExportEncryptionKey() const;
+
     /** Get the encryption algorithm of this object.
      * \returns the PdfEncryptAlgorithm of this object
      */
     inline PdfEncryptAlgorithm GetEncryptAlgorithm() const { return m_Algorithm; }
 
+    /** Checks if this object was authenticated with a file encryption
+     *  key, so the passwords are unknown and the key can't be generated
+     *  again for a different document ID
+     */
+    inline bool IsKeyAuthenticated() const { return m_IsKeyAuthenticated; }
+
     /** Checks if an owner password is set.
      *  An application reading PDF must adhere to permissions for printing,
      *  copying, etc., unless the owner password was used to open it.
@@ -355,6 +436,11 @@ public:
      */
     void EncryptTo(charbuff& out, const bufferview& view, const PdfReference& objref) const;
 
+    /** Encrypt a character span directly to an output stream,
+     *  without buffering the encrypted data
+     */
+    void EncryptTo(OutputStream& out, const bufferview& view, const PdfReference& objref) const;
+
     /** Decrypt a character span
      */
     void DecryptTo(charbuff& out, const bufferview& view, const PdfReference& objref) const;
@@ -383,6 +469,9 @@ protected:
 
     virtual void GenerateEncryptionKey(const std::string_view& documentId) = 0;
 
+    // Check if the given file encryption key is valid for the document
+    virtual bool CheckEncryptionKey(const unsigned char key[32], const std::string_view& documentId) = 0;
+
     // Check two keys for equality
     bool CheckKey(unsigned char key1[32], unsigned char key2[32]);
 
@@ -398,6 +487,8 @@ protected:
     unsigned char m_encryptionKey[32]; // Encryption key
     std::string m_documentId;          // DocumentID of the current document
     bool m_EncryptMetadata;            // Is metadata encrypted
+    bool m_IsAuthenticated;            // The encryption key has been authenticated or generated
+    bool m_IsKeyAuthenticated;         // Authenticated with a file encryption key, the passwords are unknown
 
 private:
     static PdfEncryptAlgorithm s_EnabledEncryptionAlgorithms; // Or'ed int containing the enabled encryption algorithms
@@ -489,6 +580,7 @@ public:
 protected:
     PdfEncryptAESBase();
 
+    // It's safe to call concurrently
     void BaseDecrypt(const unsigned char* key, unsigned keylen, const unsigned char* iv,
         const unsigned char* textin, size_t textlen,
         unsigned char* textout, size_t& textoutlen) const;
@@ -508,18 +600,11 @@ protected:
  */
 class PdfEncryptRC4Base
 {
-public:
-    ~PdfEncryptRC4Base();
-
 protected:
-    PdfEncryptRC4Base();
-
-    // AES encryption
+    // RC4 encryption. It's safe to call concurrently
     void RC4(const unsigned char* key, unsigned keylen,
         const unsigned char* textin, size_t textlen,
         unsigned char* textout, size_t textoutlen) const;
-
-    RC4CryptoEngine* m_rc4;                // AES encryptor
 };
 
 class PdfEncryptMD5Base : public PdfEncrypt, public PdfEncryptRC4Base
@@ -562,6 +647,12 @@ protected:
     // Pad a password to 32 characters
     void PadPassword(const std::string_view& password, unsigned char pswd[32]);
 
+    // Compute the user key from the file encryption key
+    void ComputeUserKey(const unsigned char encryptionKey[], const std::string_view& documentID,
+        int revision, unsigned char userKey[32]) const;
+
+    bool CheckEncryptionKey(const unsigned char key[32], const std::string_view& documentId) override;
+
     // Compute encryption key and user key
     void ComputeEncryptionKey(const std::string_view& documentID,
         const unsigned char userPad[32], const unsigned char ownerKey[32],
@@ -575,9 +666,6 @@ protected:
      */
     void CreateObjKey(unsigned char objkey[16], unsigned& pnKeyLen, const PdfReference& objref) const;
 
-    unsigned char m_rc4key[16];         // last RC4 key
-    unsigned char m_rc4last[256];       // last RC4 state table
-
 };
 
 /** A class that is used to encrypt a PDF file (AES-128)
@@ -594,8 +682,8 @@ public:
         PdfPermissions protection = PdfPermissions::Default);
     PdfEncryptAESV2(const PdfEncrypt& rhs);
 
-    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) override;
-    std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) override;
+    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const override;
+    std::unique_ptr<PdfEncryptOutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const override;
 
     void Encrypt(const char* inStr, size_t inLen, const PdfReference& objref,
         char* outStr, size_t outLen) const override;
@@ -629,8 +717,8 @@ public:
         PdfAESV3Revision rev, PdfPermissions protection = PdfPermissions::Default);
     PdfEncryptAESV3(const PdfEncrypt& rhs);
 
-    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) override;
-    std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) override;
+    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const override;
+    std::unique_ptr<PdfEncryptOutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const override;
 
     // Encrypt a character string
     void Encrypt(const char* inStr, size_t inLen, const PdfReference& objref,
@@ -646,6 +734,8 @@ protected:
     bool Authenticate(const std::string_view& password, const std::string_view& documentId) override;
 
     void GenerateEncryptionKey(const std::string_view& documentId) override;
+
+    bool CheckEncryptionKey(const unsigned char key[32], const std::string_view& documentId) override;
 };
 
 #endif // PODOFO_HAVE_LIBIDN
@@ -673,9 +763,9 @@ public:
     void Decrypt(const char* inStr, size_t inLen, const PdfReference& objref,
         char* outStr, size_t& outLen) const override;
 
-    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) override;
+    std::unique_ptr<InputStream> CreateEncryptionInputStream(InputStream& inputStream, size_t inputLen, const PdfReference& objref) const override;
 
-    std::unique_ptr<OutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) override;
+    std::unique_ptr<PdfEncryptOutputStream> CreateEncryptionOutputStream(OutputStream& outputStream, const PdfReference& objref) const override;
 
     size_t CalculateStreamOffset() const override;
 
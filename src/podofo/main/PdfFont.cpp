@@ -7,6 +7,8 @@
 #include <podofo/private/PdfDeclarationsPrivate.h>
 #include "PdfFont.h"
 
+#include <unordered_map>
+
 #include <utf8cpp/utf8.h>
 
 #include <podofo/private/PdfEncodingPrivate.h>
@@ -35,6 +37,46 @@ using namespace PoDoFo;
 static double getGlyphLength(double glyphLength, const PdfTextState& state, bool ignoreCharSpacing);
 static string_view toString(PdfFontStretch stretch);
 
+namespace PoDoFo
+{
+    /** Glyphs decoded by char code, to scan strings with a single
+     * lookup per glyph. It's used only for fonts loaded from
+     * documents, that have immutable encoding and metrics
+     */
+    struct PdfGlyphScanCache final
+    {
+        struct Glyph
+        {
+            std::string Text;           ///< Decoded UTF-8 text
+            double LengthRaw = 0;
+            bool Success = false;
+            bool Cached = false;
+        };
+
+        unsigned char CodeSize = 0;     ///< 0 if the glyphs can't be cached
+        std::vector<Glyph> SimpleGlyphs;    ///< Flat table for 1 byte codes
+        std::unordered_map<unsigned, Glyph> CIDGlyphs;
+    };
+
+    /** Glyph widths by unicode code point, to measure strings with
+     * a single lookup per character. The BMP code points are stored
+     * in flat pages of 256 entries, allocated on first use
+     */
+    struct PdfGlyphWidthCache final
+    {
+        struct Glyph
+        {
+            double LengthRaw = 0;
+            bool Success = false;
+            bool Cached = false;
+        };
+
+        bool Enabled = false;       ///< False if the code points may be mapped to other glyphs later
+        std::unique_ptr<Glyph[]> Pages[256];
+        std::unordered_map<char32_t, Glyph> OtherGlyphs;
+    };
+}
+
 PdfFont::PdfFont(PdfDocument& doc, const PdfFontMetricsConstPtr& metrics,
         const PdfEncoding& encoding) :
     PdfDictionaryElement(doc, "Font"),
@@ -291,11 +333,36 @@ double PdfFont::GetStringLength(const string_view& str, const PdfTextState& stat
 
 bool PdfFont::TryGetStringLength(const string_view& str, const PdfTextState& state, double& length) const
 {
-    vector<unsigned> gids;
-    bool success = tryConvertToGIDs(str, PdfGlyphAccess::Width, gids);
+    bool success = true;
     length = 0;
-    for (unsigned i = 0; i < gids.size(); i++)
-        length += getGlyphLength(m_Metrics->GetGlyphWidth(gids[i]), state, false);
+    auto it = str.begin();
+    auto end = str.end();
+    double lengthRaw;
+    while (it != end)
+    {
+        if (!tryGetCharLengthRaw((char32_t)utf8::next(it, end), lengthRaw))
+            success = false;
+
+        length += getGlyphLength(lengthRaw, state, false);
+    }
+
+    return success;
+}
+
+bool PdfFont::TryGetCharLengths(const string_view& str, const PdfTextState& state, vector<double>& lengths) const
+{
+    bool success = true;
+    lengths.clear();
+    auto it = str.begin();
+    auto end = str.end();
+    double lengthRaw;
+    while (it != end)
+    {
+        if (!tryGetCharLengthRaw((char32_t)utf8::next(it, end), lengthRaw))
+            success = false;
+
+        lengths.push_back(getGlyphLength(lengthRaw, state, false));
+    }
 
     return success;
 }
@@ -328,11 +395,56 @@ bool PdfFont::TryScanEncodedString(const PdfString& encodedStr, const PdfTextSta
     if (encodedStr.IsEmpty())
         return true;
 
-    auto context = m_Encoding->StartStringScan(encodedStr);
+    const_cast<PdfFont&>(*this).initGlyphScanCache();
+    auto& cache = *m_GlyphScanCache;
+    string_view raw = encodedStr.GetRawData();
+    if (cache.CodeSize == 0)
+        return tryScanEncodedString(raw, state, utf8str, lengths, positions);
+
     vector<codepoint> codepoints;
     PdfCID cid;
     bool success = true;
-    unsigned prevOffset = 0;
+    size_t i = 0;
+    for (; i + cache.CodeSize <= raw.length(); i += cache.CodeSize)
+    {
+        unsigned code = (unsigned char)raw[i];
+        if (cache.CodeSize == 2)
+            code = code << 8 | (unsigned char)raw[i + 1];
+
+        auto& glyph = cache.CodeSize == 1 ? cache.SimpleGlyphs[code] : cache.CIDGlyphs[code];
+        if (!glyph.Cached)
+        {
+            // Decode the glyph the first time it's found
+            PdfStringScanContext context(raw.substr(i, cache.CodeSize), *m_Encoding);
+            glyph.Success = context.TryScan(cid, glyph.Text, codepoints);
+            PODOFO_ASSERT(context.IsEndOfString());
+            glyph.LengthRaw = GetCIDLengthRaw(cid.Id);
+            glyph.Cached = true;
+        }
+
+        if (!glyph.Success)
+            success = false;
+
+        lengths.push_back(getGlyphLength(glyph.LengthRaw, state, false));
+        positions.push_back((unsigned)utf8str.length());
+        utf8str.append(glyph.Text);
+    }
+
+    // Scan a truncated trailing code, if any
+    if (i != raw.length() && !tryScanEncodedString(raw.substr(i), state, utf8str, lengths, positions))
+        success = false;
+
+    return success;
+}
+
+bool PdfFont::tryScanEncodedString(const string_view& encodedStr, const PdfTextState& state,
+    string& utf8str, vector<double>& lengths, vector<unsigned>& positions) const
+{
+    PdfStringScanContext context(encodedStr, *m_Encoding);
+    vector<codepoint> codepoints;
+    PdfCID cid;
+    bool success = true;
+    unsigned prevOffset = (unsigned)utf8str.length();
     double length;
     while (!context.IsEndOfString())
     {
@@ -372,10 +484,10 @@ bool PdfFont::TryGetCharLength(char32_t codePoint, const PdfTextState& state, do
 bool PdfFont::TryGetCharLength(char32_t codePoint, const PdfTextState& state,
     bool ignoreCharSpacing, double& length) const
 {
-    unsigned gid;
-    if (TryGetGID(codePoint, PdfGlyphAccess::Width, gid))
+    double lengthRaw;
+    if (tryGetCharLengthRaw(codePoint, lengthRaw))
     {
-        length = getGlyphLength(m_Metrics->GetGlyphWidth(gid), state, ignoreCharSpacing);
+        length = getGlyphLength(lengthRaw, state, ignoreCharSpacing);
         return true;
     }
     else
@@ -514,7 +626,11 @@ void PdfFont::EmbedFontFile(PdfObject& descriptor)
             EmbedFontFileType1(descriptor, fontdata, m_Metrics->GetFontFileLength1(), m_Metrics->GetFontFileLength2(), m_Metrics->GetFontFileLength3());
             break;
         case PdfFontFileType::Type1CCF:
-            EmbedFontFileType1CCF(descriptor, fontdata);
+            // CFF fonts wrapped in OpenType are embedded as such
+            if (fontdata.size() >= 4 && std::memcmp(fontdata.data(), "OTTO", 4) == 0)
+                EmbedFontFileOpenType(descriptor, fontdata);
+            else
+                EmbedFontFileType1CCF(descriptor, fontdata);
             break;
         case PdfFontFileType::TrueType:
             EmbedFontFileTrueType(descriptor, fontdata);
@@ -615,6 +731,51 @@ void PdfFont::initWordSpacingLength()
     }
 }
 
+void PdfFont::initGlyphScanCache()
+{
+    if (m_GlyphScanCache != nullptr)
+        return;
+
+    m_GlyphScanCache.reset(new PdfGlyphScanCache());
+
+    // NOTE: Created fonts may still add codes to
+    // their encoding, so they can't be cached
+    if (!IsObjectLoaded() || m_Encoding->IsNull() || m_Encoding->IsDynamicEncoding())
+        return;
+
+    // Only encodings with fixed code size can be cached
+    auto& limits = m_Encoding->GetEncodingMap().GetLimits();
+    if (limits.MinCodeSize != limits.MaxCodeSize)
+        return;
+
+    switch (limits.MinCodeSize)
+    {
+        case 1:
+            m_GlyphScanCache->CodeSize = 1;
+            m_GlyphScanCache->SimpleGlyphs.resize(256);
+            break;
+        case 2:
+            m_GlyphScanCache->CodeSize = 2;
+            break;
+        default:
+            break;
+    }
+}
+
+void PdfFont::initGlyphWidthCache()
+{
+    if (m_GlyphWidthCache != nullptr)
+        return;
+
+    m_GlyphWidthCache.reset(new PdfGlyphWidthCache());
+
+    // NOTE: Code points are mapped to glyphs through the encoding
+    // with loaded fonts or fonts with no unicode mapping, and
+    // dynamic encodings can still map them to other glyphs
+    m_GlyphWidthCache->Enabled = (!IsObjectLoaded() && m_Metrics->HasUnicodeMapping())
+        || !m_Encoding->IsDynamicEncoding();
+}
+
 void PdfFont::initImported()
 {
     // By default do nothing
@@ -705,76 +866,88 @@ PdfCharCode PdfFont::AddCharCodeSafe(unsigned gid, const unicodeview& codePoints
     return code;
 }
 
-bool PdfFont::tryConvertToGIDs(const std::string_view& utf8Str, PdfGlyphAccess access, std::vector<unsigned>& gids) const
+// Convert the code point to a GID, falling back to a best
+// effort one on failure, as used when measuring strings
+bool PdfFont::tryConvertToGID(char32_t codePoint, PdfGlyphAccess access, unsigned& gid) const
 {
-    bool success = true;
     if (IsObjectLoaded() || !m_Metrics->HasUnicodeMapping())
     {
         // NOTE: This is a best effort strategy. It's not intended to
         // be accurate in loaded fonts
-        auto it = utf8Str.begin();
-        auto end = utf8Str.end();
-
-        auto& toUnicode = m_Encoding->GetToUnicodeMapSafe();
-        while (it != end)
+        PdfCharCode codeUnit;
+        unsigned cid;
+        if (m_Encoding->GetToUnicodeMapSafe().TryGetCharCode(codePoint, codeUnit))
         {
-            char32_t cp = utf8::next(it, end);
-            PdfCharCode codeUnit;
-            unsigned cid;
-            unsigned gid;
-            if (toUnicode.TryGetCharCode(cp, codeUnit))
+            if (m_Encoding->TryGetCIDId(codeUnit, cid))
             {
-                if (m_Encoding->TryGetCIDId(codeUnit, cid))
-                {
-                    if (!TryMapCIDToGID(cid, access, gid))
-                    {
-                        // Fallback
-                        gid = cid;
-                        success = false;
-                    }
-                }
-                else
-                {
-                    // Fallback
-                    gid = codeUnit.Code;
-                    success = false;
-                }
+                if (TryMapCIDToGID(cid, access, gid))
+                    return true;
+
+                // Fallback
+                gid = cid;
             }
             else
             {
                 // Fallback
-                gid = cp;
-                success = false;
+                gid = codeUnit.Code;
             }
-
-            gids.push_back(gid);
         }
+        else
+        {
+            // Fallback
+            gid = codePoint;
+        }
+
+        return false;
     }
     else
     {
-        auto it = utf8Str.begin();
-        auto end = utf8Str.end();
-        while (it != end)
-        {
-            char32_t cp = utf8::next(it, end);
-            unsigned gid;
-            if (!m_Metrics->TryGetGID(cp, gid))
-            {
-                // Fallback
-                gid = cp;
-                success = false;
-            }
+        if (m_Metrics->TryGetGID(codePoint, gid))
+            return true;
 
-            gids.push_back(gid);
-        }
+        // Fallback
+        gid = codePoint;
+        return false;
+    }
+}
 
-        // Try to subsistute GIDs for fonts that support
-        // a glyph substitution mechanism
-        vector<unsigned char> backwardMap;
-        m_Metrics->SubstituteGIDs(gids, backwardMap);
+// Get the raw width of the glyph of the code point, caching
+// it when the code point can't be mapped to another glyph later
+bool PdfFont::tryGetCharLengthRaw(char32_t codePoint, double& lengthRaw) const
+{
+    const_cast<PdfFont&>(*this).initGlyphWidthCache();
+    auto& cache = *m_GlyphWidthCache;
+    unsigned gid;
+    if (!cache.Enabled)
+    {
+        bool success = tryConvertToGID(codePoint, PdfGlyphAccess::Width, gid);
+        lengthRaw = m_Metrics->GetGlyphWidth(gid);
+        return success;
     }
 
-    return success;
+    PdfGlyphWidthCache::Glyph* glyph;
+    if (codePoint < 0x10000)
+    {
+        auto& page = cache.Pages[codePoint >> 8];
+        if (page == nullptr)
+            page.reset(new PdfGlyphWidthCache::Glyph[256]);
+
+        glyph = &page[codePoint & 0xFF];
+    }
+    else
+    {
+        glyph = &cache.OtherGlyphs[codePoint];
+    }
+
+    if (!glyph->Cached)
+    {
+        glyph->Success = tryConvertToGID(codePoint, PdfGlyphAccess::Width, gid);
+        glyph->LengthRaw = m_Metrics->GetGlyphWidth(gid);
+        glyph->Cached = true;
+    }
+
+    lengthRaw = glyph->LengthRaw;
+    return glyph->Success;
 }
 
 bool PdfFont::tryAddSubsetGID(unsigned gid, const unicodeview& codePoints, PdfCID& cid)
@@ -23,6 +23,8 @@ class PdfObject;
 class PdfPage;
 class PdfWriter;
 class PdfCharCodeMap;
+struct PdfGlyphScanCache;
+struct PdfGlyphWidthCache;
 
 using UsedGIDsMap = std::map<unsigned, PdfCID>;
 
@@ -160,6 +162,15 @@ public:
      */
     bool TryGetStringLength(const std::string_view& str, const PdfTextState& state, double& width) const;
 
+    /** Retrieve the widths of all the characters of a given text
+     *  string in PDF units, measuring it at once
+     *  \param str a utf8 string of which the widths should be calculated
+     *  \param lengths the widths of the characters, one for every code point
+     *  \remarks Produces a partial result also in case of failures. The sum
+     *  of the widths is the one returned by TryGetStringLength
+     */
+    bool TryGetCharLengths(const std::string_view& str, const PdfTextState& state, std::vector<double>& lengths) const;
+
     /** Retrieve the width of a given encoded PdfString in PDF units when
      *  drawn with the current font
      *  \param view a text string of which the width should be calculated
@@ -399,7 +410,8 @@ private:
     bool TryMapCIDToGID(unsigned cid, PdfGlyphAccess access, unsigned& gid) const;
 
 private:
-    bool tryConvertToGIDs(const std::string_view& utf8Str, PdfGlyphAccess access, std::vector<unsigned>& gids) const;
+    bool tryConvertToGID(char32_t codePoint, PdfGlyphAccess access, unsigned& gid) const;
+    bool tryGetCharLengthRaw(char32_t codePoint, double& lengthRaw) const;
     bool tryAddSubsetGID(unsigned gid, const unicodeview& codePoints, PdfCID& cid);
 
     void initBase(const PdfEncoding& encoding);
@@ -414,6 +426,13 @@ private:
 
     void initWordSpacingLength();
 
+    void initGlyphScanCache();
+
+    void initGlyphWidthCache();
+
+    bool tryScanEncodedString(const std::string_view& encodedStr, const PdfTextState& state,
+        std::string& utf8str, std::vector<double>& lengths, std::vector<unsigned>& positions) const;
+
 private:
     std::string m_Name;
     std::string m_SubsetPrefix;
@@ -423,6 +442,8 @@ private:
     UsedGIDsMap m_SubsetGIDs;
     PdfCIDToGIDMapConstPtr m_cidToGidMap;
     double m_WordSpacingLengthRaw;
+    std::unique_ptr<PdfGlyphScanCache> m_GlyphScanCache;
+    std::unique_ptr<PdfGlyphWidthCache> m_GlyphWidthCache;
 
 protected:
     PdfFontMetricsConstPtr m_Metrics;
@@ -31,6 +31,7 @@ protected:
     PdfObject* getDescendantFontObject() override;
     void createWidths(PdfDictionary& fontDict, const CIDToGIDMap& glyphWidths);
     static CIDToGIDMap getCIDToGIDMapSubset(const UsedGIDsMap& usedGIDs);
+    void createCIDSet();
 
 private:
     CIDToGIDMap getIdentityCIDToGIDMap();
@@ -7,6 +7,8 @@
 #include <podofo/private/PdfDeclarationsPrivate.h>
 #include "PdfFontCIDType1.h"
 
+#include <podofo/private/FontCFFSubset.h>
+
 using namespace std;
 using namespace PoDoFo;
 
@@ -15,8 +17,35 @@ PdfFontCIDType1::PdfFontCIDType1(PdfDocument& doc, const PdfFontMetricsConstPtr&
 
 bool PdfFontCIDType1::SupportsSubsetting() const
 {
-    // Not yet supported
-    return false;
+    // Only CFF fonts, also wrapped in OpenType, can be subsetted.
+    // The Standard14 fonts are still embedded whole, keeping
+    // their glyphs selected by GIDs
+    if (GetMetrics().GetFontFileType() != PdfFontFileType::Type1CCF
+        || IsStandard14Font())
+    {
+        return false;
+    }
+
+    // NOTE: The fonts not handled by the subsetter are embedded
+    // whole. This must be known before glyphs are assigned subset
+    // CIDs, which wouldn't select the right glyphs in the whole font
+    try
+    {
+        FontCFFSubset::CheckFont(GetMetrics());
+        return true;
+    }
+    catch (const PdfError& error)
+    {
+        if (error.GetCode() != PdfErrorCode::UnsupportedFontFormat
+            && error.GetCode() != PdfErrorCode::InvalidFontData)
+        {
+            throw;
+        }
+
+        PoDoFo::LogMessage(PdfLogSeverity::Warning, "Unable to subset the font {}, embedding it whole: {}",
+            GetMetrics().GetFontName(), error.what());
+        return false;
+    }
 }
 
 PdfFontType PdfFontCIDType1::GetType() const
@@ -26,5 +55,19 @@ PdfFontType PdfFontCIDType1::GetType() const
 
 void PdfFontCIDType1::embedFontSubset()
 {
-    PODOFO_RAISE_ERROR(PdfErrorCode::NotImplemented);
+    auto& usedGIDs = GetUsedGIDs();
+    // Prepare a CID to GID for the subsetting
+    CIDToGIDMap cidToGidMap = getCIDToGIDMapSubset(usedGIDs);
+    createWidths(GetDescendantFont().GetDictionary(), cidToGidMap);
+    m_Encoding->ExportToFont(*this);
+
+    // Prepare a gid list to be used for subsetting
+    vector<unsigned> gids;
+    for (auto& pair : cidToGidMap)
+        gids.push_back(pair.second);
+
+    charbuff buffer;
+    FontCFFSubset::BuildFont(buffer, GetMetrics(), gids);
+    EmbedFontFileType1CCF(GetDescriptor(), buffer);
+    createCIDSet();
 }
@@ -44,6 +44,7 @@ string PdfFontConfigWrapper::SearchFontPath(const string_view fontPattern,
     FcResult result = FcResultMatch;
     FcValue value;
 
+    unique_lock<mutex> lock(m_mutex);
     pattern = FcPatternCreate();
     if (pattern == nullptr)
         PODOFO_RAISE_ERROR_INFO(PdfErrorCode::OutOfMemory, "FcPatternCreate returned NULL");
@@ -101,6 +102,7 @@ string PdfFontConfigWrapper::SearchFontPath(const string_view fontPattern,
 
 void PdfFontConfigWrapper::AddFontDirectory(const string_view& path)
 {
+    unique_lock<mutex> lock(m_mutex);
     if (!FcConfigAppFontAddDir(m_FcConfig, (const FcChar8*)path.data()))
         throw runtime_error("Unable to add font directory");
 }
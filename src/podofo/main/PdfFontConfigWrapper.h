@@ -9,6 +9,8 @@
 
 #include "PdfDeclarations.h"
 
+#include <mutex>
+
 FORWARD_DECLARE_FCONFIG();
 
 namespace PoDoFo {
@@ -36,6 +38,8 @@ struct PODOFO_API PdfFontConfigSearchParams final
  * will destroy the fontconfig handle.
  *
  * The fontconfig library is initialized on first used (lazy loading!)
+ *
+ * Searching fonts and adding font directories is safe from multiple threads
  */
 class PODOFO_API PdfFontConfigWrapper final
 {
@@ -50,8 +54,9 @@ public:
     /** Get the path of a font file on a Unix system using fontconfig
      *
      *  This method is only available if PoDoFo was compiled with
-     *  fontconfig support. Make sure to lock any FontConfig mutexes before
-     *  calling this method by yourself!
+     *  fontconfig support. The calls are serialized with the other
+     *  calls of this wrapper, make sure to lock any FontConfig mutexes
+     *  if using the FcConfig handle by yourself!
      *
      *  \param fontPattern search pattern of the requested font
      *  \param style font style
@@ -74,6 +79,7 @@ private:
 
 private:
     FcConfig* m_FcConfig;
+    std::mutex m_mutex;
 };
 
 };
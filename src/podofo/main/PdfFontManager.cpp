@@ -8,7 +8,11 @@
 #include "PdfFontManager.h"
 
 #include <algorithm>
+#include <list>
+#include <mutex>
 #include <podofo/private/FileSystem.h>
+#include <podofo/private/FontDirectoryIndex.h>
+#include <podofo/private/OpenSSLInternal.h>
 
 #if defined(_WIN32) && defined(PODOFO_HAVE_WIN32GDI)
 #include <podofo/private/WindowsLeanMean.h>
@@ -30,6 +34,81 @@
 using namespace std;
 using namespace PoDoFo;
 
+namespace
+{
+    /** A process wide cache of font metrics, shared by all the documents.
+     * The metrics are referenced weakly, so they are found as long as
+     * any document is using them, and the most recently used ones are
+     * also kept alive up to the maximum size. The least recently used
+     * are evicted first. The results of the font searches are cached as well
+     */
+    class FontMetricsCache final
+    {
+    public:
+        FontMetricsCache();
+
+    public:
+        PdfFontMetricsConstPtr Find(const string& key);
+        void Insert(const string& key, const PdfFontMetricsConstPtr& metrics, size_t size);
+        bool TryFindSearch(const string& key, string& path, unsigned& faceIndex);
+        void InsertSearch(const string& key, const string& path, unsigned faceIndex);
+        void ClearSearches();
+        void SetMaxSize(size_t maxSize);
+        void Clear();
+        bool IsEnabled() const { return m_maxSize.load(memory_order_relaxed) != 0; }
+
+    private:
+        struct RetainedMetrics
+        {
+            string Key;
+            PdfFontMetricsConstPtr Metrics;
+        };
+
+        struct CachedMetrics
+        {
+            weak_ptr<const PdfFontMetrics> Metrics;
+            size_t Size;
+            list<RetainedMetrics>::iterator Position;   // End if not retained
+        };
+
+        struct CachedSearch
+        {
+            string Path;
+            unsigned FaceIndex;
+        };
+
+    private:
+        void retain(CachedMetrics& cached, const string& key, const PdfFontMetricsConstPtr& metrics);
+        void removeExpired();
+        void trim(size_t maxSize);
+
+    private:
+        atomic<size_t> m_maxSize;
+        size_t m_size;
+        unordered_map<string, CachedMetrics> m_metrics;
+        list<RetainedMetrics> m_retained;  // Most recently used first
+        unordered_map<string, CachedSearch> m_searches;
+        mutex m_mutex;
+    };
+
+    struct FontDirectories
+    {
+        FontDirectoryIndex Index;
+        vector<string> DeferredPaths;   // Indexed directories not yet added to fontconfig
+        mutex Mutex;
+    };
+}
+
+static FontMetricsCache& getCache();
+static FontDirectories& getFontDirectories();
+static bool tryAddIndexedFontDirectory(const string_view& path);
+static bool trySearchIndexedFont(const string_view& fontName, const PdfFontSearchParams& params,
+    string& path, unsigned& faceIndex);
+#ifdef PODOFO_HAVE_FONTCONFIG
+static void addDeferredFontDirectories(PdfFontConfigWrapper& fc);
+#endif
+static bool tryGetFileCacheKey(const string_view& filepath, unsigned faceIndex, string& key);
+
 #if defined(_WIN32) && defined(PODOFO_HAVE_WIN32GDI)
 
 static unique_ptr<charbuff> getFontData(const LOGFONTW& inFont);
@@ -44,10 +123,12 @@ static FT_Face getFontFaceFromBuffer(const bufferview& view);
 
 #if defined(PODOFO_HAVE_FONTCONFIG)
 shared_ptr<PdfFontConfigWrapper> PdfFontManager::m_fontConfig;
+static mutex s_fontConfigMutex;
 #endif
 
 static constexpr unsigned SUBSET_PREFIX_LEN = 6;
 
+
 PdfFontManager::PdfFontManager(PdfDocument& doc)
     : m_doc(&doc)
 {
@@ -205,13 +286,10 @@ PdfFont& PdfFontManager::GetOrCreateFont(const string_view& fontPath, unsigned f
     if (found != m_cachedPaths.end())
         return *found->second;
 
-    unique_ptr<charbuff> data;
-    auto face = getFontFaceFromFile(fontPath, faceIndex, data);
-    if (face == nullptr)
+    auto metrics = getFontMetricsFromFile(fontPath, faceIndex);
+    if (metrics == nullptr)
         PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Could not parse a valid font from path {}", fontPath);
 
-    shared_ptr<PdfFontMetrics> metrics(new PdfFontMetricsFreetype(face, std::move(data)));
-    metrics->SetFilePath(string(fontPath), faceIndex);
     auto& ret = getOrCreateFontHashed(metrics, params);
     m_cachedPaths[std::move(normalizedPath)] = &ret;
     return ret;
@@ -224,16 +302,14 @@ PdfFont& PdfFontManager::GetOrCreateFontFromBuffer(const bufferview& buffer, con
 
 PdfFont& PdfFontManager::GetOrCreateFontFromBuffer(const bufferview& buffer, unsigned faceIndex, const PdfFontCreateParams& params)
 {
-    unique_ptr<charbuff> data;
-    auto face = getFontFaceFromBuffer(buffer, faceIndex, data);
-    if (face == nullptr)
+    auto metrics = getFontMetricsFromBuffer(buffer, faceIndex);
+    if (metrics == nullptr)
         PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Could not parse a valid font from the buffer");
 
-    shared_ptr<PdfFontMetrics> metrics(new PdfFontMetricsFreetype(face, std::move(data)));
     return getOrCreateFontHashed(metrics, params);
 }
 
-PdfFont& PdfFontManager::getOrCreateFontHashed(const shared_ptr<PdfFontMetrics>& metrics, const PdfFontCreateParams& params)
+PdfFont& PdfFontManager::getOrCreateFontHashed(const PdfFontMetricsConstPtr& metrics, const PdfFontCreateParams& params)
 {
     // TODO: Create a map indexed only on the hash of the font data
     // and search on that. Then remove the following
@@ -293,16 +369,10 @@ PdfFont* PdfFontManager::getImportedFont(const string_view& patternName,
     PdfFontSearchParams newParams = searchParams;
     string newPattern = (string)patternName;
     adaptSearchParams(newPattern, newParams);
-    string fontpath;
-    unsigned faceIndex;
-    unique_ptr<charbuff> data;
-    auto face = getFontFace(newPattern, newParams, data, fontpath, faceIndex);
-    if (face == nullptr)
+    auto metrics = searchFontMetrics(newPattern, newParams);
+    if (metrics == nullptr)
         return nullptr;
 
-    shared_ptr<PdfFontMetrics> metrics(new PdfFontMetricsFreetype(face, std::move(data)));
-    metrics->SetFilePath(std::move(fontpath), faceIndex);
-
     auto ret = AddImported(PdfFont::Create(*m_doc, metrics, createParams));
     fonts.push_back(ret);
     return ret;
@@ -322,23 +392,22 @@ PdfFontMetricsConstPtr PdfFontManager::SearchFontMetrics(const string_view& patt
     PdfFontSearchParams newParams = params;
     string newPattern = (string)patternName;
     adaptSearchParams(newPattern, newParams);
-    string fontpath;
-    unsigned faceIndex;
-    unique_ptr<charbuff> data;
-    auto face = getFontFace(newPattern, newParams, data, fontpath, faceIndex);
-    if (face == nullptr)
-        return nullptr;
-
-    shared_ptr<PdfFontMetrics> ret(new PdfFontMetricsFreetype(face, std::move(data)));
-    ret->SetFilePath(std::move(fontpath), faceIndex);
-    return ret;
+    return searchFontMetrics(newPattern, newParams);
 }
 
 void PdfFontManager::AddFontDirectory(const string_view& path)
 {
+    // The new fonts may change the results of the searches
+    getCache().ClearSearches();
+    bool indexed = tryAddIndexedFontDirectory(path);
 #ifdef PODOFO_HAVE_FONTCONFIG
-    auto& fc = GetFontConfigWrapper();
-    fc.AddFontDirectory(path);
+    if (!indexed)
+    {
+        auto& fc = GetFontConfigWrapper();
+        fc.AddFontDirectory(path);
+    }
+#else
+    (void)indexed;
 #endif
 #if defined(_WIN32) && defined(PODOFO_HAVE_WIN32GDI)
     string fontDir(path);
@@ -372,12 +441,38 @@ void PdfFontManager::AddFontDirectory(const string_view& path)
 #endif
 }
 
-FT_Face PdfFontManager::getFontFace(const string_view& fontName,
-    const PdfFontSearchParams& params, unique_ptr<charbuff>& data,
-    string& fontpath, unsigned& fontFaceIndex)
+void PdfFontManager::setCacheSize(size_t maxSize)
+{
+    getCache().SetMaxSize(maxSize);
+}
+
+void PdfFontManager::clearCache()
+{
+    getCache().Clear();
+}
+
+void PdfFontManager::setFontIndexFile(const string_view& filepath)
+{
+    auto& directories = getFontDirectories();
+    unique_lock<mutex> lock(directories.Mutex);
+    directories.Index.SetFilePath(filepath);
+    getCache().ClearSearches();
+}
+
+PdfFontMetricsConstPtr PdfFontManager::searchFontMetrics(const string_view& fontName,
+    const PdfFontSearchParams& params)
 {
     string path;
     unsigned faceIndex = 0;
+    if (trySearchIndexedFont(fontName, params, path, faceIndex))
+    {
+        auto ret = getFontMetricsFromFile(path, faceIndex);
+        if (ret != nullptr)
+            return ret;
+    }
+
+    path.clear();
+    faceIndex = 0;
 #ifdef PODOFO_HAVE_FONTCONFIG
     PdfFontConfigSearchParams fcParams;
     fcParams.Style = params.Style;
@@ -385,31 +480,89 @@ FT_Face PdfFontManager::getFontFace(const string_view& fontName,
         ? PdfFontConfigSearchFlags::None
         : PdfFontConfigSearchFlags::MatchPostScriptName;
 
-    auto& fc = GetFontConfigWrapper();
-    path = fc.SearchFontPath(fontName, fcParams, faceIndex);
+    string searchKey;
+    if (getCache().IsEnabled())
+    {
+        searchKey = utls::Format("{}\n{}\n{}", fontName,
+            params.Style == nullptr ? -1 : (int)*params.Style, (int)fcParams.Flags);
+    }
+
+    if (searchKey.empty() || !getCache().TryFindSearch(searchKey, path, faceIndex))
+    {
+        auto& fc = GetFontConfigWrapper();
+        addDeferredFontDirectories(fc);
+        path = fc.SearchFontPath(fontName, fcParams, faceIndex);
+        if (!searchKey.empty())
+            getCache().InsertSearch(searchKey, path, faceIndex);
+    }
 #endif
 
-    FT_Face ret = nullptr;
+    PdfFontMetricsConstPtr ret;
     if (!path.empty())
-        ret = ::getFontFaceFromFile(path, faceIndex, data);
+        ret = getFontMetricsFromFile(path, faceIndex);
 
+#if defined(_WIN32) && defined(PODOFO_HAVE_WIN32GDI)
     if (ret == nullptr)
     {
-        fontFaceIndex = 0;
-        fontpath.clear();
-#if defined(_WIN32) && defined(PODOFO_HAVE_WIN32GDI)
         // Try to use WIN32 GDI to find the font
-        data = getWin32FontData(fontName, params);
+        auto data = getWin32FontData(fontName, params);
         if (data != nullptr)
-            ret = getFontFaceFromBuffer(*data);
+        {
+            auto face = getFontFaceFromBuffer(*data);
+            if (face != nullptr)
+                ret.reset(new PdfFontMetricsFreetype(face, std::move(data)));
+        }
+    }
 #endif
+
+    return ret;
+}
+
+PdfFontMetricsConstPtr PdfFontManager::getFontMetricsFromFile(const string_view& filepath, unsigned faceIndex)
+{
+    string key;
+    if (getCache().IsEnabled() && tryGetFileCacheKey(filepath, faceIndex, key))
+    {
+        auto cached = getCache().Find(key);
+        if (cached != nullptr)
+            return cached;
     }
-    else
+
+    unique_ptr<charbuff> data;
+    auto face = getFontFaceFromFile(filepath, faceIndex, data);
+    if (face == nullptr)
+        return nullptr;
+
+    size_t size = data->size();
+    shared_ptr<PdfFontMetricsFreetype> ret(new PdfFontMetricsFreetype(face, std::move(data)));
+    ret->SetFilePath(string(filepath), faceIndex);
+    if (!key.empty())
+        getCache().Insert(key, ret, size);
+
+    return ret;
+}
+
+PdfFontMetricsConstPtr PdfFontManager::getFontMetricsFromBuffer(const bufferview& buffer, unsigned faceIndex)
+{
+    string key;
+    if (getCache().IsEnabled())
     {
-        fontpath = path;
-        fontFaceIndex = faceIndex;
+        key = utls::Format("data\n{}\n{}", ssl::ComputeHash(buffer, PdfHashingAlgorithm::SHA256), faceIndex);
+        auto cached = getCache().Find(key);
+        if (cached != nullptr)
+            return cached;
     }
 
+    unique_ptr<charbuff> data;
+    auto face = getFontFaceFromBuffer(buffer, faceIndex, data);
+    if (face == nullptr)
+        return nullptr;
+
+    size_t size = data->size();
+    shared_ptr<PdfFontMetricsFreetype> ret(new PdfFontMetricsFreetype(face, std::move(data)));
+    if (!key.empty())
+        getCache().Insert(key, ret, size);
+
     return ret;
 }
 
@@ -492,7 +645,7 @@ PdfFont& PdfFontManager::GetOrCreateFont(HFONT font, const PdfFontCreateParams&
         PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Could not retrieve buffer for font!");
 
     auto face = getFontFaceFromBuffer(*data);
-    shared_ptr<PdfFontMetrics> metrics(new PdfFontMetricsFreetype(face, std::move(data)));
+    PdfFontMetricsConstPtr metrics(new PdfFontMetricsFreetype(face, std::move(data)));
     return getOrCreateFontHashed(metrics, params);
 }
 
@@ -536,13 +689,15 @@ unique_ptr<charbuff> PdfFontManager::getWin32FontData(
 
 void PdfFontManager::SetFontConfigWrapper(const shared_ptr<PdfFontConfigWrapper>& fontConfig)
 {
-    if (m_fontConfig == fontConfig)
-        return;
-
     if (fontConfig == nullptr)
         PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Fontconfig wrapper can't be null");
 
+    unique_lock<mutex> lock(s_fontConfigMutex);
+    if (m_fontConfig == fontConfig)
+        return;
+
     m_fontConfig = fontConfig;
+    getCache().ClearSearches();
 }
 
 PdfFontConfigWrapper& PdfFontManager::GetFontConfigWrapper()
@@ -553,14 +708,11 @@ PdfFontConfigWrapper& PdfFontManager::GetFontConfigWrapper()
 
 shared_ptr<PdfFontConfigWrapper> PdfFontManager::ensureInitializedFontConfig()
 {
-    auto ret = m_fontConfig;
-    if (ret == nullptr)
-    {
-        ret.reset(new PdfFontConfigWrapper());
-        m_fontConfig = ret;
-    }
+    unique_lock<mutex> lock(s_fontConfigMutex);
+    if (m_fontConfig == nullptr)
+        m_fontConfig.reset(new PdfFontConfigWrapper());
 
-    return ret;
+    return m_fontConfig;
 }
 
 #endif // PODOFO_HAVE_FONTCONFIG
@@ -590,6 +742,228 @@ bool PdfFontManager::EqualElement::operator()(const Descriptor& lhs, const Descr
         && lhs.Style == rhs.Style;
 }
 
+FontMetricsCache::FontMetricsCache() :
+    m_maxSize(0),
+    m_size(0)
+{
+    // Ensure the FreeType library is destroyed
+    // after the faces of the cached metrics
+    (void)FT::GetLibrary();
+}
+
+PdfFontMetricsConstPtr FontMetricsCache::Find(const string& key)
+{
+    unique_lock<mutex> lock(m_mutex);
+    auto found = m_metrics.find(key);
+    if (found == m_metrics.end())
+        return nullptr;
+
+    auto metrics = found->second.Metrics.lock();
+    if (metrics == nullptr)
+    {
+        m_metrics.erase(found);
+        return nullptr;
+    }
+
+    retain(found->second, key, metrics);
+    return metrics;
+}
+
+void FontMetricsCache::Insert(const string& key, const PdfFontMetricsConstPtr& metrics, size_t size)
+{
+    unique_lock<mutex> lock(m_mutex);
+    removeExpired();
+
+    // Another thread may have cached the same metrics meanwhile
+    auto& cached = m_metrics[key];
+    if (cached.Metrics.lock() != nullptr && cached.Position != m_retained.end())
+    {
+        m_size -= cached.Size;
+        m_retained.erase(cached.Position);
+    }
+
+    cached.Metrics = metrics;
+    cached.Size = size;
+    cached.Position = m_retained.end();
+    retain(cached, key, metrics);
+}
+
+bool FontMetricsCache::TryFindSearch(const string& key, string& path, unsigned& faceIndex)
+{
+    unique_lock<mutex> lock(m_mutex);
+    auto found = m_searches.find(key);
+    if (found == m_searches.end())
+        return false;
+
+    path = found->second.Path;
+    faceIndex = found->second.FaceIndex;
+    return true;
+}
+
+void FontMetricsCache::InsertSearch(const string& key, const string& path, unsigned faceIndex)
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_searches[key] = { path, faceIndex };
+}
+
+void FontMetricsCache::ClearSearches()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_searches.clear();
+}
+
+void FontMetricsCache::SetMaxSize(size_t maxSize)
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_maxSize.store(maxSize, memory_order_relaxed);
+    trim(maxSize);
+    if (maxSize == 0)
+    {
+        m_metrics.clear();
+        m_searches.clear();
+    }
+}
+
+void FontMetricsCache::Clear()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_metrics.clear();
+    m_retained.clear();
+    m_searches.clear();
+    m_size = 0;
+}
+
+// Mark the metrics as the most recently used, keeping them alive
+void FontMetricsCache::retain(CachedMetrics& cached, const string& key, const PdfFontMetricsConstPtr& metrics)
+{
+    if (cached.Position != m_retained.end())
+    {
+        m_retained.splice(m_retained.begin(), m_retained, cached.Position);
+        return;
+    }
+
+    size_t maxSize = m_maxSize.load(memory_order_relaxed);
+    if (cached.Size > maxSize)
+        return;
+
+    trim(maxSize - cached.Size);
+    m_retained.push_front({ key, metrics });
+    cached.Position = m_retained.begin();
+    m_size += cached.Size;
+}
+
+void FontMetricsCache::removeExpired()
+{
+    for (auto it = m_metrics.begin(); it != m_metrics.end(); )
+    {
+        if (it->second.Metrics.expired())
+            it = m_metrics.erase(it);
+        else
+            it++;
+    }
+}
+
+// Release the least recently used metrics until the size fits.
+// They are still found as long as they are in use
+void FontMetricsCache::trim(size_t maxSize)
+{
+    while (m_size > maxSize)
+    {
+        auto& cached = m_metrics[m_retained.back().Key];
+        m_size -= cached.Size;
+        cached.Position = m_retained.end();
+        m_retained.pop_back();
+    }
+}
+
+FontMetricsCache& getCache()
+{
+    static FontMetricsCache s_cache;
+    return s_cache;
+}
+
+FontDirectories& getFontDirectories()
+{
+    static FontDirectories s_directories;
+    return s_directories;
+}
+
+// NOTE: Scanning the directory with fontconfig is deferred
+// until a font is not found in the index
+bool tryAddIndexedFontDirectory(const string_view& path)
+{
+    auto& directories = getFontDirectories();
+    unique_lock<mutex> lock(directories.Mutex);
+    if (!directories.Index.IsEnabled())
+        return false;
+
+    directories.Index.AddDirectory(path);
+    directories.DeferredPaths.push_back((string)path);
+    return true;
+}
+
+#ifdef PODOFO_HAVE_FONTCONFIG
+
+void addDeferredFontDirectories(PdfFontConfigWrapper& fc)
+{
+    auto& directories = getFontDirectories();
+    vector<string> paths;
+    {
+        unique_lock<mutex> lock(directories.Mutex);
+        paths = std::move(directories.DeferredPaths);
+        directories.DeferredPaths.clear();
+    }
+
+    for (auto& path : paths)
+    {
+        try
+        {
+            fc.AddFontDirectory(path);
+        }
+        catch (const exception& ex)
+        {
+            PoDoFo::LogMessage(PdfLogSeverity::Warning, "Unable to add font directory {}: {}", path, ex.what());
+        }
+    }
+}
+
+#endif // PODOFO_HAVE_FONTCONFIG
+
+bool trySearchIndexedFont(const string_view& fontName, const PdfFontSearchParams& params,
+    string& path, unsigned& faceIndex)
+{
+    auto& directories = getFontDirectories();
+    unique_lock<mutex> lock(directories.Mutex);
+    if (!directories.Index.IsEnabled())
+        return false;
+
+    return directories.Index.TrySearchFont(fontName,
+        (params.MatchBehavior & PdfFontMatchBehaviorFlags::MatchPostScriptName) != PdfFontMatchBehaviorFlags::None,
+        params.Style, path, faceIndex);
+}
+
+// The key of a font file includes its size and modification
+// time, so the cached metrics of a changed file are not used
+bool tryGetFileCacheKey(const string_view& filepath, unsigned faceIndex, string& key)
+{
+    error_code ec;
+    auto path = fs::canonical(fs::u8path(filepath), ec);
+    if (ec)
+        return false;
+
+    auto size = fs::file_size(path, ec);
+    if (ec)
+        return false;
+
+    auto time = fs::last_write_time(path, ec);
+    if (ec)
+        return false;
+
+    key = utls::Format("file\n{}\n{}\n{}\n{}", path.u8string(), faceIndex,
+        size, (int64_t)time.time_since_epoch().count());
+    return true;
+}
+
 FT_Face getFontFaceFromFile(const string_view& filepath, unsigned faceIndex, unique_ptr<charbuff>& data)
 {
     charbuff buffer;
@@ -148,6 +148,12 @@ private:
 
     static void AddFontDirectory(const std::string_view& path);
 
+    static void setCacheSize(size_t maxSize);
+
+    static void clearCache();
+
+    static void setFontIndexFile(const std::string_view& filepath);
+
 private:
     /** A private structure, which represents a cached font
      */
@@ -193,15 +199,16 @@ private:
     static std::shared_ptr<PdfFontConfigWrapper> ensureInitializedFontConfig();
 #endif // PODOFO_HAVE_FONTCONFIG
 
-    static FT_Face getFontFace(const std::string_view& fontName,
-        const PdfFontSearchParams& params, std::unique_ptr<charbuff>& data,
-        std::string& fontpath, unsigned& faceIndex);
+    static PdfFontMetricsConstPtr searchFontMetrics(const std::string_view& fontName,
+        const PdfFontSearchParams& params);
+    static PdfFontMetricsConstPtr getFontMetricsFromFile(const std::string_view& filepath, unsigned faceIndex);
+    static PdfFontMetricsConstPtr getFontMetricsFromBuffer(const bufferview& buffer, unsigned faceIndex);
     PdfFont* getImportedFont(const std::string_view& patternName,
         const PdfFontSearchParams& searchParams, const PdfFontCreateParams& createParams);
     static void adaptSearchParams(std::string& patternName,
         PdfFontSearchParams& searchParams);
     PdfFont* addImported(std::vector<PdfFont*>& fonts, std::unique_ptr<PdfFont>&& font);
-    PdfFont& getOrCreateFontHashed(const std::shared_ptr<PdfFontMetrics>& metrics, const PdfFontCreateParams& params);
+    PdfFont& getOrCreateFontHashed(const PdfFontMetricsConstPtr& metrics, const PdfFontCreateParams& params);
 
 #if defined(_WIN32) && defined(PODOFO_HAVE_WIN32GDI)
     static std::unique_ptr<charbuff> getWin32FontData(const std::string_view& fontName,
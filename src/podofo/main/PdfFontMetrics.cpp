@@ -101,12 +101,11 @@ string_view PdfFontMetrics::GetBaseFontNameSafe() const
 
 void PdfFontMetrics::initBaseFontNameSafe()
 {
-    if (m_BaseFontNameSafe != nullptr)
-        return;
-
-    m_BaseFontNameSafe.reset(new string(GetBaseFontName()));
-    if (m_BaseFontNameSafe->length() == 0)
-        *m_BaseFontNameSafe = PoDoFo::NormalizeFontName(GetFontFamilyName());;
+    std::call_once(m_BaseFontNameSafeInit, [this]() {
+        m_BaseFontNameSafe.reset(new string(GetBaseFontName()));
+        if (m_BaseFontNameSafe->length() == 0)
+            *m_BaseFontNameSafe = PoDoFo::NormalizeFontName(GetFontFamilyName());
+    });
 }
 
 string_view PdfFontMetrics::GetFontNameRaw() const
@@ -184,28 +183,32 @@ double PdfFontMetrics::GetDefaultWidth() const
 
 PdfFontStyle PdfFontMetrics::GetStyle() const
 {
-    if (m_Style.has_value())
-        return *m_Style;
-
-    // ISO 32000-1:2008: Table 122 – Entries common to all font descriptors
-    // The possible values shall be 100, 200, 300, 400, 500, 600, 700, 800,
-    // or 900, where each number indicates a weight that is at least as dark
-    // as its predecessor. A value of 400 shall indicate a normal weight;
-    // 700 shall indicate bold
-    bool isBold = getIsBoldHint()
-        || GetWeightRaw() >= 700;
-    bool isItalic = getIsItalicHint()
-        || (GetFlags() & PdfFontDescriptorFlags::Italic) != PdfFontDescriptorFlags::None
-        || GetItalicAngle() != 0;
-    PdfFontStyle style = PdfFontStyle::Regular;
-    if (isBold)
-        style |= PdfFontStyle::Bold;
-    if (isItalic)
-        style |= PdfFontStyle::Italic;
-    const_cast<PdfFontMetrics&>(*this).m_Style = style;
+    const_cast<PdfFontMetrics&>(*this).initStyle();
     return *m_Style;
 }
 
+void PdfFontMetrics::initStyle()
+{
+    std::call_once(m_StyleInit, [this]() {
+        // ISO 32000-1:2008: Table 122 – Entries common to all font descriptors
+        // The possible values shall be 100, 200, 300, 400, 500, 600, 700, 800,
+        // or 900, where each number indicates a weight that is at least as dark
+        // as its predecessor. A value of 400 shall indicate a normal weight;
+        // 700 shall indicate bold
+        bool isBold = getIsBoldHint()
+            || GetWeightRaw() >= 700;
+        bool isItalic = getIsItalicHint()
+            || (GetFlags() & PdfFontDescriptorFlags::Italic) != PdfFontDescriptorFlags::None
+            || GetItalicAngle() != 0;
+        PdfFontStyle style = PdfFontStyle::Regular;
+        if (isBold)
+            style |= PdfFontStyle::Bold;
+        if (isItalic)
+            style |= PdfFontStyle::Italic;
+        m_Style = style;
+    });
+}
+
 bool PdfFontMetrics::IsObjectLoaded() const
 {
     return false;
@@ -290,6 +293,7 @@ bool PdfFontMetrics::TryGetImplicitEncoding(PdfEncodingMapConstPtr& encoding) co
         FT_Face face;
         if (TryGetOrLoadFace(face))
         {
+            lock_guard<mutex> lock(FT::GetFaceMutex(face));
             encoding = getFontType1Encoding(face);
             return true;
         }
@@ -339,36 +343,28 @@ const PdfCIDToGIDMapConstPtr& PdfFontMetrics::getCIDToGIDMap() const
     return s_null;
 }
 
-PdfFontMetricsBase::PdfFontMetricsBase()
-    : m_dataInit(false), m_faceInit(false) { }
+PdfFontMetricsBase::PdfFontMetricsBase() { }
 
 const datahandle& PdfFontMetricsBase::GetFontFileDataHandle() const
 {
-    if (!m_dataInit)
-    {
-        auto& rthis = const_cast<PdfFontMetricsBase&>(*this);
-        rthis.m_Data = getFontFileDataHandle();
-        rthis.m_dataInit = true;
-    }
+    auto& rthis = const_cast<PdfFontMetricsBase&>(*this);
+    std::call_once(rthis.m_dataInit, [&rthis]() {
+        rthis.m_Data = rthis.getFontFileDataHandle();
+    });
 
     return m_Data;
 }
 
 const FreeTypeFacePtr& PdfFontMetricsBase::GetFaceHandle() const
 {
-    if (!m_faceInit)
-    {
-        auto& rthis = const_cast<PdfFontMetricsBase&>(*this);
-        auto view = GetFontFileDataHandle().view();
+    auto& rthis = const_cast<PdfFontMetricsBase&>(*this);
+    std::call_once(rthis.m_faceInit, [&rthis]() {
+        auto view = rthis.GetFontFileDataHandle().view();
         // NOTE: The data always represent a face, collections are not allowed
         FT_Face face = nullptr;
         if (view.size() != 0 && (face = FT::CreateFaceFromBuffer(view)) != nullptr)
             rthis.m_Face = FreeTypeFacePtr(face);
-        else
-            rthis.m_Face = FreeTypeFacePtr();
-
-        rthis.m_faceInit = true;
-    }
+    });
 
     return m_Face;
 }
@@ -376,11 +372,11 @@ const FreeTypeFacePtr& PdfFontMetricsBase::GetFaceHandle() const
 FreeTypeFacePtr::FreeTypeFacePtr() { }
 
 FreeTypeFacePtr::FreeTypeFacePtr(FT_Face face)
-    : shared_ptr<FT_FaceRec_>(face, FT_Done_Face) {}
+    : shared_ptr<FT_FaceRec_>(face, FT::DoneFace) {}
 
 void FreeTypeFacePtr::reset(FT_Face face)
 {
-    shared_ptr<FT_FaceRec_>::reset(face, FT_Done_Face);
+    shared_ptr<FT_FaceRec_>::reset(face, FT::DoneFace);
 }
 
 void PdfFontMetrics::SetFilePath(std::string&& filepath, unsigned faceIndex)
@@ -9,6 +9,8 @@
 
 #include "PdfDeclarations.h"
 
+#include <mutex>
+
 #include "PdfString.h"
 #include "PdfCMapEncoding.h"
 #include "PdfCIDToGIDMap.h"
@@ -333,6 +335,7 @@ private:
     void SetFilePath(std::string&& filepath, unsigned faceIndex);
 
 private:
+    void initStyle();
     void initBaseFontNameSafe();
     static PdfEncodingMapConstPtr getFontType1Encoding(FT_Face face);
 
@@ -342,7 +345,11 @@ private:
 
 private:
     std::string m_FilePath;
+    // NOTE: Lazily initialized members are guarded,
+    // as metrics may be shared by many threads
+    std::once_flag m_StyleInit;
     nullable<PdfFontStyle> m_Style;
+    std::once_flag m_BaseFontNameSafeInit;
     std::unique_ptr<std::string> m_BaseFontNameSafe;
     unsigned m_FaceIndex;
 };
@@ -358,9 +365,9 @@ protected:
     virtual datahandle getFontFileDataHandle() const = 0;
 
 private:
-    bool m_dataInit;
+    std::once_flag m_dataInit;
     datahandle m_Data;
-    bool m_faceInit;
+    std::once_flag m_faceInit;
     FreeTypeFacePtr m_Face;
 };
 
@@ -28,7 +28,7 @@ PdfFontMetricsFreetype::PdfFontMetricsFreetype(const FreeTypeFacePtr& face, cons
         const PdfFontMetrics* refMetrics) :
     m_Face(face),
     m_Data(data),
-    m_LengthsReady(false),
+    m_unicodeCharmapIndex(-1),
     m_Length1(0),
     m_Length2(0),
     m_Length3(0)
@@ -83,20 +83,33 @@ void PdfFontMetricsFreetype::init(const PdfFontMetrics* refMetrics)
     m_Ascent = m_Face->ascender / (double)m_Face->units_per_EM;
     m_Descent = m_Face->descender / (double)m_Face->units_per_EM;
 
-    // Try to select an unicode charmap
-    if (FT_Select_Charmap(m_Face.get(), FT_ENCODING_UNICODE) == 0)
     {
-        m_HasUnicodeMapping = true;
-    }
-    else if (refMetrics == nullptr || !refMetrics->IsObjectLoaded())
-    {
-        // Avoid try to create fallback maps from loaded metrics,
-        // they may be fake char maps for subsets
-        m_HasUnicodeMapping = tryBuildFallbackUnicodeMap();
-    }
-    else
-    {
-        m_HasUnicodeMapping = false;
+        // NOTE: Selecting charmaps modifies the face, which
+        // is shared with the reference metrics, if any
+        lock_guard<mutex> lock(FT::GetFaceMutex(m_Face.get()));
+
+        // Try to select an unicode charmap
+        auto oldCharmap = m_Face->charmap;
+        if (FT_Select_Charmap(m_Face.get(), FT_ENCODING_UNICODE) == 0)
+        {
+            m_unicodeCharmapIndex = FT_Get_Charmap_Index(m_Face->charmap);
+            m_HasUnicodeMapping = true;
+        }
+        else if (refMetrics == nullptr || !refMetrics->IsObjectLoaded())
+        {
+            // Avoid try to create fallback maps from loaded metrics,
+            // they may be fake char maps for subsets
+            m_HasUnicodeMapping = tryBuildFallbackUnicodeMap();
+
+            // Restore the charmap the other users of the face may rely on.
+            // NOTE: Initial charmap may be null
+            if (oldCharmap != nullptr)
+                (void)FT_Set_Charmap(m_Face.get(), oldCharmap);
+        }
+        else
+        {
+            m_HasUnicodeMapping = false;
+        }
     }
 
     // Set some default values, in case the font has no direct values
@@ -207,23 +220,20 @@ void PdfFontMetricsFreetype::init(const PdfFontMetrics* refMetrics)
 
 void PdfFontMetricsFreetype::ensureLengthsReady()
 {
-    if (m_LengthsReady)
-        return;
-
-    switch (m_FontFileType)
-    {
-        case PdfFontFileType::Type1:
-            initType1Lengths(m_Data.view());
-            break;
-        case PdfFontFileType::TrueType:
-            m_Length1 = (unsigned)m_Data.view().size();
-            break;
-        default:
-            // Other font types don't need lengths
-            break;
-    }
-
-    m_LengthsReady = true;
+    std::call_once(m_LengthsInit, [this]() {
+        switch (m_FontFileType)
+        {
+            case PdfFontFileType::Type1:
+                initType1Lengths(m_Data.view());
+                break;
+            case PdfFontFileType::TrueType:
+                m_Length1 = (unsigned)m_Data.view().size();
+                break;
+            default:
+                // Other font types don't need lengths
+                break;
+        }
+    });
 }
 
 void PdfFontMetricsFreetype::initType1Lengths(const bufferview& view)
@@ -324,6 +334,8 @@ unsigned PdfFontMetricsFreetype::GetGlyphCount() const
 
 bool PdfFontMetricsFreetype::TryGetGlyphWidth(unsigned gid, double& width) const
 {
+    // NOTE: Loading the glyph modifies the face
+    lock_guard<mutex> lock(FT::GetFaceMutex(m_Face.get()));
     if (FT_Load_Glyph(m_Face.get(), gid, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP) != 0)
     {
         width = -1;
@@ -361,6 +373,8 @@ bool PdfFontMetricsFreetype::TryGetGID(char32_t codePoint, unsigned& gid) const
         return true;
     }
 
+    lock_guard<mutex> lock(FT::GetFaceMutex(m_Face.get()));
+    selectUnicodeCharmap();
     gid = FT_Get_Char_Index(m_Face.get(), codePoint);
     return gid != 0;
 }
@@ -372,6 +386,8 @@ unique_ptr<PdfCMapEncoding> PdfFontMetricsFreetype::CreateToUnicodeMap(const Pdf
     FT_ULong charcode;
     FT_UInt gid;
 
+    lock_guard<mutex> lock(FT::GetFaceMutex(m_Face.get()));
+    selectUnicodeCharmap();
     charcode = FT_Get_First_Char(m_Face.get(), &gid);
     while (gid != 0)
     {
@@ -382,6 +398,17 @@ unique_ptr<PdfCMapEncoding> PdfFontMetricsFreetype::CreateToUnicodeMap(const Pdf
     return std::make_unique<PdfCMapEncoding>(std::move(map));
 }
 
+// NOTE: The face mutex must be locked. The face may be shared with
+// other metrics that selected another charmap
+void PdfFontMetricsFreetype::selectUnicodeCharmap() const
+{
+    if (m_unicodeCharmapIndex == -1 || m_Face->charmap == m_Face->charmaps[m_unicodeCharmapIndex])
+        return;
+
+    FT_Error rc = FT_Set_Charmap(m_Face.get(), m_Face->charmaps[m_unicodeCharmapIndex]);
+    CHECK_FT_RC(rc, FT_Set_Charmap);
+}
+
 bool PdfFontMetricsFreetype::tryBuildFallbackUnicodeMap()
 {
     auto os2Table = static_cast<TT_OS2*>(FT_Get_Sfnt_Table(m_Face.get(), FT_SFNT_OS2));
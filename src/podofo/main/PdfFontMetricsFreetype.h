@@ -120,6 +120,8 @@ private:
 
     bool tryBuildFallbackUnicodeMap();
 
+    void selectUnicodeCharmap() const;
+
 private:
     FreeTypeFacePtr m_Face;
     datahandle m_Data;
@@ -127,6 +129,7 @@ private:
     PdfFontFileType m_FontFileType;
 
     bool m_HasUnicodeMapping;
+    int m_unicodeCharmapIndex;      // -1 if the face has no unicode charmap
     std::unique_ptr<std::unordered_map<uint32_t, unsigned>> m_fallbackUnicodeMap;
 
     std::string m_FontBaseName;
@@ -153,7 +156,7 @@ private:
     double m_StrikeThroughThickness;
     double m_StrikeThroughPosition;
 
-    bool m_LengthsReady;
+    std::once_flag m_LengthsInit;
     unsigned m_Length1;
     unsigned m_Length2;
     unsigned m_Length3;
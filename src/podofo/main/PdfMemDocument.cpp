@@ -52,7 +52,7 @@ PdfMemDocument::PdfMemDocument(const shared_ptr<InputStreamDevice>& device, cons
     if (device == nullptr)
         PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
-    loadFromDevice(device, password);
+    loadFromDevice(device, password, nullptr);
 }
 
 PdfMemDocument::PdfMemDocument(const PdfMemDocument& rhs) :
@@ -135,10 +135,38 @@ void PdfMemDocument::LoadFromDevice(const shared_ptr<InputStreamDevice>& device,
         PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
     this->Clear();
-    loadFromDevice(device, password);
+    loadFromDevice(device, password, nullptr);
 }
 
-void PdfMemDocument::loadFromDevice(const shared_ptr<InputStreamDevice>& device, const string_view& password)
+void PdfMemDocument::Load(const string_view& filename, const PdfEncryptionKey& key)
+{
+    if (filename.length() == 0)
+        PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    auto device = std::make_shared<FileStreamDevice>(filename);
+    LoadFromDevice(device, key);
+}
+
+void PdfMemDocument::LoadFromBuffer(const bufferview& buffer, const PdfEncryptionKey& key)
+{
+    if (buffer.size() == 0)
+        PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    auto device = std::make_shared<SpanStreamDevice>(buffer);
+    LoadFromDevice(device, key);
+}
+
+void PdfMemDocument::LoadFromDevice(const shared_ptr<InputStreamDevice>& device, const PdfEncryptionKey& key)
+{
+    if (device == nullptr)
+        PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    this->Clear();
+    loadFromDevice(device, { }, &key);
+}
+
+void PdfMemDocument::loadFromDevice(const shared_ptr<InputStreamDevice>& device, const string_view& password,
+    const PdfEncryptionKey* key)
 {
     m_device = device;
 
@@ -146,6 +174,9 @@ void PdfMemDocument::loadFromDevice(const shared_ptr<InputStreamDevice>& device,
     // so that m_Parser is initialized for encrypted documents
     PdfParser parser(PdfDocument::GetObjects());
     parser.SetPassword(password);
+    if (key != nullptr)
+        parser.SetEncryptionKey(*key);
+
     parser.Parse(*device, true);
     initFromParser(parser);
 }
@@ -238,6 +269,10 @@ void PdfMemDocument::Save(OutputStreamDevice& device, PdfSaveOptions opts)
 {
     beforeWrite(opts);
 
+    // All the objects are going to be written, so load
+    // them upfront to decrypt their streams in parallel
+    PdfParser::parseStreams(this->GetObjects());
+
     PdfWriter writer(this->GetObjects(), this->GetTrailer().GetObject());
     writer.SetPdfVersion(this->GetPdfVersion());
     writer.SetSaveOptions(opts);
@@ -306,6 +341,14 @@ void PdfMemDocument::beforeWrite(PdfSaveOptions opts)
 
     GetFonts().EmbedFonts();
 
+    if ((opts & PdfSaveOptions::OptimizeContents) ==
+        PdfSaveOptions::OptimizeContents)
+    {
+        auto& pages = GetPages();
+        for (unsigned i = 0; i < pages.GetCount(); i++)
+            pages.GetPageAt(i).OptimizeContents();
+    }
+
     // After we are done with all operations on objects,
     // we can collect garbage
     if ((opts & PdfSaveOptions::NoCollectGarbage) ==
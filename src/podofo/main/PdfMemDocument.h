@@ -76,6 +76,27 @@ public:
      */
     void LoadFromDevice(const std::shared_ptr<InputStreamDevice>& device, const std::string_view& password = { });
 
+    /** Load an encrypted PdfMemDocument from a file, authenticating
+     *  with a file encryption key exported from a previous load
+     *
+     *  \see PdfEncrypt::ExportEncryptionKey
+     */
+    void Load(const std::string_view& filename, const PdfEncryptionKey& key);
+
+    /** Load an encrypted PdfMemDocument from a buffer in memory, authenticating
+     *  with a file encryption key exported from a previous load
+     *
+     *  \see PdfEncrypt::ExportEncryptionKey
+     */
+    void LoadFromBuffer(const bufferview& buffer, const PdfEncryptionKey& key);
+
+    /** Load an encrypted PdfMemDocument from a device, authenticating
+     *  with a file encryption key exported from a previous load
+     *
+     *  \see PdfEncrypt::ExportEncryptionKey
+     */
+    void LoadFromDevice(const std::shared_ptr<InputStreamDevice>& device, const PdfEncryptionKey& key);
+
     /** Save the complete document to a file
      *
      *  \param filename filename of the document
@@ -229,7 +250,8 @@ private:
     PdfMemDocument(bool empty);
 
 private:
-    void loadFromDevice(const std::shared_ptr<InputStreamDevice>& device, const std::string_view& password);
+    void loadFromDevice(const std::shared_ptr<InputStreamDevice>& device, const std::string_view& password,
+        const PdfEncryptionKey* key);
 
     /** Internal method to load all objects from a PdfParser object.
      *  The objects will be removed from the parser and are now
@@ -67,15 +67,9 @@ void PdfMemoryObjectStream::Write(OutputStream& stream, const PdfStatefulEncrypt
 {
     stream.Write("stream\n");
     if (encrypt.HasEncrypt())
-    {
-        charbuff encrypted;
-        encrypt.EncryptTo(encrypted, { m_buffer.data(), m_buffer.size() });
-        stream.Write(encrypted);
-    }
+        encrypt.EncryptTo(stream, { m_buffer.data(), m_buffer.size() });
     else
-    {
         stream.Write(string_view(m_buffer.data(), m_buffer.size()));
-    }
 
     stream.Write("\nendstream\n");
     stream.Flush();
@@ -15,6 +15,8 @@
 #include "PdfMemoryObjectStream.h"
 #include <podofo/auxiliary/StreamDevice.h>
 
+#include <mutex>
+
 using namespace std;
 using namespace PoDoFo;
 
@@ -159,12 +161,16 @@ void PdfObject::SetDocument(PdfDocument* document)
 
 void PdfObject::DelayedLoad() const
 {
-    if (m_IsDelayedLoadDone)
+    if (m_IsDelayedLoadDone.load(memory_order_acquire))
+        return;
+
+    lock_guard<recursive_mutex> lock(GetDelayedLoadMutex());
+    if (m_IsDelayedLoadDone.load(memory_order_relaxed))
         return;
 
     const_cast<PdfObject&>(*this).DelayedLoadImpl();
-    m_IsDelayedLoadDone = true;
     const_cast<PdfObject&>(*this).SetVariantOwner();
+    m_IsDelayedLoadDone.store(true, memory_order_release);
 }
 
 void PdfObject::DelayedLoadImpl()
@@ -365,11 +371,23 @@ void PdfObject::DelayedLoadStream() const
 
 void PdfObject::delayedLoadStream() const
 {
-    if (m_IsDelayedLoadStreamDone)
+    if (m_IsDelayedLoadStreamDone.load(memory_order_acquire))
+        return;
+
+    lock_guard<recursive_mutex> lock(GetDelayedLoadMutex());
+    if (m_IsDelayedLoadStreamDone.load(memory_order_relaxed))
         return;
 
     const_cast<PdfObject&>(*this).DelayedLoadStreamImpl();
-    m_IsDelayedLoadStreamDone = true;
+    m_IsDelayedLoadStreamDone.store(true, memory_order_release);
+}
+
+// The lock is recursive, since loading an object
+// may require to load the objects it refers, eg. /Length
+recursive_mutex& PdfObject::GetDelayedLoadMutex() const
+{
+    static recursive_mutex s_mutex;
+    return s_mutex;
 }
 
 // TODO2: SetDirty only if the value to be added is different
@@ -10,6 +10,9 @@
 #include "PdfVariant.h"
 #include "PdfObjectStream.h"
 
+#include <atomic>
+#include <mutex>
+
 namespace PoDoFo {
 
 class PdfEncrypt;
@@ -418,6 +421,11 @@ public:
      */
     inline bool IsDelayedLoadDone() const { return m_IsDelayedLoadDone; }
 
+    /**
+     * Same as IsDelayedLoadDone(), but for the stream
+     */
+    inline bool IsDelayedLoadStreamDone() const { return m_IsDelayedLoadStreamDone; }
+
     const PdfObjectStream* GetStream() const;
     PdfObjectStream* GetStream();
 
@@ -431,6 +439,8 @@ protected:
      * For objects complete created in memory and those that do not support
      * deferred loading this function does nothing, since deferred loading
      * will not be enabled.
+     *
+     * It's safe to call it concurrently from multiple threads
      */
     void DelayedLoad() const;
 
@@ -452,6 +462,12 @@ protected:
 
     virtual void DelayedLoadStreamImpl();
 
+    /** Get the mutex serializing the delayed loading. Objects reading
+     * from the same input device must share it. The default is a
+     * mutex shared by all the objects
+     */
+    virtual std::recursive_mutex& GetDelayedLoadMutex() const;
+
     /** Sets the dirty flag of this PdfVariant
      *
      *  \see IsDirty
@@ -556,8 +572,10 @@ private:
     PdfDataContainer* m_Parent;
     bool m_IsDirty; // Indicates if this object was modified after construction
     bool m_IsImmutable;
-    mutable bool m_IsDelayedLoadDone;
-    mutable bool m_IsDelayedLoadStreamDone;
+    // NOTE: Atomic since delayed loading can be
+    // triggered concurrently by multiple readers
+    mutable std::atomic<bool> m_IsDelayedLoadDone;
+    mutable std::atomic<bool> m_IsDelayedLoadStreamDone;
     std::unique_ptr<PdfObjectStream> m_Stream;
     // Tracks whether deferred loading is still pending (in which case it'll be
     // false). If true, deferred loading is not required or has been completed.
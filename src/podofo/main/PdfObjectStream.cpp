@@ -26,7 +26,7 @@ static bool isMediaFilter(PdfFilterType filterType);
 static PdfFilterList stripMediaFilters(const PdfFilterList& filters, PdfFilterList& mediaFilters);
 
 PdfObjectStream::PdfObjectStream(PdfObject& parent, std::unique_ptr<PdfObjectStreamProvider>&& provider)
-    : m_Parent(&parent), m_Provider(std::move(provider)), m_locked(false)
+    : m_Parent(&parent), m_Provider(std::move(provider)), m_locks(0)
 {
     m_Provider->Init(parent);
 }
@@ -59,7 +59,7 @@ PdfObjectOutputStream PdfObjectStream::GetOutputStream(const PdfFilterList& filt
 
 PdfObjectInputStream PdfObjectStream::GetInputStream(bool raw) const
 {
-    ensureClosed();
+    ensureNotWriting();
     return PdfObjectInputStream(const_cast<PdfObjectStream&>(*this), raw);
 }
 
@@ -384,7 +384,12 @@ void PdfObjectStream::InitData(InputStream& stream, size_t size, PdfFilterList&&
 
 void PdfObjectStream::ensureClosed() const
 {
-    PODOFO_RAISE_LOGIC_IF(m_locked, "The stream should have no read/write operations in progress");
+    PODOFO_RAISE_LOGIC_IF(m_locks != 0, "The stream should have no read/write operations in progress");
+}
+
+void PdfObjectStream::ensureNotWriting() const
+{
+    PODOFO_RAISE_LOGIC_IF(m_locks < 0, "The stream should have no write operations in progress");
 }
 
 PdfObjectInputStream::PdfObjectInputStream()
@@ -393,7 +398,7 @@ PdfObjectInputStream::PdfObjectInputStream()
 PdfObjectInputStream::~PdfObjectInputStream()
 {
     if (m_stream != nullptr)
-        m_stream->m_locked = false;
+        m_stream->m_locks--;
 }
 
 PdfObjectInputStream::PdfObjectInputStream(PdfObjectInputStream&& rhs) noexcept
@@ -405,7 +410,7 @@ PdfObjectInputStream::PdfObjectInputStream(PdfObjectInputStream&& rhs) noexcept
 PdfObjectInputStream::PdfObjectInputStream(PdfObjectStream& stream, bool raw)
     : m_stream(&stream)
 {
-    m_stream->m_locked = true;
+    m_stream->m_locks++;
     m_input = stream.getInputStream(raw, m_MediaFilters, m_MediaDecodeParms);
 }
 
@@ -436,7 +441,7 @@ PdfObjectOutputStream::~PdfObjectOutputStream()
     if (m_stream != nullptr)
     {
         // Unlock the stream
-        m_stream->m_locked = false;
+        m_stream->m_locks = 0;
 
         auto document = m_stream->GetParent().GetDocument();
         if (document != nullptr)
@@ -469,7 +474,7 @@ PdfObjectOutputStream::PdfObjectOutputStream(PdfObjectStream& stream,
     if (append)
         stream.CopyTo(buffer);
 
-    m_stream->m_locked = true;
+    m_stream->m_locks = -1;
 
     if (filters_.has_value())
     {
@@ -15,6 +15,8 @@
 #include <podofo/auxiliary/InputStream.h>
 #include "PdfObjectStreamProvider.h"
 
+#include <atomic>
+
 namespace PoDoFo {
 
 class PdfObject;
@@ -221,6 +223,8 @@ private:
 private:
     void ensureClosed() const;
 
+    void ensureNotWriting() const;
+
     std::unique_ptr<InputStream> getInputStream(bool raw, PdfFilterList& mediaFilters,
         std::vector<const PdfDictionary*>& decodeParms);
 
@@ -234,7 +238,9 @@ private:
     PdfObject* m_Parent;
     std::unique_ptr<PdfObjectStreamProvider> m_Provider;
     PdfFilterList m_Filters;
-    bool m_locked;
+    // Number of input streams in progress, or -1 when an output
+    // stream is in progress. Multiple threads can read concurrently
+    std::atomic<int> m_locks;
 };
 
 };
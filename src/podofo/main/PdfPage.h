@@ -16,10 +16,14 @@
 #include "PdfContents.h"
 #include "PdfField.h"
 #include "PdfResources.h"
+#include "PdfTextMatcher.h"
+
+#include <unordered_map>
 
 namespace PoDoFo {
 
 class PdfDocument;
+class PdfFont;
 class PdfDictionary;
 class PdfIndirectObjectList;
 class InputStream;
@@ -40,6 +44,25 @@ struct PODOFO_API PdfTextExtractParams final
     PdfTextExtractFlags Flags;
 };
 
+/** A run of text, reported as soon as it's found during text extraction
+ * \remarks All the views are valid only during the handler invocation
+ */
+struct PODOFO_API PdfTextRun final
+{
+    std::string_view Text;
+    int Page = 0;
+    double X = 0;
+    double Y = 0;
+    double Length = 0;
+    double FontSize = 0;                    ///< Font size as set by the Tf operator
+    nullable<const Rect&> BoundingBox;      ///< Set with PdfTextExtractFlags::ComputeBoundingBox
+    cspan<double> GlyphAdvances;            ///< Advance of every glyph of the run, in text order
+};
+
+/** Handler for the text runs found during text extraction
+ */
+using PdfTextRunHandler = std::function<void(const PdfTextRun& run)>;
+
 /** PdfPage is one page in the pdf document.
  *  It is possible to draw on a page using a PdfPainter object.
  *  Every document needs at least one page.
@@ -76,6 +99,36 @@ public:
         const std::string_view& pattern = { },
         const PdfTextExtractParams& params = { }) const;
 
+    void ExtractTextTo(const PdfTextRunHandler& handler,
+        const PdfTextExtractParams& params) const;
+
+    /** Extract the text of the page, invoking the handler for every
+     * run as soon as it's found, without accumulating the entries
+     */
+    void ExtractTextTo(const PdfTextRunHandler& handler,
+        const std::string_view& pattern = { },
+        const PdfTextExtractParams& params = { }) const;
+
+    /** Search all the keywords of the matcher in a single pass
+     * over the text of the page
+     * \param matches the occurrences are appended here, with the
+     *  position and length of the matched text only
+     * \param params extraction parameters. Matching flags, like
+     *  PdfTextExtractFlags::IgnoreCase, are set on the matcher instead
+     */
+    void SearchTextTo(std::vector<PdfTextMatch>& matches, const PdfTextMatcher& matcher,
+        const PdfTextExtractParams& params = { }) const;
+
+    /** Shrink the page contents, by dropping redundant graphics state
+     * changes and identity transformations, collapsing nested or empty
+     * save/restore pairs, merging adjacent text objects and normalizing
+     * the number formatting. Multiple content streams are merged
+     * \returns true if the contents were rewritten. Contents are left
+     *  untouched if malformed or if they would not get smaller
+     * \see PdfSaveOptions::OptimizeContents
+     */
+    bool OptimizeContents();
+
     Rect GetRect() const;
 
     Rect GetRectRaw() const override;
@@ -215,6 +268,9 @@ public:
     inline const PdfAnnotationCollection& GetAnnotations() const { return m_Annotations; }
 
 private:
+    // Fonts loaded by a single text extraction thread, by font object
+    using FontCache = std::unordered_map<const PdfObject*, std::unique_ptr<PdfFont>>;
+
     // To be called by PdfPageCollection
     void FlattenStructure();
     void SetIndex(unsigned index) { m_Index = index; }
@@ -225,6 +281,17 @@ private:
 
     PdfField& createField(const std::string_view& name, const std::type_info& typeInfo, const Rect& rect, bool rawRect);
 
+    // Extract the text using the given thread local fonts, or the
+    // document font manager when null
+    void extractTextTo(std::vector<PdfTextEntry>& entries, const std::string_view& pattern,
+        const PdfTextExtractParams& params, FontCache* fonts) const;
+
+    void extractTextTo(const PdfTextRunHandler& handler, const std::string_view& pattern,
+        const PdfTextExtractParams& params, FontCache* fonts) const;
+
+    void searchTextTo(std::vector<PdfTextMatch>& matches, const PdfTextMatcher& matcher,
+        const PdfTextExtractParams& params, FontCache* fonts) const;
+
     PdfResources* getResources() override;
 
     PdfObject* getContentsObject() override;
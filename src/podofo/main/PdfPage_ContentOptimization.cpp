@@ -0,0 +1,626 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#include <podofo/private/PdfDeclarationsPrivate.h>
+#include "PdfPage.h"
+
+#include "PdfDocument.h"
+#include "PdfContentStreamViewReader.h"
+
+using namespace std;
+using namespace PoDoFo;
+
+// Precision used to normalize real operands, matching PdfPainter
+static constexpr unsigned short NumberPrecision = 6;
+
+namespace
+{
+    struct OptimizedContent
+    {
+        PdfContentType Type;
+        PdfOperator Operator;
+        string_view Keyword;
+        size_t OperandIndex;
+        size_t OperandCount;
+        bufferview RawData;     ///< Verbatim data for inline images and unexpected keywords
+        bool Dropped;
+    };
+
+    // Graphics and text state parameters tracked to detect redundant settings
+    enum class StateParameter
+    {
+        LineWidth = 0,
+        LineCap,
+        LineJoin,
+        MiterLimit,
+        DashPattern,
+        RenderingIntent,
+        Flatness,
+        StrokeColor,
+        FillColor,
+        CharSpacing,
+        WordSpacing,
+        HorizontalScaling,
+        Leading,
+        Font,
+        RenderingMode,
+        Rise,
+        Count,
+    };
+
+    // The serialized operator setting each parameter. An empty value
+    // means the parameter is unknown, which is the case at start since
+    // the state may be inherited from the caller of the stream
+    using OptimizerState = array<string, (size_t)StateParameter::Count>;
+}
+
+static bool readContents(PdfContentStreamViewReader& reader, vector<OptimizedContent>& contents,
+    vector<PdfContentOperand>& operands, size_t& inputSize);
+static void dropRedundantStates(vector<OptimizedContent>& contents, const vector<PdfContentOperand>& operands);
+static void collapseSaveRestores(vector<OptimizedContent>& contents);
+static void mergeTextObjects(vector<OptimizedContent>& contents, const vector<PdfContentOperand>& operands);
+static void writeContents(string& output, const vector<OptimizedContent>& contents,
+    const vector<PdfContentOperand>& operands);
+static void writeContent(string& output, const OptimizedContent& content,
+    const vector<PdfContentOperand>& operands);
+static void writeOperand(string& output, const PdfContentOperand& operand, string& temp);
+static bool isIdentityMatrix(const OptimizedContent& content, const vector<PdfContentOperand>& operands);
+static bool isTextObjectStartingWithTm(const vector<OptimizedContent>& contents, size_t index);
+
+bool PdfPage::OptimizeContents()
+{
+    auto contentsObj = getContentsObject();
+    if (contentsObj == nullptr)
+        return false;
+
+    // NOTE: The reader holds the decoded contents, which
+    // are viewed by the operands and keywords read
+    PdfContentStreamViewReader reader(*this);
+    vector<OptimizedContent> contents;
+    vector<PdfContentOperand> operands;
+    size_t inputSize;
+    if (!readContents(reader, contents, operands, inputSize))
+        return false;
+
+    dropRedundantStates(contents, operands);
+    collapseSaveRestores(contents);
+    mergeTextObjects(contents, operands);
+
+    string output;
+    writeContents(output, contents, operands);
+    if (output.size() >= inputSize)
+        return false;
+
+    auto& doc = GetDocument();
+    PdfObject* target;
+    PdfArray* arr;
+    if (contentsObj->TryGetArray(arr))
+    {
+        target = &doc.GetObjects().CreateDictionaryObject();
+        arr->Clear();
+        arr->Add(target->GetIndirectReference());
+    }
+    else
+    {
+        target = contentsObj;
+    }
+
+    auto stream = target->GetOrCreateStream().GetOutputStream();
+    stream.Write(output);
+    return true;
+}
+
+// Read all the page contents. Fails if the contents are malformed,
+// since optimizing them may then change the rendering
+bool readContents(PdfContentStreamViewReader& reader, vector<OptimizedContent>& contents,
+    vector<PdfContentOperand>& operands, size_t& inputSize)
+{
+    PdfContentView content;
+    const char* inputStart = nullptr;
+    const char* inputEnd = nullptr;
+    while (true)
+    {
+        try
+        {
+            if (!reader.TryReadNext(content))
+                break;
+        }
+        catch (PdfError& e)
+        {
+            PoDoFo::LogMessage(PdfLogSeverity::Warning,
+                "Skipping the optimization of malformed contents: {}", e.what());
+            return false;
+        }
+
+        if (content.Warnings != PdfContentWarnings::None)
+            return false;
+
+        if (inputStart == nullptr)
+            inputStart = content.RawData.data();
+        inputEnd = content.RawData.data() + content.RawData.size();
+
+        if (content.Type == PdfContentType::ImageData)
+        {
+            // The data immediately follows its dictionary
+            // in the buffer, so they are copied together
+            auto& dict = contents.back();
+            dict.RawData = bufferview(dict.RawData.data(), inputEnd - dict.RawData.data());
+            continue;
+        }
+
+        contents.push_back({ content.Type, content.Operator, content.Keyword,
+            operands.size(), content.Operands.size(), content.RawData, false });
+        operands.insert(operands.end(), content.Operands.begin(), content.Operands.end());
+    }
+
+    inputSize = inputEnd - inputStart;
+    return true;
+}
+
+// Drop identity "cm" operators and operators setting a state
+// parameter to the value it already has. Color space operators are
+// never dropped, since they also reset the color to its initial value
+void dropRedundantStates(vector<OptimizedContent>& contents, const vector<PdfContentOperand>& operands)
+{
+    OptimizerState state;
+    vector<OptimizerState> stack;
+    string key;
+    auto resetState = [&state]() {
+        for (auto& value : state)
+            value.clear();
+    };
+    auto setParameter = [&](OptimizedContent& content, StateParameter param) {
+        key.clear();
+        writeContent(key, content, operands);
+        auto& value = state[(size_t)param];
+        if (value == key)
+        {
+            content.Dropped = true;
+            return false;
+        }
+
+        value = key;
+        return true;
+    };
+    // Colors are compared by their verbatim operands, so
+    // only exactly identical settings are dropped
+    auto setColor = [&](OptimizedContent& content, StateParameter param) {
+        key.assign(content.Keyword);
+        for (size_t i = 0; i < content.OperandCount; i++)
+        {
+            auto& operand = operands[content.OperandIndex + i];
+            key.push_back(' ');
+            key.push_back((char)('0' + (int)operand.Type));
+            key.append(operand.Data);
+        }
+
+        auto& value = state[(size_t)param];
+        if (value == key)
+        {
+            content.Dropped = true;
+            return false;
+        }
+
+        value = key;
+        return true;
+    };
+
+    for (auto& content : contents)
+    {
+        if (content.Type == PdfContentType::UnexpectedKeyword)
+        {
+            // The effect of unknown operators is unknown
+            resetState();
+            continue;
+        }
+
+        if (content.Type != PdfContentType::Operator)
+            continue;
+
+        switch (content.Operator)
+        {
+            case PdfOperator::q:
+                stack.push_back(state);
+                break;
+            case PdfOperator::Q:
+                if (stack.size() == 0)
+                {
+                    resetState();
+                }
+                else
+                {
+                    state = std::move(stack.back());
+                    stack.pop_back();
+                }
+                break;
+            case PdfOperator::cm:
+                if (isIdentityMatrix(content, operands))
+                    content.Dropped = true;
+                break;
+            case PdfOperator::gs:
+                // An extended graphics state can set any parameter
+                resetState();
+                break;
+            case PdfOperator::w:
+                setParameter(content, StateParameter::LineWidth);
+                break;
+            case PdfOperator::J:
+                setParameter(content, StateParameter::LineCap);
+                break;
+            case PdfOperator::j:
+                setParameter(content, StateParameter::LineJoin);
+                break;
+            case PdfOperator::M:
+                setParameter(content, StateParameter::MiterLimit);
+                break;
+            case PdfOperator::d:
+                setParameter(content, StateParameter::DashPattern);
+                break;
+            case PdfOperator::ri:
+                setParameter(content, StateParameter::RenderingIntent);
+                break;
+            case PdfOperator::i:
+                setParameter(content, StateParameter::Flatness);
+                break;
+            case PdfOperator::CS:
+                // Setting the color space also resets the color
+                state[(size_t)StateParameter::StrokeColor].clear();
+                break;
+            case PdfOperator::cs:
+                state[(size_t)StateParameter::FillColor].clear();
+                break;
+            case PdfOperator::SC:
+            case PdfOperator::SCN:
+                setColor(content, StateParameter::StrokeColor);
+                break;
+            case PdfOperator::sc:
+            case PdfOperator::scn:
+                setColor(content, StateParameter::FillColor);
+                break;
+            case PdfOperator::G:
+            case PdfOperator::RG:
+            case PdfOperator::K:
+                setColor(content, StateParameter::StrokeColor);
+                break;
+            case PdfOperator::g:
+            case PdfOperator::rg:
+            case PdfOperator::k:
+                setColor(content, StateParameter::FillColor);
+                break;
+            case PdfOperator::Tc:
+                setParameter(content, StateParameter::CharSpacing);
+                break;
+            case PdfOperator::Tw:
+                setParameter(content, StateParameter::WordSpacing);
+                break;
+            case PdfOperator::Tz:
+                setParameter(content, StateParameter::HorizontalScaling);
+                break;
+            case PdfOperator::TL:
+                setParameter(content, StateParameter::Leading);
+                break;
+            case PdfOperator::Tf:
+                setParameter(content, StateParameter::Font);
+                break;
+            case PdfOperator::Tr:
+                setParameter(content, StateParameter::RenderingMode);
+                break;
+            case PdfOperator::Ts:
+                setParameter(content, StateParameter::Rise);
+                break;
+            case PdfOperator::DoubleQuote:
+                // The " operator also sets word and character spacing
+                state[(size_t)StateParameter::WordSpacing].clear();
+                state[(size_t)StateParameter::CharSpacing].clear();
+                break;
+            case PdfOperator::TD:
+                // TD also sets the leading
+                state[(size_t)StateParameter::Leading].clear();
+                break;
+            default:
+                // Other operators don't change the tracked parameters
+                break;
+        }
+    }
+}
+
+// Remove empty "q Q" pairs and collapse "q q ... Q Q" sequences
+// where the inner pair encloses all the contents of the outer one
+void collapseSaveRestores(vector<OptimizedContent>& contents)
+{
+    vector<size_t> indices;
+    vector<size_t> matches;
+    vector<size_t> stack;
+    bool changed;
+    do
+    {
+        changed = false;
+        indices.clear();
+        for (size_t i = 0; i < contents.size(); i++)
+        {
+            if (!contents[i].Dropped)
+                indices.push_back(i);
+        }
+
+        // Match the save/restore pairs. Unmatched ones are left alone
+        matches.assign(indices.size(), numeric_limits<size_t>::max());
+        stack.clear();
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            auto& content = contents[indices[i]];
+            if (content.Type != PdfContentType::Operator)
+                continue;
+
+            if (content.Operator == PdfOperator::q)
+            {
+                stack.push_back(i);
+            }
+            else if (content.Operator == PdfOperator::Q && stack.size() != 0)
+            {
+                matches[stack.back()] = i;
+                matches[i] = stack.back();
+                stack.pop_back();
+            }
+        }
+
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            auto& content = contents[indices[i]];
+            if (content.Dropped || content.Type != PdfContentType::Operator
+                || content.Operator != PdfOperator::q)
+            {
+                continue;
+            }
+
+            size_t match = matches[i];
+            if (match == numeric_limits<size_t>::max() || match < i
+                || contents[indices[match]].Dropped)
+            {
+                continue;
+            }
+
+            if (match == i + 1)
+            {
+                content.Dropped = true;
+                contents[indices[match]].Dropped = true;
+                changed = true;
+            }
+            else if (matches[i + 1] == match - 1 && contents[indices[i + 1]].Operator == PdfOperator::q
+                && !contents[indices[i + 1]].Dropped)
+            {
+                contents[indices[i + 1]].Dropped = true;
+                contents[indices[match - 1]].Dropped = true;
+                changed = true;
+            }
+        }
+    } while (changed);
+}
+
+// Merge "ET BT" sequences when the following text object starts
+// by setting the text matrix, so the text matrix at the end of
+// the previous object has no effect
+void mergeTextObjects(vector<OptimizedContent>& contents, const vector<PdfContentOperand>& operands)
+{
+    for (auto& content : contents)
+    {
+        if (content.Dropped || content.Type != PdfContentType::Operator
+            || content.Operator != PdfOperator::Tr)
+        {
+            continue;
+        }
+
+        // Clipping text render modes accumulate the glyphs
+        // to the clipping path which is applied at ET
+        if (content.OperandCount != 1 || operands[content.OperandIndex].Type != PdfContentOperandType::Number
+            || operands[content.OperandIndex].Number >= 4)
+        {
+            return;
+        }
+    }
+
+    size_t prevIndex = numeric_limits<size_t>::max();
+    for (size_t i = 0; i < contents.size(); i++)
+    {
+        auto& content = contents[i];
+        if (content.Dropped)
+            continue;
+
+        if (content.Type == PdfContentType::Operator && content.Operator == PdfOperator::BT
+            && prevIndex != numeric_limits<size_t>::max()
+            && contents[prevIndex].Type == PdfContentType::Operator
+            && contents[prevIndex].Operator == PdfOperator::ET
+            && isTextObjectStartingWithTm(contents, i + 1))
+        {
+            contents[prevIndex].Dropped = true;
+            content.Dropped = true;
+        }
+
+        prevIndex = i;
+    }
+}
+
+void writeContents(string& output, const vector<OptimizedContent>& contents,
+    const vector<PdfContentOperand>& operands)
+{
+    for (auto& content : contents)
+    {
+        if (content.Dropped)
+            continue;
+
+        writeContent(output, content, operands);
+        output.push_back('\n');
+    }
+}
+
+void writeContent(string& output, const OptimizedContent& content,
+    const vector<PdfContentOperand>& operands)
+{
+    if (content.Type != PdfContentType::Operator)
+    {
+        // Inline images and unknown keywords are copied verbatim
+        output.append(content.RawData.data(), content.RawData.size());
+        return;
+    }
+
+    string temp;
+    bool needSpace = false;
+    for (size_t i = 0; i < content.OperandCount; i++)
+    {
+        auto& operand = operands[content.OperandIndex + i];
+        switch (operand.Type)
+        {
+            case PdfContentOperandType::ArrayEnd:
+            case PdfContentOperandType::DictionaryEnd:
+                break;
+            default:
+                if (needSpace)
+                    output.push_back(' ');
+                break;
+        }
+
+        writeOperand(output, operand, temp);
+        needSpace = operand.Type != PdfContentOperandType::ArrayBegin
+            && operand.Type != PdfContentOperandType::DictionaryBegin;
+    }
+
+    if (needSpace)
+        output.push_back(' ');
+    output.append(content.Keyword);
+}
+
+void writeOperand(string& output, const PdfContentOperand& operand, string& temp)
+{
+    switch (operand.Type)
+    {
+        case PdfContentOperandType::Null:
+            output.append("null");
+            break;
+        case PdfContentOperandType::Bool:
+            output.append(operand.Bool ? "true" : "false");
+            break;
+        case PdfContentOperandType::Number:
+            utls::FormatTo(temp, (long long)operand.Number);
+            output.append(temp);
+            break;
+        case PdfContentOperandType::Real:
+        {
+            utls::FormatTo(temp, operand.Real, NumberPrecision);
+            if (temp == "-0")
+            {
+                temp = "0";
+            }
+
+            if (temp == "0" && operand.Real != 0)
+            {
+                // Don't lose values below the precision
+                output.append(operand.Data);
+            }
+            else if (temp.size() > 1 && temp[0] == '0' && temp[1] == '.')
+            {
+                // The leading zero is not required
+                output.append(temp, 1);
+            }
+            else if (temp.size() > 2 && temp[0] == '-' && temp[1] == '0' && temp[2] == '.')
+            {
+                output.push_back('-');
+                output.append(temp, 2);
+            }
+            else
+            {
+                output.append(temp);
+            }
+            break;
+        }
+        case PdfContentOperandType::Name:
+            output.push_back('/');
+            output.append(operand.Data);
+            break;
+        case PdfContentOperandType::String:
+            output.push_back('(');
+            output.append(operand.Data);
+            output.push_back(')');
+            break;
+        case PdfContentOperandType::HexString:
+            output.push_back('<');
+            output.append(operand.Data);
+            output.push_back('>');
+            break;
+        case PdfContentOperandType::ArrayBegin:
+            output.push_back('[');
+            break;
+        case PdfContentOperandType::ArrayEnd:
+            output.push_back(']');
+            break;
+        case PdfContentOperandType::DictionaryBegin:
+            output.append("<<");
+            break;
+        case PdfContentOperandType::DictionaryEnd:
+            output.append(">>");
+            break;
+        default:
+            output.append(operand.Data);
+            break;
+    }
+}
+
+bool isIdentityMatrix(const OptimizedContent& content, const vector<PdfContentOperand>& operands)
+{
+    constexpr double identity[] = { 1, 0, 0, 1, 0, 0 };
+    if (content.OperandCount != 6)
+        return false;
+
+    for (size_t i = 0; i < 6; i++)
+    {
+        auto& operand = operands[content.OperandIndex + i];
+        if (operand.Type != PdfContentOperandType::Number
+            && operand.Type != PdfContentOperandType::Real)
+        {
+            return false;
+        }
+
+        if (operand.GetReal() != identity[i])
+            return false;
+    }
+
+    return true;
+}
+
+// Determine if the first positioning or showing operator of
+// the text object starting at the given index is "Tm"
+bool isTextObjectStartingWithTm(const vector<OptimizedContent>& contents, size_t index)
+{
+    for (size_t i = index; i < contents.size(); i++)
+    {
+        auto& content = contents[i];
+        if (content.Dropped)
+            continue;
+
+        if (content.Type != PdfContentType::Operator)
+            return false;
+
+        switch (content.Operator)
+        {
+            case PdfOperator::Tm:
+                return true;
+            case PdfOperator::ET:
+                // No text is shown in the object
+                return true;
+            case PdfOperator::Td:
+            case PdfOperator::TD:
+            case PdfOperator::T_Star:
+            case PdfOperator::Tj:
+            case PdfOperator::TJ:
+            case PdfOperator::Quote:
+            case PdfOperator::DoubleQuote:
+            case PdfOperator::BT:
+                return false;
+            default:
+                break;
+        }
+    }
+
+    return false;
+}
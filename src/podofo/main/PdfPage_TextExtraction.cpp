@@ -36,6 +36,9 @@ constexpr unsigned HARD_SEPARATION_SPACING_MULTIPLIER = 6;
 
 static constexpr float NaN = numeric_limits<float>::quiet_NaN();
 
+// Same as PdfPage::FontCache
+using FontCache = unordered_map<const PdfObject*, unique_ptr<PdfFont>>;
+
 // 5.2 Text State Parameters and Operators
 // 5.3 Text Objects
 struct TextState
@@ -103,11 +106,43 @@ struct XObjectState
     unsigned TextStateIndex;
 };
 
+struct GlyphAddress
+{
+    unsigned StringIndex;
+    unsigned GlyphIndex;
+};
+
+// Buffers used to build the entries, reused between them
+struct EntryBuffers
+{
+    string Text;
+    vector<unsigned> Positions;
+    vector<const StatefulString*> Strings;
+    vector<GlyphAddress> GlyphAddresses;
+    vector<double> GlyphAdvances;
+    string LoweredText;
+    string Match;
+};
+
+// Search pattern, compiled once for the whole extraction
+struct TextPattern
+{
+    TextPattern(const string_view& pattern, const EntryOptions& options);
+    TextPattern(const PdfTextMatcher& matcher);
+    string Text;                // Lowered with IgnoreCase, unless it's a regex
+    unique_ptr<regex> Regex;
+    const PdfTextMatcher* Matcher;
+};
+
+// Handler of the runs, with the index of the matched
+// keyword when searching with a PdfTextMatcher
+using RunHandler = function<void(const PdfTextRun& run, unsigned keyword)>;
+
 struct ExtractionContext
 {
 public:
-    ExtractionContext(vector<PdfTextEntry> &entries, const PdfPage &page, const string_view &pattern,
-        PdfTextExtractFlags flags, const nullable<Rect> &clipRect);
+    ExtractionContext(const RunHandler& handler, const PdfPage &page, const TextPattern& pattern,
+        const EntryOptions& options, const nullable<Rect> &clipRect, FontCache* fonts);
 public:
     void BeginText();
     void EndText();
@@ -127,16 +162,19 @@ private:
     void addEntry();
     void tryAddEntry(const StatefulString& currStr);
     const PdfCanvas& getActualCanvas();
+    const PdfFont* getFont(const PdfResources& resources, const PdfName& fontname);
     const StatefulString& getPreviouString() const;
 private:
     const PdfPage& m_page;
+    FontCache* m_fonts;
 public:
     const int PageIndex;
-    const string Pattern;
+    const TextPattern& Pattern;
     const EntryOptions Options;
     const nullable<Rect> ClipRect;
     unique_ptr<Matrix> Rotation;
-    vector<PdfTextEntry> &Entries;
+    const RunHandler& Handler;
+    EntryBuffers Buffers;
     StringChunkPtr Chunk = std::make_unique<StringChunk>();
     StringChunkList Chunks;
     TextStateStack States;
@@ -146,12 +184,6 @@ public:
     bool BlockOpen = false;
 };
 
-struct GlyphAddress
-{
-    unsigned StringIndex;
-    unsigned GlyphIndex;
-};
-
 static bool decodeString(const PdfString &str, TextState &state, string &decoded,
     vector<double> &lengths, vector<unsigned>& positions);
 static bool areEqual(double lhs, double rhs);
@@ -160,12 +192,17 @@ static void splitChunkBySpaces(vector<StringChunkPtr> &splittedChunks, const Str
 static void splitStringBySpaces(vector<StatefulString> &separatedStrings, const StatefulString &string);
 static void trimSpacesBegin(StringChunk &chunk);
 static void trimSpacesEnd(StringChunk &chunk);
-static void addEntry(vector<PdfTextEntry> &textEntries, StringChunkList &strings,
-    const string_view &pattern, const EntryOptions &options, const nullable<Rect> &clipRect,
+static void extractText(const PdfPage& page, ExtractionContext& context);
+static void addEntry(const RunHandler& handler, EntryBuffers& buffers, StringChunkList &strings,
+    const TextPattern& pattern, const EntryOptions &options, const nullable<Rect> &clipRect,
     int pageIndex, const Matrix* rotation);
-static void addEntryChunk(vector<PdfTextEntry> &textEntries, StringChunkList &strings,
-    const string_view &pattern, const EntryOptions& options, const nullable<Rect> &clipRect,
+static void addEntryChunk(const RunHandler& handler, EntryBuffers& buffers, StringChunkList &strings,
+    const TextPattern& pattern, const EntryOptions& options, const nullable<Rect> &clipRect,
     int pageIndex, const Matrix* rotation);
+static void emitRun(const RunHandler& handler, EntryBuffers& buffers, const string_view& text,
+    const TextState& textState, unsigned lowerIndex, unsigned upperIndexLimit, unsigned keyword,
+    const EntryOptions& options, int pageIndex, const Matrix* rotation);
+static const string& toLower(const string& str, string& lowered);
 static void processChunks(const StringChunkList& chunks, string& destString,
     vector<unsigned>& positions, vector<const StatefulString*>& strings,
     vector<GlyphAddress>& glyphAddresses);
@@ -187,10 +224,81 @@ void PdfPage::ExtractTextTo(vector<PdfTextEntry>& entries, const PdfTextExtractP
 void PdfPage::ExtractTextTo(vector<PdfTextEntry>& entries, const string_view& pattern,
     const PdfTextExtractParams& params) const
 {
-    ExtractionContext context(entries, *this, pattern, params.Flags, params.ClipRect);
+    extractTextTo(entries, pattern, params, nullptr);
+}
+
+void PdfPage::ExtractTextTo(const PdfTextRunHandler& handler, const PdfTextExtractParams& params) const
+{
+    ExtractTextTo(handler, { }, params);
+}
 
+void PdfPage::ExtractTextTo(const PdfTextRunHandler& handler, const string_view& pattern,
+    const PdfTextExtractParams& params) const
+{
+    extractTextTo(handler, pattern, params, nullptr);
+}
+
+void PdfPage::extractTextTo(vector<PdfTextEntry>& entries, const string_view& pattern,
+    const PdfTextExtractParams& params, FontCache* fonts) const
+{
+    extractTextTo([&entries](const PdfTextRun& run) {
+        nullable<Rect> bbox;
+        if (run.BoundingBox.has_value())
+            bbox = *run.BoundingBox;
+
+        entries.push_back(PdfTextEntry{ (string)run.Text, run.Page,
+            run.X, run.Y, run.Length, bbox });
+    }, pattern, params, fonts);
+}
+
+void PdfPage::extractTextTo(const PdfTextRunHandler& handler, const string_view& pattern,
+    const PdfTextExtractParams& params, FontCache* fonts) const
+{
+    if (handler == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Handler must be non null");
+
+    auto options = optionsFromFlags(params.Flags);
+    TextPattern compiled(pattern, options);
+    RunHandler runHandler = [&handler](const PdfTextRun& run, unsigned) {
+        handler(run);
+    };
+    ExtractionContext context(runHandler, *this, compiled, options, params.ClipRect, fonts);
+    extractText(*this, context);
+}
+
+void PdfPage::SearchTextTo(vector<PdfTextMatch>& matches, const PdfTextMatcher& matcher,
+    const PdfTextExtractParams& params) const
+{
+    searchTextTo(matches, matcher, params, nullptr);
+}
+
+void PdfPage::searchTextTo(vector<PdfTextMatch>& matches, const PdfTextMatcher& matcher,
+    const PdfTextExtractParams& params, FontCache* fonts) const
+{
+    constexpr PdfTextExtractFlags MatchingFlags = PdfTextExtractFlags::IgnoreCase
+        | PdfTextExtractFlags::MatchWholeWord | PdfTextExtractFlags::RegexPattern
+        | PdfTextExtractFlags::ExtractSubstring;
+    if ((params.Flags & MatchingFlags) != PdfTextExtractFlags::None)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::NotImplemented, "Matching flags must be set on the PdfTextMatcher");
+
+    auto options = optionsFromFlags(params.Flags);
+    TextPattern compiled(matcher);
+    RunHandler runHandler = [&matches](const PdfTextRun& run, unsigned keyword) {
+        nullable<Rect> bbox;
+        if (run.BoundingBox.has_value())
+            bbox = *run.BoundingBox;
+
+        matches.push_back(PdfTextMatch{ keyword, (string)run.Text, run.Page,
+            run.X, run.Y, run.Length, bbox });
+    };
+    ExtractionContext context(runHandler, *this, compiled, options, params.ClipRect, fonts);
+    extractText(*this, context);
+}
+
+void extractText(const PdfPage& page, ExtractionContext& context)
+{
     // Look FIGURE 4.1 Graphics objects
-    PdfContentStreamReader reader(*this);
+    PdfContentStreamReader reader(page);
     PdfContent content;
     vector<double> lengths;
     vector<unsigned> positions;
@@ -427,7 +535,7 @@ void PdfPage::ExtractTextTo(vector<PdfTextEntry>& entries, const string_view& pa
     context.TryAddLastEntry();
 }
 
-void addEntry(vector<PdfTextEntry> &textEntries, StringChunkList &chunks, const string_view &pattern,
+void addEntry(const RunHandler& handler, EntryBuffers& buffers, StringChunkList &chunks, const TextPattern& pattern,
     const EntryOptions &options, const nullable<Rect> &clipRect, int pageIndex, const Matrix* rotation)
 {
     if (options.TokenizeWords)
@@ -481,18 +589,18 @@ void addEntry(vector<PdfTextEntry> &textEntries, StringChunkList &chunks, const
 
         for (auto& batch : batches)
         {
-            addEntryChunk(textEntries, *batch, pattern, options,
+            addEntryChunk(handler, buffers, *batch, pattern, options,
                 clipRect, pageIndex, rotation);
         }
     }
     else
     {
-        addEntryChunk(textEntries, chunks, pattern, options,
+        addEntryChunk(handler, buffers, chunks, pattern, options,
             clipRect, pageIndex, rotation);
     }
 }
 
-void addEntryChunk(vector<PdfTextEntry> &textEntries, StringChunkList &chunks, const string_view &pattern,
+void addEntryChunk(const RunHandler& handler, EntryBuffers& buffers, StringChunkList &chunks, const TextPattern& pattern,
     const EntryOptions& options, const nullable<Rect> &clipRect, int pageIndex, const Matrix* rotation)
 {
     if (options.TrimSpaces)
@@ -539,59 +647,89 @@ void addEntryChunk(vector<PdfTextEntry> &textEntries, StringChunkList &chunks, c
         return;
     }
 
-    string str;
-    vector<unsigned> positions;
-    vector<const StatefulString*> strings;
-    vector<GlyphAddress> glyphAddresses;
+    auto& str = buffers.Text;
+    auto& positions = buffers.Positions;
+    auto& strings = buffers.Strings;
+    auto& glyphAddresses = buffers.GlyphAddresses;
+    str.clear();
+    positions.clear();
+    strings.clear();
+    glyphAddresses.clear();
     processChunks(chunks, str, positions, strings, glyphAddresses);
     unsigned lowerIndex = 0;
     unsigned upperIndexLimit = (unsigned)glyphAddresses.size();
     auto textState = firstStr.State;
-    if (pattern.length() != 0)
+    if (pattern.Matcher != nullptr)
+    {
+        // Emit a run for every occurrence of the keywords
+        pattern.Matcher->Search(str, [&](unsigned keyword, size_t offset) {
+            size_t length = pattern.Matcher->GetKeyword(keyword).length();
+            unsigned matchLowerIndex;
+            unsigned matchUpperIndexLimit;
+            getSubstringIndices(positions, (unsigned)offset, (unsigned)(offset + length),
+                matchLowerIndex, matchUpperIndexLimit);
+            if (matchLowerIndex >= matchUpperIndexLimit)
+            {
+                // The match lies inside a single glyph
+                // mapping multiple characters, eg. a ligature
+                return;
+            }
+
+            auto matchState = textState;
+            if (matchLowerIndex != 0)
+            {
+                // TODO: Handle vertical scripts
+                double substringTx = computeLength(strings, glyphAddresses, 0, matchLowerIndex - 1);
+                matchState.T_rm.Apply<Tx>(substringTx);
+            }
+
+            buffers.Match.assign(str, offset, length);
+            emitRun(handler, buffers, buffers.Match, matchState, matchLowerIndex, matchUpperIndexLimit,
+                keyword, options, pageIndex, rotation);
+        });
+
+        chunks.clear();
+        return;
+    }
+
+    if (pattern.Text.length() != 0)
     {
-        PODOFO_INVARIANT(utls::IsValidUtf8String(pattern));
         bool match;
-        if (options.RegexPattern)
+        if (pattern.Regex != nullptr)
         {
             PODOFO_ASSERT(!(options.MatchWholeWord || options.ExtractSubstring));
-            auto flags = regex_constants::ECMAScript;
-            if (options.IgnoreCase)
-                flags |= regex_constants::icase;
-
             // NOTE: regex_search returns true when a sub-part of the string
             // matches the regex
-            regex pieces_regex((string)pattern, flags);
-            match = std::regex_search(str, pieces_regex);
+            match = std::regex_search(str, *pattern.Regex);
         }
         else
         {
+            // NOTE: The pattern is already lowered with IgnoreCase
+            auto& searched = options.IgnoreCase ? toLower(str, buffers.LoweredText) : str;
             if (options.ExtractSubstring)
             {
                 size_t pos;
                 if (options.MatchWholeWord)
                 {
-                    if (options.IgnoreCase)
-                        match = isMatchWholeWordSubstring(utls::ToLower(str), utls::ToLower(pattern), pos);
-                    else
-                        match = isMatchWholeWordSubstring(str, pattern, pos);
+                    match = isMatchWholeWordSubstring(searched, pattern.Text, pos);
                 }
                 else
                 {
-                    if (options.IgnoreCase)
-                        pos = utls::ToLower(str).find(utls::ToLower(pattern));
-                    else
-                        pos = str.find(pattern);
+                    pos = searched.find(pattern.Text);
                     match = pos != string::npos;
                 }
 
                 if (match)
                 {
-                    getSubstringIndices(positions, (unsigned)pos, (unsigned)(pos + pattern.size()),
+                    getSubstringIndices(positions, (unsigned)pos, (unsigned)(pos + pattern.Text.size()),
                         lowerIndex, upperIndexLimit);
 
                     // Assign actual found matched substring
-                    if (pos != 0 || str.size() != pattern.size())
-                        str = str.substr(pos, pattern.size());
+                    if (pos != 0 || str.size() != pattern.Text.size())
+                    {
+                        str.resize(pos + pattern.Text.size());
+                        str.erase(0, pos);
+                    }
 
                     if (lowerIndex != 0)
                     {
@@ -605,19 +743,9 @@ void addEntryChunk(vector<PdfTextEntry> &textEntries, StringChunkList &chunks, c
             else
             {
                 if (options.MatchWholeWord)
-                {
-                    if (options.IgnoreCase)
-                        match = utls::ToLower(str) == utls::ToLower(pattern);
-                    else
-                        match = str == pattern;
-                }
+                    match = searched == pattern.Text;
                 else
-                {
-                    if (options.IgnoreCase)
-                        match = utls::ToLower(str).find(utls::ToLower(pattern)) != string::npos;
-                    else
-                        match = str.find(pattern) != string::npos;
-                }
+                    match = searched.find(pattern.Text) != string::npos;
             }
         }
 
@@ -628,27 +756,54 @@ void addEntryChunk(vector<PdfTextEntry> &textEntries, StringChunkList &chunks, c
         }
     }
 
+    emitRun(handler, buffers, str, textState, lowerIndex, upperIndexLimit, 0, options, pageIndex, rotation);
+    chunks.clear();
+}
+
+void emitRun(const RunHandler& handler, EntryBuffers& buffers, const string_view& text,
+    const TextState& textState, unsigned lowerIndex, unsigned upperIndexLimit, unsigned keyword,
+    const EntryOptions& options, int pageIndex, const Matrix* rotation)
+{
+    auto& strings = buffers.Strings;
+    auto& glyphAddresses = buffers.GlyphAddresses;
     double strLength = computeLength(strings, glyphAddresses, lowerIndex, upperIndexLimit - 1);
     nullable<Rect> bbox;
     if (options.ComputeBoundingBox)
         bbox = computeBoundingBox(textState, strLength);
 
+    auto& advances = buffers.GlyphAdvances;
+    advances.clear();
+    for (unsigned i = lowerIndex; i < upperIndexLimit; i++)
+    {
+        auto& address = glyphAddresses[i];
+        advances.push_back(strings[address.StringIndex]->Lengths[address.GlyphIndex]);
+    }
+
+    PdfTextRun run;
+    run.Text = text;
+    run.Page = pageIndex;
+    run.Length = strLength;
+    run.FontSize = textState.PdfState.FontSize;
+    if (bbox.has_value())
+        run.BoundingBox = *bbox;
+    run.GlyphAdvances = advances;
+
     // Rotate to canonical frame
     auto strPosition = textState.T_rm.GetTranslationVector();
     if (rotation == nullptr || options.RawCoordinates)
     {
-        textEntries.push_back(PdfTextEntry{ str, pageIndex,
-            strPosition.X, strPosition.Y, strLength, bbox });
+        run.X = strPosition.X;
+        run.Y = strPosition.Y;
     }
     else
     {
         Vector2 rawp(strPosition.X, strPosition.Y);
         auto p_1 = rawp * (*rotation);
-        textEntries.push_back(PdfTextEntry{ str, pageIndex,
-            p_1.X, p_1.Y, strLength, bbox });
+        run.X = p_1.X;
+        run.Y = p_1.Y;
     }
 
-    chunks.clear();
+    handler(run, keyword);
 }
 
 void read(const PdfVariantStack& tokens, double & tx, double & ty)
@@ -839,24 +994,56 @@ vector<double> StatefulString::computeLengths(const vector<double>& rawLengths)
     return ret;
 }
 
-ExtractionContext::ExtractionContext(vector<PdfTextEntry>& entries, const PdfPage& page, const string_view& pattern,
-    PdfTextExtractFlags flags , const nullable<Rect>& clipRect) :
+ExtractionContext::ExtractionContext(const RunHandler& handler, const PdfPage& page, const TextPattern& pattern,
+    const EntryOptions& options, const nullable<Rect>& clipRect, FontCache* fonts) :
     m_page(page),
+    m_fonts(fonts),
     PageIndex(page.GetPageNumber() - 1),
     Pattern(pattern),
-    Options(optionsFromFlags(flags)),
+    Options(options),
     ClipRect(clipRect),
-    Entries(entries)
+    Handler(handler)
 {
-    if (Options.ExtractSubstring && pattern.empty())
-        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::NotImplemented, "Unsupported ExtractSubstring flag with empty pattern");
-
     // Determine page rotation transformation
     double teta;
     if (page.HasRotation(teta))
         Rotation = std::make_unique<Matrix>(PoDoFo::GetFrameRotationTransform(page.GetRectRaw(), teta));
 }
 
+TextPattern::TextPattern(const string_view& pattern, const EntryOptions& options) :
+    Matcher(nullptr)
+{
+    if (options.ExtractSubstring && pattern.empty())
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::NotImplemented, "Unsupported ExtractSubstring flag with empty pattern");
+
+    if (pattern.empty())
+        return;
+
+    PODOFO_INVARIANT(utls::IsValidUtf8String(pattern));
+    if (options.RegexPattern)
+    {
+        auto flags = regex_constants::ECMAScript | regex_constants::optimize;
+        if (options.IgnoreCase)
+            flags |= regex_constants::icase;
+
+        Text = pattern;
+        Regex.reset(new regex(Text, flags));
+    }
+    else if (options.IgnoreCase)
+    {
+        Text = utls::ToLower(pattern);
+    }
+    else
+    {
+        Text = pattern;
+    }
+}
+
+TextPattern::TextPattern(const PdfTextMatcher& matcher) :
+    Matcher(&matcher)
+{
+}
+
 void ExtractionContext::BeginText()
 {
     ASSERT(!BlockOpen, "Text block already open");
@@ -879,7 +1066,7 @@ void ExtractionContext::Tf_Operator(const PdfName &fontname, double fontsize)
     auto resources = getActualCanvas().GetResources();
     double spacingLengthRaw = 0;
     States.Current->PdfState.FontSize = fontsize;
-    if (resources == nullptr || (States.Current->PdfState.Font = resources->GetFont(fontname)) == nullptr)
+    if (resources == nullptr || (States.Current->PdfState.Font = getFont(*resources, fontname)) == nullptr)
         PoDoFo::LogMessage(PdfLogSeverity::Warning, "Unable to find font object {}", fontname.GetString());
     else
         spacingLengthRaw = States.Current->GetWordSpacingLength();
@@ -980,6 +1167,26 @@ const PdfCanvas& ExtractionContext::getActualCanvas()
     return *XObjectStateIndices.back().Form;
 }
 
+const PdfFont* ExtractionContext::getFont(const PdfResources& resources, const PdfName& fontname)
+{
+    if (m_fonts == nullptr)
+        return resources.GetFont(fontname);
+
+    // Fonts lazily initialize internal state, so when extracting
+    // concurrently they are not shared with other threads
+    auto fontObj = resources.GetResource("Font", fontname);
+    if (fontObj == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "A font with name {} was not found", fontname.GetString());
+
+    auto found = m_fonts->find(fontObj);
+    if (found != m_fonts->end())
+        return found->second.get();
+
+    unique_ptr<PdfFont> font;
+    PdfFont::TryCreateFromObject(const_cast<PdfObject&>(*fontObj), font);
+    return m_fonts->emplace(fontObj, std::move(font)).first->second.get();
+}
+
 const StatefulString& ExtractionContext::getPreviouString() const
 {
     const StatefulString* prevString;
@@ -998,7 +1205,7 @@ const StatefulString& ExtractionContext::getPreviouString() const
 
 void ExtractionContext::addEntry()
 {
-    ::addEntry(Entries, Chunks, Pattern, Options, ClipRect, PageIndex, Rotation.get());
+    ::addEntry(Handler, Buffers, Chunks, Pattern, Options, ClipRect, PageIndex, Rotation.get());
 }
 
 void ExtractionContext::tryAddEntry(const StatefulString& currStr)
@@ -1409,3 +1616,13 @@ EntryOptions optionsFromFlags(PdfTextExtractFlags flags)
 
     return ret;
 }
+
+// Lower the string reusing the given buffer, with
+// the same folding of utls::ToLower()
+const string& toLower(const string& str, string& lowered)
+{
+    lowered.resize(str.size());
+    std::transform(str.begin(), str.end(), lowered.begin(),
+        [](unsigned char c) { return (char)std::tolower(c); });
+    return lowered;
+}
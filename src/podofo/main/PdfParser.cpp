@@ -8,6 +8,7 @@
 #include "PdfParser.h"
 
 #include <algorithm>
+#include <atomic>
 
 #include "PdfArray.h"
 #include "PdfDictionary.h"
@@ -20,6 +21,7 @@
 #include "PdfXRefStreamParserObject.h"
 
 #include <podofo/private/PdfObjectStreamParser.h>
+#include <podofo/private/ParallelUtils.h>
 
 constexpr unsigned PDF_VERSION_LENGHT = 3;
 constexpr unsigned PDF_MAGIC_LENGHT = 8;
@@ -35,6 +37,7 @@ static bool CheckXRefEntryType(char c);
 static bool ReadMagicWord(char ch, unsigned& cursoridx);
 
 static unsigned s_MaxObjectCount = (1U << 23) - 1;
+static atomic<unsigned> s_DecryptionThreadCount(0);
 
 PdfParser::PdfParser(PdfIndirectObjectList& objects) :
     m_buffer(std::make_shared<charbuff>(PdfTokenizer::BufferSize)),
@@ -74,6 +77,7 @@ void PdfParser::Parse(InputStreamDevice& device, bool loadOnDemand)
     reset();
 
     m_LoadOnDemand = loadOnDemand;
+    m_deviceMutex = std::make_shared<recursive_mutex>();
 
     try
     {
@@ -224,6 +228,7 @@ void PdfParser::readNextTrailer(InputStreamDevice& device)
     // Ignore the encryption in the trailer as the trailer may not be encrypted
     auto trailer = new PdfParserObject(m_Objects->GetDocument(), device, -1);
     trailer->SetIsTrailer(true);
+    trailer->SetDeviceMutex(m_deviceMutex);
 
     unique_ptr<PdfParserObject> trailerTemp;
     if (m_Trailer == nullptr)
@@ -544,6 +549,7 @@ void PdfParser::ReadXRefStreamContents(InputStreamDevice& device, size_t offset,
 
     device.Seek(offset);
     auto xrefObjTrailer = new PdfXRefStreamParserObject(m_Objects->GetDocument(), device, m_entries);
+    xrefObjTrailer->SetDeviceMutex(m_deviceMutex);
     try
     {
         xrefObjTrailer->ParseStream();
@@ -624,6 +630,7 @@ void PdfParser::ReadObjects(InputStreamDevice& device)
 
             // The encryption dictionary is not encrypted
             unique_ptr<PdfParserObject> obj(new PdfParserObject(device, encryptRef, (ssize_t)m_entries[i].Offset));
+            obj->SetDeviceMutex(m_deviceMutex);
             try
             {
                 obj->Parse();
@@ -651,9 +658,14 @@ void PdfParser::ReadObjects(InputStreamDevice& device)
                 "The encryption entry in the trailer is neither an object nor a reference");
         }
 
-        // Generate encryption keys
-        bool isAuthenticated = m_Encrypt->Authenticate(m_Password, this->getDocumentId());
-        if (!isAuthenticated)
+        // Generate encryption keys, or just validate
+        // the one that was supplied by the user
+        if (m_EncryptionKey != nullptr)
+        {
+            if (!m_Encrypt->Authenticate(*m_EncryptionKey, this->getDocumentId()))
+                PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidPassword, "The supplied encryption key is not valid for this PDF file");
+        }
+        else if (!m_Encrypt->Authenticate(m_Password, this->getDocumentId()))
         {
             // authentication failed so we need a password from the user.
             // The user can set the password using PdfParser::SetPassword
@@ -690,6 +702,7 @@ void PdfParser::readObjectsInternal(InputStreamDevice& device)
                         unique_ptr<PdfParserObject> obj(new PdfParserObject(m_Objects->GetDocument(), reference, device, (ssize_t)entry.Offset));
                         try
                         {
+                            obj->SetDeviceMutex(m_deviceMutex);
                             obj->SetEncrypt(m_Encrypt);
                             if (m_Encrypt != nullptr && obj->IsDictionary())
                             {
@@ -698,6 +711,7 @@ void PdfParser::readObjectsInternal(InputStreamDevice& device)
                                 {
                                     // XRef is never encrypted
                                     obj.reset(new PdfParserObject(m_Objects->GetDocument(), reference, device, (ssize_t)entry.Offset));
+                                    obj->SetDeviceMutex(m_deviceMutex);
                                     if (m_LoadOnDemand)
                                         obj->DelayedLoad();
                                 }
@@ -797,11 +811,7 @@ void PdfParser::readObjectsInternal(InputStreamDevice& device)
         // run that populates m_Objects because a stream might have a /Length
         // key that references an object we haven't yet read. So we must do it here
         // in a second pass, or (if demand loading is enabled) defer it for later.
-        for (auto objToLoad : *m_Objects)
-        {
-            auto obj = dynamic_cast<PdfParserObject*>(objToLoad);
-            obj->ParseStream();
-        }
+        parseStreams(*m_Objects);
     }
 
     updateDocumentVersion();
@@ -867,7 +877,13 @@ void PdfParser::updateDocumentVersion()
 {
     if (m_Trailer->IsDictionary() && m_Trailer->GetDictionary().HasKey("Root"))
     {
-        auto catalog = m_Trailer->GetDictionary().FindKey("Root");
+        // Resolve the catalog with the parsed objects, since
+        // they may be not part of any document
+        auto catalog = m_Trailer->GetDictionary().GetKey("Root");
+        PdfReference ref;
+        if (catalog != nullptr && catalog->TryGetReference(ref))
+            catalog = m_Objects->GetObject(ref);
+
         if (catalog != nullptr
             && catalog->IsDictionary()
             && catalog->GetDictionary().HasKey("Version"))
@@ -948,6 +964,11 @@ const PdfObject& PdfParser::GetTrailer() const
     return *m_Trailer;
 }
 
+void PdfParser::SetEncryptionKey(const PdfEncryptionKey& key)
+{
+    m_EncryptionKey.reset(new PdfEncryptionKey(key));
+}
+
 bool PdfParser::IsEncrypted() const
 {
     return m_Encrypt != nullptr;
@@ -963,6 +984,42 @@ void PdfParser::SetMaxObjectCount(unsigned maxObjectCount)
     s_MaxObjectCount = maxObjectCount;
 }
 
+unsigned PdfParser::GetDecryptionThreadCount()
+{
+    return s_DecryptionThreadCount;
+}
+
+void PdfParser::SetDecryptionThreadCount(unsigned threadCount)
+{
+    s_DecryptionThreadCount = threadCount;
+}
+
+void PdfParser::parseStreams(PdfIndirectObjectList& objects)
+{
+    // Reading from the device and resolving the /Length
+    // keys must be done sequentially, while decryption
+    // only depends on the key and the object reference
+    vector<PdfParserObject*> encrypted;
+    for (auto obj : objects)
+    {
+        auto parserObj = dynamic_cast<PdfParserObject*>(obj);
+        if (parserObj != nullptr && parserObj->readEncryptedStream())
+            encrypted.push_back(parserObj);
+    }
+
+    utls::ParallelFor(encrypted.size(), utls::GetWorkerThreadCount(s_DecryptionThreadCount),
+        [&encrypted](size_t i) {
+            encrypted[i]->decryptStream();
+        });
+
+    for (auto obj : objects)
+    {
+        auto parserObj = dynamic_cast<PdfParserObject*>(obj);
+        if (parserObj != nullptr)
+            parserObj->ParseStream();
+    }
+}
+
 // Read magic word keeping cursor
 bool ReadMagicWord(char ch, unsigned& cursoridx)
 {
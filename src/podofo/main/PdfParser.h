@@ -16,6 +16,7 @@
 namespace PoDoFo {
 
 class PdfEncrypt;
+class PdfEncryptionKey;
 class PdfString;
 class PdfParserObject;
 
@@ -29,6 +30,7 @@ class PODOFO_API PdfParser
 {
     PODOFO_UNIT_TEST(PdfParserTest);
     friend class PdfDocument;
+    friend class PdfMemDocument;
     friend class PdfWriter;
 
 public:
@@ -73,6 +75,21 @@ public:
     static unsigned GetMaxObjectCount();
     static void SetMaxObjectCount(unsigned maxObjectCount);
 
+    /** Get the number of threads used to decrypt the streams
+     *  of encrypted documents when they are all loaded at once
+     *  \see SetDecryptionThreadCount
+     */
+    static unsigned GetDecryptionThreadCount();
+
+    /** Set the number of threads used to decrypt the streams
+     *  of encrypted documents when they are all loaded at once,
+     *  that is when parsing with loadOnDemand set to false or
+     *  when saving a PdfMemDocument. The default is 0, which means
+     *  the number of hardware threads, while 1 disables parallel
+     *  decryption. The loaded data doesn't depend on this setting
+     */
+    static void SetDecryptionThreadCount(unsigned threadCount);
+
 public:
     /** If you try to open an encrypted PDF file, which requires
      *  a password to open, PoDoFo will throw a PdfError( PdfErrorCode::InvalidPassword )
@@ -92,6 +109,16 @@ public:
     inline void SetPassword(const std::string_view& password) { m_Password = password; }
     inline const std::string& GetPassword() { return m_Password; }
 
+    /** Set a file encryption key, previously exported from the same
+     *  document, to be used instead of the password for authentication
+     *
+     *  If the key is not valid for the document, a PdfError( PdfErrorCode::InvalidPassword )
+     *  exception is thrown when parsing
+     *
+     *  \see PdfEncrypt::ExportEncryptionKey
+     */
+    void SetEncryptionKey(const PdfEncryptionKey& key);
+
     /**
      * Retrieve the number of incremental updates that
      * have been applied to the last parsed PDF file.
@@ -278,6 +305,14 @@ private:
 
     void readNextTrailer(InputStreamDevice& device);
 
+    /** Load the streams of all the parsed objects. Encrypted stream
+     *  data is first read sequentially, then decrypted in parallel
+     *  and finally loaded in the objects in the original order
+     *
+     *  \see SetDecryptionThreadCount
+     */
+    static void parseStreams(PdfIndirectObjectList& objects);
+
 
     /** Checks for the existence of the %%EOF marker at the end of the file.
      *  When strict mode is off it will also attempt to setup the parser to ignore
@@ -326,8 +361,11 @@ private:
 
     std::unique_ptr<PdfParserObject> m_Trailer;
     std::shared_ptr<PdfEncrypt> m_Encrypt;
+    // Serialize the delayed loading of the objects of the parsed device
+    std::shared_ptr<std::recursive_mutex> m_deviceMutex;
 
     std::string m_Password;
+    std::unique_ptr<PdfEncryptionKey> m_EncryptionKey;
 
     bool m_StrictParsing;
     bool m_IgnoreBrokenObjects;
@@ -9,6 +9,7 @@
 
 #include "PdfArray.h"
 #include "PdfDictionary.h"
+#include <podofo/auxiliary/StreamDevice.h>
 
 #include <podofo/private/PdfFilterFactory.h>
 
@@ -76,6 +77,14 @@ void PdfParserObject::DelayedLoadImpl()
     Parse(tokenizer);
 }
 
+recursive_mutex& PdfParserObject::GetDelayedLoadMutex() const
+{
+    if (m_deviceMutex == nullptr)
+        return PdfObject::GetDelayedLoadMutex();
+
+    return *m_deviceMutex;
+}
+
 void PdfParserObject::DelayedLoadStreamImpl()
 {
     PODOFO_ASSERT(getStream() == nullptr);
@@ -160,6 +169,79 @@ void PdfParserObject::parseStream()
 {
     PODOFO_ASSERT(IsDelayedLoadDone());
 
+    if (m_streamData != nullptr)
+    {
+        // The stream was already read and decrypted, see decryptStream()
+        SpanStreamDevice input(*m_streamData);
+        getOrCreateStream().InitData(input, m_streamData->size(), PdfFilterFactory::CreateFilterList(*this));
+        m_streamData = nullptr;
+        m_Encrypt = nullptr;
+        return;
+    }
+
+    size_t size = seekStreamData();
+
+    // Set stream raw data without marking the object dirty
+    if (m_Encrypt != nullptr)
+    {
+        auto input = m_Encrypt->CreateEncryptionInputStream(*m_device, size, GetIndirectReference());
+        getOrCreateStream().InitData(*input, static_cast<ssize_t>(size), PdfFilterFactory::CreateFilterList(*this));
+        // Release the encrypt object after loading the stream.
+        // It's not needed for serialization here
+        m_Encrypt = nullptr;
+    }
+    else
+    {
+        getOrCreateStream().InitData(*m_device, static_cast<ssize_t>(size), PdfFilterFactory::CreateFilterList(*this));
+    }
+}
+
+bool PdfParserObject::readEncryptedStream()
+{
+    DelayedLoad();
+    if (m_Encrypt == nullptr || !m_HasStream || IsDelayedLoadStreamDone())
+        return false;
+
+    try
+    {
+        size_t size = seekStreamData();
+        if (m_Encrypt == nullptr)
+            return false;
+
+        m_streamData.reset(new charbuff(size));
+        m_device->Read(m_streamData->data(), size);
+        return true;
+    }
+    catch (PdfError& e)
+    {
+        m_streamData = nullptr;
+        PODOFO_PUSH_FRAME_INFO(e, "Unable to parse the stream for object {} {} R",
+            GetIndirectReference().ObjectNumber(),
+            GetIndirectReference().GenerationNumber());
+        throw;
+    }
+}
+
+void PdfParserObject::decryptStream()
+{
+    PODOFO_ASSERT(m_streamData != nullptr && m_Encrypt != nullptr);
+    try
+    {
+        charbuff decrypted;
+        m_Encrypt->DecryptTo(decrypted, *m_streamData, GetIndirectReference());
+        *m_streamData = std::move(decrypted);
+    }
+    catch (PdfError& e)
+    {
+        PODOFO_PUSH_FRAME_INFO(e, "Unable to decrypt the stream for object {} {} R",
+            GetIndirectReference().ObjectNumber(),
+            GetIndirectReference().GenerationNumber());
+        throw;
+    }
+}
+
+size_t PdfParserObject::seekStreamData()
+{
     int64_t size = -1;
     char ch;
 
@@ -230,19 +312,7 @@ ReadStream:
         }
     }
 
-    // Set stream raw data without marking the object dirty
-    if (m_Encrypt != nullptr)
-    {
-        auto input = m_Encrypt->CreateEncryptionInputStream(*m_device, static_cast<size_t>(size), GetIndirectReference());
-        getOrCreateStream().InitData(*input, static_cast<ssize_t>(size), PdfFilterFactory::CreateFilterList(*this));
-        // Release the encrypt object after loading the stream.
-        // It's not needed for serialization here
-        m_Encrypt = nullptr;
-    }
-    else
-    {
-        getOrCreateStream().InitData(*m_device, static_cast<ssize_t>(size), PdfFilterFactory::CreateFilterList(*this));
-    }
+    return static_cast<size_t>(size);
 }
 
 void PdfParserObject::checkReference(PdfTokenizer& tokenizer)
@@ -90,9 +90,15 @@ public:
 
     inline void SetIsTrailer(bool isTrailer) { m_IsTrailer = isTrailer; }
 
+    /** Set the mutex serializing the delayed loading
+     * of the objects reading from the same input device
+     */
+    inline void SetDeviceMutex(const std::shared_ptr<std::recursive_mutex>& mutex) { m_deviceMutex = mutex; }
+
 protected:
     void DelayedLoadImpl() override;
     void DelayedLoadStreamImpl() override;
+    std::recursive_mutex& GetDelayedLoadMutex() const override;
     PdfReference ReadReference(PdfTokenizer& tokenizer);
     void Parse(PdfTokenizer& tokenizer);
 
@@ -108,13 +114,33 @@ private:
      */
     void parseStream();
 
+    /** Seek the device to the beginning of the stream data
+     *  \returns the length of the stream data
+     */
+    size_t seekStreamData();
+
+    /** Read in memory the still encrypted stream data, so it can
+     *  be decrypted with decryptStream() and eventually loaded
+     *  by parseStream()
+     *  \returns false if there's no encrypted stream to read
+     */
+    bool readEncryptedStream();
+
+    /** Decrypt the stream data previously read by readEncryptedStream().
+     *  It doesn't access the device or the document, so it can be
+     *  safely called concurrently on different objects
+     */
+    void decryptStream();
+
     PdfReference readReference(PdfTokenizer& tokenizer);
 
     void checkReference(PdfTokenizer& tokenizer);
 
 private:
     std::shared_ptr<PdfEncrypt> m_Encrypt;
+    std::unique_ptr<charbuff> m_streamData;
     InputStreamDevice* m_device;
+    std::shared_ptr<std::recursive_mutex> m_deviceMutex;
     size_t m_Offset;
     size_t m_StreamOffset;
     bool m_IsTrailer;
@@ -6,8 +6,10 @@
 
 #include <podofo/private/PdfDeclarationsPrivate.h>
 #include "PdfSignerCms.h"
+#include "PdfSigningContext.h"
 #include <podofo/private/OpenSSLInternal.h>
 #include <podofo/private/CmsContext.h>
+#include <podofo/private/ParallelUtils.h>
 
 using namespace std;
 using namespace PoDoFo;
@@ -21,7 +23,7 @@ PdfSignerCms::PdfSignerCms(const bufferview& cert, const PdfSignerCmsParams& par
 
 PdfSignerCms::PdfSignerCms(const bufferview& cert, const bufferview& pkey,
         const PdfSignerCmsParams& parameters) :
-    m_certificate(cert),
+    m_certificate(std::make_shared<CmsCertificate>(cert, parameters.Hashing)),
     m_privKey(nullptr),
     m_parameters(parameters),
     m_reservedSize(0)
@@ -30,6 +32,17 @@ PdfSignerCms::PdfSignerCms(const bufferview& cert, const bufferview& pkey,
         m_privKey = ssl::LoadPrivateKey(pkey);
 }
 
+PdfSignerCms::PdfSignerCms(const shared_ptr<const CmsCertificate>& cert, EVP_PKEY* privKey,
+        const PdfSignerCmsParams& parameters) :
+    m_certificate(cert),
+    m_privKey(privKey),
+    m_parameters(parameters),
+    m_reservedSize(0)
+{
+    if (m_privKey != nullptr)
+        EVP_PKEY_up_ref(m_privKey);
+}
+
 PdfSignerCms::~PdfSignerCms()
 {
     if (m_privKey != nullptr)
@@ -53,8 +66,12 @@ void PdfSignerCms::ComputeSignature(charbuff& contents, bool dryrun)
     m_cmsContext->ComputeHashToSign(hashToSign);
     if (m_parameters.SigningService == nullptr)
     {
-        // Do default signing
-        doSign(hashToSign, m_encryptedHash);
+        // Do default signing. On dry runs just prepare a
+        // fake result, sparing the private key operation
+        if (dryrun)
+            m_encryptedHash.resize(getSignedHashSize());
+        else
+            doSign(hashToSign, m_encryptedHash);
     }
     else if (!dryrun || (m_parameters.Flags & PdfSignerCmsFlags::ServiceDoDryRun) != PdfSignerCmsFlags::None)
     {
@@ -91,7 +108,7 @@ void PdfSignerCms::ComputeSignatureSequential(const bufferview& processedResult,
         // Just prepare a fake result with the size of RSA block
         charbuff fakeresult;
         m_cmsContext->ComputeHashToSign(fakeresult);
-        fakeresult.resize(RSASignedHashSize);
+        fakeresult.resize(getSignedHashSize());
         m_cmsContext->ComputeSignature(fakeresult, contents);
         if (m_reservedSize != 0)
             contents.resize(contents.size() + m_reservedSize);
@@ -247,3 +264,79 @@ void PdfSignerCms::doSign(const bufferview& input, charbuff& output)
     PODOFO_ASSERT(m_privKey != nullptr);
     return ssl::DoSign(input, m_privKey, PdfHashingAlgorithm::Unknown, output);
 }
+
+unsigned PdfSignerCms::getSignedHashSize() const
+{
+    if (m_privKey == nullptr)
+        return RSASignedHashSize;
+
+    return (unsigned)EVP_PKEY_size(m_privKey);
+}
+
+void PoDoFo::SignDocuments(const cspan<PdfSigningBatchItem>& items, PdfSignerCms& signer,
+    PdfSaveOptions saveOptions)
+{
+    if (signer.m_parameters.SigningService == nullptr && signer.m_privKey == nullptr)
+    {
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic,
+            "The signer can't perform batch signing without a signing service or a private pkey");
+    }
+
+    struct BatchContext
+    {
+        PdfSigningContext Context;
+        PdfSigningResults Results;
+        PdfSignerId SignerId;
+    };
+
+    // Prepare all the documents, collecting the hashes to sign.
+    // Every document needs its own CMS structure, but the signers
+    // share the parsed certificate and the private key
+    vector<unique_ptr<BatchContext>> contexts;
+    contexts.reserve(items.size());
+    for (auto& item : items)
+    {
+        if (item.Document == nullptr || item.Device == nullptr || item.Signature == nullptr)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Invalid batch signing item");
+
+        contexts.push_back(unique_ptr<BatchContext>(new BatchContext()));
+        auto& ctx = *contexts.back();
+        shared_ptr<PdfSignerCms> docSigner(new PdfSignerCms(signer.m_certificate,
+            signer.m_privKey, signer.m_parameters));
+        ctx.SignerId = ctx.Context.AddSigner(*item.Signature, docSigner);
+        ctx.Context.StartSigning(*item.Document, item.Device, ctx.Results, saveOptions);
+    }
+
+    // Sign all the hashes in one pass
+    auto signHash = [&](size_t i) {
+        auto& ctx = *contexts[i];
+        auto& hash = ctx.Results.Intermediate[ctx.SignerId];
+        charbuff signedHash;
+        if (signer.m_parameters.SigningService == nullptr)
+            ssl::DoSign(hash, signer.m_privKey, PdfHashingAlgorithm::Unknown, signedHash);
+        else
+            signer.m_parameters.SigningService(hash, false, signedHash);
+
+        hash = std::move(signedHash);
+    };
+
+    if (signer.m_parameters.SigningService == nullptr)
+    {
+        // The private key is only read, so it can be used concurrently
+        utls::ParallelFor(contexts.size(), utls::GetWorkerThreadCount(0), signHash);
+    }
+    else
+    {
+        for (size_t i = 0; i < contexts.size(); i++)
+            signHash(i);
+    }
+
+    // Finally write all the signatures
+    for (auto& ctx : contexts)
+    {
+        if (signer.m_parameters.SignedHashHandler != nullptr)
+            signer.m_parameters.SignedHashHandler(ctx->Results.Intermediate[ctx->SignerId], false);
+
+        ctx->Context.FinishSigning(ctx->Results);
+    }
+}
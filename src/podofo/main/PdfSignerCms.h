@@ -19,6 +19,7 @@ extern "C"
 namespace PoDoFo
 {
     class CmsContext;
+    class CmsCertificate;
 
     using PdfSigningService = std::function<void(bufferview hashToSign, bool dryrun, charbuff& signedHash)>;
     using PdfSignedHashHandler = std::function<void(bufferview signedhHash, bool dryrun)>;
@@ -57,10 +58,39 @@ namespace PoDoFo
         AsOctetString = 2,
     };
 
+    /** A document to be signed with PoDoFo::SignDocuments()
+     */
+    struct PODOFO_API PdfSigningBatchItem final
+    {
+        PdfMemDocument* Document = nullptr;
+        std::shared_ptr<StreamDevice> Device;
+        PdfSignature* Signature = nullptr;
+    };
+
+    class PdfSignerCms;
+
+    /** Sign many documents with the same signer
+     *
+     * All the documents are first prepared with a sequential signing,
+     * collecting their hashes, then all the hashes are signed in one pass
+     * and finally the signatures are written in the documents. The parsed
+     * certificate and the private key of the signer are shared by all the
+     * signatures. When signing with the private key, the hashes are signed
+     * on worker threads, while a signing service is invoked sequentially
+     * \param items the documents to be signed
+     * \param signer the signer, which must have a private key or a signing service
+     * \param saveOptions document saving options
+     */
+    PODOFO_API void SignDocuments(const cspan<PdfSigningBatchItem>& items, PdfSignerCms& signer,
+        PdfSaveOptions saveOptions = PdfSaveOptions::None);
+
     /** This class computes a CMS signature according to RFC 5652
      */
     class PODOFO_API PdfSignerCms : public PdfSigner
     {
+        friend PODOFO_API void SignDocuments(const cspan<PdfSigningBatchItem>& items, PdfSignerCms& signer,
+            PdfSaveOptions saveOptions);
+
     public:
         /** Load X509 certificate and supply a ASN.1 encoded private key
          * \param cert x509 certificate
@@ -104,6 +134,11 @@ namespace PoDoFo
     public:
         const PdfSignerCmsParams& GetParameters() const { return m_parameters; }
 
+    private:
+        // Create a signer sharing the certificate and the private key
+        PdfSignerCms(const std::shared_ptr<const CmsCertificate>& cert, struct evp_pkey_st* privKey,
+            const PdfSignerCmsParams& parameters);
+
     private:
         void ensureEventBasedSigning();
         void ensureSequentialSigning();
@@ -111,9 +146,10 @@ namespace PoDoFo
         void ensureContextInitialized();
         void resetContext();
         void doSign(const bufferview& input, charbuff& output);
+        unsigned getSignedHashSize() const;
     private:
         nullable<bool> m_sequentialSigning;
-        charbuff m_certificate;
+        std::shared_ptr<const CmsCertificate> m_certificate;
         std::unique_ptr<CmsContext> m_cmsContext;
         struct evp_pkey_st* m_privKey;
         PdfSignerCmsParams m_parameters;
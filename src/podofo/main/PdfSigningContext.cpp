@@ -7,17 +7,37 @@
 #include <podofo/private/PdfDeclarationsPrivate.h>
 #include "PdfSigningContext.h"
 #include <podofo/auxiliary/StreamDevice.h>
+#include <podofo/private/ParallelUtils.h>
+
+#include <condition_variable>
+#include <mutex>
 
 using namespace std;
 using namespace PoDoFo;
 
+namespace
+{
+    struct SignerData
+    {
+        PdfSignerId Id;
+        PdfSigner* Signer;
+        size_t ContentsOffset;
+        size_t ContentsSize;
+    };
+}
+
 constexpr const char* ByteRangeBeacon = "[ 0 1234567890 1234567890 1234567890]";
 constexpr size_t BufferSize = 65536;
+// Bigger blocks amortize the synchronization with the
+// worker threads when hashing for multiple signers
+constexpr size_t ParallelBufferSize = 1048576;
+// Number of blocks that can be read ahead of the slowest worker
+constexpr unsigned ParallelBlockCount = 4;
 
 static PdfSignature& getSignature(PdfDocument& doc, int pageIndex, const PdfReference& signatureRef);
-static size_t readForSignature(StreamDevice& device,
-    size_t conentsBeaconOffset, size_t conentsBeaconSize,
-    char* buffer, size_t size);
+static void feedSignersParallel(StreamDevice& device, const vector<SignerData>& signers, unsigned workerCount);
+static void appendDataForSigner(PdfSigner& signer, const char* data, size_t size,
+    size_t offset, size_t conentsBeaconOffset, size_t conentsBeaconSize);
 static void adjustByteRange(StreamDevice& device, size_t byteRangeOffset,
     size_t conentsBeaconOffset, size_t conentsBeaconSize, PdfArray& byteRangeArr, charbuff& buffer);
 static void setSignature(StreamDevice& device, const string_view& sigData,
@@ -91,6 +111,17 @@ void PdfSigningContext::Sign(PdfMemDocument& doc, StreamDevice& device, PdfSaveO
 
 PdfSignerId PdfSigningContext::addSigner(const PdfSignature& signature, PdfSigner* signer, const shared_ptr<PdfSigner>& storage)
 {
+    // A signer holds the state of a single signature computation,
+    // so it can't be used for more signatures at the same time
+    for (auto& pair : m_signers)
+    {
+        for (auto registered : pair.second.Signers)
+        {
+            if (registered == signer)
+                PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The signer is already registered");
+        }
+    }
+
     auto reference = signature.GetObject().GetIndirectReference();
     auto found = m_signers.find(reference);
     SignatureAttrs* attrs;
@@ -173,6 +204,9 @@ void PdfSigningContext::saveDocForSigning(PdfMemDocument& doc, StreamDevice& dev
 void PdfSigningContext::appendDataForSigning(unordered_map<PdfSignerId, SignatureCtx>& contexts, StreamDevice& device,
     std::unordered_map<PdfSignerId, charbuff>* intermediateResults, charbuff& tmpbuff)
 {
+    // Finalize the /ByteRange of all the signatures first, so
+    // the document is then read only once for all the signers
+    vector<SignerData> signers;
     for (auto& pair : m_signers)
     {
         auto& attrs = pair.second;
@@ -186,21 +220,44 @@ void PdfSigningContext::appendDataForSigning(unordered_map<PdfSignerId, Signatur
                 ctx.Beacons.ContentsBeacon.size(), ctx.ByteRangeArr, tmpbuff);
             device.Flush();
 
-            // Read data from the device to prepare the signature
             signer->Reset();
-            device.Seek(0);
-            size_t readBytes;
-            tmpbuff.resize(BufferSize);
-            while ((readBytes = readForSignature(device, *ctx.Beacons.ContentsOffset, ctx.Beacons.ContentsBeacon.size(),
-                tmpbuff.data(), BufferSize)) != 0)
+            signers.push_back({ signerId, signer, *ctx.Beacons.ContentsOffset, ctx.Beacons.ContentsBeacon.size() });
+        }
+    }
+
+    // Signers are distinct, so each one can be fed independently
+    // on worker threads. Every signer still receives the data
+    // in the same order, so the results are deterministic
+    if (signers.size() > 1)
+    {
+        unsigned workerCount = std::min(utls::GetWorkerThreadCount(0), (unsigned)signers.size());
+        feedSignersParallel(device, signers, workerCount);
+    }
+    else
+    {
+        // Read data from the device to prepare the signatures
+        size_t fileSize = device.GetLength();
+        size_t offset = 0;
+        device.Seek(0);
+        tmpbuff.resize(BufferSize);
+        while (offset < fileSize)
+        {
+            size_t readSize = std::min(BufferSize, fileSize - offset);
+            device.Read(tmpbuff.data(), readSize);
+            for (auto& data : signers)
             {
-                signer->AppendData({ tmpbuff.data(), readBytes });
+                appendDataForSigner(*data.Signer, tmpbuff.data(), readSize,
+                    offset, data.ContentsOffset, data.ContentsSize);
             }
-
-            if (intermediateResults != nullptr)
-                signer->FetchIntermediateResult((*intermediateResults)[signerId]);
+            offset += readSize;
         }
     }
+
+    if (intermediateResults != nullptr)
+    {
+        for (auto& data : signers)
+            data.Signer->FetchIntermediateResult((*intermediateResults)[data.Id]);
+    }
 }
 
 void PdfSigningContext::computeSignatures(unordered_map<PdfSignerId, SignatureCtx>& contexts,
@@ -241,42 +298,131 @@ void PdfSigningContext::computeSignatures(unordered_map<PdfSignerId, SignatureCt
     }
 }
 
-size_t readForSignature(StreamDevice& device, size_t conentsBeaconOffset, size_t conentsBeaconSize,
-    char* buffer, size_t bufferSize)
+// Read the device once on the calling thread, while the given number
+// of workers, started only once, feed the signers from a small ring of
+// blocks. Each worker owns a fixed subset of the signers and consumes
+// all the blocks in order
+void feedSignersParallel(StreamDevice& device, const vector<SignerData>& signers, unsigned workerCount)
 {
-    if (device.Eof())
-        return 0;
-
-    size_t pos = device.GetPosition();
-    size_t readSize = 0;
-    // Check if we are before beacon
-    if (pos < conentsBeaconOffset)
+    struct Block
     {
-        readSize = std::min(bufferSize, conentsBeaconOffset - pos);
-        if (readSize > 0)
+        charbuff Data;
+        size_t Offset = 0;
+        size_t Size = 0;
+        unsigned Pending = 0;
+    };
+
+    Block blocks[ParallelBlockCount];
+    mutex blockMutex;
+    condition_variable blockCond;
+    size_t blockCount = 0;
+    bool finished = false;
+
+    utls::ParallelFor(workerCount + 1, workerCount + 1, [&](size_t index) {
+        if (index == 0)
         {
-            device.Read(buffer, readSize);
-            buffer += readSize;
-            bufferSize -= readSize;
-            if (bufferSize == 0)
-                return readSize;
+            // The reader
+            try
+            {
+                size_t fileSize = device.GetLength();
+                size_t offset = 0;
+                device.Seek(0);
+                for (size_t n = 0; offset < fileSize; n++)
+                {
+                    auto& block = blocks[n % ParallelBlockCount];
+                    {
+                        unique_lock<mutex> lock(blockMutex);
+                        blockCond.wait(lock, [&] { return block.Pending == 0; });
+                    }
+
+                    // No worker accesses the block until it's published
+                    block.Size = std::min(ParallelBufferSize, fileSize - offset);
+                    block.Offset = offset;
+                    block.Data.resize(ParallelBufferSize);
+                    device.Read(block.Data.data(), block.Size);
+                    offset += block.Size;
+
+                    unique_lock<mutex> lock(blockMutex);
+                    block.Pending = workerCount;
+                    blockCount++;
+                    blockCond.notify_all();
+                }
+            }
+            catch (...)
+            {
+                unique_lock<mutex> lock(blockMutex);
+                finished = true;
+                blockCond.notify_all();
+                throw;
+            }
+
+            unique_lock<mutex> lock(blockMutex);
+            finished = true;
+            blockCond.notify_all();
+            return;
         }
-    }
 
-    // shift at the end of beacon
-    if ((pos + readSize) >= conentsBeaconOffset
-        && pos < (conentsBeaconOffset + conentsBeaconSize))
+        // A worker: after a failure it keeps consuming the
+        // blocks without feeding, so the reader doesn't stall
+        exception_ptr error;
+        for (size_t n = 0; ; n++)
+        {
+            {
+                unique_lock<mutex> lock(blockMutex);
+                blockCond.wait(lock, [&] { return n < blockCount || finished; });
+                if (n >= blockCount)
+                    break;
+            }
+
+            auto& block = blocks[n % ParallelBlockCount];
+            if (error == nullptr)
+            {
+                try
+                {
+                    for (size_t i = index - 1; i < signers.size(); i += workerCount)
+                    {
+                        auto& data = signers[i];
+                        appendDataForSigner(*data.Signer, block.Data.data(), block.Size,
+                            block.Offset, data.ContentsOffset, data.ContentsSize);
+                    }
+                }
+                catch (...)
+                {
+                    error = current_exception();
+                }
+            }
+
+            unique_lock<mutex> lock(blockMutex);
+            block.Pending--;
+            if (block.Pending == 0)
+                blockCond.notify_all();
+        }
+
+        if (error != nullptr)
+            rethrow_exception(error);
+    });
+}
+
+// Append a block of the document data, which starts at the given
+// offset, skipping the part overlapping the /Contents beacon
+void appendDataForSigner(PdfSigner& signer, const char* data, size_t size,
+    size_t offset, size_t conentsBeaconOffset, size_t conentsBeaconSize)
+{
+    size_t end = offset + size;
+    size_t beaconEnd = conentsBeaconOffset + conentsBeaconSize;
+    if (end <= conentsBeaconOffset || offset >= beaconEnd)
     {
-        device.Seek(conentsBeaconOffset + conentsBeaconSize);
+        signer.AppendData({ data, size });
+        return;
     }
 
-    // read after beacon
-    bufferSize = std::min(bufferSize, device.GetLength() - device.GetPosition());
-    if (bufferSize == 0)
-        return readSize;
+    // Data before the beacon
+    if (offset < conentsBeaconOffset)
+        signer.AppendData({ data, conentsBeaconOffset - offset });
 
-    device.Read(buffer, bufferSize);
-    return readSize + bufferSize;
+    // Data after the beacon
+    if (end > beaconEnd)
+        signer.AppendData({ data + (beaconEnd - offset), end - beaconEnd });
 }
 
 void adjustByteRange(StreamDevice& device, size_t byteRangeOffset,
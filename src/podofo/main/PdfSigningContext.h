@@ -70,6 +70,7 @@ namespace PoDoFo
      */
     class PODOFO_API PdfSigningContext final
     {
+        PODOFO_UNIT_TEST(PdfSigningContextTest);
         friend PODOFO_API void SignDocument(PdfMemDocument& doc, StreamDevice& device, PdfSigner& signer,
             PdfSignature& signature, PdfSaveOptions saveOptions);
     public:
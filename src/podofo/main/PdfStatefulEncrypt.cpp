@@ -22,6 +22,12 @@ void PdfStatefulEncrypt::EncryptTo(charbuff& out, const bufferview& view) const
     m_encrypt->EncryptTo(out, view, m_currReference);
 }
 
+void PdfStatefulEncrypt::EncryptTo(OutputStream& out, const bufferview& view) const
+{
+    PODOFO_INVARIANT(m_encrypt != nullptr);
+    m_encrypt->EncryptTo(out, view, m_currReference);
+}
+
 void PdfStatefulEncrypt::DecryptTo(charbuff& out, const bufferview& view) const
 {
     PODOFO_INVARIANT(m_encrypt != nullptr);
@@ -13,6 +13,7 @@
 namespace PoDoFo
 {
     class PdfEncrypt;
+    class OutputStream;
 
     class PODOFO_API PdfStatefulEncrypt final
     {
@@ -25,6 +26,10 @@ namespace PoDoFo
          */
         void EncryptTo(charbuff& out, const bufferview& view) const;
 
+        /** Encrypt a character span directly to an output stream
+         */
+        void EncryptTo(OutputStream& out, const bufferview& view) const;
+
         /** Decrypt a character span
          */
         void DecryptTo(charbuff& out, const bufferview& view) const;
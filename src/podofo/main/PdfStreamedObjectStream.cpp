@@ -25,7 +25,7 @@ public:
     {
     }
 
-    ObjectOutputStream(PdfStreamedObjectStream& stream, unique_ptr<OutputStream> outputStream) :
+    ObjectOutputStream(PdfStreamedObjectStream& stream, unique_ptr<PdfEncryptOutputStream> outputStream) :
         m_objectStream(&stream),
         m_outputStream(outputStream.get()),
         m_outputStreamStore(std::move(outputStream))
@@ -34,7 +34,18 @@ public:
 
     ~ObjectOutputStream()
     {
-        Flush(*m_outputStream);
+        if (m_outputStreamStore == nullptr)
+        {
+            Flush(*m_outputStream);
+        }
+        else
+        {
+            // Close the encryption stream first, so it
+            // writes its final block to the device
+            m_outputStreamStore->Close();
+            m_outputStreamStore = nullptr;
+            Flush(*m_objectStream->m_Device);
+        }
         m_objectStream->FinishOutput();
     }
 
@@ -53,7 +64,7 @@ protected:
 private:
     PdfStreamedObjectStream* m_objectStream;
     OutputStream* m_outputStream;
-    std::unique_ptr<OutputStream> m_outputStreamStore;
+    std::unique_ptr<PdfEncryptOutputStream> m_outputStreamStore;
 };
 
 PdfStreamedObjectStream::PdfStreamedObjectStream(OutputStreamDevice& device) :
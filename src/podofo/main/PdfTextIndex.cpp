@@ -0,0 +1,481 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#include <podofo/private/PdfDeclarationsPrivate.h>
+#include <podofo/private/ParallelUtils.h>
+#include "PdfTextIndex.h"
+
+#include <cstring>
+
+#include <utf8cpp/utf8.h>
+
+#include <podofo/auxiliary/StreamDevice.h>
+
+#include "PdfDocument.h"
+#include "PdfPage.h"
+
+using namespace std;
+using namespace PoDoFo;
+
+constexpr string_view IndexMagic = "PDFTXIDX";
+constexpr uint32_t IndexVersion = 1;
+
+namespace
+{
+    // Words of a page, with terms not yet merged in the index
+    struct PendingPage
+    {
+        unsigned PageIndex;
+        size_t EntryStart;
+        size_t EntryCount;
+        vector<string> Terms;           // Distinct terms of the page
+        vector<unsigned> Words;         // Indices in Terms, by position
+        vector<Rect> Rects;
+    };
+}
+
+static PdfTextExtractParams getExtractParams();
+static void normalizeTerm(const string_view& word, string& term);
+static void splitPhrase(const string_view& phrase, vector<string>& terms);
+static void writeReal(OutputStream& stream, double value);
+static double readReal(InputStream& stream);
+static void readString(InputStream& stream, string& str);
+
+PdfTextIndex::PdfTextIndex() { }
+
+void PdfTextIndex::AddPage(const PdfPage& page)
+{
+    unsigned pageIndex = page.GetIndex();
+    RemovePage(pageIndex);
+    m_pages[pageIndex];
+
+    vector<PdfTextEntry> entries;
+    page.ExtractTextTo(entries, getExtractParams());
+    addEntries(entries, 1);
+}
+
+void PdfTextIndex::AddPages(const PdfDocument& doc, unsigned threadCount)
+{
+    auto& pages = doc.GetPages();
+    unsigned pageCount = pages.GetCount();
+    for (unsigned i = 0; i < pageCount; i++)
+    {
+        RemovePage(i);
+        m_pages[i];
+    }
+
+    vector<PdfTextEntry> entries;
+    doc.ExtractTextTo(entries, getExtractParams(), threadCount);
+    addEntries(entries, threadCount);
+}
+
+void PdfTextIndex::RemovePage(unsigned pageIndex)
+{
+    auto found = m_pages.find(pageIndex);
+    if (found == m_pages.end())
+        return;
+
+    for (unsigned term : found->second.Terms)
+    {
+        auto& postings = m_postings[term];
+        auto range = std::equal_range(postings.begin(), postings.end(), Posting{ pageIndex, 0 },
+            [](const Posting& lhs, const Posting& rhs) { return lhs.Page < rhs.Page; });
+        postings.erase(range.first, range.second);
+    }
+
+    m_pages.erase(found);
+}
+
+void PdfTextIndex::Search(vector<PdfTextIndexHit>& hits, const string_view& phrase) const
+{
+    if (!utls::IsValidUtf8String(phrase))
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "The phrase must be a valid UTF-8 string");
+
+    vector<string> terms;
+    splitPhrase(phrase, terms);
+    if (terms.size() == 0)
+        return;
+
+    vector<const vector<Posting>*> postings;
+    for (auto& term : terms)
+    {
+        auto found = m_termIds.find(term);
+        if (found == m_termIds.end())
+            return;
+
+        postings.push_back(&m_postings[found->second]);
+    }
+
+    auto less = [](const Posting& lhs, const Posting& rhs) {
+        return lhs.Page < rhs.Page || (lhs.Page == rhs.Page && lhs.Position < rhs.Position);
+    };
+
+    // Verify the following terms are found at the following
+    // positions of every occurrence of the first term
+    for (auto& first : *postings[0])
+    {
+        bool match = true;
+        for (unsigned i = 1; i < postings.size(); i++)
+        {
+            if (!std::binary_search(postings[i]->begin(), postings[i]->end(),
+                Posting{ first.Page, first.Position + i }, less))
+            {
+                match = false;
+                break;
+            }
+        }
+
+        if (!match)
+            continue;
+
+        auto& page = m_pages.at(first.Page);
+        PdfTextIndexHit hit;
+        hit.Page = first.Page;
+        hit.Rects.assign(page.Rects.begin() + first.Position,
+            page.Rects.begin() + first.Position + terms.size());
+        hits.push_back(std::move(hit));
+    }
+}
+
+void PdfTextIndex::Clear()
+{
+    m_termIds.clear();
+    m_terms.clear();
+    m_postings.clear();
+    m_pages.clear();
+}
+
+void PdfTextIndex::Save(const string_view& filename) const
+{
+    FileStreamDevice device(filename, FileMode::Create);
+    Save(device);
+}
+
+void PdfTextIndex::Save(OutputStreamDevice& device) const
+{
+    // Save only the terms still found in some
+    // page, compacting their identifiers
+    constexpr unsigned NoTerm = numeric_limits<unsigned>::max();
+    vector<unsigned> savedIds(m_terms.size(), NoTerm);
+    vector<unsigned> savedTerms;
+    for (unsigned i = 0; i < m_terms.size(); i++)
+    {
+        if (m_postings[i].size() == 0)
+            continue;
+
+        savedIds[i] = (unsigned)savedTerms.size();
+        savedTerms.push_back(i);
+    }
+
+    device.Write(IndexMagic);
+    utls::WriteUInt32BE(device, IndexVersion);
+    utls::WriteUInt32BE(device, (uint32_t)savedTerms.size());
+    for (unsigned term : savedTerms)
+    {
+        auto& str = *m_terms[term];
+        utls::WriteUInt32BE(device, (uint32_t)str.length());
+        device.Write(str);
+    }
+
+    utls::WriteUInt32BE(device, (uint32_t)m_pages.size());
+    for (auto& pair : m_pages)
+    {
+        auto& page = pair.second;
+        utls::WriteUInt32BE(device, pair.first);
+        utls::WriteUInt32BE(device, (uint32_t)page.Terms.size());
+        for (unsigned i = 0; i < page.Terms.size(); i++)
+        {
+            auto& rect = page.Rects[i];
+            utls::WriteUInt32BE(device, savedIds[page.Terms[i]]);
+            writeReal(device, rect.X);
+            writeReal(device, rect.Y);
+            writeReal(device, rect.Width);
+            writeReal(device, rect.Height);
+        }
+    }
+
+    device.Flush();
+}
+
+void PdfTextIndex::Load(const string_view& filename)
+{
+    if (filename.length() == 0)
+        PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    FileStreamDevice device(filename);
+    LoadFromStream(device);
+}
+
+void PdfTextIndex::LoadFromBuffer(const bufferview& buffer)
+{
+    SpanStreamDevice device(buffer);
+    LoadFromStream(device);
+}
+
+void PdfTextIndex::LoadFromStream(InputStream& stream)
+{
+    Clear();
+
+    char magic[IndexMagic.size()];
+    stream.Read(magic, IndexMagic.size());
+    uint32_t version;
+    utls::ReadUInt32BE(stream, version);
+    if (string_view(magic, IndexMagic.size()) != IndexMagic || version != IndexVersion)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid or unsupported text index");
+
+    uint32_t termCount;
+    utls::ReadUInt32BE(stream, termCount);
+    vector<unsigned> termIds;
+    string term;
+    for (unsigned i = 0; i < termCount; i++)
+    {
+        readString(stream, term);
+        termIds.push_back(getOrCreateTerm(term));
+    }
+
+    uint32_t pageCount;
+    utls::ReadUInt32BE(stream, pageCount);
+    for (unsigned i = 0; i < pageCount; i++)
+    {
+        uint32_t pageIndex;
+        uint32_t wordCount;
+        utls::ReadUInt32BE(stream, pageIndex);
+        utls::ReadUInt32BE(stream, wordCount);
+        auto& page = m_pages[pageIndex];
+        if (page.Terms.size() != 0)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Duplicated page in text index");
+
+        for (unsigned j = 0; j < wordCount; j++)
+        {
+            uint32_t savedId;
+            utls::ReadUInt32BE(stream, savedId);
+            if (savedId >= termIds.size())
+                PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid term in text index");
+
+            Rect rect;
+            rect.X = readReal(stream);
+            rect.Y = readReal(stream);
+            rect.Width = readReal(stream);
+            rect.Height = readReal(stream);
+            unsigned termId = termIds[savedId];
+            page.Terms.push_back(termId);
+            page.Rects.push_back(rect);
+            addPosting(termId, Posting{ pageIndex, j });
+        }
+    }
+}
+
+unsigned PdfTextIndex::GetTermCount() const
+{
+    unsigned count = 0;
+    for (auto& postings : m_postings)
+    {
+        if (postings.size() != 0)
+            count++;
+    }
+
+    return count;
+}
+
+void PdfTextIndex::addEntries(const vector<PdfTextEntry>& entries, unsigned threadCount)
+{
+    // Group the entries by page. They are sorted by page
+    vector<PendingPage> pending;
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        unsigned pageIndex = (unsigned)entries[i].Page;
+        if (pending.size() == 0 || pending.back().PageIndex != pageIndex)
+            pending.push_back(PendingPage{ pageIndex, i, 0, { }, { }, { } });
+
+        pending.back().EntryCount++;
+    }
+
+    // Normalize the terms of every page concurrently
+    threadCount = utls::GetWorkerThreadCount(threadCount);
+    utls::ParallelFor(pending.size(), threadCount, [&](size_t index) {
+        auto& page = pending[index];
+        unordered_map<string, unsigned> pageTerms;
+        string term;
+        for (size_t i = page.EntryStart; i < page.EntryStart + page.EntryCount; i++)
+        {
+            auto& entry = entries[i];
+            normalizeTerm(entry.Text, term);
+            if (term.empty())
+                continue;
+
+            auto inserted = pageTerms.emplace(term, (unsigned)page.Terms.size());
+            if (inserted.second)
+                page.Terms.push_back(term);
+
+            page.Words.push_back(inserted.first->second);
+            if (entry.BoundingBox.has_value())
+                page.Rects.push_back(*entry.BoundingBox);
+            else
+                page.Rects.push_back(Rect(entry.X, entry.Y, entry.Length, 0));
+        }
+    });
+
+    // Assign the identifiers to the distinct terms of every page
+    vector<unsigned> termIds;
+    vector<const IndexedPage*> indexedPages;
+    for (auto& page : pending)
+    {
+        termIds.clear();
+        for (auto& term : page.Terms)
+            termIds.push_back(getOrCreateTerm(term));
+
+        auto& indexed = m_pages[page.PageIndex];
+        indexedPages.push_back(&indexed);
+        indexed.Terms.reserve(page.Words.size());
+        for (unsigned word : page.Words)
+            indexed.Terms.push_back(termIds[word]);
+
+        indexed.Rects = std::move(page.Rects);
+    }
+
+    // Merge the postings concurrently, with every worker
+    // handling a disjoint set of terms, so the lists are
+    // filled without locking and in page order
+    unsigned shardCount = (unsigned)std::min<size_t>(threadCount, std::max<size_t>(m_terms.size(), 1));
+    utls::ParallelFor(shardCount, shardCount, [&](size_t shard) {
+        for (unsigned i = 0; i < pending.size(); i++)
+        {
+            auto& terms = indexedPages[i]->Terms;
+            for (unsigned j = 0; j < terms.size(); j++)
+            {
+                if (terms[j] % shardCount == shard)
+                    addPosting(terms[j], Posting{ pending[i].PageIndex, j });
+            }
+        }
+    });
+}
+
+unsigned PdfTextIndex::getOrCreateTerm(const string& term)
+{
+    auto inserted = m_termIds.emplace(term, (unsigned)m_terms.size());
+    if (inserted.second)
+    {
+        m_terms.push_back(&inserted.first->first);
+        m_postings.emplace_back();
+    }
+
+    return inserted.first->second;
+}
+
+void PdfTextIndex::addPosting(unsigned term, const Posting& posting)
+{
+    auto less = [](const Posting& lhs, const Posting& rhs) {
+        return lhs.Page < rhs.Page || (lhs.Page == rhs.Page && lhs.Position < rhs.Position);
+    };
+
+    auto& postings = m_postings[term];
+    if (postings.size() == 0 || less(postings.back(), posting))
+        postings.push_back(posting);
+    else
+        postings.insert(std::upper_bound(postings.begin(), postings.end(), posting, less), posting);
+}
+
+PdfTextExtractParams getExtractParams()
+{
+    PdfTextExtractParams params = { };
+    params.Flags = PdfTextExtractFlags::TokenizeWords | PdfTextExtractFlags::ComputeBoundingBox;
+    return params;
+}
+
+// Trim the delimiters around the word and lower it,
+// with the same folding of text extraction
+void normalizeTerm(const string_view& word, string& term)
+{
+    term.clear();
+    auto begin = word.end();
+    auto end = word.begin();
+    auto it = word.begin();
+    while (it != word.end())
+    {
+        auto prev = it;
+        char32_t cp = utf8::unchecked::next(it);
+        if (utls::IsStringDelimiter(cp))
+            continue;
+
+        if (begin == word.end())
+            begin = prev;
+
+        end = it;
+    }
+
+    if (begin == word.end())
+        return;
+
+    term.assign(begin, end);
+    std::transform(term.begin(), term.end(), term.begin(),
+        [](unsigned char c) { return (char)std::tolower(c); });
+}
+
+void splitPhrase(const string_view& phrase, vector<string>& terms)
+{
+    string term;
+    auto wordStart = phrase.begin();
+    auto it = phrase.begin();
+    while (true)
+    {
+        auto prev = it;
+        bool end = it == phrase.end();
+        if (end || utls::IsWhiteSpace(utf8::unchecked::next(it)))
+        {
+            normalizeTerm(phrase.substr(wordStart - phrase.begin(), prev - wordStart), term);
+            if (!term.empty())
+                terms.push_back(term);
+
+            if (end)
+                break;
+
+            wordStart = it;
+        }
+    }
+}
+
+// NOTE: Coordinates are saved in single precision
+void writeReal(OutputStream& stream, double value)
+{
+    float real = (float)value;
+    uint32_t bits;
+    std::memcpy(&bits, &real, sizeof(bits));
+    utls::WriteUInt32BE(stream, bits);
+}
+
+double readReal(InputStream& stream)
+{
+    uint32_t bits;
+    utls::ReadUInt32BE(stream, bits);
+    float real;
+    std::memcpy(&real, &bits, sizeof(real));
+    return real;
+}
+
+void readString(InputStream& stream, string& str)
+{
+    uint32_t length;
+    utls::ReadUInt32BE(stream, length);
+
+    // Check the length against the remaining data, so a corrupted
+    // index can't cause huge allocations
+    auto device = dynamic_cast<InputStreamDevice*>(&stream);
+    if (device != nullptr && length > device->GetLength() - device->GetPosition())
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid string length in text index");
+
+    // Otherwise read in blocks, which fails at the
+    // end of the stream before allocating too much
+    constexpr size_t BlockSize = 4096;
+    str.clear();
+    size_t read = 0;
+    while (read < length)
+    {
+        size_t size = std::min<size_t>(length - read, BlockSize);
+        str.resize(read + size);
+        stream.Read(str.data() + read, size);
+        read += size;
+    }
+}
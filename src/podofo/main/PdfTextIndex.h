@@ -0,0 +1,128 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef PDF_TEXT_INDEX_H
+#define PDF_TEXT_INDEX_H
+
+#include "PdfDeclarations.h"
+
+#include <map>
+#include <unordered_map>
+
+#include <podofo/auxiliary/Rect.h>
+#include <podofo/auxiliary/InputStream.h>
+#include <podofo/auxiliary/OutputDevice.h>
+
+namespace PoDoFo {
+
+class PdfDocument;
+class PdfPage;
+struct PdfTextEntry;
+
+/** An occurrence of a phrase found with PdfTextIndex::Search()
+ */
+struct PODOFO_API PdfTextIndexHit final
+{
+    unsigned Page;              ///< Index of the page
+    std::vector<Rect> Rects;    ///< Bounding boxes of the words of the phrase, to highlight them
+};
+
+/** A compact inverted index of the words of the pages of a
+ * document, mapping every term to the pages and positions where
+ * it's found, to be queried with phrase search. Terms are case
+ * insensitive and the punctuation around words is ignored.
+ * The index can be saved next to the document and loaded back
+ * without parsing the document again
+ */
+class PODOFO_API PdfTextIndex final
+{
+public:
+    PdfTextIndex();
+
+    PdfTextIndex(PdfTextIndex&&) = default;
+
+    PdfTextIndex& operator=(PdfTextIndex&&) = default;
+
+public:
+    /** Index the words of the page, replacing the
+     * ones previously indexed for the same page
+     */
+    void AddPage(const PdfPage& page);
+
+    /** Index the words of all the pages of the document, replacing
+     * the pages previously indexed. The text of the pages is extracted
+     * and merged in the index concurrently
+     * \param threadCount number of threads to use, including the calling
+     *  one. 0 means the number of hardware threads available
+     * \see PdfDocument::ExtractTextTo()
+     */
+    void AddPages(const PdfDocument& doc, unsigned threadCount = 0);
+
+    /** Remove the words of the page with the given index, if indexed
+     */
+    void RemovePage(unsigned pageIndex);
+
+    /** Search the words of the phrase, following each other on the same page
+     * \param hits the occurrences are appended here, in page and position order
+     */
+    void Search(std::vector<PdfTextIndexHit>& hits, const std::string_view& phrase) const;
+
+    void Clear();
+
+    void Save(const std::string_view& filename) const;
+
+    void Save(OutputStreamDevice& device) const;
+
+    /** Load an index previously saved, replacing the current content
+     */
+    void Load(const std::string_view& filename);
+
+    void LoadFromBuffer(const bufferview& buffer);
+
+    void LoadFromStream(InputStream& stream);
+
+    /** Get the number of indexed pages
+     */
+    unsigned GetPageCount() const { return (unsigned)m_pages.size(); }
+
+    /** Get the number of distinct terms in the index
+     */
+    unsigned GetTermCount() const;
+
+private:
+    struct Posting
+    {
+        unsigned Page;
+        unsigned Position;
+    };
+
+    struct IndexedPage
+    {
+        std::vector<unsigned> Terms;    // Term identifiers, by position
+        std::vector<Rect> Rects;
+    };
+
+private:
+    // NOTE: Copies are not allowed, since the terms by identifier
+    // point to the keys of the map of the identifiers
+    PdfTextIndex(const PdfTextIndex&) = delete;
+    PdfTextIndex& operator=(const PdfTextIndex&) = delete;
+
+private:
+    void addEntries(const std::vector<PdfTextEntry>& entries, unsigned threadCount);
+    unsigned getOrCreateTerm(const std::string& term);
+    void addPosting(unsigned term, const Posting& posting);
+
+private:
+    std::unordered_map<std::string, unsigned> m_termIds;
+    std::vector<const std::string*> m_terms;        // Terms by identifier
+    std::vector<std::vector<Posting>> m_postings;   // Postings by term, sorted by page and position
+    std::map<unsigned, IndexedPage> m_pages;
+};
+
+}
+
+#endif // PDF_TEXT_INDEX_H
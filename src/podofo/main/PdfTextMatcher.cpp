@@ -0,0 +1,175 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#include <podofo/private/PdfDeclarationsPrivate.h>
+#include "PdfTextMatcher.h"
+
+#include <deque>
+
+#include <utf8cpp/utf8.h>
+
+using namespace std;
+using namespace PoDoFo;
+
+constexpr unsigned NoNode = numeric_limits<unsigned>::max();
+
+static unsigned char foldCase(unsigned char ch);
+
+PdfTextMatcher::PdfTextMatcher(const cspan<string_view>& keywords, PdfTextExtractFlags flags) :
+    m_ignoreCase((flags & PdfTextExtractFlags::IgnoreCase) != PdfTextExtractFlags::None),
+    m_matchWholeWord((flags & PdfTextExtractFlags::MatchWholeWord) != PdfTextExtractFlags::None)
+{
+    if (keywords.size() == 0)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "At least one keyword must be specified");
+
+    // Build the trie of the keywords
+    m_keywords.reserve(keywords.size());
+    m_nodes.push_back(Node{ { }, 0, NoNode, NoNode });
+    for (unsigned i = 0; i < keywords.size(); i++)
+    {
+        auto& keyword = keywords[i];
+        if (keyword.empty())
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Keywords must be non empty");
+
+        if (!utls::IsValidUtf8String(keyword))
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Keywords must be valid UTF-8 strings");
+
+        m_keywords.push_back((string)keyword);
+        unsigned node = 0;
+        for (char ch : keyword)
+        {
+            unsigned char folded = m_ignoreCase ? foldCase((unsigned char)ch) : (unsigned char)ch;
+            auto& children = m_nodes[node].Children;
+            auto found = std::lower_bound(children.begin(), children.end(), folded,
+                [](const pair<unsigned char, unsigned>& edge, unsigned char value) { return edge.first < value; });
+            if (found != children.end() && found->first == folded)
+            {
+                node = found->second;
+            }
+            else
+            {
+                unsigned child = (unsigned)m_nodes.size();
+                children.insert(found, { folded, child });
+                m_nodes.push_back(Node{ { }, 0, NoNode, NoNode });
+                node = child;
+            }
+        }
+
+        m_links.push_back(KeywordLink{ i, m_nodes[node].Keywords });
+        m_nodes[node].Keywords = (unsigned)m_links.size() - 1;
+    }
+
+    // Compute the failure links breadth first, so the
+    // failure node of every node is already resolved
+    deque<unsigned> queue;
+    for (auto& edge : m_nodes[0].Children)
+        queue.push_back(edge.second);
+
+    while (queue.size() != 0)
+    {
+        unsigned node = queue.front();
+        queue.pop_front();
+        for (auto& edge : m_nodes[node].Children)
+        {
+            unsigned child = edge.second;
+            unsigned failure = m_nodes[node].Failure;
+            unsigned next;
+            while ((next = findChild(failure, edge.first)) == NoNode && failure != 0)
+                failure = m_nodes[failure].Failure;
+
+            failure = next == NoNode ? 0 : next;
+            auto& childNode = m_nodes[child];
+            childNode.Failure = failure;
+            childNode.Suffix = m_nodes[failure].Keywords == NoNode ? m_nodes[failure].Suffix : failure;
+            queue.push_back(child);
+        }
+    }
+}
+
+void PdfTextMatcher::Search(const string_view& text, const PdfTextMatchHandler& handler) const
+{
+    if (handler == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Handler must be non null");
+
+    unsigned state = 0;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        unsigned char ch = m_ignoreCase ? foldCase((unsigned char)text[i]) : (unsigned char)text[i];
+        unsigned next;
+        while ((next = findChild(state, ch)) == NoNode && state != 0)
+            state = m_nodes[state].Failure;
+
+        state = next == NoNode ? 0 : next;
+        for (unsigned node = state; node != NoNode; node = m_nodes[node].Suffix)
+        {
+            for (unsigned link = m_nodes[node].Keywords; link != NoNode; link = m_links[link].Next)
+            {
+                unsigned keyword = m_links[link].Keyword;
+                size_t length = m_keywords[keyword].length();
+                size_t offset = i + 1 - length;
+                if (m_matchWholeWord && !isWholeWord(text, offset, length))
+                    continue;
+
+                handler(keyword, offset);
+            }
+        }
+    }
+}
+
+const string& PdfTextMatcher::GetKeyword(unsigned index) const
+{
+    if (index >= m_keywords.size())
+        PODOFO_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+
+    return m_keywords[index];
+}
+
+unsigned PdfTextMatcher::findChild(unsigned node, unsigned char ch) const
+{
+    auto& children = m_nodes[node].Children;
+    auto found = std::lower_bound(children.begin(), children.end(), ch,
+        [](const pair<unsigned char, unsigned>& edge, unsigned char value) { return edge.first < value; });
+    if (found == children.end() || found->first != ch)
+        return NoNode;
+
+    return found->second;
+}
+
+// Verify the presence of delimiters around the match
+bool PdfTextMatcher::isWholeWord(const string_view& text, size_t offset, size_t length) const
+{
+    if (offset != 0)
+    {
+        // Go back to the lead byte of the previous code point
+        size_t prev = offset - 1;
+        while (prev != 0 && ((unsigned char)text[prev] & 0xC0) == 0x80)
+            prev--;
+
+        auto it = text.begin() + prev;
+        if (!utls::IsStringDelimiter(utf8::unchecked::next(it)))
+            return false;
+    }
+
+    size_t end = offset + length;
+    if (end != text.size())
+    {
+        auto it = text.begin() + end;
+        if (!utls::IsStringDelimiter(utf8::unchecked::next(it)))
+            return false;
+    }
+
+    return true;
+}
+
+// NOTE: Same folding as the one used by
+// text extraction with IgnoreCase flag
+unsigned char foldCase(unsigned char ch)
+{
+    if (ch >= 'A' && ch <= 'Z')
+        return (unsigned char)(ch + ('a' - 'A'));
+
+    return ch;
+}
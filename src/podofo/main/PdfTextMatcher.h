@@ -0,0 +1,96 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef PDF_TEXT_MATCHER_H
+#define PDF_TEXT_MATCHER_H
+
+#include "PdfDeclarations.h"
+
+#include <podofo/auxiliary/Rect.h>
+
+namespace PoDoFo {
+
+/** An occurrence of a keyword found by PdfPage::SearchTextTo()
+ */
+struct PODOFO_API PdfTextMatch final
+{
+    unsigned Keyword;       ///< Index of the matched keyword
+    std::string Text;       ///< The matched text, as found in the page
+    int Page;
+    double X;
+    double Y;
+    double Length;
+    nullable<Rect> BoundingBox;
+};
+
+/** Handler invoked with the index of the matched keyword
+ * and the byte offset of the occurrence in the text
+ */
+using PdfTextMatchHandler = std::function<void(unsigned keyword, size_t offset)>;
+
+/** A matcher of multiple keywords at once, compiled to an
+ * Aho-Corasick automaton, so the text is scanned only one time
+ * regardless of the number of keywords. It can be shared between
+ * threads and reused across pages and documents
+ * \see PdfPage::SearchTextTo(), PdfDocument::SearchTextTo()
+ */
+class PODOFO_API PdfTextMatcher final
+{
+public:
+    /**
+     * \param keywords UTF-8 keywords to search, must be non empty
+     * \param flags only PdfTextExtractFlags::IgnoreCase and
+     *  PdfTextExtractFlags::MatchWholeWord are considered
+     */
+    PdfTextMatcher(const cspan<std::string_view>& keywords,
+        PdfTextExtractFlags flags = PdfTextExtractFlags::None);
+
+public:
+    /** Find all the occurrences of the keywords in the text,
+     * including overlapping ones, ordered by their end
+     */
+    void Search(const std::string_view& text, const PdfTextMatchHandler& handler) const;
+
+    const std::string& GetKeyword(unsigned index) const;
+
+    unsigned GetKeywordCount() const { return (unsigned)m_keywords.size(); }
+
+    bool IsIgnoreCase() const { return m_ignoreCase; }
+
+    bool IsMatchWholeWord() const { return m_matchWholeWord; }
+
+private:
+    unsigned findChild(unsigned node, unsigned char ch) const;
+
+    bool isWholeWord(const std::string_view& text, size_t offset, size_t length) const;
+
+private:
+    struct Node
+    {
+        // Trie edges, sorted by byte
+        std::vector<std::pair<unsigned char, unsigned>> Children;
+        unsigned Failure = 0;
+        unsigned Suffix;        // Nearest node on the failure chain ending a keyword
+        unsigned Keywords;      // Head of the list of keywords ending here
+    };
+
+    struct KeywordLink
+    {
+        unsigned Keyword;
+        unsigned Next;
+    };
+
+private:
+    std::vector<std::string> m_keywords;
+    std::vector<Node> m_nodes;
+    std::vector<KeywordLink> m_links;
+    bool m_ignoreCase;
+    bool m_matchWholeWord;
+};
+
+}
+
+#endif // PDF_TEXT_MATCHER_H
@@ -10,66 +10,94 @@
 using namespace std;
 using namespace PoDoFo;
 
+static const PdfVariantStack::Stack s_emptyStack;
+
 void PdfVariantStack::Push(const PdfVariant& var)
 {
-    m_variants.push_back(var);
+    getVariantsForWrite().push_back(var);
 }
 
 void PdfVariantStack::Push(PdfVariant&& var)
 {
-    m_variants.push_back(std::move(var));
+    getVariantsForWrite().push_back(std::move(var));
 }
 
 void PdfVariantStack::Pop()
 {
-    m_variants.pop_back();
+    getVariantsForWrite().pop_back();
 }
 
 void PdfVariantStack::Clear()
 {
-    m_variants.clear();
+    if (m_variants == nullptr)
+        return;
+
+    // Keep the allocated memory only if not shared
+    if (m_variants.use_count() == 1)
+        m_variants->clear();
+    else
+        m_variants = nullptr;
 }
 
 unsigned PdfVariantStack::GetSize() const
 {
-    return (unsigned)m_variants.size();
+    return (unsigned)getVariants().size();
 }
 
 const PdfVariant& PdfVariantStack::operator[](size_t index) const
 {
+    auto& variants = getVariants();
     // Access elements from the end
-    index = (m_variants.size() - 1) - index;
-    if (index >= m_variants.size())
+    index = (variants.size() - 1) - index;
+    if (index >= variants.size())
         PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Index {} is out of range", index);
 
-    return m_variants[index];
+    return variants[index];
 }
 
 PdfVariantStack::iterator PdfVariantStack::begin() const
 {
     // Iterate elements from the end in the regular iteration
-    return m_variants.rbegin();
+    return getVariants().rbegin();
 }
 
 PdfVariantStack::iterator PdfVariantStack::end() const
 {
     // Iterate elements from the end in the regular iteration
-    return m_variants.rend();
+    return getVariants().rend();
 }
 
 PdfVariantStack::reverse_iterator PdfVariantStack::rbegin() const
 {
     // Iterate elements from the begin the reverse iteration
-    return m_variants.begin();
+    return getVariants().begin();
 }
 
 PdfVariantStack::reverse_iterator PdfVariantStack::rend() const
 {
     // Iterate elements from the begin the reverse iteration
-    return m_variants.end();
+    return getVariants().end();
 }
 
 size_t PdfVariantStack::size() const
 {
-    return m_variants.size();
+    return getVariants().size();
+}
+
+const PdfVariantStack::Stack& PdfVariantStack::getVariants() const
+{
+    if (m_variants == nullptr)
+        return s_emptyStack;
+
+    return *m_variants;
+}
+
+PdfVariantStack::Stack& PdfVariantStack::getVariantsForWrite()
+{
+    if (m_variants == nullptr)
+        m_variants = std::make_shared<Stack>();
+    else if (m_variants.use_count() != 1)
+        m_variants = std::make_shared<Stack>(*m_variants);
+
+    return *m_variants;
 }
@@ -36,7 +36,13 @@ public:
     size_t size() const;
 
 private:
-    Stack m_variants;
+    const Stack& getVariants() const;
+    Stack& getVariantsForWrite();
+
+private:
+    // Copies share the variants until they are modified, so
+    // contents replayed from a cache are not deep copied
+    std::shared_ptr<Stack> m_variants;
 };
 
 }
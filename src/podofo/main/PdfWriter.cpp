@@ -36,6 +36,7 @@ PdfWriter::PdfWriter(PdfIndirectObjectList* objects, const PdfObject& trailer, P
     m_EncryptObj(nullptr),
     m_SaveOptions(PdfSaveOptions::None),
     m_WriteFlags(PdfWriteFlags::None),
+    m_keepOriginalIdentifier(false),
     m_PrevXRefOffset(0),
     m_IncrementalUpdate(false),
     m_rewriteXRefTable(false)
@@ -73,10 +74,16 @@ void PdfWriter::Write(OutputStreamDevice& device)
 {
     CreateFileIdentifier(m_identifier, *m_Trailer, &m_originalIdentifier);
 
+    // The file encryption key of a document authenticated with
+    // it derives from the original first /ID element, which
+    // is then kept as for incremental updates
+    m_keepOriginalIdentifier = !m_originalIdentifier.IsEmpty()
+        && (m_IncrementalUpdate || (m_Encrypt != nullptr && m_Encrypt->IsKeyAuthenticated()));
+
     // setup encrypt dictionary
     if (m_Encrypt != nullptr)
     {
-        m_Encrypt->GenerateEncryptionKey(m_identifier);
+        m_Encrypt->GenerateEncryptionKey(m_keepOriginalIdentifier ? m_originalIdentifier : m_identifier);
 
         // Add our own Encryption dictionary
         m_EncryptObj = &m_Objects->CreateDictionaryObject();
@@ -200,7 +207,7 @@ void PdfWriter::FillTrailerObject(PdfObject& trailer, size_t size, bool onlySize
 
         PdfArray array;
         // The ID is the same unless the PDF was incrementally updated
-        if (m_IncrementalUpdate && !m_originalIdentifier.IsEmpty())
+        if (m_keepOriginalIdentifier)
             array.Add(m_originalIdentifier);
         else
             array.Add(m_identifier);
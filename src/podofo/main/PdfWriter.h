@@ -189,6 +189,7 @@ private:
 
     PdfString m_identifier;
     PdfString m_originalIdentifier; // used for incremental update
+    bool m_keepOriginalIdentifier;  // The original identifier is the first /ID element
     int64_t m_PrevXRefOffset;
     bool m_IncrementalUpdate;
     bool m_rewriteXRefTable; // Only used if incremental update
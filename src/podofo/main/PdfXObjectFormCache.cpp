@@ -0,0 +1,81 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#include <podofo/private/PdfDeclarationsPrivate.h>
+#include "PdfXObjectFormCache.h"
+
+#include <podofo/private/PdfXObjectFormCacheEntry.h>
+
+using namespace std;
+using namespace PoDoFo;
+
+PdfXObjectFormCache::PdfXObjectFormCache(size_t maxSize) :
+    m_maxSize(maxSize),
+    m_size(0)
+{
+}
+
+void PdfXObjectFormCache::Clear()
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_forms.clear();
+    m_usage.clear();
+    m_size = 0;
+}
+
+void PdfXObjectFormCache::Remove(const PdfReference& ref)
+{
+    unique_lock<mutex> lock(m_mutex);
+    remove(ref);
+}
+
+size_t PdfXObjectFormCache::GetSize() const
+{
+    unique_lock<mutex> lock(m_mutex);
+    return m_size;
+}
+
+shared_ptr<const PdfXObjectFormCacheEntry> PdfXObjectFormCache::find(const PdfReference& ref)
+{
+    unique_lock<mutex> lock(m_mutex);
+    auto found = m_forms.find(ref);
+    if (found == m_forms.end())
+        return nullptr;
+
+    // Mark the form as the most recently used
+    m_usage.splice(m_usage.begin(), m_usage, found->second.Position);
+    return found->second.Entry;
+}
+
+void PdfXObjectFormCache::insert(const PdfReference& ref, const shared_ptr<const PdfXObjectFormCacheEntry>& entry)
+{
+    if (entry->Size > m_maxSize)
+        return;
+
+    unique_lock<mutex> lock(m_mutex);
+    // Another reader may have cached the same form meanwhile
+    remove(ref);
+    while (m_size + entry->Size > m_maxSize)
+    {
+        PdfReference leastUsed = m_usage.back();
+        remove(leastUsed);
+    }
+
+    m_usage.push_front(ref);
+    m_forms[ref] = { entry, m_usage.begin() };
+    m_size += entry->Size;
+}
+
+void PdfXObjectFormCache::remove(const PdfReference& ref)
+{
+    auto found = m_forms.find(ref);
+    if (found == m_forms.end())
+        return;
+
+    m_size -= found->second.Entry->Size;
+    m_usage.erase(found->second.Position);
+    m_forms.erase(found);
+}
@@ -0,0 +1,79 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef PDF_XOBJECT_FORM_CACHE_H
+#define PDF_XOBJECT_FORM_CACHE_H
+
+#include "PdfReference.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace PoDoFo {
+
+struct PdfXObjectFormCacheEntry;
+
+/** A bounded cache of the tokenized contents of XObject forms,
+ * shared by all the PdfContentStreamReader instances reading the
+ * contents of a document. The least recently used forms are
+ * evicted first. It's safe to use it from multiple threads
+ * \remarks Forms are cached by reference, so the cache must be
+ * cleared if the content of cached forms is modified
+ * \see PdfDocument::SetXObjectFormCacheSize()
+ */
+class PODOFO_API PdfXObjectFormCache final
+{
+    friend class PdfDocument;
+    friend class PdfContentStreamReader;
+
+private:
+    PdfXObjectFormCache(size_t maxSize);
+
+public:
+    /** Remove all the cached forms
+     */
+    void Clear();
+
+    /** Remove the cached contents of the form with the given reference
+     */
+    void Remove(const PdfReference& ref);
+
+    /** Get the approximate size of the cached contents in bytes
+     */
+    size_t GetSize() const;
+
+    size_t GetMaxSize() const { return m_maxSize; }
+
+private:
+    std::shared_ptr<const PdfXObjectFormCacheEntry> find(const PdfReference& ref);
+
+    void insert(const PdfReference& ref, const std::shared_ptr<const PdfXObjectFormCacheEntry>& entry);
+
+    void remove(const PdfReference& ref);
+
+private:
+    PdfXObjectFormCache(const PdfXObjectFormCache&) = delete;
+    PdfXObjectFormCache& operator=(const PdfXObjectFormCache&) = delete;
+
+private:
+    struct CachedForm
+    {
+        std::shared_ptr<const PdfXObjectFormCacheEntry> Entry;
+        std::list<PdfReference>::iterator Position;
+    };
+
+private:
+    size_t m_maxSize;
+    size_t m_size;
+    std::unordered_map<PdfReference, CachedForm> m_forms;
+    std::list<PdfReference> m_usage; // Most recently used first
+    mutable std::mutex m_mutex;
+};
+
+}
+
+#endif // PDF_XOBJECT_FORM_CACHE_H
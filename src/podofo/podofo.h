@@ -36,6 +36,8 @@
 #include "main/PdfColorSpace.h"
 #include "main/PdfColor.h"
 #include "main/PdfContentStreamReader.h"
+#include "main/PdfContentStreamViewReader.h"
+#include "main/PdfContentStreamRewriter.h"
 #include "main/PdfPostScriptTokenizer.h"
 #include "main/PdfData.h"
 #include "main/PdfDataProvider.h"
@@ -117,8 +119,11 @@
 #include "main/PdfPainterPath.h"
 #include "main/PdfPainter.h"
 #include "main/PdfStreamedDocument.h"
+#include "main/PdfTextIndex.h"
+#include "main/PdfTextMatcher.h"
 #include "main/PdfXObject.h"
 #include "main/PdfXObjectForm.h"
+#include "main/PdfXObjectFormCache.h"
 #include "main/PdfXObjectPostScript.h"
 
 // Staging headers
@@ -20,9 +20,47 @@ using namespace PoDoFo;
 static void addAttribute(CMS_SignerInfo* si, int(*addAttributeFun)(CMS_SignerInfo*, const char*, int, const void*, int),
     const string_view& nid, const bufferview& attr, bool octet);
 
+CmsCertificate::CmsCertificate(const bufferview& cert, PdfHashingAlgorithm hashing) :
+    m_hashing(hashing)
+{
+    auto in = (const unsigned char*)cert.data();
+    m_cert = d2i_X509(nullptr, &in, (int)cert.size());
+    if (m_cert == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::OutOfMemory, "d2i_X509");
+
+    int len;
+    unsigned char* buf = nullptr;
+    len = i2d_X509(m_cert, &buf);
+    if (len < 0)
+    {
+        X509_free(m_cert);
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::OutOfMemory, "i2d_X509");
+    }
+
+    auto clean = [&]() {
+        OPENSSL_free(buf);
+    };
+
+    try
+    {
+        m_hash = ssl::ComputeHash({(const char*) buf, (size_t)len }, hashing);
+    }
+    catch (...)
+    {
+        clean();
+        X509_free(m_cert);
+        throw;
+    }
+    clean();
+}
+
+CmsCertificate::~CmsCertificate()
+{
+    X509_free(m_cert);
+}
+
 CmsContext::CmsContext() :
     m_status(CmsContextStatus::Uninitialized),
-    m_cert(nullptr),
     m_cms(nullptr),
     m_signer(nullptr),
     m_databio(nullptr),
@@ -30,14 +68,13 @@ CmsContext::CmsContext() :
 {
 }
 
-void CmsContext::Reset(const bufferview& cert, const CmsContextParams& parameters)
+void CmsContext::Reset(const shared_ptr<const CmsCertificate>& cert, const CmsContextParams& parameters)
 {
+    PODOFO_ASSERT(cert != nullptr && cert->GetHashing() == parameters.Hashing);
     clear();
 
     m_parameters = parameters,
-
-    loadX509Certificate(cert);
-    computeCertificateHash();
+    m_cert = cert;
 
     reset();
     m_status = CmsContextStatus::Initialized;
@@ -139,46 +176,9 @@ void CmsContext::AddAttribute(const string_view& nid, const bufferview& attr, bo
     }
 }
 
-void CmsContext::loadX509Certificate(const bufferview& cert)
-{
-    auto in = (const unsigned char*)cert.data();
-    m_cert = d2i_X509(nullptr, &in, (int)cert.size());
-    if (m_cert == nullptr)
-        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::OutOfMemory, "d2i_X509");
-}
-
-void CmsContext::computeCertificateHash()
-{
-    int len;
-    unsigned char* buf = nullptr;
-
-    len = i2d_X509(m_cert, &buf);
-    if (len < 0)
-        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::OutOfMemory, "i2d_X509");
-
-    auto clean = [&]() {
-        OPENSSL_free(buf);
-    };
-
-    try
-    {
-        m_certHash = ssl::ComputeHash({(const char*) buf, (size_t)len }, m_parameters.Hashing);
-    }
-    catch (...)
-    {
-        clean();
-        throw;
-    }
-    clean();
-}
-
 void CmsContext::clear()
 {
-    if (m_cert != nullptr)
-    {
-        X509_free(m_cert);
-        m_cert = nullptr;
-    }
+    m_cert = nullptr;
 
     if (m_cms != nullptr)
     {
@@ -213,16 +213,16 @@ void CmsContext::reset()
     // Fake private key using public key from certificate
     // This allows to pass internal checks of CMS_add1_signer
     // since parameter "pk" can't be nullptr
-    auto fakePrivKey = X509_get0_pubkey(m_cert);
+    auto fakePrivKey = X509_get0_pubkey(m_cert->GetX509());
 
     // NOTE: CAdES signatures don't want unneeded attributes
-    m_signer = CMS_add1_signer(m_cms, m_cert, fakePrivKey, sign_md,
+    m_signer = CMS_add1_signer(m_cms, m_cert->GetX509(), fakePrivKey, sign_md,
         m_parameters.SkipWriteMIMECapabilities ? CMS_NOSMIMECAP : 0);
     if (m_signer == nullptr)
         PODOFO_RAISE_ERROR_INFO(PdfErrorCode::OpenSSL, "CMS_add1_signer");
 
     if (m_parameters.AddSigningCertificateV2)
-        ssl::AddSigningCertificateV2(m_signer, m_certHash);
+        ssl::AddSigningCertificateV2(m_signer, m_cert->GetHash());
 }
 
 void CmsContext::checkAppendStarted()
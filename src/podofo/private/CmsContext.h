@@ -34,6 +34,27 @@ namespace PoDoFo
         nullable<std::chrono::seconds> SigningTimeUTC;
     };
 
+    /** A parsed X509 certificate together with its hash. It's
+     * immutable, so it can be shared by many contexts
+     */
+    class CmsCertificate final
+    {
+    public:
+        CmsCertificate(const bufferview& cert, PdfHashingAlgorithm hashing);
+        ~CmsCertificate();
+    public:
+        struct x509_st* GetX509() const { return m_cert; }
+        const charbuff& GetHash() const { return m_hash; }
+        PdfHashingAlgorithm GetHashing() const { return m_hashing; }
+    private:
+        CmsCertificate(const CmsCertificate&) = delete;
+        CmsCertificate& operator=(const CmsCertificate&) = delete;
+    private:
+        struct x509_st* m_cert;
+        charbuff m_hash;
+        PdfHashingAlgorithm m_hashing;
+    };
+
     /** This class computes a CMS signature according to RFC 5652
      */
     class CmsContext final
@@ -42,14 +63,12 @@ namespace PoDoFo
         CmsContext();
         ~CmsContext();
     public:
-        void Reset(const bufferview& cert, const CmsContextParams& parameters);
+        void Reset(const std::shared_ptr<const CmsCertificate>& cert, const CmsContextParams& parameters);
         void AppendData(const bufferview& data);
         void ComputeHashToSign(charbuff& hashToSign);
         void ComputeSignature(const bufferview& signedHash, charbuff& signature);
         void AddAttribute(const std::string_view& nid, const bufferview& attr, bool signedAttr, bool octetString);
     private:
-        void loadX509Certificate(const bufferview& cert);
-        void computeCertificateHash();
         void clear();
         void reset();
         void checkAppendStarted();
@@ -70,8 +89,7 @@ namespace PoDoFo
     private:
         CmsContextStatus m_status;
         CmsContextParams m_parameters;
-        struct x509_st* m_cert;
-        charbuff m_certHash;
+        std::shared_ptr<const CmsCertificate> m_cert;
         struct CMS_ContentInfo_st* m_cms;
         struct CMS_SignerInfo_st* m_signer;
         struct bio_st* m_databio;
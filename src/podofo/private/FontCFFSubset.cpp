@@ -0,0 +1,959 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "FontCFFSubset.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+// The Compact Font Format Specification, Technical Note #5176
+// https://adobe-type-tools.github.io/font-tech-notes/pdfs/5176.CFF.pdf
+// The Type 2 Charstring Format, Technical Note #5177
+// https://adobe-type-tools.github.io/font-tech-notes/pdfs/5177.Type2.pdf
+
+using namespace std;
+using namespace PoDoFo;
+
+enum CFFOperator : unsigned
+{
+    OpUniqueID = 13,
+    OpXUID = 14,
+    OpCharset = 15,
+    OpEncoding = 16,
+    OpCharStrings = 17,
+    OpPrivate = 18,
+    OpSubrs = 19,
+    OpCharstringType = 1206,
+    OpROS = 1230,
+    OpCIDCount = 1234,
+    OpFDArray = 1236,
+    OpFDSelect = 1237,
+};
+
+// Maximum nesting of subroutine calls in Type 2 charstrings
+static constexpr unsigned MaxSubrDepth = 10;
+
+// Subroutine used to replace the unused ones, just returning
+static const char EmptySubr[] = { 11 };
+
+static bufferview getCFFData(const bufferview& data, bool& isOpenType);
+static unsigned readCard(const bufferview& data, size_t offset, unsigned size);
+static int getSubrBias(size_t subrCount);
+static unsigned getStandardEncodingSID(unsigned code);
+static void writeCard(charbuff& output, unsigned value, unsigned size);
+static void writeIndex(charbuff& output, const vector<bufferview>& items);
+static void writeSubrs(charbuff& output, const vector<bufferview>& subrs, const vector<bool>& usedSubrs, bool keepAll);
+static void writeDictInt(charbuff& output, int value);
+static void writeDictOp(charbuff& output, unsigned op);
+
+FontCFFSubset::FontCFFSubset(const bufferview& data, bool cidGlyphIds) :
+    m_data(data),
+    m_cidGlyphIds(cidGlyphIds),
+    m_isCIDKeyed(false),
+    m_isType2(true),
+    m_keepAllSubrs(false)
+{
+}
+
+void FontCFFSubset::BuildFont(charbuff& output, const PdfFontMetrics& metrics,
+    const GIDList& gidList)
+{
+    if (metrics.GetFontFileType() != PdfFontFileType::Type1CCF)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "The font to be subsetted is not a CFF font");
+
+    bool isOpenType;
+    auto data = getCFFData(metrics.GetOrLoadFontFileData(), isOpenType);
+    FontCFFSubset subset(data, !isOpenType);
+    subset.buildFont(output, gidList);
+}
+
+void FontCFFSubset::CheckFont(const PdfFontMetrics& metrics)
+{
+    if (metrics.GetFontFileType() != PdfFontFileType::Type1CCF)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "The font to be subsetted is not a CFF font");
+
+    bool isOpenType;
+    auto data = getCFFData(metrics.GetOrLoadFontFileData(), isOpenType);
+    FontCFFSubset subset(data, !isOpenType);
+    subset.init();
+}
+
+void FontCFFSubset::buildFont(charbuff& output, const GIDList& gidList)
+{
+    init();
+    loadGlyphs(gidList);
+    writeFont(output);
+}
+
+void FontCFFSubset::init()
+{
+    size_t offset = readCard(m_data, 2, 1);
+    offset = readIndex(offset, m_names);
+    offset = readIndex(offset, m_topDicts);
+    offset = readIndex(offset, m_strings);
+    (void)readIndex(offset, m_globalSubrs);
+    if (m_topDicts.Items.size() != 1)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedFontFormat, "CFF font sets are not supported");
+
+    parseDict(m_topDicts.Items[0], m_topDict);
+    // Type 1 charstrings are not inspected for subroutine calls
+    if (getDictValue(m_topDict, OpCharstringType, 2) != 2)
+    {
+        m_isType2 = false;
+        m_keepAllSubrs = true;
+    }
+
+    if (findEntry(m_topDict, OpCharStrings) == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Missing CFF CharStrings");
+
+    (void)readIndex((unsigned)getDictValue(m_topDict, OpCharStrings, 0), m_charStrings);
+    unsigned glyphCount = (unsigned)m_charStrings.Items.size();
+    if (glyphCount == 0)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Missing CFF glyphs");
+
+    readCharset((unsigned)getDictValue(m_topDict, OpCharset, 0), glyphCount);
+    m_isCIDKeyed = findEntry(m_topDict, OpROS) != nullptr;
+    if (m_isCIDKeyed)
+    {
+        if (findEntry(m_topDict, OpFDArray) == nullptr || findEntry(m_topDict, OpFDSelect) == nullptr)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Missing CFF FDArray or FDSelect");
+
+        (void)readIndex((unsigned)getDictValue(m_topDict, OpFDArray, 0), m_fdArray);
+        m_fontDicts.resize(m_fdArray.Items.size());
+        m_privates.resize(m_fdArray.Items.size());
+        for (unsigned i = 0; i < m_fontDicts.size(); i++)
+        {
+            parseDict(m_fdArray.Items[i], m_fontDicts[i]);
+            readPrivate(m_fontDicts[i], m_privates[i]);
+        }
+
+        readFDSelect((unsigned)getDictValue(m_topDict, OpFDSelect, 0), glyphCount);
+    }
+    else
+    {
+        m_privates.resize(1);
+        readPrivate(m_topDict, m_privates[0]);
+        m_fdSelect.resize(glyphCount);
+    }
+
+    m_usedGlobalSubrs.resize(m_globalSubrs.Items.size());
+    for (auto& priv : m_privates)
+        priv.UsedSubrs.resize(priv.Subrs.Items.size());
+}
+
+void FontCFFSubset::loadGlyphs(const GIDList& gidList)
+{
+    unordered_map<unsigned, unsigned> cidToGidMap;
+    if (m_cidGlyphIds && m_isCIDKeyed)
+    {
+        for (unsigned gid = 0; gid < m_charset.size(); gid++)
+            cidToGidMap.insert({ m_charset[gid], gid });
+    }
+
+    // For any fonts, assume that glyph 0 is needed
+    m_orderedGIDs.push_back(0);
+    for (unsigned gid : gidList)
+    {
+        if (m_cidGlyphIds && m_isCIDKeyed)
+        {
+            auto found = cidToGidMap.find(gid);
+            gid = found == cidToGidMap.end() ? 0 : found->second;
+        }
+
+        if (gid >= m_charStrings.Items.size())
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Glyph index {} out of range", gid);
+
+        m_orderedGIDs.push_back(gid);
+    }
+
+    unordered_set<unsigned> loadedGIDs(m_orderedGIDs.begin(), m_orderedGIDs.end());
+    unordered_map<unsigned, unsigned> sidToGidMap;
+    for (unsigned i = 0; i < m_orderedGIDs.size(); i++)
+    {
+        unsigned gid = m_orderedGIDs[i];
+        CharstringContext ctx;
+        ctx.Private = &m_privates[m_fdSelect[gid]];
+        if (m_isType2)
+        {
+            try
+            {
+                scanCharstring(m_charStrings.Items[gid], ctx, 0);
+            }
+            catch (const PdfError& error)
+            {
+                if (error.GetCode() != PdfErrorCode::InvalidFontData)
+                    throw;
+
+                // The used subroutines can't be determined from a
+                // malformed charstring, so keep them all: the subset
+                // is still valid, just not as small as possible
+                if (!m_keepAllSubrs)
+                {
+                    PoDoFo::LogMessage(PdfLogSeverity::Warning,
+                        "Malformed CFF charstring for glyph {}, keeping all the subroutines: {}", gid, error.what());
+                    m_keepAllSubrs = true;
+                }
+            }
+        }
+
+        if (ctx.AccentCodes.empty())
+            continue;
+
+        // The base and accent glyphs of the "seac" like endchar are
+        // selected by name, so they are added after the requested ones
+        if (sidToGidMap.empty())
+        {
+            for (unsigned j = 0; j < m_charset.size(); j++)
+                sidToGidMap.insert({ m_charset[j], j });
+        }
+
+        for (unsigned code : ctx.AccentCodes)
+        {
+            auto found = sidToGidMap.find(getStandardEncodingSID(code));
+            if (found != sidToGidMap.end() && loadedGIDs.insert(found->second).second)
+                m_orderedGIDs.push_back(found->second);
+        }
+    }
+}
+
+// Determine the used subroutines by following the calls in the
+// charstring. The stem hints are counted to skip the hint masks
+void FontCFFSubset::scanCharstring(const bufferview& charstring, CharstringContext& ctx, unsigned depth)
+{
+    if (depth > MaxSubrDepth)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Too deeply nested CFF subroutines");
+
+    auto& stack = ctx.Stack;
+    size_t size = charstring.size();
+    size_t i = 0;
+    while (i < size)
+    {
+        unsigned char b0 = (unsigned char)charstring[i];
+        i++;
+        if (b0 >= 32)
+        {
+            if (b0 <= 246)
+            {
+                stack.push_back((int)b0 - 139);
+            }
+            else if (b0 <= 254)
+            {
+                if (i + 1 > size)
+                    PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Invalid CFF charstring");
+
+                int value = ((int)b0 - (b0 <= 250 ? 247 : 251)) * 256 + (unsigned char)charstring[i] + 108;
+                stack.push_back(b0 <= 250 ? value : -value);
+                i++;
+            }
+            else
+            {
+                // 16.16 fixed number, only the integer part is used
+                stack.push_back((int)readCard(charstring, i, 4) >> 16);
+                i += 4;
+            }
+
+            continue;
+        }
+
+        switch (b0)
+        {
+            case 28:
+            {
+                stack.push_back((int16_t)readCard(charstring, i, 2));
+                i += 2;
+                break;
+            }
+            case 1:     // hstem
+            case 3:     // vstem
+            case 18:    // hstemhm
+            case 23:    // vstemhm
+            {
+                ctx.StemCount += (unsigned)stack.size() / 2;
+                stack.clear();
+                break;
+            }
+            case 19:    // hintmask
+            case 20:    // cntrmask
+            {
+                // The arguments, if present, are implicit vstem hints
+                ctx.StemCount += (unsigned)stack.size() / 2;
+                stack.clear();
+                i += (ctx.StemCount + 7) / 8;
+                break;
+            }
+            case 10:    // callsubr
+            case 29:    // callgsubr
+            {
+                if (stack.empty())
+                    PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Missing CFF subroutine number");
+
+                auto& subrs = b0 == 10 ? ctx.Private->Subrs.Items : m_globalSubrs.Items;
+                auto& usedSubrs = b0 == 10 ? ctx.Private->UsedSubrs : m_usedGlobalSubrs;
+                int index = stack.back() + getSubrBias(subrs.size());
+                stack.pop_back();
+                if (index < 0 || (size_t)index >= subrs.size())
+                    PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Invalid CFF subroutine number");
+
+                usedSubrs[index] = true;
+                scanCharstring(subrs[index], ctx, depth + 1);
+                if (ctx.Ended)
+                    return;
+
+                break;
+            }
+            case 11:    // return
+            {
+                return;
+            }
+            case 14:    // endchar
+            {
+                // With four arguments, the deprecated "seac" composition
+                // of the standard encoding base and accent characters
+                if (!m_isCIDKeyed && stack.size() >= 4)
+                {
+                    ctx.AccentCodes.push_back((unsigned)stack[stack.size() - 2]);
+                    ctx.AccentCodes.push_back((unsigned)stack[stack.size() - 1]);
+                }
+
+                ctx.Ended = true;
+                return;
+            }
+            case 12:
+            {
+                if (i + 1 > size)
+                    PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Invalid CFF charstring");
+
+                unsigned char b1 = (unsigned char)charstring[i];
+                i++;
+                switch (b1)
+                {
+                    case 0:     // dotsection
+                    case 34:    // hflex
+                    case 35:    // flex
+                    case 36:    // hflex1
+                    case 37:    // flex1
+                        stack.clear();
+                        break;
+                    default:
+                    {
+                        // Arithmetic and storage operators can compute
+                        // subroutine numbers, so all of them are kept
+                        m_keepAllSubrs = true;
+                        ctx.Ended = true;
+                        return;
+                    }
+                }
+                break;
+            }
+            default:
+            {
+                // Path construction operators
+                stack.clear();
+                break;
+            }
+        }
+    }
+}
+
+// NOTE: All the offsets in the DICTs are written with 5 bytes,
+// so their sizes are known before the offsets are computed
+void FontCFFSubset::writeFont(charbuff& output)
+{
+    // Map the font DICTs of the used glyphs to the ones of the subset
+    vector<int> fdMap(m_privates.size(), -1);
+    vector<unsigned> usedFDs;
+    for (unsigned gid : m_orderedGIDs)
+    {
+        unsigned fd = m_fdSelect[gid];
+        if (fdMap[fd] == -1)
+        {
+            fdMap[fd] = (int)usedFDs.size();
+            usedFDs.push_back(fd);
+        }
+    }
+
+    charbuff globalSubrs;
+    writeSubrs(globalSubrs, m_globalSubrs.Items, m_usedGlobalSubrs, m_keepAllSubrs);
+
+    charbuff charset;
+    writeCharset(charset);
+
+    charbuff fdSelect;
+    if (m_isCIDKeyed)
+        writeFDSelect(fdSelect, fdMap);
+
+    charbuff charStrings;
+    vector<bufferview> glyphs;
+    for (unsigned gid : m_orderedGIDs)
+        glyphs.push_back(m_charStrings.Items[gid]);
+    writeIndex(charStrings, glyphs);
+
+    // The Private DICTs are followed by their local subroutines
+    vector<charbuff> privates(usedFDs.size());
+    vector<unsigned> privateSizes(usedFDs.size());
+    for (unsigned i = 0; i < usedFDs.size(); i++)
+        writePrivate(privates[i], m_privates[usedFDs[i]], privateSizes[i]);
+
+    charbuff topDict;
+    writeTopDict(topDict, 0, 0, 0, 0, 0, 0);
+    charbuff topDicts;
+    writeIndex(topDicts, { topDict });
+
+    unsigned charsetOffset = (unsigned)(4 + m_names.Data.size() + topDicts.size()
+        + m_strings.Data.size() + globalSubrs.size());
+    unsigned fdSelectOffset = charsetOffset + (unsigned)charset.size();
+    unsigned charStringsOffset = fdSelectOffset + (unsigned)fdSelect.size();
+    unsigned fdArrayOffset = charStringsOffset + (unsigned)charStrings.size();
+
+    charbuff fdArray;
+    vector<unsigned> privateOffsets(usedFDs.size());
+    if (m_isCIDKeyed)
+    {
+        // Compute the size of the FDArray with placeholder
+        // offsets, to compute the offsets of the Private DICTs
+        vector<charbuff> fontDicts(usedFDs.size());
+        writeFDArray(fdArray, fontDicts, usedFDs, privateSizes, privateOffsets);
+        unsigned privateOffset = fdArrayOffset + (unsigned)fdArray.size();
+        for (unsigned i = 0; i < usedFDs.size(); i++)
+        {
+            privateOffsets[i] = privateOffset;
+            privateOffset += (unsigned)privates[i].size();
+        }
+
+        fdArray.clear();
+        writeFDArray(fdArray, fontDicts, usedFDs, privateSizes, privateOffsets);
+    }
+    else
+    {
+        privateOffsets[0] = fdArrayOffset;
+    }
+
+    size_t topDictSize = topDict.size();
+    topDict.clear();
+    writeTopDict(topDict, charsetOffset, fdSelectOffset, charStringsOffset, fdArrayOffset,
+        m_isCIDKeyed ? 0 : privateSizes[0], privateOffsets[0]);
+    PODOFO_ASSERT(topDict.size() == topDictSize);
+    (void)topDictSize;
+    topDicts.clear();
+    writeIndex(topDicts, { topDict });
+
+    // Header, with the offsets size ignored by the readers
+    output.clear();
+    output.push_back(m_data[0]);
+    output.push_back(m_data[1]);
+    output.push_back(4);
+    output.push_back(4);
+    output.append(m_names.Data.data(), m_names.Data.size());
+    output.append(topDicts);
+    output.append(m_strings.Data.data(), m_strings.Data.size());
+    output.append(globalSubrs);
+    output.append(charset);
+    output.append(fdSelect);
+    output.append(charStrings);
+    output.append(fdArray);
+    for (auto& priv : privates)
+        output.append(priv);
+}
+
+void FontCFFSubset::writeCharset(charbuff& output)
+{
+    if (m_isCIDKeyed)
+    {
+        // The glyphs are selected by CIDs that equal the new GIDs,
+        // so a single range of consecutive CIDs is written
+        if (m_orderedGIDs.size() == 1)
+        {
+            output.push_back(0);
+        }
+        else
+        {
+            output.push_back(2);
+            writeCard(output, 1, 2);
+            writeCard(output, (unsigned)m_orderedGIDs.size() - 2, 2);
+        }
+    }
+    else
+    {
+        output.push_back(0);
+        for (unsigned i = 1; i < m_orderedGIDs.size(); i++)
+            writeCard(output, m_charset[m_orderedGIDs[i]], 2);
+    }
+}
+
+void FontCFFSubset::writeFDSelect(charbuff& output, const vector<int>& fdMap)
+{
+    vector<pair<unsigned, unsigned>> ranges;
+    for (unsigned i = 0; i < m_orderedGIDs.size(); i++)
+    {
+        unsigned fd = (unsigned)fdMap[m_fdSelect[m_orderedGIDs[i]]];
+        if (ranges.empty() || ranges.back().second != fd)
+            ranges.push_back({ i, fd });
+    }
+
+    output.push_back(3);
+    writeCard(output, (unsigned)ranges.size(), 2);
+    for (auto& range : ranges)
+    {
+        writeCard(output, range.first, 2);
+        writeCard(output, range.second, 1);
+    }
+
+    writeCard(output, (unsigned)m_orderedGIDs.size(), 2);
+}
+
+void FontCFFSubset::writePrivate(charbuff& output, PrivateData& priv, unsigned& dictSize)
+{
+    static const unsigned skippedOps[] = { OpSubrs };
+    writeDictEntries(output, priv.Entries, skippedOps);
+    if (priv.Subrs.Items.size() != 0)
+    {
+        // The local subroutines follow the DICT, and
+        // their offset is relative to its beginning
+        writeDictInt(output, (int)output.size() + 6);
+        writeDictOp(output, OpSubrs);
+        dictSize = (unsigned)output.size();
+        writeSubrs(output, priv.Subrs.Items, priv.UsedSubrs, m_keepAllSubrs);
+    }
+    else
+    {
+        dictSize = (unsigned)output.size();
+    }
+}
+
+void FontCFFSubset::writeFDArray(charbuff& output, vector<charbuff>& fontDicts, const vector<unsigned>& usedFDs,
+    const vector<unsigned>& privateSizes, const vector<unsigned>& privateOffsets)
+{
+    static const unsigned skippedOps[] = { OpPrivate };
+    vector<bufferview> items;
+    for (unsigned i = 0; i < usedFDs.size(); i++)
+    {
+        auto& fontDict = fontDicts[i];
+        fontDict.clear();
+        writeDictEntries(fontDict, m_fontDicts[usedFDs[i]], skippedOps);
+        writeDictInt(fontDict, (int)privateSizes[i]);
+        writeDictInt(fontDict, (int)privateOffsets[i]);
+        writeDictOp(fontDict, OpPrivate);
+        items.push_back(fontDict);
+    }
+
+    writeIndex(output, items);
+}
+
+void FontCFFSubset::writeTopDict(charbuff& output, unsigned charsetOffset, unsigned fdSelectOffset,
+    unsigned charStringsOffset, unsigned fdArrayOffset, unsigned privateSize, unsigned privateOffset)
+{
+    // The unique identifiers are removed, as the subset is a different font,
+    // and the encoding is not used when selecting glyphs by CID
+    static const unsigned skippedOps[] = { OpUniqueID, OpXUID, OpCharset, OpEncoding,
+        OpCharStrings, OpPrivate, OpCIDCount, OpFDArray, OpFDSelect };
+    writeDictEntries(output, m_topDict, skippedOps);
+    writeDictInt(output, (int)charsetOffset);
+    writeDictOp(output, OpCharset);
+    writeDictInt(output, (int)charStringsOffset);
+    writeDictOp(output, OpCharStrings);
+    if (m_isCIDKeyed)
+    {
+        writeDictInt(output, (int)m_orderedGIDs.size());
+        writeDictOp(output, OpCIDCount);
+        writeDictInt(output, (int)fdArrayOffset);
+        writeDictOp(output, OpFDArray);
+        writeDictInt(output, (int)fdSelectOffset);
+        writeDictOp(output, OpFDSelect);
+    }
+    else
+    {
+        writeDictInt(output, (int)privateSize);
+        writeDictInt(output, (int)privateOffset);
+        writeDictOp(output, OpPrivate);
+    }
+}
+
+size_t FontCFFSubset::readIndex(size_t offset, Index& index) const
+{
+    index.Items.clear();
+    unsigned count = readCard(m_data, offset, 2);
+    if (count == 0)
+    {
+        index.Data = m_data.subspan(offset, 2);
+        return offset + 2;
+    }
+
+    unsigned offSize = readCard(m_data, offset + 2, 1);
+    if (offSize < 1 || offSize > 4)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Invalid CFF INDEX");
+
+    // The offsets are relative to the byte preceding the data
+    size_t offsetsStart = offset + 3;
+    size_t dataStart = offsetsStart + (size_t)(count + 1) * offSize - 1;
+    unsigned prevOffset = readCard(m_data, offsetsStart, offSize);
+    for (unsigned i = 1; i <= count; i++)
+    {
+        unsigned currOffset = readCard(m_data, offsetsStart + (size_t)i * offSize, offSize);
+        if (prevOffset == 0 || currOffset < prevOffset || dataStart + currOffset > m_data.size())
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Invalid CFF INDEX");
+
+        index.Items.push_back(m_data.subspan(dataStart + prevOffset, currOffset - prevOffset));
+        prevOffset = currOffset;
+    }
+
+    size_t end = dataStart + prevOffset;
+    index.Data = m_data.subspan(offset, end - offset);
+    return end;
+}
+
+void FontCFFSubset::readCharset(unsigned offset, unsigned glyphCount)
+{
+    m_charset.resize(glyphCount);
+    switch (offset)
+    {
+        case 0:
+        {
+            // ISOAdobe charset, with SIDs equal to GIDs
+            for (unsigned gid = 0; gid < glyphCount; gid++)
+                m_charset[gid] = gid;
+            return;
+        }
+        case 1:
+        case 2:
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::UnsupportedFontFormat, "CFF expert charsets are not supported");
+        default:
+            break;
+    }
+
+    unsigned format = readCard(m_data, offset, 1);
+    size_t pos = offset + 1;
+    unsigned gid = 1;
+    switch (format)
+    {
+        case 0:
+        {
+            for (; gid < glyphCount; gid++, pos += 2)
+                m_charset[gid] = readCard(m_data, pos, 2);
+            break;
+        }
+        case 1:
+        case 2:
+        {
+            unsigned leftSize = format == 1 ? 1 : 2;
+            while (gid < glyphCount)
+            {
+                unsigned first = readCard(m_data, pos, 2);
+                unsigned left = readCard(m_data, pos + 2, leftSize);
+                pos += 2 + leftSize;
+                for (unsigned i = 0; i <= left && gid < glyphCount; i++, gid++)
+                    m_charset[gid] = first + i;
+            }
+            break;
+        }
+        default:
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Invalid CFF charset format");
+    }
+}
+
+void FontCFFSubset::readFDSelect(unsigned offset, unsigned glyphCount)
+{
+    m_fdSelect.resize(glyphCount);
+    unsigned format = readCard(m_data, offset, 1);
+    switch (format)
+    {
+        case 0:
+        {
+            for (unsigned gid = 0; gid < glyphCount; gid++)
+                m_fdSelect[gid] = (uint8_t)readCard(m_data, offset + 1 + gid, 1);
+            break;
+        }
+        case 3:
+        {
+            unsigned rangeCount = readCard(m_data, offset + 1, 2);
+            size_t pos = offset + 3;
+            for (unsigned i = 0; i < rangeCount; i++, pos += 3)
+            {
+                unsigned first = readCard(m_data, pos, 2);
+                unsigned fd = readCard(m_data, pos + 2, 1);
+                unsigned last = std::min(readCard(m_data, pos + 3, 2), glyphCount);
+                for (unsigned gid = first; gid < last; gid++)
+                    m_fdSelect[gid] = (uint8_t)fd;
+            }
+            break;
+        }
+        default:
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Invalid CFF FDSelect format");
+    }
+
+    for (uint8_t fd : m_fdSelect)
+    {
+        if (fd >= m_fontDicts.size())
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Invalid CFF FDSelect");
+    }
+}
+
+void FontCFFSubset::readPrivate(const Dict& dict, PrivateData& priv) const
+{
+    auto entry = findEntry(dict, OpPrivate);
+    if (entry == nullptr || entry->Values.size() != 2)
+        return;
+
+    unsigned size = (unsigned)entry->Values[0];
+    unsigned offset = (unsigned)entry->Values[1];
+    if ((size_t)offset + size > m_data.size())
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Invalid CFF Private DICT");
+
+    parseDict(m_data.subspan(offset, size), priv.Entries);
+    if (findEntry(priv.Entries, OpSubrs) != nullptr)
+        (void)readIndex((size_t)offset + (unsigned)getDictValue(priv.Entries, OpSubrs, 0), priv.Subrs);
+}
+
+// Get the bare CFF data, extracting it from the "CFF "
+// table if the font is an OpenType font
+bufferview getCFFData(const bufferview& data, bool& isOpenType)
+{
+    if (data.size() < 12 || string_view(data.data(), 4) != "OTTO")
+    {
+        isOpenType = false;
+        return data;
+    }
+
+    isOpenType = true;
+    unsigned tableCount = readCard(data, 4, 2);
+    for (unsigned i = 0; i < tableCount; i++)
+    {
+        size_t record = 12 + (size_t)i * 16;
+        if (readCard(data, record, 4) != 0x43464620) // "CFF "
+            continue;
+
+        unsigned offset = readCard(data, record + 8, 4);
+        unsigned length = readCard(data, record + 12, 4);
+        if ((size_t)offset + length > data.size())
+            break;
+
+        return data.subspan(offset, length);
+    }
+
+    PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Missing OpenType CFF table");
+}
+
+unsigned readCard(const bufferview& data, size_t offset, unsigned size)
+{
+    if (offset + size > data.size())
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Unexpected end of CFF data");
+
+    unsigned ret = 0;
+    for (unsigned i = 0; i < size; i++)
+        ret = ret << 8 | (unsigned char)data[offset + i];
+
+    return ret;
+}
+
+void FontCFFSubset::parseDict(const bufferview& data, Dict& dict)
+{
+    size_t size = data.size();
+    size_t operandsStart = 0;
+    vector<int> values;
+    size_t i = 0;
+    while (i < size)
+    {
+        unsigned char b0 = (unsigned char)data[i];
+        if (b0 <= 21)
+        {
+            size_t operandsEnd = i;
+            unsigned op = b0;
+            i++;
+            if (b0 == 12)
+            {
+                op = 1200 + readCard(data, i, 1);
+                i++;
+            }
+
+            dict.push_back({ op, data.subspan(operandsStart, operandsEnd - operandsStart), std::move(values) });
+            values.clear();
+            operandsStart = i;
+        }
+        else if (b0 == 28)
+        {
+            values.push_back((int16_t)readCard(data, i + 1, 2));
+            i += 3;
+        }
+        else if (b0 == 29)
+        {
+            values.push_back((int32_t)readCard(data, i + 1, 4));
+            i += 5;
+        }
+        else if (b0 == 30)
+        {
+            // Skip the nibbles of the real number, up to the end one
+            i++;
+            while (true)
+            {
+                unsigned char nibbles = (unsigned char)readCard(data, i, 1);
+                i++;
+                if ((nibbles & 0x0F) == 0x0F || (nibbles & 0xF0) == 0xF0)
+                    break;
+            }
+
+            values.push_back(0);
+        }
+        else if (b0 >= 32 && b0 <= 246)
+        {
+            values.push_back((int)b0 - 139);
+            i++;
+        }
+        else if (b0 >= 247 && b0 <= 254)
+        {
+            int value = ((int)b0 - (b0 <= 250 ? 247 : 251)) * 256 + (int)readCard(data, i + 1, 1) + 108;
+            values.push_back(b0 <= 250 ? value : -value);
+            i += 2;
+        }
+        else
+        {
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidFontData, "Invalid CFF DICT");
+        }
+    }
+}
+
+const FontCFFSubset::DictEntry* FontCFFSubset::findEntry(const Dict& dict, unsigned op)
+{
+    for (auto& entry : dict)
+    {
+        if (entry.Operator == op)
+            return &entry;
+    }
+
+    return nullptr;
+}
+
+int FontCFFSubset::getDictValue(const Dict& dict, unsigned op, int defaultValue)
+{
+    auto entry = findEntry(dict, op);
+    if (entry == nullptr || entry->Values.empty())
+        return defaultValue;
+
+    return entry->Values.back();
+}
+
+int getSubrBias(size_t subrCount)
+{
+    if (subrCount < 1240)
+        return 107;
+    else if (subrCount < 33900)
+        return 1131;
+    else
+        return 32768;
+}
+
+// Map the standard encoding code to the SID of the glyph name
+unsigned getStandardEncodingSID(unsigned code)
+{
+    struct Range
+    {
+        unsigned char FirstCode;
+        unsigned char LastCode;
+        unsigned char FirstSID;
+    };
+
+    static const Range ranges[] = {
+        { 32, 126, 1 }, { 161, 175, 96 }, { 177, 180, 111 }, { 182, 189, 115 },
+        { 191, 191, 123 }, { 193, 200, 124 }, { 202, 203, 132 }, { 205, 208, 134 },
+        { 225, 225, 138 }, { 227, 227, 139 }, { 232, 235, 140 }, { 241, 241, 144 },
+        { 245, 245, 145 }, { 248, 251, 146 },
+    };
+
+    for (auto& range : ranges)
+    {
+        if (code >= range.FirstCode && code <= range.LastCode)
+            return range.FirstSID + code - range.FirstCode;
+    }
+
+    // .notdef
+    return 0;
+}
+
+void writeCard(charbuff& output, unsigned value, unsigned size)
+{
+    for (unsigned i = size; i > 0; i--)
+        output.push_back((char)(value >> ((i - 1) * 8)));
+}
+
+void writeIndex(charbuff& output, const vector<bufferview>& items)
+{
+    writeCard(output, (unsigned)items.size(), 2);
+    if (items.empty())
+        return;
+
+    size_t dataSize = 0;
+    for (auto& item : items)
+        dataSize += item.size();
+
+    unsigned offSize;
+    if (dataSize + 1 < 0x100)
+        offSize = 1;
+    else if (dataSize + 1 < 0x10000)
+        offSize = 2;
+    else if (dataSize + 1 < 0x1000000)
+        offSize = 3;
+    else
+        offSize = 4;
+
+    output.push_back((char)offSize);
+    unsigned offset = 1;
+    writeCard(output, offset, offSize);
+    for (auto& item : items)
+    {
+        offset += (unsigned)item.size();
+        writeCard(output, offset, offSize);
+    }
+
+    for (auto& item : items)
+        output.append(item.data(), item.size());
+}
+
+// The unused subroutines are replaced with empty ones,
+// so the numbers of the used ones don't change
+void writeSubrs(charbuff& output, const vector<bufferview>& subrs, const vector<bool>& usedSubrs, bool keepAll)
+{
+    vector<bufferview> items;
+    items.reserve(subrs.size());
+    for (unsigned i = 0; i < subrs.size(); i++)
+    {
+        if (keepAll || usedSubrs[i])
+            items.push_back(subrs[i]);
+        else
+            items.push_back(bufferview(EmptySubr, 1));
+    }
+
+    writeIndex(output, items);
+}
+
+void FontCFFSubset::writeDictEntries(charbuff& output, const Dict& dict, const cspan<unsigned>& skippedOps)
+{
+    for (auto& entry : dict)
+    {
+        if (std::find(skippedOps.begin(), skippedOps.end(), entry.Operator) != skippedOps.end())
+            continue;
+
+        output.append(entry.Operands.data(), entry.Operands.size());
+        writeDictOp(output, entry.Operator);
+    }
+}
+
+void writeDictInt(charbuff& output, int value)
+{
+    output.push_back(29);
+    writeCard(output, (unsigned)value, 4);
+}
+
+void writeDictOp(charbuff& output, unsigned op)
+{
+    if (op >= 1200)
+    {
+        output.push_back(12);
+        output.push_back((char)(op - 1200));
+    }
+    else
+    {
+        output.push_back((char)op);
+    }
+}
@@ -0,0 +1,127 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef PDF_FONT_CFF_SUBSET_H
+#define PDF_FONT_CFF_SUBSET_H
+
+#include "FontTrueTypeSubset.h"
+
+namespace PoDoFo {
+
+/**
+ * This class is able to build a new CFF font with only
+ * certain glyphs from an existing CFF font, bare or
+ * wrapped in an OpenType font.
+ *
+ * The glyphs are renumbered consecutively after the .notdef
+ * glyph, in the order they are given, so CIDs used to select
+ * them in a CIDFontType0 font equal their new GIDs
+ */
+class FontCFFSubset final
+{
+private:
+    FontCFFSubset(const bufferview& data, bool cidGlyphIds);
+
+public:
+    /**
+     * Actually generate the subsetted font
+     *
+     * \param output write the bare CFF font to this buffer
+     * \param metrics font metrics object for this font
+     * \param gidList a list of gids to load
+     */
+    static void BuildFont(charbuff& output, const PdfFontMetrics& metrics,
+        const GIDList& gidList);
+
+    /**
+     * Check the font can be subsetted, raising the same
+     * errors of BuildFont() for unsupported or invalid fonts
+     *
+     * \param metrics font metrics object for this font
+     */
+    static void CheckFont(const PdfFontMetrics& metrics);
+
+private:
+    FontCFFSubset(const FontCFFSubset& rhs) = delete;
+    FontCFFSubset& operator=(const FontCFFSubset& rhs) = delete;
+
+private:
+    struct Index
+    {
+        bufferview Data;                // The whole INDEX
+        std::vector<bufferview> Items;
+    };
+
+    struct DictEntry
+    {
+        unsigned Operator;              // Two byte operators are 1200 + second byte
+        bufferview Operands;
+        std::vector<int> Values;        // Real numbers are read as 0
+    };
+
+    using Dict = std::vector<DictEntry>;
+
+    struct PrivateData
+    {
+        Dict Entries;
+        Index Subrs;
+        std::vector<bool> UsedSubrs;
+    };
+
+    struct CharstringContext
+    {
+        PrivateData* Private = nullptr;
+        std::vector<int> Stack;
+        unsigned StemCount = 0;
+        bool Ended = false;
+        std::vector<unsigned> AccentCodes;  // Standard encoding codes of "seac" like endchar
+    };
+
+    void init();
+    void buildFont(charbuff& output, const GIDList& gidList);
+    void loadGlyphs(const GIDList& gidList);
+    void scanCharstring(const bufferview& charstring, CharstringContext& ctx, unsigned depth);
+    void writeFont(charbuff& output);
+    void writeCharset(charbuff& output);
+    void writeFDSelect(charbuff& output, const std::vector<int>& fdMap);
+    void writePrivate(charbuff& output, PrivateData& priv, unsigned& dictSize);
+    void writeFDArray(charbuff& output, std::vector<charbuff>& fontDicts, const std::vector<unsigned>& usedFDs,
+        const std::vector<unsigned>& privateSizes, const std::vector<unsigned>& privateOffsets);
+    void writeTopDict(charbuff& output, unsigned charsetOffset, unsigned fdSelectOffset,
+        unsigned charStringsOffset, unsigned fdArrayOffset, unsigned privateSize, unsigned privateOffset);
+    size_t readIndex(size_t offset, Index& index) const;
+    void readCharset(unsigned offset, unsigned glyphCount);
+    void readFDSelect(unsigned offset, unsigned glyphCount);
+    void readPrivate(const Dict& dict, PrivateData& priv) const;
+    static void parseDict(const bufferview& data, Dict& dict);
+    static const DictEntry* findEntry(const Dict& dict, unsigned op);
+    static int getDictValue(const Dict& dict, unsigned op, int defaultValue);
+    static void writeDictEntries(charbuff& output, const Dict& dict, const cspan<unsigned>& skippedOps);
+
+private:
+    bufferview m_data;
+    bool m_cidGlyphIds;     // True if glyphs are identified by CIDs, like FreeType does for bare CID-keyed fonts
+    bool m_isCIDKeyed;
+    bool m_isType2;         // True if the charstrings are in the Type 2 format
+    bool m_keepAllSubrs;
+    Index m_names;
+    Index m_topDicts;
+    Index m_strings;
+    Index m_globalSubrs;
+    Index m_charStrings;
+    Index m_fdArray;
+    Dict m_topDict;
+    std::vector<Dict> m_fontDicts;
+    std::vector<PrivateData> m_privates;    // One for every font DICT
+    std::vector<unsigned> m_charset;        // GID to SID, or to CID for CID-keyed fonts
+    std::vector<uint8_t> m_fdSelect;        // GID to font DICT
+    std::vector<bool> m_usedGlobalSubrs;
+    std::vector<unsigned> m_orderedGIDs;    // Ordered list of original GIDs as they will appear in the subset
+};
+
+};
+
+#endif // PDF_FONT_CFF_SUBSET_H
@@ -0,0 +1,365 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "FontDirectoryIndex.h"
+#include "FileSystem.h"
+#include "FreetypePrivate.h"
+#include FT_TRUETYPE_TABLES_H
+
+#include <podofo/auxiliary/StreamDevice.h>
+
+using namespace std;
+using namespace PoDoFo;
+
+constexpr string_view IndexMagic = "PDFFNIDX";
+constexpr uint32_t IndexVersion = 1;
+// Two string lengths, style, weight and index
+constexpr size_t MinFaceSize = 4 + 4 + 2 + 2 + 4;
+
+static string normalizeName(const string_view& name);
+static void writeString(OutputStream& stream, const string_view& str);
+static void readString(InputStreamDevice& device, string& str);
+static void writeUInt64(OutputStream& stream, uint64_t value);
+static uint64_t readUInt64(InputStream& stream);
+
+FontDirectoryIndex::FontDirectoryIndex() { }
+
+void FontDirectoryIndex::SetFilePath(const string_view& filepath)
+{
+    m_filePath = filepath;
+    m_directories.clear();
+    buildLookups();
+    if (!m_filePath.empty())
+        load();
+}
+
+void FontDirectoryIndex::AddDirectory(const string_view& path)
+{
+    error_code ec;
+    auto dirPath = fs::canonical(fs::u8path(path), ec);
+    if (ec || !fs::is_directory(dirPath, ec))
+        return;
+
+    auto& directory = m_directories[dirPath.u8string()];
+    directory.Added = true;
+
+    // Verify the files with their size and modification
+    // time, opening only the new or changed ones
+    bool changed = false;
+    map<string, File> files;
+    for (fs::recursive_directory_iterator it(dirPath, fs::directory_options::skip_permission_denied, ec), end;
+        !ec && it != end; it.increment(ec))
+    {
+        auto& filePath = it->path();
+        if (!fs::is_regular_file(filePath, ec))
+            continue;
+
+        auto size = fs::file_size(filePath, ec);
+        if (ec)
+            continue;
+
+        auto time = fs::last_write_time(filePath, ec);
+        if (ec)
+            continue;
+
+        auto filePathStr = filePath.u8string();
+        auto& file = files[filePathStr];
+        file.Size = size;
+        file.ModificationTime = (int64_t)time.time_since_epoch().count();
+        auto found = directory.Files.find(filePathStr);
+        if (found != directory.Files.end()
+            && found->second.Size == file.Size
+            && found->second.ModificationTime == file.ModificationTime)
+        {
+            file.Faces = std::move(found->second.Faces);
+        }
+        else
+        {
+            readFaces(filePathStr, file.Faces);
+            changed = true;
+        }
+    }
+
+    // Also the removed files change the index
+    if (files.size() != directory.Files.size())
+        changed = true;
+
+    directory.Files = std::move(files);
+    buildLookups();
+    if (changed)
+        save();
+}
+
+bool FontDirectoryIndex::TrySearchFont(const string_view& fontName, bool matchPostScriptName,
+    const nullable<PdfFontStyle>& style, string& path, unsigned& faceIndex) const
+{
+    auto& lookup = matchPostScriptName ? m_postScriptNames : m_familyNames;
+    auto found = lookup.find(normalizeName(fontName));
+    if (found == lookup.end())
+        return false;
+
+    // Choose the closest face to the style, like fontconfig
+    // does, preferring the regular style if none is requested
+    bool italic = style.has_value() && (*style & PdfFontStyle::Italic) == PdfFontStyle::Italic;
+    int weight = style.has_value() && (*style & PdfFontStyle::Bold) == PdfFontStyle::Bold ? 700 : 400;
+    const IndexedFace* matched = nullptr;
+    int matchedDistance = numeric_limits<int>::max();
+    for (auto& face : found->second)
+    {
+        int distance = std::abs((int)face.Info->Weight - weight);
+        if (((face.Info->Style & PdfFontStyle::Italic) == PdfFontStyle::Italic) != italic)
+            distance += 1000;
+
+        if (distance < matchedDistance)
+        {
+            matched = &face;
+            matchedDistance = distance;
+        }
+    }
+
+    path = *matched->Path;
+    faceIndex = matched->Info->Index;
+    return true;
+}
+
+void FontDirectoryIndex::load()
+{
+    error_code ec;
+    if (!fs::exists(fs::u8path(m_filePath), ec))
+        return;
+
+    try
+    {
+        charbuff buffer;
+        utls::ReadTo(buffer, m_filePath);
+        SpanStreamDevice device(buffer);
+        readFrom(device);
+    }
+    catch (const std::exception& ex)
+    {
+        // The index will be built again
+        PoDoFo::LogMessage(PdfLogSeverity::Warning, "Invalid font index {}, ignoring it: {}",
+            m_filePath, ex.what());
+        m_directories.clear();
+    }
+}
+
+// NOTE: The index is written to a temporary file first,
+// so it's never found partially written
+void FontDirectoryIndex::save() const
+{
+    string tempPath = m_filePath + ".tmp";
+    try
+    {
+        {
+            FileStreamDevice device(tempPath, FileMode::Create);
+            writeTo(device);
+        }
+
+        error_code ec;
+        fs::rename(fs::u8path(tempPath), fs::u8path(m_filePath), ec);
+        if (ec)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDeviceOperation, "Unable to rename {}", tempPath);
+    }
+    catch (const PdfError& error)
+    {
+        // The index is just an optimization
+        PoDoFo::LogMessage(PdfLogSeverity::Warning, "Unable to save the font index {}: {}",
+            m_filePath, error.what());
+    }
+}
+
+void FontDirectoryIndex::readFrom(InputStreamDevice& device)
+{
+    char magic[IndexMagic.size()];
+    device.Read(magic, IndexMagic.size());
+    uint32_t version;
+    utls::ReadUInt32BE(device, version);
+    if (string_view(magic, IndexMagic.size()) != IndexMagic || version != IndexVersion)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid or unsupported font index");
+
+    uint32_t directoryCount;
+    utls::ReadUInt32BE(device, directoryCount);
+    string path;
+    for (unsigned i = 0; i < directoryCount; i++)
+    {
+        readString(device, path);
+        auto& directory = m_directories[path];
+        uint32_t fileCount;
+        utls::ReadUInt32BE(device, fileCount);
+        for (unsigned j = 0; j < fileCount; j++)
+        {
+            readString(device, path);
+            auto& file = directory.Files[path];
+            file.Size = readUInt64(device);
+            file.ModificationTime = (int64_t)readUInt64(device);
+            uint32_t faceCount;
+            utls::ReadUInt32BE(device, faceCount);
+            if (faceCount > (device.GetLength() - device.GetPosition()) / MinFaceSize)
+                PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid face count in font index");
+
+            file.Faces.resize(faceCount);
+            for (auto& face : file.Faces)
+            {
+                readString(device, face.FamilyName);
+                readString(device, face.PostScriptName);
+                uint16_t style;
+                utls::ReadUInt16BE(device, style);
+                face.Style = (PdfFontStyle)style;
+                utls::ReadUInt16BE(device, face.Weight);
+                uint32_t index;
+                utls::ReadUInt32BE(device, index);
+                face.Index = index;
+            }
+        }
+    }
+}
+
+void FontDirectoryIndex::writeTo(OutputStream& stream) const
+{
+    stream.Write(IndexMagic);
+    utls::WriteUInt32BE(stream, IndexVersion);
+    utls::WriteUInt32BE(stream, (uint32_t)m_directories.size());
+    for (auto& dirPair : m_directories)
+    {
+        writeString(stream, dirPair.first);
+        utls::WriteUInt32BE(stream, (uint32_t)dirPair.second.Files.size());
+        for (auto& filePair : dirPair.second.Files)
+        {
+            auto& file = filePair.second;
+            writeString(stream, filePair.first);
+            writeUInt64(stream, file.Size);
+            writeUInt64(stream, (uint64_t)file.ModificationTime);
+            utls::WriteUInt32BE(stream, (uint32_t)file.Faces.size());
+            for (auto& face : file.Faces)
+            {
+                writeString(stream, face.FamilyName);
+                writeString(stream, face.PostScriptName);
+                utls::WriteUInt16BE(stream, (uint16_t)face.Style);
+                utls::WriteUInt16BE(stream, face.Weight);
+                utls::WriteUInt32BE(stream, face.Index);
+            }
+        }
+    }
+
+    stream.Flush();
+}
+
+// Map the names of the faces of the searchable directories
+void FontDirectoryIndex::buildLookups()
+{
+    m_familyNames.clear();
+    m_postScriptNames.clear();
+    for (auto& dirPair : m_directories)
+    {
+        if (!dirPair.second.Added)
+            continue;
+
+        for (auto& filePair : dirPair.second.Files)
+        {
+            for (auto& face : filePair.second.Faces)
+            {
+                IndexedFace indexed{ &filePair.first, &face };
+                if (!face.FamilyName.empty())
+                    m_familyNames[normalizeName(face.FamilyName)].push_back(indexed);
+
+                if (!face.PostScriptName.empty())
+                    m_postScriptNames[normalizeName(face.PostScriptName)].push_back(indexed);
+            }
+        }
+    }
+}
+
+// Read the faces of the file, skipping the ones not usable in PDF.
+// Only the tables needed are read, not the whole file
+void FontDirectoryIndex::readFaces(const string& filepath, vector<Face>& faces)
+{
+    faces.clear();
+    FT_Long faceCount = 1;
+    for (FT_Long i = 0; i < faceCount; i++)
+    {
+        FT_Face face = FT::NewFace(filepath, (unsigned)i);
+        if (face == nullptr)
+            break;
+
+        unique_ptr<struct FT_FaceRec_, decltype(&FT::DoneFace)> facePtr(face, FT::DoneFace);
+        faceCount = face->num_faces;
+        if (!FT::IsPdfSupported(face))
+            continue;
+
+        Face info;
+        if (face->family_name != nullptr)
+            info.FamilyName = face->family_name;
+
+        auto psName = FT_Get_Postscript_Name(face);
+        if (psName != nullptr)
+            info.PostScriptName = psName;
+
+        info.Style = PdfFontStyle::Regular;
+        if ((face->style_flags & FT_STYLE_FLAG_ITALIC) != 0)
+            info.Style |= PdfFontStyle::Italic;
+        if ((face->style_flags & FT_STYLE_FLAG_BOLD) != 0)
+            info.Style |= PdfFontStyle::Bold;
+
+        auto os2 = (TT_OS2*)FT_Get_Sfnt_Table(face, FT_SFNT_OS2);
+        if (os2 != nullptr && os2->version != 0xFFFF && os2->usWeightClass != 0)
+            info.Weight = os2->usWeightClass;
+        else
+            info.Weight = (info.Style & PdfFontStyle::Bold) == PdfFontStyle::Bold ? 700 : 400;
+
+        info.Index = (unsigned)i;
+        faces.push_back(std::move(info));
+    }
+}
+
+// Names are matched ignoring case and spaces, like fontconfig does
+string normalizeName(const string_view& name)
+{
+    string ret;
+    ret.reserve(name.size());
+    for (char ch : name)
+    {
+        if (ch == ' ')
+            continue;
+
+        ret.push_back(ch >= 'A' && ch <= 'Z' ? (char)(ch + ('a' - 'A')) : ch);
+    }
+
+    return ret;
+}
+
+void writeString(OutputStream& stream, const string_view& str)
+{
+    utls::WriteUInt32BE(stream, (uint32_t)str.length());
+    stream.Write(str);
+}
+
+void readString(InputStreamDevice& device, string& str)
+{
+    uint32_t length;
+    utls::ReadUInt32BE(device, length);
+    if (length > device.GetLength() - device.GetPosition())
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidDataType, "Invalid string length in font index");
+
+    str.resize(length);
+    device.Read(str.data(), length);
+}
+
+void writeUInt64(OutputStream& stream, uint64_t value)
+{
+    utls::WriteUInt32BE(stream, (uint32_t)(value >> 32));
+    utls::WriteUInt32BE(stream, (uint32_t)value);
+}
+
+uint64_t readUInt64(InputStream& stream)
+{
+    uint32_t high;
+    uint32_t low;
+    utls::ReadUInt32BE(stream, high);
+    utls::ReadUInt32BE(stream, low);
+    return (uint64_t)high << 32 | low;
+}
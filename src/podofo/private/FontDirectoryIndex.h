@@ -0,0 +1,97 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef PODOFO_FONT_DIRECTORY_INDEX_H
+#define PODOFO_FONT_DIRECTORY_INDEX_H
+
+#include <podofo/main/PdfDeclarations.h>
+
+#include <map>
+#include <unordered_map>
+
+namespace PoDoFo {
+
+class InputStreamDevice;
+class OutputStream;
+
+/** An index of the faces of the font files found in some
+ * directories, that can be persisted to a file. The font files
+ * are opened only when the index is built, and later only when
+ * their size or modification time change, so fonts can be
+ * searched by name without scanning the directories again
+ */
+class FontDirectoryIndex final
+{
+public:
+    FontDirectoryIndex();
+
+public:
+    /** Set the file where the index is persisted, loading
+     * it if existing. An empty path disables the index
+     */
+    void SetFilePath(const std::string_view& filepath);
+
+    /** Make the fonts of the directory, and of its subdirectories,
+     * searchable. The index is updated with the files changed
+     * since it was built and saved again, if needed
+     */
+    void AddDirectory(const std::string_view& path);
+
+    /** Search the face with the given family name, or PostScript name,
+     * and the closest style to the given one
+     */
+    bool TrySearchFont(const std::string_view& fontName, bool matchPostScriptName,
+        const nullable<PdfFontStyle>& style, std::string& path, unsigned& faceIndex) const;
+
+    bool IsEnabled() const { return !m_filePath.empty(); }
+
+private:
+    struct Face
+    {
+        std::string FamilyName;
+        std::string PostScriptName;
+        PdfFontStyle Style;
+        uint16_t Weight;
+        unsigned Index;
+    };
+
+    struct File
+    {
+        uint64_t Size;
+        int64_t ModificationTime;
+        std::vector<Face> Faces;    // Empty if not a font file
+    };
+
+    struct IndexedFace
+    {
+        const std::string* Path;
+        const Face* Info;
+    };
+
+    struct Directory
+    {
+        std::map<std::string, File> Files;
+        bool Added = false;     // True if searchable
+    };
+
+private:
+    void load();
+    void save() const;
+    void readFrom(InputStreamDevice& device);
+    void writeTo(OutputStream& stream) const;
+    void buildLookups();
+    static void readFaces(const std::string& filepath, std::vector<Face>& faces);
+
+private:
+    std::string m_filePath;
+    std::map<std::string, Directory> m_directories;
+    std::unordered_map<std::string, std::vector<IndexedFace>> m_familyNames;
+    std::unordered_map<std::string, std::vector<IndexedFace>> m_postScriptNames;
+};
+
+}
+
+#endif // PODOFO_FONT_DIRECTORY_INDEX_H
@@ -45,6 +45,12 @@ static unsigned determineFaceSize(FT_Face face, vector<TableInfo>& tables, unsig
 static FT_Face createFaceFromBuffer(const bufferview& view, unsigned faceIndex);
 static bool tryExtractDataFromTTC(FT_Face face, charbuff& buffer);
 static void getDataFromFace(FT_Face face, charbuff& buffer);
+static void attachFaceMutex(FT_Face face);
+
+// NOTE: Constant initialized, so they are destroyed after
+// any static object that may still hold a face
+static mutex s_libraryMutex;
+static mutex s_foreignFaceMutex;
 
 FT_Library FT::GetLibrary()
 {
@@ -70,11 +76,40 @@ FT_Library FT::GetLibrary()
     return init.Library;
 }
 
+FT_Face FT::NewFace(const string_view& filepath, unsigned faceIndex)
+{
+    auto library = FT::GetLibrary();
+    FT_Face face;
+    {
+        unique_lock<mutex> lock(s_libraryMutex);
+        if (FT_New_Face(library, string(filepath).c_str(), faceIndex, &face) != 0)
+            return nullptr;
+    }
+
+    attachFaceMutex(face);
+    return face;
+}
+
+void FT::DoneFace(FT_Face face)
+{
+    unique_lock<mutex> lock(s_libraryMutex);
+    FT_Done_Face(face);
+}
+
+mutex& FT::GetFaceMutex(FT_Face face)
+{
+    // The face may be not created by us
+    if (face->generic.data == nullptr)
+        return s_foreignFaceMutex;
+
+    return *(mutex*)face->generic.data;
+}
+
 FT_Face FT::CreateFaceFromBuffer(const bufferview& view, unsigned faceIndex,
     charbuff& buffer)
 {
     // Extract data and re-create the face
-    unique_ptr<struct FT_FaceRec_, decltype(&FT_Done_Face)> face(createFaceFromBuffer(view, faceIndex), FT_Done_Face);
+    unique_ptr<struct FT_FaceRec_, decltype(&FT::DoneFace)> face(createFaceFromBuffer(view, faceIndex), FT::DoneFace);
     if (tryExtractDataFromTTC(face.get(), buffer))
     {
         return createFaceFromBuffer(buffer, 0);
@@ -95,14 +130,12 @@ FT_Face FT::CreateFaceFromBuffer(const bufferview& view)
 FT_Face FT::CreateFaceFromFile(const string_view& filepath, unsigned faceIndex,
     charbuff& buffer)
 {
-    FT_Error rc;
-    FT_Face face_;
-    rc = FT_New_Face(FT::GetLibrary(), filepath.data(), faceIndex, &face_);
-    if (rc != 0)
+    FT_Face face_ = FT::NewFace(filepath, faceIndex);
+    if (face_ == nullptr)
         return nullptr;
 
     // Extract data and re-create the face
-    unique_ptr<struct FT_FaceRec_, decltype(&FT_Done_Face)> face(face_, FT_Done_Face);
+    unique_ptr<struct FT_FaceRec_, decltype(&FT::DoneFace)> face(face_, FT::DoneFace);
     if (tryExtractDataFromTTC(face.get(), buffer))
     {
         return createFaceFromBuffer(buffer, 0);
@@ -146,8 +179,10 @@ bool FT::TryGetFontFileFormat(FT_Face face, PdfFontFileType& format)
 bool FT::IsPdfSupported(FT_Face face)
 {
     PdfFontFileType format;
+    // NOTE: CFF fonts may also be wrapped in OpenType fonts
     if (!FT::TryGetFontFileFormat(face, format) ||
-        !(format == PdfFontFileType::TrueType || format == PdfFontFileType::OpenType))
+        !(format == PdfFontFileType::TrueType || format == PdfFontFileType::OpenType
+            || format == PdfFontFileType::Type1CCF))
     {
         return false;
     }
@@ -165,14 +200,28 @@ FT_Face createFaceFromBuffer(const bufferview& view, unsigned faceIndex)
     openArgs.memory_base = (const FT_Byte*)view.data();
     openArgs.memory_size = (FT_Long)view.size();
 
+    auto library = FT::GetLibrary();
     FT_Face face;
-    rc = FT_Open_Face(FT::GetLibrary(), &openArgs, faceIndex, &face);
-    if (rc != 0)
-        return nullptr;
+    {
+        unique_lock<mutex> lock(s_libraryMutex);
+        rc = FT_Open_Face(library, &openArgs, faceIndex, &face);
+        if (rc != 0)
+            return nullptr;
+    }
 
+    attachFaceMutex(face);
     return face;
 }
 
+// The mutex is destroyed together with the face
+void attachFaceMutex(FT_Face face)
+{
+    face->generic.data = new mutex();
+    face->generic.finalizer = [](void* obj) {
+        delete (mutex*)((FT_Face)obj)->generic.data;
+    };
+}
+
 // Try to handle TTC font collections
 bool tryExtractDataFromTTC(FT_Face face, charbuff& buffer)
 {
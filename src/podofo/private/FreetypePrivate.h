@@ -13,12 +13,23 @@
 
 #include <podofo/main/PdfDeclarations.h>
 
+#include <mutex>
+
 #define CHECK_FT_RC(rc, func) if (rc != 0)\
     PODOFO_RAISE_ERROR_INFO(PdfErrorCode::FreeType, "Function " #func " failed")
 
 namespace FT
 {
+    // NOTE: The library is shared by all the threads. FreeType
+    // requires the creation and the destruction of the faces
+    // to be serialized, so faces must be created and destroyed
+    // only with the functions below
     FT_Library GetLibrary();
+    FT_Face NewFace(const std::string_view& filepath, unsigned faceIndex);
+    void DoneFace(FT_Face face);
+    // Get the mutex to serialize the operations
+    // on a face that may be shared by many threads
+    std::mutex& GetFaceMutex(FT_Face face);
     FT_Face CreateFaceFromFile(const std::string_view& filepath, unsigned faceIndex,
         PoDoFo::charbuff& buffer);
     FT_Face CreateFaceFromBuffer(const PoDoFo::bufferview& view, unsigned faceIndex,
@@ -0,0 +1,73 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "ParallelUtils.h"
+
+#include <atomic>
+#include <exception>
+#include <thread>
+
+using namespace std;
+
+unsigned utls::GetWorkerThreadCount(unsigned requested)
+{
+    if (requested != 0)
+        return requested;
+
+    unsigned ret = thread::hardware_concurrency();
+    return ret == 0 ? 1 : ret;
+}
+
+void utls::ParallelFor(size_t count, unsigned threadCount,
+    const function<void(size_t)>& func)
+{
+    if (threadCount > count)
+        threadCount = (unsigned)count;
+
+    if (threadCount <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            func(i);
+
+        return;
+    }
+
+    atomic<size_t> next(0);
+    vector<exception_ptr> errors(count);
+    auto worker = [&]() {
+        while (true)
+        {
+            size_t i = next.fetch_add(1, memory_order_relaxed);
+            if (i >= count)
+                break;
+
+            try
+            {
+                func(i);
+            }
+            catch (...)
+            {
+                errors[i] = current_exception();
+            }
+        }
+    };
+
+    vector<thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned i = 1; i < threadCount; i++)
+        threads.emplace_back(worker);
+
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    for (auto& error : errors)
+    {
+        if (error != nullptr)
+            rethrow_exception(error);
+    }
+}
@@ -0,0 +1,29 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef PARALLEL_UTILS_H
+#define PARALLEL_UTILS_H
+
+#include <functional>
+
+namespace utls
+{
+    /** Resolve a requested worker thread count, where 0 means
+     * the number of hardware threads available
+     */
+    unsigned GetWorkerThreadCount(unsigned requested);
+
+    /** Invoke the given function for every index in [0, count)
+     * using up to threadCount threads, including the calling one.
+     * If any invocation throws, the exception raised by the lowest
+     * index is rethrown after all the work completed, so the outcome
+     * never depends on thread scheduling
+     */
+    void ParallelFor(size_t count, unsigned threadCount,
+        const std::function<void(size_t)>& func);
+}
+
+#endif // PARALLEL_UTILS_H
@@ -0,0 +1,202 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfPredefinedCMapData.h"
+#include "PdfFilterFactory.h"
+
+#include <map>
+
+#include <utf8cpp/utf8.h>
+
+using namespace std;
+using namespace PoDoFo;
+
+// NOTE: The decoded mappings are keyed by the code size in
+// the upper 32 bits and by the code in the lower ones. A code
+// size of 0 means the code is an unicode code point
+using CMapMappings = map<uint64_t, uint32_t>;
+
+static void decodeMappings(unsigned index, CMapMappings& mappings);
+static uint32_t readVarInt(const char*& it, const char* end);
+static int32_t readZigZagInt(const char*& it, const char* end);
+static bool tryGetCharCode(char32_t codePoint, PredefinedCMapForm form, PdfCharCode& code);
+
+bool PoDoFo::TryGetPredefinedCMap(const string_view& name, unsigned& index)
+{
+    auto cmaps = GetPredefinedCMaps();
+    auto found = std::lower_bound(cmaps.begin(), cmaps.end(), name,
+        [](const PredefinedCMapInfo& info, const string_view& name) { return info.Name < name; });
+    if (found == cmaps.end() || found->Name != name)
+    {
+        index = 0;
+        return false;
+    }
+
+    index = (unsigned)(found - cmaps.begin());
+    return true;
+}
+
+PdfCharCodeMap PoDoFo::DecodePredefinedCMap(unsigned index)
+{
+    auto cmaps = GetPredefinedCMaps();
+    if (index >= cmaps.size())
+        PODOFO_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+
+    CMapMappings mappings;
+    decodeMappings(index, mappings);
+
+    auto& info = cmaps[index];
+    PdfCharCodeMap ret;
+    PdfCharCode code;
+    for (auto& pair : mappings)
+    {
+        unsigned char codeSize = (unsigned char)(pair.first >> 32);
+        if (codeSize == 0)
+        {
+            if (!tryGetCharCode((char32_t)pair.first, info.Form, code))
+                continue;
+        }
+        else
+        {
+            code = PdfCharCode((unsigned)pair.first, codeSize);
+        }
+
+        ret.PushMapping(code, (codepoint)pair.second);
+    }
+
+    return ret;
+}
+
+// The mappings are stored as groups of codes of the same size.
+// Every group has ranges of consecutive codes mapped to consecutive
+// values, stored as the gap from the previous range, the count and
+// the value difference, followed by ranges of codes to remove from
+// the base mappings, all as variable length integers
+void decodeMappings(unsigned index, CMapMappings& mappings)
+{
+    auto& info = GetPredefinedCMaps()[index];
+    if (info.Base != -1)
+        decodeMappings((unsigned)info.Base, mappings);
+
+    if (info.DataSize == 0)
+        return;
+
+    charbuff buffer;
+    PdfFilterFactory::Create(PdfFilterType::FlateDecode)->DecodeTo(buffer,
+        bufferview((const char*)info.Data, info.DataSize));
+
+    const char* it = buffer.data();
+    const char* end = it + buffer.size();
+    unsigned groupCount = readVarInt(it, end);
+    for (unsigned i = 0; i < groupCount; i++)
+    {
+        if (it == end)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidStream, "Corrupted predefined CMap data");
+
+        uint64_t codeSize = (uint64_t)(unsigned char)*it << 32;
+        it++;
+
+        unsigned rangeCount = readVarInt(it, end);
+        uint32_t code = numeric_limits<uint32_t>::max();
+        uint32_t value = 0;
+        for (unsigned j = 0; j < rangeCount; j++)
+        {
+            code += readVarInt(it, end) + 1;
+            unsigned count = readVarInt(it, end) + 1;
+            value += readZigZagInt(it, end);
+            for (unsigned k = 0; k < count; k++)
+                mappings[codeSize | (code + k)] = value + k;
+
+            code += count - 1;
+            value += count - 1;
+        }
+
+        rangeCount = readVarInt(it, end);
+        code = numeric_limits<uint32_t>::max();
+        for (unsigned j = 0; j < rangeCount; j++)
+        {
+            code += readVarInt(it, end) + 1;
+            unsigned count = readVarInt(it, end) + 1;
+            for (unsigned k = 0; k < count; k++)
+                mappings.erase(codeSize | (code + k));
+
+            code += count - 1;
+        }
+    }
+}
+
+uint32_t readVarInt(const char*& it, const char* end)
+{
+    uint32_t ret = 0;
+    unsigned shift = 0;
+    while (true)
+    {
+        if (it == end || shift > 28)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidStream, "Corrupted predefined CMap data");
+
+        unsigned char byte = (unsigned char)*it;
+        it++;
+        ret |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return ret;
+
+        shift += 7;
+    }
+}
+
+int32_t readZigZagInt(const char*& it, const char* end)
+{
+    uint32_t value = readVarInt(it, end);
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+bool tryGetCharCode(char32_t codePoint, PredefinedCMapForm form, PdfCharCode& code)
+{
+    switch (form)
+    {
+        case PredefinedCMapForm::UTF8:
+        {
+            char buffer[4];
+            char* end = utf8::unchecked::append(codePoint, buffer);
+            unsigned value = 0;
+            for (char* it = buffer; it != end; it++)
+                value = value << 8 | (unsigned char)*it;
+
+            code = PdfCharCode(value, (unsigned char)(end - buffer));
+            return true;
+        }
+        case PredefinedCMapForm::UTF16:
+        {
+            if (codePoint < 0x10000)
+            {
+                code = PdfCharCode((unsigned)codePoint, 2);
+            }
+            else
+            {
+                unsigned value = (unsigned)codePoint - 0x10000;
+                code = PdfCharCode((0xD800 + (value >> 10)) << 16 | (0xDC00 + (value & 0x3FF)), 4);
+            }
+
+            return true;
+        }
+        case PredefinedCMapForm::UTF32:
+        {
+            code = PdfCharCode((unsigned)codePoint, 4);
+            return true;
+        }
+        case PredefinedCMapForm::UCS2:
+        {
+            if (codePoint >= 0x10000)
+                return false;
+
+            code = PdfCharCode((unsigned)codePoint, 2);
+            return true;
+        }
+        default:
+            PODOFO_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+    }
+}
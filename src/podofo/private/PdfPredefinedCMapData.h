@@ -0,0 +1,54 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef PDF_PREDEFINED_CMAP_DATA_H
+#define PDF_PREDEFINED_CMAP_DATA_H
+
+#include <podofo/main/PdfCharCodeMap.h>
+
+namespace PoDoFo {
+
+/** The form of the character codes of a predefined CMap. Unicode
+ * CMaps store the mappings by code point, and the codes are
+ * obtained by encoding the code points in the given form
+ */
+enum class PredefinedCMapForm : uint8_t
+{
+    Raw = 0,    ///< The codes are stored as they are
+    UTF8,
+    UTF16,
+    UTF32,
+    UCS2,
+};
+
+struct PredefinedCMapInfo final
+{
+    const char* Name;
+    const char* Ordering;           ///< Ordering of the Adobe character collection, eg. "Japan1"
+    int Base;                       ///< Index of the CMap of which only the differences are stored, or -1
+    PredefinedCMapForm Form;
+    bool Vertical;
+    const unsigned char* Data;      ///< Deflated mappings, may be null if equal to the base ones
+    unsigned DataSize;
+};
+
+/** Get the predefined CMaps bundled with the library, sorted by name
+ */
+cspan<PredefinedCMapInfo> GetPredefinedCMaps();
+
+/** Find the index of the predefined CMap with the given name
+ */
+bool TryGetPredefinedCMap(const std::string_view& name, unsigned& index);
+
+/** Decode the mappings of the predefined CMap with the given index.
+ * The CMaps map codes to CIDs, except the "Adobe-<Ordering>-UCS2"
+ * ones that map CIDs to unicode code points
+ */
+PdfCharCodeMap DecodePredefinedCMap(unsigned index);
+
+};
+
+#endif // PDF_PREDEFINED_CMAP_DATA_H
@@ -0,0 +1,40 @@
+/**
+ * SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ * SPDX-License-Identifier: MPL-2.0
+ */
+
+#ifndef PDF_XOBJECT_FORM_CACHE_ENTRY_H
+#define PDF_XOBJECT_FORM_CACHE_ENTRY_H
+
+#include <podofo/main/PdfContentStreamReader.h>
+
+namespace PoDoFo {
+
+/** Content of a XObject form as read from the stream,
+ * before handling Do operators
+ */
+struct PdfCachedContent final
+{
+    PdfContentType Type = PdfContentType::Unknown;
+    PdfContentWarnings Warnings = PdfContentWarnings::None;
+    PdfVariantStack Stack;
+    PdfOperator Operator = PdfOperator::Unknown;
+    std::string Keyword;
+    PdfDictionary InlineImageDictionary;
+    charbuff InlineImageData;
+};
+
+/** Tokenized contents of a XObject form. A last content
+ * with Unknown type holds the operands found at the end
+ * of the stream without an operator, if any
+ */
+struct PdfXObjectFormCacheEntry final
+{
+    std::vector<PdfCachedContent> Contents;
+    size_t Size = 0;    ///< Approximate memory size in bytes
+};
+
+}
+
+#endif // PDF_XOBJECT_FORM_CACHE_ENTRY_H
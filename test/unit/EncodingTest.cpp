@@ -10,11 +10,17 @@
 
 #include <ostream>
 #include <iostream>
+#include <chrono>
+
+#include <utf8cpp/utf8.h>
 
 using namespace std;
 using namespace PoDoFo;
 
 static void outofRangeHelper(PdfEncoding& encoding);
+static void fillCIDToUnicodeMap(PdfCharCodeMap& map, unsigned cidCount);
+static void createCIDText(string& text, unsigned cidCount);
+static unsigned lookupCharCodeMap(const PdfCharCodeMap& map, const string_view& text, unsigned cidCount);
 
 inline ostream& operator<<(ostream& o, const PdfVariant& s)
 {
@@ -177,6 +183,45 @@ TEST_CASE("testDifferencesEncoding")
     REQUIRE(unicode == "BAABI");
 }
 
+TEST_CASE("testOneByteConversions")
+{
+    PdfMemDocument doc;
+    PdfFontCreateParams params;
+    params.Encoding = PdfEncoding(PdfEncodingMapFactory::WinAnsiEncodingInstance());
+    auto& font = doc.GetFonts().GetStandard14Font(PdfStandard14FontType::Helvetica, params);
+    auto& encoding = font.GetEncoding();
+
+    auto encoded = encoding.ConvertToEncoded("H\u00E9llo \u20AC\u2019");
+    REQUIRE(encoded == "H\xE9llo \x80\x92"sv);
+    REQUIRE(encoding.ConvertToUtf8(PdfString::FromRaw(encoded)) == "H\u00E9llo \u20AC\u2019");
+    REQUIRE(!encoding.TryConvertToEncoded("\u011B", encoded));
+
+    // Codes not mapped by the /ToUnicode map are decoded as the code
+    // point with the same value, but the conversion is reported as failed
+    auto& toUnicodeObj = doc.GetObjects().CreateDictionaryObject();
+    toUnicodeObj.GetOrCreateStream().SetData(
+        "1 begincodespacerange <00> <FF> endcodespacerange\n"
+        "2 beginbfchar <41> <0042> <42> <00660069> endbfchar\n"sv);
+    PdfEncoding mapped(PdfEncodingMapFactory::WinAnsiEncodingInstance(), PdfCMapEncoding::CreateFromObject(toUnicodeObj));
+    string decoded;
+    REQUIRE(!mapped.TryConvertToUtf8(PdfString::FromRaw("AB\x81"sv), decoded));
+    REQUIRE(decoded == "Bfi\u0081");
+
+    // The decoding of every code is the same of the encoding map
+    auto& map = encoding.GetEncodingMap();
+    vector<char32_t> codePoints;
+    for (unsigned code = 1; code < 256; code++)
+    {
+        char ch = (char)code;
+        if (!map.TryGetCodePoints(PdfCharCode(code, 1), codePoints) || codePoints[0] == U'\0')
+            continue;
+
+        string expected;
+        utf8::append(codePoints[0], std::back_inserter(expected));
+        REQUIRE(encoding.ConvertToUtf8(PdfString::FromRaw(string_view(&ch, 1))) == expected);
+    }
+}
+
 // FIX-ME: This test passes but it's garbage and very slow
 // Fix it the whole thing by handling properly the Adobe Glyph List
 // in PdfDifferenceEncoding (or better a new separate function)
@@ -253,6 +298,26 @@ TEST_CASE("testUnicodeNames", "[.]")
     REQUIRE(codeCount == 65421);
 }
 
+TEST_CASE("testGlyphNameLookup")
+{
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("space"sv) == U' ');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("Adieresis"sv) == U'\u00C4');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("fi"sv) == U'\uFB01');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("a9"sv) == U'\u2720');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("!"sv) == U'!');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("uni0041"sv) == U'A');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint("Adieresiss"sv) == U'\0');
+    REQUIRE(PdfDifferenceEncoding::NameToCodePoint(""sv) == U'\0');
+
+    // Names in the canonical list are preferred
+    REQUIRE(PdfDifferenceEncoding::CodePointToName(U'!') == "exclam");
+    REQUIRE(PdfDifferenceEncoding::CodePointToName(U'\u00C4') == "Adieresis");
+    REQUIRE(PdfDifferenceEncoding::CodePointToName(U'\u2720') == "a9");
+    REQUIRE(PdfDifferenceEncoding::CodePointToName(U'\0') == ".notdef");
+    REQUIRE(PdfDifferenceEncoding::CodePointToName(U'\uE000') == "unie000");
+    REQUIRE(PdfDifferenceEncoding::CodePointToName(U'\U0001F600') == "uni1f600");
+}
+
 TEST_CASE("testGetCharCode")
 {
     auto winAnsiEncoding = PdfEncodingFactory::CreateWinAnsiEncoding();
@@ -270,6 +335,100 @@ TEST_CASE("testGetCharCode")
     outofRangeHelper(differenceEncoding);
 }
 
+TEST_CASE("testCharCodeMap")
+{
+    constexpr unsigned CIDCount = 20000;
+
+    // Dense maps use the direct indexed tables
+    PdfCharCodeMap map;
+    fillCIDToUnicodeMap(map, CIDCount);
+
+    // This map has also a very far code and a very
+    // far code point, so it can't use the tables
+    PdfCharCodeMap sparseMap;
+    fillCIDToUnicodeMap(sparseMap, CIDCount);
+    sparseMap.PushMapping(PdfCharCode(0xFFFFFF, 3), U'\U0010FFFF');
+    sparseMap.PushMapping(PdfCharCode(CIDCount + 10, 2), (codepoint)0x7FFFFFF0);
+    REQUIRE(map.GetLookupTablesSize() >= CIDCount * (sizeof(codepoint) + sizeof(PdfCharCode)));
+    REQUIRE(sparseMap.GetLookupTablesSize() == 0);
+
+    for (auto currMap : { &map, &sparseMap })
+    {
+        vector<codepoint> codePoints;
+        REQUIRE(currMap->TryGetCodePoints(PdfCharCode(1, 2), codePoints));
+        REQUIRE(codePoints == vector<codepoint>{ U'\u4E01' });
+        REQUIRE(currMap->TryGetCodePoints(PdfCharCode(CIDCount + 1, 2), codePoints));
+        REQUIRE(codePoints == vector<codepoint>{ U'f', U'i' });
+        REQUIRE(!currMap->TryGetCodePoints(PdfCharCode(0, 2), codePoints));
+        REQUIRE(codePoints.size() == 0);
+        REQUIRE(!currMap->TryGetCodePoints(PdfCharCode(CIDCount + 5, 2), codePoints));
+
+        PdfCharCode code;
+        REQUIRE(currMap->TryGetCharCode(U'\u4E05', code));
+        REQUIRE(code == PdfCharCode(5, 2));
+        REQUIRE(currMap->TryGetCharCode(U'f', code));
+        REQUIRE(code == PdfCharCode(CIDCount + 2, 2));
+        codepoint ligature[] = { U'f', U'i' };
+        REQUIRE(currMap->TryGetCharCode(codepointview(ligature), code));
+        REQUIRE(code == PdfCharCode(CIDCount + 1, 2));
+        REQUIRE(!currMap->TryGetCharCode(U'i', code));
+        REQUIRE(!currMap->TryGetCharCode(U'\u4E00', code));
+
+        string_view str = "fif\xE4\xB8\x85x";
+        vector<PdfCharCode> codes;
+        auto it = str.begin();
+        while (it != str.end())
+        {
+            if (!currMap->TryGetNextCharCode(it, str.end(), code))
+                code = { };
+
+            codes.push_back(code);
+        }
+        REQUIRE(codes == vector<PdfCharCode>{ PdfCharCode(CIDCount + 1, 2), PdfCharCode(CIDCount + 2, 2),
+            PdfCharCode(5, 2), PdfCharCode() });
+    }
+
+    // More code units mapping to the same code point
+    PdfCharCodeMap duplicateMap;
+    duplicateMap.PushMapping(PdfCharCode(2), U'A');
+    duplicateMap.PushMapping(PdfCharCode(1), U'A');
+    PdfCharCode code;
+    REQUIRE(duplicateMap.TryGetCharCode(U'A', code));
+    REQUIRE(code == PdfCharCode(1));
+
+    // Compare lookups using the tables and the slower structures
+    string text;
+    createCIDText(text, CIDCount);
+    unsigned mapped = lookupCharCodeMap(map, text, CIDCount);
+    REQUIRE(mapped == (CIDCount + 1) * 2 - 2);
+    REQUIRE(lookupCharCodeMap(sparseMap, text, CIDCount) == mapped);
+}
+
+TEST_CASE("testCharCodeMapBenchmark", "[.]")
+{
+    constexpr unsigned CIDCount = 20000;
+    PdfCharCodeMap map;
+    fillCIDToUnicodeMap(map, CIDCount);
+    PdfCharCodeMap sparseMap;
+    fillCIDToUnicodeMap(sparseMap, CIDCount);
+    sparseMap.PushMapping(PdfCharCode(0xFFFFFF, 3), U'\U0010FFFF');
+
+    string text;
+    createCIDText(text, CIDCount);
+    auto measure = [&](const PdfCharCodeMap& currMap) {
+        auto start = chrono::steady_clock::now();
+        for (unsigned i = 0; i < 10; i++)
+            (void)lookupCharCodeMap(currMap, text, CIDCount);
+
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+    };
+
+    auto time = measure(map);
+    auto sparseTime = measure(sparseMap);
+    WARN("PdfCharCodeMap lookups with tables: " << time.count() << "us");
+    WARN("PdfCharCodeMap lookups without tables: " << sparseTime.count() << "us");
+}
+
 TEST_CASE("testToUnicodeParse")
 {
     string_view toUnicode =
@@ -337,6 +496,154 @@ TEST_CASE("testToUnicodeParse")
     }
 }
 
+TEST_CASE("testCMapCache")
+{
+    string_view toUnicode =
+        "2 beginbfrange\n"
+        "<0001> <0004> <1001>\n"
+        "<0005> <000A> [<000A> <0009> <0008> <0007> <0006> <0005>]\n"
+        "endbfrange\n";
+    string_view identity =
+        "1 begincidrange\n"
+        "<0100> <01FF> 256\n"
+        "endcidrange\n";
+
+    PdfMemDocument doc1;
+    auto& toUnicodeObj1 = doc1.GetObjects().CreateDictionaryObject();
+    toUnicodeObj1.GetOrCreateStream().SetData(toUnicode);
+    auto& identityObj = doc1.GetObjects().CreateDictionaryObject();
+    identityObj.GetOrCreateStream().SetData(identity);
+    PdfMemDocument doc2;
+    auto& toUnicodeObj2 = doc2.GetObjects().CreateDictionaryObject();
+    toUnicodeObj2.GetOrCreateStream().SetData(toUnicode);
+
+    auto getCharMap = [](const PdfEncodingMap& map) {
+        return &dynamic_cast<const PdfCMapEncoding&>(map).GetCharMap();
+    };
+
+    // The cache is disabled by default
+    auto encoding1 = PdfCMapEncoding::CreateFromObject(toUnicodeObj1);
+    auto encoding2 = PdfCMapEncoding::CreateFromObject(toUnicodeObj2);
+    REQUIRE(getCharMap(*encoding1) != getCharMap(*encoding2));
+
+    PdfCommon::SetCMapCacheSize(1024 * 1024);
+    encoding1 = PdfCMapEncoding::CreateFromObject(toUnicodeObj1);
+    encoding2 = PdfCMapEncoding::CreateFromObject(toUnicodeObj2);
+    REQUIRE(getCharMap(*encoding1) == getCharMap(*encoding2));
+    REQUIRE(encoding2->GetLimits().FirstChar.Code == 1);
+    REQUIRE(encoding2->GetLimits().LastChar.Code == 10);
+
+    vector<char32_t> codePoints;
+    REQUIRE(encoding2->TryGetCodePoints(PdfCharCode(6, 2), codePoints));
+    REQUIRE(codePoints == vector<char32_t>{ U'\u0009' });
+
+    // Identity CMaps are cached as well
+    for (unsigned i = 0; i < 2; i++)
+    {
+        auto identityEncoding = PdfCMapEncoding::CreateFromObject(identityObj);
+        REQUIRE(dynamic_cast<const PdfIdentityEncoding*>(identityEncoding.get()) != nullptr);
+        REQUIRE(identityEncoding->GetLimits().MaxCodeSize == 2);
+    }
+
+    // Changed CMaps are parsed again
+    toUnicodeObj2.GetOrCreateStream().SetData("1 beginbfchar\n<0001> <0041>\nendbfchar\n"sv);
+    encoding2 = PdfCMapEncoding::CreateFromObject(toUnicodeObj2);
+    REQUIRE(getCharMap(*encoding1) != getCharMap(*encoding2));
+    REQUIRE(encoding2->TryGetCodePoints(PdfCharCode(1, 2), codePoints));
+    REQUIRE(codePoints == vector<char32_t>{ U'A' });
+
+    // CMaps larger than the cache are not cached
+    PdfCommon::SetCMapCacheSize(16);
+    encoding1 = PdfCMapEncoding::CreateFromObject(toUnicodeObj1);
+    encoding2 = PdfCMapEncoding::CreateFromObject(toUnicodeObj1);
+    REQUIRE(getCharMap(*encoding1) != getCharMap(*encoding2));
+
+    PdfCommon::SetCMapCacheSize(1024 * 1024);
+    encoding1 = PdfCMapEncoding::CreateFromObject(toUnicodeObj1);
+    PdfCommon::ClearCMapCache();
+    encoding2 = PdfCMapEncoding::CreateFromObject(toUnicodeObj1);
+    REQUIRE(getCharMap(*encoding1) != getCharMap(*encoding2));
+    PdfCommon::SetCMapCacheSize(0);
+}
+
+TEST_CASE("testPredefinedCMaps")
+{
+    REQUIRE(PdfEncodingMapFactory::GetPredefinedCMap("Unknown-H") == nullptr);
+    REQUIRE(PdfEncodingMapFactory::GetPredefinedCMap("Identity-H")
+        == PdfEncodingMapFactory::TwoBytesHorizontalIdentityEncodingInstance());
+
+    // The CMaps are decoded once
+    auto utf16 = PdfEncodingMapFactory::GetPredefinedCMap("UniJIS-UTF16-H");
+    REQUIRE(utf16 != nullptr);
+    REQUIRE(utf16 == PdfEncodingMapFactory::GetPredefinedCMap("UniJIS-UTF16-H"));
+
+    vector<char32_t> codePoints;
+    REQUIRE(utf16->TryGetCodePoints(PdfCharCode(0x3042, 2), codePoints));
+    REQUIRE(codePoints == vector<char32_t>{ 843 });
+    REQUIRE(utf16->TryGetCodePoints(PdfCharCode(0xD842DF9F, 4), codePoints));
+    REQUIRE(codePoints == vector<char32_t>{ 13803 });
+    REQUIRE(utf16->GetLimits().MinCodeSize == 2);
+    REQUIRE(utf16->GetLimits().MaxCodeSize == 4);
+
+    // Variants of the same CMap in other forms and orientations
+    auto utf8 = PdfEncodingMapFactory::GetPredefinedCMap("UniJIS-UTF8-H");
+    REQUIRE(utf8->TryGetCodePoints(PdfCharCode(0xE38182, 3), codePoints));
+    REQUIRE(codePoints == vector<char32_t>{ 843 });
+    REQUIRE(utf8->TryGetCodePoints(PdfCharCode(0x41, 1), codePoints));
+    REQUIRE(codePoints == vector<char32_t>{ 34 });
+    auto utf16Vertical = PdfEncodingMapFactory::GetPredefinedCMap("UniJIS-UTF16-V");
+    REQUIRE(utf16->TryGetCodePoints(PdfCharCode(0x3001, 2), codePoints));
+    REQUIRE(codePoints == vector<char32_t>{ 634 });
+    REQUIRE(utf16Vertical->TryGetCodePoints(PdfCharCode(0x3001, 2), codePoints));
+    REQUIRE(codePoints == vector<char32_t>{ 7887 });
+    auto ucs2 = PdfEncodingMapFactory::GetPredefinedCMap("UniGB-UCS2-H");
+    REQUIRE(ucs2->TryGetCodePoints(PdfCharCode(0x4E2D, 2), codePoints));
+    REQUIRE(codePoints == vector<char32_t>{ 4559 });
+
+    auto cidToUnicode = PdfEncodingMapFactory::GetPredefinedCMap("Adobe-Japan1-UCS2");
+    REQUIRE(cidToUnicode->TryGetCodePoints(PdfCharCode(843, 2), codePoints));
+    REQUIRE(codePoints == vector<char32_t>{ U'\u3042' });
+
+    // Fonts with predefined CMaps and no /ToUnicode map
+    // are extracted through the CIDs of the collection
+    PdfMemDocument doc;
+    auto& descendantObj = doc.GetObjects().CreateDictionaryObject();
+    auto& descendant = descendantObj.GetDictionary();
+    descendant.AddKey("Type", PdfName("Font"));
+    descendant.AddKey("Subtype", PdfName("CIDFontType0"));
+    descendant.AddKey("BaseFont", PdfName("KozMinPr6N-Regular"));
+    auto& descriptor = descendant.AddKey("FontDescriptor", PdfDictionary()).GetDictionary();
+    descriptor.AddKey("Type", PdfName("FontDescriptor"));
+    descriptor.AddKey("FontName", PdfName("KozMinPr6N-Regular"));
+    descriptor.AddKey("Flags", static_cast<int64_t>(4));
+    auto& cidSystemInfo = descendant.AddKey("CIDSystemInfo", PdfDictionary()).GetDictionary();
+    cidSystemInfo.AddKey("Registry", PdfString("Adobe"));
+    cidSystemInfo.AddKey("Ordering", PdfString("Japan1"));
+    cidSystemInfo.AddKey("Supplement", static_cast<int64_t>(6));
+
+    auto createFont = [&](const string_view& cmapName) {
+        auto& fontObj = doc.GetObjects().CreateDictionaryObject();
+        auto& dict = fontObj.GetDictionary();
+        dict.AddKey("Type", PdfName("Font"));
+        dict.AddKey("Subtype", PdfName("Type0"));
+        dict.AddKey("BaseFont", PdfName("KozMinPr6N-Regular"));
+        dict.AddKey("Encoding", PdfName(cmapName));
+        PdfArray descendants;
+        descendants.Add(descendantObj.GetIndirectReference());
+        dict.AddKey("DescendantFonts", descendants);
+        unique_ptr<PdfFont> font;
+        REQUIRE(PdfFont::TryCreateFromObject(fontObj, font));
+        return font;
+    };
+
+    auto font = createFont("90ms-RKSJ-H");
+    REQUIRE(font->GetEncoding().ConvertToUtf8(PdfString::FromRaw("\x82\xA0\x41"sv)) == "\u3042A");
+    font = createFont("UniJIS-UTF16-H");
+    REQUIRE(font->GetEncoding().ConvertToUtf8(PdfString::FromRaw("\x30\x42\xD8\x42\xDF\x9F"sv)) == "\u3042\U00020B9F");
+    font = createFont("Identity-H");
+    REQUIRE(font->GetEncoding().ConvertToUtf8(PdfString::FromRaw("\x03\x4B"sv)) == "\u3042");
+}
+
 void outofRangeHelper(PdfEncoding& encoding)
 {
     (void)encoding.GetCodePoint(encoding.GetFirstChar());
@@ -344,3 +651,42 @@ void outofRangeHelper(PdfEncoding& encoding)
     (void)encoding.GetCodePoint(encoding.GetLastChar());
     REQUIRE(encoding.GetCodePoint(encoding.GetLastChar().Code + 1) == U'\0');
 }
+
+// Map CIDs to ideographs, with two more codes for a ligature and its first letter
+void fillCIDToUnicodeMap(PdfCharCodeMap& map, unsigned cidCount)
+{
+    for (unsigned i = 1; i <= cidCount; i++)
+        map.PushMapping(PdfCharCode(i, 2), (codepoint)(0x4E00 + i));
+
+    map.PushMapping(PdfCharCode(cidCount + 1, 2), vector<codepoint>{ U'f', U'i' });
+    map.PushMapping(PdfCharCode(cidCount + 2, 2), U'f');
+}
+
+void createCIDText(string& text, unsigned cidCount)
+{
+    for (unsigned i = 1; i <= cidCount; i++)
+        utf8::append((char32_t)(0x4E00 + i), std::back_inserter(text));
+}
+
+// Lookup all the CIDs and all the code points of the
+// text, returning the count of the mapped ones
+unsigned lookupCharCodeMap(const PdfCharCodeMap& map, const string_view& text, unsigned cidCount)
+{
+    vector<codepoint> codePoints;
+    PdfCharCode code;
+    unsigned mapped = 0;
+    for (unsigned cid = 0; cid <= cidCount; cid++)
+    {
+        if (map.TryGetCodePoints(PdfCharCode(cid, 2), codePoints))
+            mapped++;
+    }
+
+    auto it = text.begin();
+    while (it != text.end())
+    {
+        if (map.TryGetNextCharCode(it, text.end(), code))
+            mapped++;
+    }
+
+    return mapped;
+}
@@ -13,6 +13,9 @@ using namespace PoDoFo;
 
 static void testAuthenticate(PdfEncrypt& encrypt);
 static void testEncrypt(PdfEncrypt& encrypt);
+static void testEncryptStreamed(PdfEncrypt& encrypt);
+static void testParallelDecryption(PdfEncryptAlgorithm algorithm, PdfKeyLength keyLength);
+static void testLoadWithEncryptionKey(PdfEncryptAlgorithm algorithm, PdfKeyLength keyLength);
 static void createEncryptedPdf(const string_view& filename);
 
 charbuff s_encBuffer;
@@ -290,6 +293,47 @@ TEST_CASE("TestEncryptBigBuffer")
     }
 }
 
+// Test streamed encryption and decryption with buffers not aligned
+// to the AES block size, or to the internal chunk size
+TEST_CASE("TestEncryptStreamed")
+{
+    auto encrypt = PdfEncrypt::Create(PDF_USER_PASSWORD, PDF_OWNER_PASSWORD, s_protection,
+        PdfEncryptAlgorithm::RC4V2, PdfKeyLength::L128);
+    testEncryptStreamed(*encrypt);
+
+    encrypt = PdfEncrypt::Create(PDF_USER_PASSWORD, PDF_OWNER_PASSWORD, s_protection,
+        PdfEncryptAlgorithm::AESV2, PdfKeyLength::L128);
+    testEncryptStreamed(*encrypt);
+
+#ifdef PODOFO_HAVE_LIBIDN
+    encrypt = PdfEncrypt::Create(PDF_USER_PASSWORD, PDF_OWNER_PASSWORD, s_protection,
+        PdfEncryptAlgorithm::AESV3R6, PdfKeyLength::L256);
+    testEncryptStreamed(*encrypt);
+#endif // PODOFO_HAVE_LIBIDN
+}
+
+TEST_CASE("TestLoadWithEncryptionKey")
+{
+    testLoadWithEncryptionKey(PdfEncryptAlgorithm::RC4V2, PdfKeyLength::L128);
+    testLoadWithEncryptionKey(PdfEncryptAlgorithm::AESV2, PdfKeyLength::L128);
+#ifdef PODOFO_HAVE_LIBIDN
+    // AESV3 validates the key with the /Perms value
+    testLoadWithEncryptionKey(PdfEncryptAlgorithm::AESV3R6, PdfKeyLength::L256);
+#endif // PODOFO_HAVE_LIBIDN
+}
+
+// Test that loading all the streams at once gives the same
+// results regardless of the number of decryption threads
+TEST_CASE("TestParallelStreamDecryption")
+{
+    unsigned threadCount = PdfParser::GetDecryptionThreadCount();
+    testParallelDecryption(PdfEncryptAlgorithm::RC4V2, PdfKeyLength::L128);
+    testParallelDecryption(PdfEncryptAlgorithm::AESV2, PdfKeyLength::L128);
+
+    // Restore default
+    PdfParser::SetDecryptionThreadCount(threadCount);
+}
+
 void testAuthenticate(PdfEncrypt& encrypt)
 {
     PdfString documentId = PdfString::FromHexData("BF37541A9083A51619AD5924ECF156DF");
@@ -332,6 +376,49 @@ void testEncrypt(PdfEncrypt& encrypt)
     REQUIRE(memcmp(s_encBuffer.data(), decrypted.data(), s_encBuffer.size()) == 0);
 }
 
+void testEncryptStreamed(PdfEncrypt& encrypt)
+{
+    encrypt.GenerateEncryptionKey(PdfString::FromHexData("BF37541A9083A51619AD5924ECF156DF"));
+
+    for (size_t size : { (size_t)0, (size_t)15, (size_t)16, (size_t)4097, (size_t)100003 })
+    {
+        charbuff buffer(size);
+        for (size_t i = 0; i < size; i++)
+            buffer[i] = (char)(i % 251);
+
+        charbuff encrypted;
+        {
+            StringStreamDevice device(encrypted);
+            auto output = encrypt.CreateEncryptionOutputStream(device, PdfReference(7, 0));
+            // Write in odd sized pieces
+            for (size_t i = 0; i < size; i += 1000)
+                output->Write(buffer.data() + i, std::min((size_t)1000, size - i));
+
+            output->Close();
+            ASSERT_THROW_WITH_ERROR_CODE(output->Write("A"), PdfErrorCode::InternalLogic);
+        }
+        REQUIRE(encrypted.size() == encrypt.CalculateStreamLength(size));
+
+        // The streamed output must be decryptable in one pass
+        charbuff decrypted;
+        encrypt.DecryptTo(decrypted, encrypted, PdfReference(7, 0));
+        REQUIRE(decrypted == buffer);
+
+        // Decrypt again with a stream, reading small pieces
+        SpanStreamDevice input(encrypted);
+        auto decryptStream = encrypt.CreateEncryptionInputStream(input, encrypted.size(), PdfReference(7, 0));
+        decrypted.clear();
+        char chunk[7];
+        bool eof;
+        do
+        {
+            size_t read = decryptStream->Read(chunk, sizeof(chunk), eof);
+            decrypted.append(chunk, read);
+        } while (!eof);
+        REQUIRE(decrypted == buffer);
+    }
+}
+
 void createEncryptedPdf(const string_view& filename)
 {
     PdfMemDocument doc;
@@ -352,3 +439,127 @@ void createEncryptedPdf(const string_view& filename)
 
     INFO(utls::Format("Wrote: {} (R={})", filename, doc.GetEncrypt()->GetRevision()));
 }
+
+void testParallelDecryption(PdfEncryptAlgorithm algorithm, PdfKeyLength keyLength)
+{
+    constexpr unsigned StreamCount = 40;
+    auto getData = [](unsigned i) {
+        // Include empty streams and sizes not aligned to the AES block size
+        string data(i * i * 37 % 5000, '\0');
+        for (unsigned j = 0; j < data.size(); j++)
+            data[j] = (char)(i * 31 + j);
+
+        return data;
+    };
+
+    string tempFile = TestUtils::GetTestOutputFilePath("TestParallelStreamDecryption.pdf");
+    vector<PdfReference> refs;
+    {
+        PdfMemDocument doc;
+        (void)doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto& streamsObj = doc.GetObjects().CreateArrayObject();
+        auto& streams = streamsObj.GetArray();
+        for (unsigned i = 0; i < StreamCount; i++)
+        {
+            auto& obj = doc.GetObjects().CreateDictionaryObject();
+            obj.GetOrCreateStream().SetData(getData(i));
+            refs.push_back(obj.GetIndirectReference());
+            streams.AddIndirect(obj);
+        }
+        doc.GetCatalog().GetDictionary().AddKeyIndirect("TestStreams", streamsObj);
+        doc.SetEncrypted(PDF_USER_PASSWORD, PDF_OWNER_PASSWORD, s_protection, algorithm, keyLength);
+        doc.Save(tempFile);
+    }
+
+    // Saving a document loaded on demand loads all the streams at once
+    string tempFile2 = TestUtils::GetTestOutputFilePath("TestParallelStreamDecryption2.pdf");
+    for (unsigned threadCount : { 1u, 4u })
+    {
+        PdfParser::SetDecryptionThreadCount(threadCount);
+        {
+            PdfMemDocument doc;
+            doc.Load(tempFile, PDF_USER_PASSWORD);
+            doc.Save(tempFile2);
+        }
+
+        PdfMemDocument doc;
+        doc.Load(tempFile2, PDF_USER_PASSWORD);
+        for (unsigned i = 0; i < StreamCount; i++)
+            REQUIRE(doc.GetObjects().MustGetObject(refs[i]).MustGetStream().GetCopy() == getData(i));
+    }
+
+    // Parsing without load on demand decrypts all the streams at once
+    for (unsigned threadCount : { 1u, 4u })
+    {
+        PdfParser::SetDecryptionThreadCount(threadCount);
+        FileStreamDevice device(tempFile);
+        PdfIndirectObjectList objects;
+        PdfParser parser(objects);
+        parser.SetPassword(PDF_USER_PASSWORD);
+        parser.Parse(device, false);
+        for (unsigned i = 0; i < StreamCount; i++)
+            REQUIRE(objects.MustGetObject(refs[i]).MustGetStream().GetCopy() == getData(i));
+    }
+}
+
+void testLoadWithEncryptionKey(PdfEncryptAlgorithm algorithm, PdfKeyLength keyLength)
+{
+    string tempFile = TestUtils::GetTestOutputFilePath("TestLoadWithEncryptionKey.pdf");
+    string savedFile = TestUtils::GetTestOutputFilePath("TestLoadWithEncryptionKeySaved.pdf");
+    PdfReference bufferRef;
+    {
+        PdfMemDocument doc;
+        (void)doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        obj.GetOrCreateStream().SetData("Hello encrypted world"sv);
+        bufferRef = obj.GetIndirectReference();
+        doc.GetCatalog().GetDictionary().AddKeyIndirect("TestKey", obj);
+        doc.SetEncrypted(PDF_USER_PASSWORD, PDF_OWNER_PASSWORD, PdfPermissions::Default, algorithm, keyLength);
+        doc.Save(tempFile);
+    }
+
+    PdfMemDocument doc;
+    doc.Load(tempFile, PDF_USER_PASSWORD);
+    auto key = doc.GetEncrypt()->ExportEncryptionKey();
+    REQUIRE(key.GetAlgorithm() == algorithm);
+
+    PdfMemDocument doc2;
+    doc2.Load(tempFile, key);
+    charbuff buff;
+    doc2.GetObjects().MustGetObject(bufferRef).MustGetStream().CopyTo(buff);
+    REQUIRE(buff == "Hello encrypted world");
+
+    // Saving must keep the original passwords, that are unknown
+    doc2.Save(savedFile);
+    {
+        PdfMemDocument doc3;
+        ASSERT_THROW_WITH_ERROR_CODE(doc3.Load(savedFile), PdfErrorCode::InvalidPassword);
+        doc3.Load(savedFile, PDF_USER_PASSWORD);
+        doc3.GetObjects().MustGetObject(bufferRef).MustGetStream().CopyTo(buff);
+        REQUIRE(buff == "Hello encrypted world");
+        doc3.Load(savedFile, key);
+    }
+
+    // Changing the info dictionary changes the document ID, but the
+    // original first /ID element, that derives the key, is kept
+    doc2.GetMetadata().SetTitle(PdfString("Changed title"));
+    doc2.Save(savedFile);
+    {
+        PdfMemDocument doc3;
+        ASSERT_THROW_WITH_ERROR_CODE(doc3.Load(savedFile), PdfErrorCode::InvalidPassword);
+        doc3.Load(savedFile, PDF_USER_PASSWORD);
+        REQUIRE(doc3.GetMetadata().GetTitle()->GetString() == "Changed title");
+        doc3.GetObjects().MustGetObject(bufferRef).MustGetStream().CopyTo(buff);
+        REQUIRE(buff == "Hello encrypted world");
+        auto& originalId = doc.GetTrailer().GetDictionary().MustFindKey("ID").GetArray().MustFindAt(0).GetString();
+        auto& savedId = doc3.GetTrailer().GetDictionary().MustFindKey("ID").GetArray().MustFindAt(0).GetString();
+        REQUIRE(savedId.GetRawData() == originalId.GetRawData());
+        doc3.Load(savedFile, key);
+    }
+
+    // A key with wrong bytes must be rejected
+    charbuff wrongKeyData(key.GetKey());
+    wrongKeyData[0] ^= 0xFF;
+    PdfEncryptionKey wrongKey(key.GetAlgorithm(), wrongKeyData);
+    ASSERT_THROW_WITH_ERROR_CODE(doc2.Load(tempFile, wrongKey), PdfErrorCode::InvalidPassword);
+}
@@ -9,10 +9,25 @@
 #include <PdfTest.h>
 
 #include <podofo/private/FreetypePrivate.h>
+#include <podofo/private/FontCFFSubset.h>
+
+#include <numeric>
+#include <thread>
 
 using namespace std;
 using namespace PoDoFo;
 
+static void testIndexedFonts();
+static charbuff createCIDKeyedCFF(bool fontSet, bool malformed = false);
+static charbuff createOpenTypeCFF(const bufferview& cff, unsigned glyphCount);
+static charbuff createRectSubr(int x, int y, int size, int globalSubr = -1);
+static charbuff createGlyphCharstring(unsigned subr);
+static vector<pair<long, long>> getOutlinePoints(FT_Face face, unsigned gid);
+static void writeCFFIndex(charbuff& output, const vector<charbuff>& items);
+static void writeCFFDictInt(charbuff& output, int value);
+static void writeCharstringInt(charbuff& output, int value);
+static void writeBigEndian(charbuff& output, unsigned value, unsigned size);
+
 #ifdef PODOFO_HAVE_FONTCONFIG
 
 #include <fontconfig/fontconfig.h>
@@ -159,3 +174,617 @@ bool getFontInfo(FcPattern* font, string& fontFamily, string& fontPath,
 }
 
 #endif // PODOFO_HAVE_FONTCONFIG
+
+TEST_CASE("TestFontCFFSubset")
+{
+    // Create a CFF font with the program of a Standard14 font
+    charbuff fontData;
+    {
+        PdfMemDocument doc;
+        auto data = doc.GetFonts().GetStandard14Font(PdfStandard14FontType::TimesRoman)
+            .GetMetrics().GetOrLoadFontFileData();
+        fontData = charbuff(data.data(), data.size());
+    }
+
+    PdfMemDocument doc;
+    auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    auto& font = doc.GetFonts().GetOrCreateFontFromBuffer(fontData);
+    REQUIRE(font.GetType() == PdfFontType::CIDType1);
+    REQUIRE(font.IsSubsettingEnabled());
+
+    {
+        PdfPainter painter;
+        painter.SetCanvas(page);
+        painter.TextState.SetFont(font, 30.0);
+        painter.DrawText("Hello world", 100, 600);
+        painter.FinishDrawing();
+    }
+
+    charbuff output;
+    {
+        BufferStreamDevice stream(output);
+        doc.Save(stream);
+    }
+
+    PdfMemDocument doc2;
+    doc2.LoadFromBuffer(output);
+    vector<PdfTextEntry> entries;
+    doc2.GetPages().GetPageAt(0).ExtractTextTo(entries);
+    REQUIRE(entries[0].Text == "Hello world");
+
+    // The subset has the .notdef glyph and the used ones
+    auto& fontObj = doc2.GetObjects().MustGetObject(font.GetObject().GetIndirectReference());
+    auto& descendantFont = fontObj.GetDictionary().MustFindKey("DescendantFonts").GetArray().MustFindAt(0);
+    auto& fontFile = descendantFont.GetDictionary().MustFindKey("FontDescriptor").GetDictionary().MustFindKey("FontFile3");
+    REQUIRE(fontFile.GetDictionary().MustFindKey("Subtype").GetName() == "CIDFontType0C");
+    auto subsetData = fontFile.MustGetStream().GetCopy();
+    REQUIRE(subsetData.size() < fontData.size() / 4);
+
+    unique_ptr<struct FT_FaceRec_, decltype(&FT::DoneFace)> face(FT::CreateFaceFromBuffer(subsetData), FT::DoneFace);
+    REQUIRE(face->num_glyphs == 9);
+    set<string> glyphNames;
+    for (FT_Long gid = 0; gid < face->num_glyphs; gid++)
+    {
+        REQUIRE(FT_Load_Glyph(face.get(), (FT_UInt)gid, FT_LOAD_NO_SCALE) == 0);
+        char glyphName[32];
+        REQUIRE(FT_Get_Glyph_Name(face.get(), (FT_UInt)gid, glyphName, sizeof(glyphName)) == 0);
+        glyphNames.insert(glyphName);
+    }
+
+    REQUIRE(glyphNames == set<string>{ ".notdef", "H", "d", "e", "l", "o", "r", "space", "w" });
+}
+
+TEST_CASE("TestFontCFFSubsetCIDKeyed")
+{
+    // The glyphs use the font DICTs 0, 1, 1, 2, 2, 3 and have
+    // CIDs 0, 10, 20, 30, 40, 50, see createCIDKeyedCFF()
+    auto cffData = createCIDKeyedCFF(false);
+    auto openTypeData = createOpenTypeCFF(cffData, 6);
+    for (unsigned i = 0; i < 2; i++)
+    {
+        bool openType = i == 1;
+        auto& fontData = openType ? openTypeData : cffData;
+        PdfMemDocument doc;
+        auto& font = doc.GetFonts().GetOrCreateFontFromBuffer(fontData);
+        REQUIRE(font.GetType() == PdfFontType::CIDType1);
+        REQUIRE(font.IsSubsettingEnabled());
+
+        // The glyphs are selected by CIDs in bare CFF fonts and by GIDs
+        // in OpenType fonts. They use the font DICTs 3 and 1, so the
+        // font DICT 2 is dropped and the others are renumbered
+        vector<unsigned> gids = openType ? vector<unsigned>{ 5, 2 } : vector<unsigned>{ 50, 20 };
+        charbuff subsetData;
+        FontCFFSubset::BuildFont(subsetData, font.GetMetrics(), gids);
+
+        unique_ptr<struct FT_FaceRec_, decltype(&FT::DoneFace)> face(FT::CreateFaceFromBuffer(fontData), FT::DoneFace);
+        unique_ptr<struct FT_FaceRec_, decltype(&FT::DoneFace)> subsetFace(FT::CreateFaceFromBuffer(subsetData), FT::DoneFace);
+        REQUIRE(subsetFace != nullptr);
+        REQUIRE(subsetFace->num_glyphs == 3);
+
+        // The glyphs have the default widths of their font DICTs, and
+        // the outlines drawn by the local and global subroutines
+        const unsigned originalGIDs[] = { 0, 5, 2 };
+        const FT_Pos widths[] = { 100, 400, 200 };
+        for (unsigned gid = 0; gid < 3; gid++)
+        {
+            INFO(utls::Format("OpenType: {}, GID: {}", openType, gid));
+            auto points = getOutlinePoints(subsetFace.get(), gid);
+            REQUIRE(points.size() != 0);
+            REQUIRE(subsetFace->glyph->metrics.horiAdvance == widths[gid]);
+            REQUIRE(points == getOutlinePoints(face.get(), openType ? originalGIDs[gid] : originalGIDs[gid] * 10));
+        }
+    }
+
+    // A charstring calling a missing subroutine doesn't prevent
+    // subsetting, all the subroutines are kept instead
+    {
+        auto malformedData = createCIDKeyedCFF(false, true);
+        PdfMemDocument doc;
+        auto& font = doc.GetFonts().GetOrCreateFontFromBuffer(malformedData);
+        REQUIRE(font.IsSubsettingEnabled());
+        vector<unsigned> gids = { 40, 30 };
+        charbuff subsetData;
+        FontCFFSubset::BuildFont(subsetData, font.GetMetrics(), gids);
+
+        unique_ptr<struct FT_FaceRec_, decltype(&FT::DoneFace)> face(FT::CreateFaceFromBuffer(malformedData), FT::DoneFace);
+        unique_ptr<struct FT_FaceRec_, decltype(&FT::DoneFace)> subsetFace(FT::CreateFaceFromBuffer(subsetData), FT::DoneFace);
+        REQUIRE(subsetFace != nullptr);
+        REQUIRE(subsetFace->num_glyphs == 3);
+        REQUIRE(getOutlinePoints(subsetFace.get(), 2) == getOutlinePoints(face.get(), 30));
+    }
+
+    // CFF font sets can't be subsetted, so the font is embedded whole
+    auto fontSetData = createCIDKeyedCFF(true);
+    PdfMemDocument doc;
+    auto& font = doc.GetFonts().GetOrCreateFontFromBuffer(fontSetData);
+    REQUIRE(font.GetType() == PdfFontType::CIDType1);
+    REQUIRE(!font.IsSubsettingEnabled());
+    ASSERT_THROW_WITH_ERROR_CODE(FontCFFSubset::CheckFont(font.GetMetrics()), PdfErrorCode::UnsupportedFontFormat);
+}
+
+TEST_CASE("TestFontStringLengths")
+{
+    PdfMemDocument doc;
+    auto& font = doc.GetFonts().GetOrCreateFont(TestUtils::GetTestInputFilePath("Fonts", "Lato-Regular.ttf"));
+    PdfTextState state;
+    state.Font = &font;
+    state.FontSize = 12;
+    state.CharSpacing = 1;
+
+    // Measure twice, the second time with cached widths
+    string_view text = "Hello W\xC3\xB6rld \xF0\x9D\x84\x9E";
+    for (unsigned i = 0; i < 2; i++)
+    {
+        vector<double> lengths;
+        REQUIRE(!font.TryGetCharLengths(text, state, lengths));
+        REQUIRE(lengths.size() == 13);
+
+        double length;
+        REQUIRE(!font.TryGetStringLength(text, state, length));
+        REQUIRE(std::abs(std::accumulate(lengths.begin(), lengths.end(), 0.0) - length) < 0.0001);
+
+        // The musical symbol is missing in the font
+        u32string codePoints = U"Hello W\u00F6rld ";
+        for (unsigned j = 0; j < codePoints.size(); j++)
+        {
+            unsigned gid = font.GetGID(codePoints[j], PdfGlyphAccess::Width);
+            double expected = (font.GetMetrics().GetGlyphWidth(gid) * state.FontSize + state.CharSpacing) * state.FontScale;
+            REQUIRE(std::abs(lengths[j] - expected) < 0.0001);
+            REQUIRE(font.GetCharLength(codePoints[j], state) == lengths[j]);
+        }
+
+        REQUIRE(font.GetCharLength(U'\U0001D11E', state) == font.GetDefaultCharLength(state));
+    }
+}
+
+TEST_CASE("TestFontCache")
+{
+    auto fontPath = TestUtils::GetTestInputFilePath("Fonts", "Lato-Regular.ttf");
+    charbuff fontData;
+    utls::ReadTo(fontData, fontPath);
+
+    PdfMemDocument doc1;
+    PdfMemDocument doc2;
+
+    // The cache is disabled by default
+    auto& font1 = doc1.GetFonts().GetOrCreateFont(fontPath);
+    auto& font2 = doc2.GetFonts().GetOrCreateFont(fontPath);
+    REQUIRE(&font1.GetMetrics() != &font2.GetMetrics());
+
+    PdfCommon::SetFontCacheSize(16 * 1024 * 1024);
+    PdfMemDocument doc3;
+    PdfMemDocument doc4;
+    auto& font3 = doc3.GetFonts().GetOrCreateFont(fontPath);
+    auto& font4 = doc4.GetFonts().GetOrCreateFont(fontPath);
+    REQUIRE(&font3.GetMetrics() == &font4.GetMetrics());
+    REQUIRE(font4.GetMetrics().GetFilePath() == fontPath);
+
+    // Fonts from buffers are cached by content
+    auto& font5 = doc3.GetFonts().GetOrCreateFontFromBuffer(fontData);
+    auto& font6 = doc4.GetFonts().GetOrCreateFontFromBuffer(fontData);
+    REQUIRE(&font5.GetMetrics() == &font6.GetMetrics());
+
+    // Fonts larger than the cache are only shared while in use
+    PdfCommon::SetFontCacheSize(1024);
+    PdfMemDocument doc5;
+    auto& font7 = doc5.GetFonts().GetOrCreateFont(fontPath);
+    REQUIRE(&font7.GetMetrics() == &font3.GetMetrics());
+
+    PdfCommon::SetFontCacheSize(0);
+    PdfMemDocument doc6;
+    auto& font8 = doc6.GetFonts().GetOrCreateFont(fontPath);
+    REQUIRE(&font8.GetMetrics() != &font3.GetMetrics());
+}
+
+TEST_CASE("TestFontIndex")
+{
+    auto indexPath = TestUtils::GetTestOutputFilePath("FontIndex.bin");
+    auto fontsPath = TestUtils::GetTestInputFilePath("Fonts");
+    fs::remove(fs::u8path(indexPath));
+
+    fs::file_time_type indexTime;
+    for (unsigned i = 0; i < 2; i++)
+    {
+        if (i == 1)
+        {
+            // Backdate the index, so a rewrite is detected
+            indexTime = fs::file_time_type::clock::now() - chrono::hours(1);
+            fs::last_write_time(fs::u8path(indexPath), indexTime);
+        }
+
+        // The index is built the first time, then loaded from the file
+        PdfCommon::SetFontIndexFile(indexPath);
+        PdfCommon::AddFontDirectory(fontsPath);
+        REQUIRE(fs::exists(fs::u8path(indexPath)));
+        testIndexedFonts();
+    }
+
+    // The fonts didn't change, so the index is not saved again
+    REQUIRE(fs::last_write_time(fs::u8path(indexPath)) == indexTime);
+
+    charbuff index;
+    utls::ReadTo(index, indexPath);
+
+    // A truncated index and one with a corrupted string length
+    // are ignored, and the index is built again
+    charbuff truncated(index.data(), index.size() / 2);
+    charbuff corrupted = index;
+    // Skip the magic, the version and the directory count
+    std::fill(corrupted.begin() + 16, corrupted.begin() + 20, '\xFF');
+    for (auto& invalid : { truncated, corrupted })
+    {
+        utls::WriteTo(indexPath, invalid);
+        PdfCommon::SetFontIndexFile(indexPath);
+        PdfCommon::AddFontDirectory(fontsPath);
+        testIndexedFonts();
+
+        charbuff rebuilt;
+        utls::ReadTo(rebuilt, indexPath);
+        REQUIRE(rebuilt == index);
+    }
+
+    PdfCommon::SetFontIndexFile({ });
+}
+
+void testIndexedFonts()
+{
+    auto metrics = PdfFontManager::SearchFontMetrics("Lato");
+    REQUIRE(metrics != nullptr);
+    REQUIRE(fs::u8path(metrics->GetFilePath()).filename() == "Lato-Regular.ttf");
+
+    PdfFontSearchParams params;
+    params.Style = PdfFontStyle::Italic;
+    metrics = PdfFontManager::SearchFontMetrics("lato", params);
+    REQUIRE(metrics != nullptr);
+    REQUIRE(fs::u8path(metrics->GetFilePath()).filename() == "Lato-RegularItalic.ttf");
+
+    params.Style = PdfFontStyle::Bold;
+    metrics = PdfFontManager::SearchFontMetrics("Source Code Pro", params);
+    REQUIRE(metrics != nullptr);
+    REQUIRE(fs::u8path(metrics->GetFilePath()).filename() == "SourceCodePro-Bold.ttf");
+
+    params.Style = nullptr;
+    params.MatchBehavior = PdfFontMatchBehaviorFlags::MatchPostScriptName;
+    metrics = PdfFontManager::SearchFontMetrics("SourceCodePro-Bold", params);
+    REQUIRE(metrics != nullptr);
+    REQUIRE(fs::u8path(metrics->GetFilePath()).filename() == "SourceCodePro-Bold.ttf");
+}
+
+// Generate documents in parallel, sharing the font
+// metrics among the threads with the font cache
+TEST_CASE("TestFontsMultiThreaded")
+{
+    constexpr unsigned ThreadCount = 8;
+    constexpr unsigned DocumentCount = 4;
+    auto fontPath = TestUtils::GetTestInputFilePath("Fonts", "Lato-Regular.ttf");
+    charbuff fontData;
+    utls::ReadTo(fontData, fontPath);
+
+    PdfCommon::SetFontCacheSize(16 * 1024 * 1024);
+    vector<thread> threads;
+    vector<string> errors(ThreadCount);
+    vector<size_t> sizes(ThreadCount);
+    for (unsigned i = 0; i < ThreadCount; i++)
+    {
+        threads.emplace_back([&, i]() {
+            try
+            {
+                for (unsigned j = 0; j < DocumentCount; j++)
+                {
+                    PdfMemDocument doc;
+                    auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+                    auto& font1 = doc.GetFonts().GetOrCreateFont(fontPath);
+                    auto& font2 = doc.GetFonts().GetOrCreateFontFromBuffer(fontData);
+                    auto& font3 = doc.GetFonts().GetStandard14Font(PdfStandard14FontType::Helvetica);
+                    PdfPainter painter;
+                    painter.SetCanvas(page);
+                    for (unsigned k = 0; k < 20; k++)
+                    {
+                        auto& font = k % 3 == 0 ? font1 : (k % 3 == 1 ? font2 : font3);
+                        painter.TextState.SetFont(font, 12);
+                        painter.DrawText(utls::Format("Thread {} document {} line {}: {}", i, j, k,
+                            &font == &font3 ? "Hello" : "ÀÉÎÕÜ àéîõü"), 50, 800 - k * 30.0);
+                    }
+
+                    painter.FinishDrawing();
+                    charbuff buffer;
+                    BufferStreamDevice device(buffer);
+                    doc.Save(device);
+                    sizes[i] += buffer.size();
+                }
+            }
+            catch (const exception& ex)
+            {
+                errors[i] = ex.what();
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    PdfCommon::SetFontCacheSize(0);
+    for (unsigned i = 0; i < ThreadCount; i++)
+    {
+        INFO(errors[i]);
+        REQUIRE(errors[i].empty());
+        REQUIRE(sizes[i] != 0);
+    }
+}
+
+// Create a CID-keyed CFF font with 6 glyphs having CIDs 0, 10, 20, 30,
+// 40, 50 and using 4 font DICTs, with different default widths. The
+// glyphs are drawn by local subroutines, also calling a global one.
+// If malformed, the glyph with CID 40 calls a missing subroutine
+charbuff createCIDKeyedCFF(bool fontSet, bool malformed)
+{
+    const unsigned glyphFDs[] = { 0, 1, 1, 2, 2, 3 };
+    const unsigned glyphSubrs[] = { 0, 0, 2, 1, malformed ? 5u : 0u, 0 };
+    vector<vector<charbuff>> localSubrs = {
+        { createRectSubr(50, 50, 100) },
+        { createRectSubr(10, 10, 200), createRectSubr(20, 20, 300), createRectSubr(30, 30, 400) },
+        { createRectSubr(40, 40, 500), createRectSubr(50, 50, 600) },
+        { createRectSubr(60, 60, 700, 0) },
+    };
+
+    charbuff names;
+    if (fontSet)
+        writeCFFIndex(names, { charbuff(string("CIDTest")), charbuff(string("CIDTest2")) });
+    else
+        writeCFFIndex(names, { charbuff(string("CIDTest")) });
+
+    // The strings have SIDs 391 and 392, after the standard ones
+    charbuff strings;
+    writeCFFIndex(strings, { charbuff(string("Adobe")), charbuff(string("Identity")) });
+    charbuff globalSubrs;
+    writeCFFIndex(globalSubrs, { createRectSubr(100, 100, 50) });
+
+    charbuff charset;
+    charset.push_back(0);
+    for (unsigned gid = 1; gid < std::size(glyphFDs); gid++)
+        writeBigEndian(charset, gid * 10, 2);
+
+    charbuff fdSelect;
+    fdSelect.push_back(0);
+    for (unsigned fd : glyphFDs)
+        fdSelect.push_back((char)fd);
+
+    vector<charbuff> glyphs;
+    for (unsigned subr : glyphSubrs)
+        glyphs.push_back(createGlyphCharstring(subr));
+    charbuff charStrings;
+    writeCFFIndex(charStrings, glyphs);
+
+    // The Private DICTs are followed by their local subroutines
+    vector<charbuff> privates(localSubrs.size());
+    vector<unsigned> privateSizes(localSubrs.size());
+    for (unsigned i = 0; i < localSubrs.size(); i++)
+    {
+        auto& priv = privates[i];
+        writeCFFDictInt(priv, (int)(i + 1) * 100);
+        priv.push_back(20);     // defaultWidthX
+        writeCFFDictInt(priv, 0);
+        priv.push_back(21);     // nominalWidthX
+        writeCFFDictInt(priv, (int)priv.size() + 6);
+        priv.push_back(19);     // Subrs
+        privateSizes[i] = (unsigned)priv.size();
+        writeCFFIndex(priv, localSubrs[i]);
+    }
+
+    // All the DICT integers have 5 bytes, so the sizes
+    // are known before the offsets are computed
+    auto createTopDicts = [&](unsigned charsetOffset, unsigned fdSelectOffset,
+        unsigned charStringsOffset, unsigned fdArrayOffset)
+    {
+        charbuff topDict;
+        writeCFFDictInt(topDict, 391);
+        writeCFFDictInt(topDict, 392);
+        writeCFFDictInt(topDict, 0);
+        topDict.append({ 12, 30 });     // ROS
+        writeCFFDictInt(topDict, 51);
+        topDict.append({ 12, 34 });     // CIDCount
+        writeCFFDictInt(topDict, (int)charsetOffset);
+        topDict.push_back(15);          // charset
+        writeCFFDictInt(topDict, (int)fdSelectOffset);
+        topDict.append({ 12, 37 });     // FDSelect
+        writeCFFDictInt(topDict, (int)charStringsOffset);
+        topDict.push_back(17);          // CharStrings
+        writeCFFDictInt(topDict, (int)fdArrayOffset);
+        topDict.append({ 12, 36 });     // FDArray
+
+        charbuff ret;
+        if (fontSet)
+            writeCFFIndex(ret, { topDict, topDict });
+        else
+            writeCFFIndex(ret, { topDict });
+        return ret;
+    };
+
+    auto createFDArray = [&](unsigned privateOffset)
+    {
+        vector<charbuff> fontDicts(privates.size());
+        for (unsigned i = 0; i < privates.size(); i++)
+        {
+            writeCFFDictInt(fontDicts[i], (int)privateSizes[i]);
+            writeCFFDictInt(fontDicts[i], (int)privateOffset);
+            fontDicts[i].push_back(18);     // Private
+            privateOffset += (unsigned)privates[i].size();
+        }
+
+        charbuff ret;
+        writeCFFIndex(ret, fontDicts);
+        return ret;
+    };
+
+    unsigned charsetOffset = (unsigned)(4 + names.size() + createTopDicts(0, 0, 0, 0).size()
+        + strings.size() + globalSubrs.size());
+    unsigned fdSelectOffset = charsetOffset + (unsigned)charset.size();
+    unsigned charStringsOffset = fdSelectOffset + (unsigned)fdSelect.size();
+    unsigned fdArrayOffset = charStringsOffset + (unsigned)charStrings.size();
+    unsigned privateOffset = fdArrayOffset + (unsigned)createFDArray(0).size();
+
+    charbuff ret;
+    ret.append({ 1, 0, 4, 4 });
+    ret.append(names);
+    ret.append(createTopDicts(charsetOffset, fdSelectOffset, charStringsOffset, fdArrayOffset));
+    ret.append(strings);
+    ret.append(globalSubrs);
+    ret.append(charset);
+    ret.append(fdSelect);
+    ret.append(charStrings);
+    ret.append(createFDArray(privateOffset));
+    for (auto& priv : privates)
+        ret.append(priv);
+
+    return ret;
+}
+
+// Wrap the CFF font in an OpenType font with the minimal tables
+charbuff createOpenTypeCFF(const bufferview& cff, unsigned glyphCount)
+{
+    charbuff head;
+    writeBigEndian(head, 0x00010000, 4);    // version
+    writeBigEndian(head, 0x00010000, 4);    // fontRevision
+    writeBigEndian(head, 0, 4);             // checksumAdjustment
+    writeBigEndian(head, 0x5F0F3CF5, 4);    // magicNumber
+    writeBigEndian(head, 0, 2);             // flags
+    writeBigEndian(head, 1000, 2);          // unitsPerEm
+    head.resize(head.size() + 16);          // created, modified
+    writeBigEndian(head, 0, 2);             // xMin
+    writeBigEndian(head, 0, 2);             // yMin
+    writeBigEndian(head, 1000, 2);          // xMax
+    writeBigEndian(head, 1000, 2);          // yMax
+    head.resize(head.size() + 10);          // macStyle ... glyphDataFormat
+
+    charbuff hhea;
+    writeBigEndian(hhea, 0x00010000, 4);    // version
+    writeBigEndian(hhea, 800, 2);           // ascender
+    writeBigEndian(hhea, (unsigned)-200, 2); // descender
+    hhea.resize(hhea.size() + 10);          // lineGap ... xMaxExtent
+    writeBigEndian(hhea, 1, 2);             // caretSlopeRise
+    hhea.resize(hhea.size() + 14);          // caretSlopeRun ... metricDataFormat
+    writeBigEndian(hhea, glyphCount, 2);    // numberOfHMetrics
+
+    charbuff hmtx;
+    for (unsigned i = 0; i < glyphCount; i++)
+    {
+        writeBigEndian(hmtx, 500, 2);
+        writeBigEndian(hmtx, 0, 2);
+    }
+
+    charbuff maxp;
+    writeBigEndian(maxp, 0x00005000, 4);
+    writeBigEndian(maxp, glyphCount, 2);
+
+    // The tables are sorted by tag
+    vector<pair<string_view, bufferview>> tables = {
+        { "CFF ", cff }, { "head", head }, { "hhea", hhea }, { "hmtx", hmtx }, { "maxp", maxp }
+    };
+
+    charbuff ret;
+    ret.append("OTTO");
+    writeBigEndian(ret, (unsigned)tables.size(), 2);
+    writeBigEndian(ret, 64, 2);             // searchRange
+    writeBigEndian(ret, 2, 2);              // entrySelector
+    writeBigEndian(ret, (unsigned)tables.size() * 16 - 64, 2); // rangeShift
+    unsigned offset = 12 + (unsigned)tables.size() * 16;
+    for (auto& table : tables)
+    {
+        ret.append(table.first);
+        writeBigEndian(ret, 0, 4);          // checksum
+        writeBigEndian(ret, offset, 4);
+        writeBigEndian(ret, (unsigned)table.second.size(), 4);
+        offset += ((unsigned)table.second.size() + 3) & ~3U;
+    }
+
+    for (auto& table : tables)
+    {
+        ret.append(table.second.data(), table.second.size());
+        ret.resize((ret.size() + 3) & ~(size_t)3);
+    }
+
+    return ret;
+}
+
+// Draw a square, and optionally call a global subroutine
+charbuff createRectSubr(int x, int y, int size, int globalSubr)
+{
+    charbuff ret;
+    writeCharstringInt(ret, x);
+    writeCharstringInt(ret, y);
+    ret.push_back(21);      // rmoveto
+    writeCharstringInt(ret, size);
+    writeCharstringInt(ret, 0);
+    writeCharstringInt(ret, 0);
+    writeCharstringInt(ret, size);
+    writeCharstringInt(ret, -size);
+    writeCharstringInt(ret, 0);
+    ret.push_back(5);       // rlineto
+    if (globalSubr >= 0)
+    {
+        // The subroutine numbers are biased by 107
+        writeCharstringInt(ret, globalSubr - 107);
+        ret.push_back(29);  // callgsubr
+    }
+
+    ret.push_back(11);      // return
+    return ret;
+}
+
+charbuff createGlyphCharstring(unsigned subr)
+{
+    charbuff ret;
+    writeCharstringInt(ret, (int)subr - 107);
+    ret.push_back(10);      // callsubr
+    ret.push_back(14);      // endchar
+    return ret;
+}
+
+vector<pair<long, long>> getOutlinePoints(FT_Face face, unsigned gid)
+{
+    REQUIRE(FT_Load_Glyph(face, gid, FT_LOAD_NO_SCALE) == 0);
+    auto& outline = face->glyph->outline;
+    vector<pair<long, long>> ret;
+    for (int i = 0; i < outline.n_points; i++)
+        ret.push_back({ (long)outline.points[i].x, (long)outline.points[i].y });
+
+    return ret;
+}
+
+void writeCFFIndex(charbuff& output, const vector<charbuff>& items)
+{
+    writeBigEndian(output, (unsigned)items.size(), 2);
+    if (items.size() == 0)
+        return;
+
+    // The offsets are relative to the byte preceding the data
+    output.push_back(4);
+    unsigned offset = 1;
+    writeBigEndian(output, offset, 4);
+    for (auto& item : items)
+    {
+        offset += (unsigned)item.size();
+        writeBigEndian(output, offset, 4);
+    }
+
+    for (auto& item : items)
+        output.append(item);
+}
+
+void writeCFFDictInt(charbuff& output, int value)
+{
+    output.push_back(29);
+    writeBigEndian(output, (unsigned)value, 4);
+}
+
+void writeCharstringInt(charbuff& output, int value)
+{
+    output.push_back(28);
+    writeBigEndian(output, (unsigned)value, 2);
+}
+
+void writeBigEndian(charbuff& output, unsigned value, unsigned size)
+{
+    for (unsigned i = size; i > 0; i--)
+        output.push_back((char)(value >> ((i - 1) * 8)));
+}
@@ -445,6 +445,335 @@ TEST_CASE("TestRotate")
     test(270);
 }
 
+TEST_CASE("TestContentStreamViewReader")
+{
+    string_view contents =
+        "q 1 0 0 1 10 20.5 cm /F#31 12 Tf [(Hel\\)l(o)) -120 <41 4243>] TJ\n"
+        "BI /W 2 /H 1 /D [1 0] ID \x01\x02 EI % Comment\n"
+        "/Span << /MCID 0 >> BDC foo EMC 1 Q";
+    PdfContentStreamViewReader reader(bufferview(contents.data(), contents.size()));
+    PdfContentView content;
+    charbuff buffer;
+
+    REQUIRE(reader.TryReadNext(content));
+    REQUIRE(content.Operator == PdfOperator::q);
+    REQUIRE(content.Operands.size() == 0);
+
+    REQUIRE(reader.TryReadNext(content));
+    REQUIRE(content.Operator == PdfOperator::cm);
+    REQUIRE(content.Operands.size() == 6);
+    REQUIRE(content.Operands[4].Type == PdfContentOperandType::Number);
+    REQUIRE(content.Operands[4].Number == 10);
+    REQUIRE(content.Operands[5].Type == PdfContentOperandType::Real);
+    REQUIRE(content.Operands[5].GetReal() == 20.5);
+    REQUIRE(content.Warnings == PdfContentWarnings::None);
+
+    REQUIRE(reader.TryReadNext(content));
+    REQUIRE(content.Operator == PdfOperator::Tf);
+    REQUIRE(content.Operands[0].Type == PdfContentOperandType::Name);
+    REQUIRE(content.Operands[0].Data == "F#31");
+    content.Operands[0].DecodeTo(buffer);
+    REQUIRE(buffer == "F1");
+
+    REQUIRE(reader.TryReadNext(content));
+    REQUIRE(content.Operator == PdfOperator::TJ);
+    REQUIRE(content.Warnings == PdfContentWarnings::None);
+    REQUIRE(content.Operands.size() == 5);
+    REQUIRE(content.Operands[0].Type == PdfContentOperandType::ArrayBegin);
+    REQUIRE(content.Operands[1].Type == PdfContentOperandType::String);
+    REQUIRE(content.Operands[1].Data == "Hel\\)l(o)");
+    content.Operands[1].DecodeTo(buffer);
+    REQUIRE(buffer == "Hel)l(o)");
+    REQUIRE(content.Operands[2].Number == -120);
+    REQUIRE(content.Operands[3].Type == PdfContentOperandType::HexString);
+    content.Operands[3].DecodeTo(buffer);
+    REQUIRE(buffer == "ABC");
+    REQUIRE(content.Operands[4].Type == PdfContentOperandType::ArrayEnd);
+
+    REQUIRE(reader.TryReadNext(content));
+    REQUIRE(content.Type == PdfContentType::ImageDictionary);
+    REQUIRE(content.Warnings == PdfContentWarnings::None);
+    REQUIRE(content.Operands.size() == 9);
+    REQUIRE(content.Operands[4].Data == "D");
+    REQUIRE(content.Operands[5].Type == PdfContentOperandType::ArrayBegin);
+
+    REQUIRE(reader.TryReadNext(content));
+    REQUIRE(content.Type == PdfContentType::ImageData);
+    // NOTE: Like PdfContentStreamReader the whitespace before EI is kept
+    REQUIRE(content.InlineImageData.size() == 3);
+    REQUIRE(content.InlineImageData[0] == '\x01');
+    REQUIRE(content.InlineImageData[1] == '\x02');
+
+    REQUIRE(reader.TryReadNext(content));
+    REQUIRE(content.Operator == PdfOperator::BDC);
+    REQUIRE(content.Warnings == PdfContentWarnings::None);
+    REQUIRE(content.Operands.size() == 5);
+    REQUIRE(content.Operands[1].Type == PdfContentOperandType::DictionaryBegin);
+    REQUIRE(content.Operands[4].Type == PdfContentOperandType::DictionaryEnd);
+
+    REQUIRE(reader.TryReadNext(content));
+    REQUIRE(content.Type == PdfContentType::UnexpectedKeyword);
+    REQUIRE(content.Keyword == "foo");
+
+    REQUIRE(reader.TryReadNext(content));
+    REQUIRE(content.Operator == PdfOperator::EMC);
+
+    REQUIRE(reader.TryReadNext(content));
+    REQUIRE(content.Operator == PdfOperator::Q);
+    REQUIRE(content.Warnings == PdfContentWarnings::SpuriousStackContent);
+
+    REQUIRE(!reader.TryReadNext(content));
+    REQUIRE(content.Type == PdfContentType::Unknown);
+
+    // Malformed numbers are skipped with a warning
+    contents = "--1 0 m 10 -. l +10 10 l";
+    PdfContentStreamViewReader reader2(bufferview(contents.data(), contents.size()));
+
+    REQUIRE(reader2.TryReadNext(content));
+    REQUIRE(content.Operator == PdfOperator::m);
+    REQUIRE(content.Operands.size() == 1);
+    REQUIRE(content.Warnings == PdfContentWarnings::InvalidOperator);
+
+    REQUIRE(reader2.TryReadNext(content));
+    REQUIRE(content.Operator == PdfOperator::l);
+    REQUIRE(content.Operands.size() == 1);
+    REQUIRE(content.Warnings == PdfContentWarnings::InvalidOperator);
+
+    REQUIRE(reader2.TryReadNext(content));
+    REQUIRE(content.Operator == PdfOperator::l);
+    REQUIRE(content.Operands[0].Number == 10);
+    REQUIRE(content.Warnings == PdfContentWarnings::None);
+}
+
+TEST_CASE("TestContentStreamViewReaderCanvas")
+{
+    PdfMemDocument doc;
+    auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    PdfPainter painter;
+    painter.SetCanvas(page);
+    drawSample(painter);
+    drawSquareWithCross(painter, 100, 100);
+    painter.FinishDrawing();
+
+    // Both readers must report the same operators and operands
+    PdfContentStreamReader reader(page);
+    PdfContentStreamViewReader viewReader(page);
+    PdfContent content;
+    PdfContentView contentView;
+    unsigned count = 0;
+    while (reader.TryReadNext(content))
+    {
+        REQUIRE(viewReader.TryReadNext(contentView));
+        REQUIRE(contentView.Type == content.Type);
+        REQUIRE(contentView.Operator == content.Operator);
+        REQUIRE(contentView.Operands.size() == content.Stack.GetSize());
+        for (unsigned i = 0; i < content.Stack.GetSize(); i++)
+        {
+            // NOTE: The stack is in reverse order
+            auto& operand = content.Stack[content.Stack.GetSize() - 1 - i];
+            if (operand.IsNumberOrReal())
+                REQUIRE(contentView.Operands[i].GetReal() == operand.GetReal());
+        }
+
+        count++;
+    }
+
+    REQUIRE(count != 0);
+    REQUIRE(!viewReader.TryReadNext(contentView));
+}
+
+TEST_CASE("TestContentStreamRewriter")
+{
+    string_view contents = "q 1 0 0 RG 0 0 10 10 re\nS BI /W 1 /H 1 ID \x01 EI\n(Hello) Tj Q";
+    PdfContentStreamRewriter rewriter([](const PdfContentView& content, PdfStringStream& output) {
+        switch (content.Operator)
+        {
+            case PdfOperator::RG:
+                return PdfContentRewriteAction::Drop;
+            case PdfOperator::re:
+                output << "1 1 5 5 re";
+                return PdfContentRewriteAction::Drop;
+            case PdfOperator::S:
+                output << "0 g";
+                return PdfContentRewriteAction::Keep;
+            default:
+                break;
+        }
+
+        if (content.Type == PdfContentType::ImageDictionary)
+            return PdfContentRewriteAction::Drop;
+
+        return PdfContentRewriteAction::Keep;
+    });
+
+    charbuff buffer;
+    BufferStreamDevice output(buffer);
+    rewriter.Rewrite(bufferview(contents.data(), contents.size()), output);
+    REQUIRE(buffer == "q  1 1 5 5 re\n\n0 g\nS (Hello) Tj Q");
+}
+
+TEST_CASE("TestContentStreamRewriterCanvas")
+{
+    PdfMemDocument doc;
+    auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    PdfPainter painter;
+    painter.SetCanvas(page);
+    drawSample(painter);
+    drawSquareWithCross(painter, 100, 100);
+    painter.FinishDrawing();
+
+    PdfContentStreamRewriter rewriter([](const PdfContentView& content, PdfStringStream&) {
+        return content.Operator == PdfOperator::f
+            ? PdfContentRewriteAction::Drop
+            : PdfContentRewriteAction::Keep;
+    });
+    rewriter.Rewrite(page);
+
+    auto& contents = page.GetContents()->GetObject();
+    REQUIRE(contents.GetArray().GetSize() == 1);
+    auto& stream = contents.GetArray().MustFindAt(0);
+    REQUIRE(stream.GetDictionary().MustFindKey("Filter").GetName() == "FlateDecode");
+
+    PdfContentStreamViewReader reader(page);
+    PdfContentView content;
+    unsigned count = 0;
+    while (reader.TryReadNext(content))
+    {
+        REQUIRE(content.Operator != PdfOperator::f);
+        count++;
+    }
+
+    REQUIRE(count != 0);
+}
+
+TEST_CASE("TestXObjectFormCache")
+{
+    PdfMemDocument doc;
+    auto xobj = doc.CreateXObjectForm(Rect(0, 0, 50, 50));
+    PdfPainter painter;
+    painter.SetCanvas(*xobj);
+    drawSquareWithCross(painter, 10, 10);
+    painter.FinishDrawing();
+
+    for (unsigned i = 0; i < 3; i++)
+    {
+        auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        painter.SetCanvas(page);
+        painter.DrawXObject(*xobj, 100, 100);
+        painter.DrawXObject(*xobj, 200, 200);
+        drawSample(painter);
+        painter.FinishDrawing();
+    }
+
+    auto readContents = [&](string& str) {
+        str.clear();
+        PdfContent content;
+        for (unsigned i = 0; i < doc.GetPages().GetCount(); i++)
+        {
+            PdfContentStreamReader reader(doc.GetPages().GetPageAt(i));
+            while (reader.TryReadNext(content))
+            {
+                str.append(utls::Format("{} {} {} {}\n", (int)content.Type,
+                    (int)content.Operator, content.Stack.GetSize(), (int)content.Warnings));
+            }
+        }
+    };
+
+    string expected;
+    readContents(expected);
+
+    doc.SetXObjectFormCacheSize(1 << 20);
+    auto cache = doc.GetXObjectFormCache();
+    REQUIRE(cache != nullptr);
+    REQUIRE(cache->GetSize() == 0);
+
+    string actual;
+    readContents(actual);
+    REQUIRE(cache->GetSize() != 0);
+    REQUIRE(actual == expected);
+
+    // Read again all the pages using only the cache
+    readContents(actual);
+    REQUIRE(actual == expected);
+
+    // Forms bigger than the cache are not cached
+    doc.SetXObjectFormCacheSize(16);
+    readContents(actual);
+    REQUIRE(actual == expected);
+    REQUIRE(doc.GetXObjectFormCache()->GetSize() == 0);
+
+    doc.SetXObjectFormCacheSize(0);
+    REQUIRE(doc.GetXObjectFormCache() == nullptr);
+}
+
+TEST_CASE("TestOptimizeContents")
+{
+    string_view example =
+        "q q 1 w 1 w 1 0 0 1 0 0 cm 0.500000 g\n"
+        "BT /F1 12 Tf 1 0 0 1 10 10 Tm [(a) -10.50 (b)] TJ ET\n"
+        "BT /F1 12 Tf 1 0 0 1 20.0000001 20 Tm (c) Tj ET\n"
+        "Q Q q Q 0.0000001 w BI /W 1 /H 1 /BPC 8 /CS /G ID x EI";
+    string_view expected =
+        "q\n1 w\n.5 g\nBT\n/F1 12 Tf\n1 0 0 1 10 10 Tm\n[(a) -10.5 (b)] TJ\n"
+        "1 0 0 1 20 20 Tm\n(c) Tj\nET\nQ\n0.0000001 w\nBI /W 1 /H 1 /BPC 8 /CS /G ID x EI\n";
+
+    {
+        PdfMemDocument doc;
+        auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        page.GetOrCreateContents().GetStreamForAppending().SetData(example);
+        REQUIRE(page.OptimizeContents());
+        REQUIRE(getContents(page) == expected);
+
+        // Already optimized contents are left untouched
+        REQUIRE(!page.OptimizeContents());
+    }
+
+    {
+        // Text objects using clipping render modes are not merged,
+        // and the text matrix is relative to the previous one
+        PdfMemDocument doc;
+        auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        page.GetOrCreateContents().GetStreamForAppending().SetData(
+            "BT 7 Tr (a) Tj ET BT 1 0 0 1 5 5 Tm (b) Tj ET BT 10 10 Td (c) Tj ET 1.000000 w"sv);
+        REQUIRE(page.OptimizeContents());
+        REQUIRE(getContents(page) == "BT\n7 Tr\n(a) Tj\nET\nBT\n1 0 0 1 5 5 Tm\n(b) Tj\nET\n"
+            "BT\n10 10 Td\n(c) Tj\nET\n1 w\n");
+    }
+
+    {
+        // Color spaces are never dropped, since they reset the color,
+        // and only colors with identical operands are dropped
+        PdfMemDocument doc;
+        auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        page.GetOrCreateContents().GetStreamForAppending().SetData(
+            "/CS0   cs 1 sc /CS0   cs 1 sc 1 sc   0.5 g 0.5 g 0.50 g   "sv);
+        REQUIRE(page.OptimizeContents());
+        REQUIRE(getContents(page) == "/CS0 cs\n1 sc\n/CS0 cs\n1 sc\n.5 g\n.5 g\n");
+    }
+
+    {
+        // Malformed contents are not optimized
+        PdfMemDocument doc;
+        auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        page.GetOrCreateContents().GetStreamForAppending().SetData("--1   w   1   w"sv);
+        REQUIRE(!page.OptimizeContents());
+    }
+
+    {
+        // Optimize on save
+        PdfMemDocument doc;
+        auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        page.GetOrCreateContents().GetStreamForAppending().SetData(example);
+        charbuff buffer;
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::OptimizeContents);
+
+        PdfMemDocument loaded;
+        loaded.LoadFromBuffer(buffer);
+        REQUIRE(getContents(loaded.GetPages().GetPageAt(0)) == expected);
+    }
+}
+
 static void drawSample(PdfPainter& painter)
 {
     painter.DrawCircle(100, 500, 20, PdfPathDrawMode::Fill);
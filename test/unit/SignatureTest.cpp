@@ -6,9 +6,63 @@
 #include <PdfTest.h>
 #include <podofo/private/OpenSSLInternal.h>
 
+namespace PoDoFo
+{
+    class PdfSigningContextTest
+    {
+    public:
+        static void AddSignerUnsafe(PdfSigningContext& ctx, const PdfSignature& signature, PdfSigner& signer)
+        {
+            ctx.AddSignerUnsafe(signature, signer);
+        }
+    };
+}
+
 using namespace std;
 using namespace PoDoFo;
 
+static void createSignableDocument(charbuff& buff, unsigned fieldCount = 1, size_t dataSize = 200000);
+static void createTestKey(charbuff& cert, charbuff& pkey);
+static void verifySignature(const charbuff& buff);
+static PdfSignature& getSignatureField(PdfMemDocument& doc, unsigned index = 0);
+
+namespace
+{
+    // A signer that just records the data to be signed
+    class RecordingSigner : public PdfSigner
+    {
+    public:
+        void Reset() override
+        {
+            Data.clear();
+        }
+
+        void AppendData(const bufferview& data) override
+        {
+            Data.append(data.data(), data.size());
+        }
+
+        void ComputeSignature(charbuff& contents, bool dryrun) override
+        {
+            (void)dryrun;
+            contents = "recorded"sv;
+        }
+
+        string GetSignatureSubFilter() const override
+        {
+            return "adbe.pkcs7.detached";
+        }
+
+        string GetSignatureType() const override
+        {
+            return "Sig";
+        }
+
+    public:
+        charbuff Data;
+    };
+}
+
 // Test signing with supplied private key
 TEST_CASE("TestSignature1")
 {
@@ -193,3 +247,269 @@ TEST_CASE("TestPdfSignerCms")
         }
     }
 }
+
+// Test that the signed data is all the document but the /Contents
+TEST_CASE("TestSignatureByteRange")
+{
+    charbuff buff;
+    createSignableDocument(buff);
+
+    RecordingSigner signer;
+    {
+        auto device = std::make_shared<BufferStreamDevice>(buff);
+        PdfMemDocument doc(device);
+        PoDoFo::SignDocument(doc, *device, signer, getSignatureField(doc), PdfSaveOptions::NoMetadataUpdate);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buff);
+    auto& annot = doc.GetPages().GetPageAt(0).GetAnnotations().GetAnnotAt(0);
+    auto& byteRange = annot.GetDictionary().MustFindKey("V").GetDictionary().MustFindKey("ByteRange").GetArray();
+    REQUIRE(byteRange.GetSize() == 4);
+    auto offset2 = (size_t)byteRange[2].GetNumber();
+    auto length1 = (size_t)byteRange[1].GetNumber();
+    auto length2 = (size_t)byteRange[3].GetNumber();
+    REQUIRE(byteRange[0].GetNumber() == 0);
+    REQUIRE(offset2 + length2 == buff.size());
+
+    charbuff expected;
+    expected.append(buff.data(), length1);
+    expected.append(buff.data() + offset2, length2);
+    REQUIRE(signer.Data == expected);
+}
+
+// Test that many signers fed together each receive
+// exactly the data in their own /ByteRange
+TEST_CASE("TestSignatureMultipleSigners")
+{
+    constexpr unsigned SignerCount = 3;
+    charbuff buff;
+    // Big enough to cycle through all the read ahead blocks
+    createSignableDocument(buff, SignerCount, 6000000);
+
+    RecordingSigner signers[SignerCount];
+    {
+        auto device = std::make_shared<BufferStreamDevice>(buff);
+        PdfMemDocument doc(device);
+        PdfSigningContext ctx;
+        for (unsigned i = 0; i < SignerCount; i++)
+            PdfSigningContextTest::AddSignerUnsafe(ctx, getSignatureField(doc, i), signers[i]);
+
+        ctx.Sign(doc, *device, PdfSaveOptions::NoMetadataUpdate);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buff);
+    vector<pair<size_t, size_t>> contentsRanges;
+    for (unsigned i = 0; i < SignerCount; i++)
+    {
+        auto& annot = doc.GetPages().GetPageAt(0).GetAnnotations().GetAnnotAt(i);
+        auto& byteRange = annot.GetDictionary().MustFindKey("V").GetDictionary().MustFindKey("ByteRange").GetArray();
+        REQUIRE(byteRange.GetSize() == 4);
+        REQUIRE(byteRange[0].GetNumber() == 0);
+        REQUIRE((size_t)(byteRange[2].GetNumber() + byteRange[3].GetNumber()) == buff.size());
+        contentsRanges.push_back({ (size_t)byteRange[1].GetNumber(), (size_t)byteRange[2].GetNumber() });
+    }
+
+    for (unsigned i = 0; i < SignerCount; i++)
+    {
+        // The other signatures /Contents were still
+        // blank beacons when the data was recorded
+        charbuff expected = buff;
+        for (unsigned j = 0; j < SignerCount; j++)
+        {
+            if (j != i)
+                std::fill(expected.begin() + contentsRanges[j].first, expected.begin() + contentsRanges[j].second, ' ');
+        }
+
+        expected.erase(contentsRanges[i].first, contentsRanges[i].second - contentsRanges[i].first);
+        REQUIRE(signers[i].Data == expected);
+    }
+}
+
+// Test signing many documents with the same signer
+TEST_CASE("TestSignDocuments")
+{
+    charbuff cert;
+    charbuff pkey;
+    createTestKey(cert, pkey);
+
+    constexpr unsigned DocCount = 5;
+    vector<charbuff> buffers(DocCount);
+    vector<unique_ptr<PdfMemDocument>> docs;
+    vector<PdfSigningBatchItem> items;
+    for (unsigned i = 0; i < DocCount; i++)
+    {
+        createSignableDocument(buffers[i]);
+        auto device = std::make_shared<BufferStreamDevice>(buffers[i]);
+        docs.push_back(std::make_unique<PdfMemDocument>(device));
+
+        PdfSigningBatchItem item;
+        item.Document = docs.back().get();
+        item.Device = device;
+        item.Signature = &getSignatureField(*docs.back());
+        items.push_back(item);
+    }
+
+    {
+        PdfSignerCms signer(cert, pkey);
+        PoDoFo::SignDocuments(items, signer, PdfSaveOptions::NoMetadataUpdate);
+    }
+
+    for (auto& buff : buffers)
+        verifySignature(buff);
+
+    // The signer can still be used with a signing service
+    for (unsigned i = 0; i < DocCount; i++)
+    {
+        createSignableDocument(buffers[i]);
+        auto device = std::make_shared<BufferStreamDevice>(buffers[i]);
+        docs[i] = std::make_unique<PdfMemDocument>(device);
+        items[i].Document = docs[i].get();
+        items[i].Device = device;
+        items[i].Signature = &getSignatureField(*docs[i]);
+    }
+
+    unsigned serviceCalls = 0;
+    PdfSignerCmsParams params;
+    params.SigningService = [&](bufferview hashToSign, bool dryrun, charbuff& signedHash)
+    {
+        REQUIRE(!dryrun);
+        ssl::DoSign(hashToSign, pkey, params.Hashing, signedHash);
+        serviceCalls++;
+    };
+
+    {
+        PdfSignerCms signer(cert, params);
+        PoDoFo::SignDocuments(items, signer, PdfSaveOptions::NoMetadataUpdate);
+    }
+
+    REQUIRE(serviceCalls == DocCount);
+    for (auto& buff : buffers)
+        verifySignature(buff);
+}
+
+TEST_CASE("TestSignDocumentsBenchmark", "[.]")
+{
+    charbuff cert;
+    charbuff pkey;
+    createTestKey(cert, pkey);
+
+    constexpr unsigned DocCount = 200;
+    charbuff input;
+    createSignableDocument(input);
+
+    vector<charbuff> buffers(DocCount);
+    vector<unique_ptr<PdfMemDocument>> docs;
+    auto loadDocuments = [&]() {
+        docs.clear();
+        for (unsigned i = 0; i < DocCount; i++)
+        {
+            buffers[i] = input;
+            docs.push_back(std::make_unique<PdfMemDocument>(std::make_shared<BufferStreamDevice>(buffers[i])));
+        }
+    };
+
+    loadDocuments();
+    auto start = chrono::steady_clock::now();
+    for (unsigned i = 0; i < DocCount; i++)
+    {
+        PdfSignerCms signer(cert, pkey);
+        BufferStreamDevice device(buffers[i]);
+        PoDoFo::SignDocument(*docs[i], device, signer, getSignatureField(*docs[i]), PdfSaveOptions::NoMetadataUpdate);
+    }
+    auto singleTime = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+
+    loadDocuments();
+    vector<PdfSigningBatchItem> items;
+    for (unsigned i = 0; i < DocCount; i++)
+    {
+        PdfSigningBatchItem item;
+        item.Document = docs[i].get();
+        item.Device = std::make_shared<BufferStreamDevice>(buffers[i]);
+        item.Signature = &getSignatureField(*docs[i]);
+        items.push_back(item);
+    }
+
+    start = chrono::steady_clock::now();
+    {
+        PdfSignerCms signer(cert, pkey);
+        PoDoFo::SignDocuments(items, signer, PdfSaveOptions::NoMetadataUpdate);
+    }
+    auto batchTime = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+
+    for (auto& buff : buffers)
+        verifySignature(buff);
+
+    WARN("SignDocument() on " << DocCount << " documents: " << singleTime.count() << "ms");
+    WARN("SignDocuments() on " << DocCount << " documents: " << batchTime.count() << "ms");
+}
+
+void createSignableDocument(charbuff& buff, unsigned fieldCount, size_t dataSize)
+{
+    PdfMemDocument doc;
+    auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+    // Make the document big enough to be read in multiple blocks
+    auto& obj = doc.GetObjects().CreateDictionaryObject();
+    obj.GetOrCreateStream().SetData(string(dataSize, 'x'), true);
+    doc.GetCatalog().GetDictionary().AddKeyIndirect("TestData", obj);
+    for (unsigned i = 0; i < fieldCount; i++)
+        (void)page.CreateField<PdfSignature>(i == 0 ? "Signature" : "Signature" + std::to_string(i + 1), Rect());
+    buff.clear();
+    BufferStreamDevice device(buff);
+    doc.Save(device, PdfSaveOptions::NoFlateCompress);
+}
+
+PdfSignature& getSignatureField(PdfMemDocument& doc, unsigned index)
+{
+    auto& annot = doc.GetPages().GetPageAt(0).GetAnnotations().GetAnnotAt(index);
+    return dynamic_cast<PdfSignature&>(dynamic_cast<PdfAnnotationWidget&>(annot).GetField());
+}
+
+// Create a self signed certificate with a RSA 2048 bit key
+void createTestKey(charbuff& cert, charbuff& pkey)
+{
+    unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr), EVP_PKEY_CTX_free);
+    REQUIRE(ctx != nullptr);
+    REQUIRE(EVP_PKEY_keygen_init(ctx.get()) > 0);
+    REQUIRE(EVP_PKEY_CTX_set_rsa_keygen_bits(ctx.get(), 2048) > 0);
+    EVP_PKEY* key = nullptr;
+    REQUIRE(EVP_PKEY_keygen(ctx.get(), &key) > 0);
+    unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> keyPtr(key, EVP_PKEY_free);
+
+    unique_ptr<X509, decltype(&X509_free)> x509(X509_new(), X509_free);
+    REQUIRE(x509 != nullptr);
+    ASN1_INTEGER_set(X509_get_serialNumber(x509.get()), 1);
+    X509_gmtime_adj(X509_getm_notBefore(x509.get()), 0);
+    X509_gmtime_adj(X509_getm_notAfter(x509.get()), 60 * 60 * 24);
+    REQUIRE(X509_set_pubkey(x509.get(), key) == 1);
+    auto name = X509_get_subject_name(x509.get());
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"PoDoFo Test", -1, -1, 0);
+    REQUIRE(X509_set_issuer_name(x509.get(), name) == 1);
+    REQUIRE(X509_sign(x509.get(), key, EVP_sha256()) > 0);
+
+    cert = ssl::GetEncoded(x509.get());
+    pkey = ssl::GetEncoded(key);
+}
+
+// Verify the CMS signature against the signed /ByteRange
+void verifySignature(const charbuff& buff)
+{
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buff);
+    auto& annot = doc.GetPages().GetPageAt(0).GetAnnotations().GetAnnotAt(0);
+    auto& sigDict = annot.GetDictionary().MustFindKey("V").GetDictionary();
+    auto& byteRange = sigDict.MustFindKey("ByteRange").GetArray();
+    auto& contents = sigDict.MustFindKey("Contents").GetString().GetRawData();
+
+    charbuff signedData;
+    signedData.append(buff.data(), (size_t)byteRange[1].GetNumber());
+    signedData.append(buff.data() + byteRange[2].GetNumber(), (size_t)byteRange[3].GetNumber());
+
+    auto in = (const unsigned char*)contents.data();
+    unique_ptr<CMS_ContentInfo, decltype(&CMS_ContentInfo_free)> cms(
+        d2i_CMS_ContentInfo(nullptr, &in, (long)contents.size()), CMS_ContentInfo_free);
+    REQUIRE(cms != nullptr);
+    unique_ptr<BIO, decltype(&BIO_free)> data(BIO_new_mem_buf(signedData.data(), (int)signedData.size()), BIO_free);
+    REQUIRE(CMS_verify(cms.get(), nullptr, nullptr, data.get(), nullptr, CMS_BINARY | CMS_NO_SIGNER_CERT_VERIFY) == 1);
+}
@@ -11,6 +11,8 @@
 using namespace std;
 using namespace PoDoFo;
 
+static void createTextDocument(charbuff& buffer, unsigned pageCount);
+
 TEST_CASE("TextExtraction1")
 {
     PdfMemDocument doc;
@@ -45,3 +47,428 @@ TEST_CASE("TextExtraction2")
     ASSERT_EQUAL(entries[0].X, 31.199999999999999);
     ASSERT_EQUAL(entries[0].Y, 801.60000000000002);
 }
+
+TEST_CASE("TextExtractionParallel")
+{
+    charbuff buffer;
+    createTextDocument(buffer, 20);
+
+    vector<PdfTextEntry> expected;
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        auto& pages = doc.GetPages();
+        for (unsigned i = 0; i < pages.GetCount(); i++)
+            pages.GetPageAt(i).ExtractTextTo(expected);
+    }
+    REQUIRE(expected.size() == 60);
+
+    auto compare = [&](const vector<PdfTextEntry>& entries) {
+        REQUIRE(entries.size() == expected.size());
+        for (unsigned i = 0; i < entries.size(); i++)
+        {
+            REQUIRE(entries[i].Text == expected[i].Text);
+            REQUIRE(entries[i].Page == expected[i].Page);
+            REQUIRE(entries[i].X == expected[i].X);
+            REQUIRE(entries[i].Y == expected[i].Y);
+        }
+    };
+
+    // Extract on freshly loaded documents, so the objects
+    // are loaded concurrently by the worker threads
+    for (unsigned threadCount : { 1u, 4u, 0u })
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        vector<PdfTextEntry> entries;
+        doc.ExtractTextTo(entries, { }, { }, threadCount);
+        compare(entries);
+    }
+
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(buffer);
+        doc.SetXObjectFormCacheSize(1 << 20);
+        vector<PdfTextEntry> entries;
+        doc.ExtractTextTo(entries, { }, { }, 4);
+        compare(entries);
+    }
+}
+
+TEST_CASE("TextExtractionRuns")
+{
+    charbuff buffer;
+    createTextDocument(buffer, 2);
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto& page = doc.GetPages().GetPageAt(1);
+
+    PdfTextExtractParams params = { };
+    params.Flags = PdfTextExtractFlags::ComputeBoundingBox;
+    vector<PdfTextEntry> expected;
+    page.ExtractTextTo(expected, params);
+    REQUIRE(expected.size() == 3);
+
+    unsigned count = 0;
+    page.ExtractTextTo([&](const PdfTextRun& run) {
+        auto& entry = expected[count];
+        REQUIRE(run.Text == entry.Text);
+        REQUIRE(run.Page == 1);
+        REQUIRE(run.X == entry.X);
+        REQUIRE(run.Y == entry.Y);
+        REQUIRE(run.Length == entry.Length);
+        REQUIRE(run.BoundingBox.has_value());
+        REQUIRE(run.BoundingBox->Width == entry.BoundingBox->Width);
+        REQUIRE(run.FontSize == (count == 0 ? 10 : 12));
+
+        // The text is ASCII, so there's an advance per character
+        REQUIRE(run.GlyphAdvances.size() == run.Text.size());
+        double length = 0;
+        for (double advance : run.GlyphAdvances)
+        {
+            REQUIRE(advance > 0);
+            length += advance;
+        }
+        ASSERT_EQUAL(length, run.Length);
+        count++;
+    }, params);
+    REQUIRE(count == expected.size());
+
+    // Runs matching a pattern
+    vector<string> texts;
+    page.ExtractTextTo([&](const PdfTextRun& run) {
+        texts.push_back((string)run.Text);
+    }, "second");
+    REQUIRE(texts == vector<string>{ "Page 2 second line" });
+}
+
+TEST_CASE("TextMatcher")
+{
+    vector<pair<unsigned, size_t>> matches;
+    auto handler = [&](unsigned keyword, size_t offset) {
+        matches.push_back({ keyword, offset });
+    };
+
+    PdfTextMatcher matcher(vector<string_view>{ "he", "she", "his", "hers" });
+    matcher.Search("ushers", handler);
+    REQUIRE(matches == vector<pair<unsigned, size_t>>{ { 1, 1 }, { 0, 2 }, { 3, 2 } });
+
+    matches.clear();
+    PdfTextMatcher ignoreCase(vector<string_view>{ "Hello", "wörld" }, PdfTextExtractFlags::IgnoreCase);
+    ignoreCase.Search("hELLO WöRLD, HelloWörld", handler);
+    REQUIRE(matches == vector<pair<unsigned, size_t>>{ { 0, 0 }, { 1, 6 }, { 0, 14 }, { 1, 19 } });
+
+    matches.clear();
+    PdfTextMatcher wholeWord(vector<string_view>{ "cat", "cats" }, PdfTextExtractFlags::MatchWholeWord);
+    wholeWord.Search("cat, concatenate cats", handler);
+    REQUIRE(matches == vector<pair<unsigned, size_t>>{ { 0, 0 }, { 1, 17 } });
+
+    ASSERT_THROW_WITH_ERROR_CODE(PdfTextMatcher(vector<string_view>{ }), PdfErrorCode::ValueOutOfRange);
+    ASSERT_THROW_WITH_ERROR_CODE(PdfTextMatcher(vector<string_view>{ "a", "" }), PdfErrorCode::ValueOutOfRange);
+}
+
+TEST_CASE("TextExtractionKeywords")
+{
+    charbuff buffer;
+    createTextDocument(buffer, 20);
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+
+    PdfTextMatcher matcher(vector<string_view>{ "first", "SECOND LINE", "letterhead", "missing" },
+        PdfTextExtractFlags::IgnoreCase);
+    vector<PdfTextMatch> matches;
+    doc.SearchTextTo(matches, matcher, { }, 4);
+    REQUIRE(matches.size() == 60);
+
+    // Compare with the extraction of the single keywords
+    unsigned count = 0;
+    PdfTextExtractParams params = { };
+    params.Flags = PdfTextExtractFlags::ExtractSubstring | PdfTextExtractFlags::IgnoreCase;
+    for (unsigned i = 0; i < doc.GetPages().GetCount(); i++)
+    {
+        auto& page = doc.GetPages().GetPageAt(i);
+        vector<PdfTextEntry> entries;
+        for (unsigned j = 0; j < matcher.GetKeywordCount(); j++)
+            page.ExtractTextTo(entries, matcher.GetKeyword(j), params);
+
+        REQUIRE(entries.size() == 3);
+        for (auto& entry : entries)
+        {
+            auto found = std::find_if(matches.begin(), matches.end(), [&](const PdfTextMatch& match) {
+                return match.Page == (int)i && match.Text == entry.Text;
+            });
+            REQUIRE(found != matches.end());
+            REQUIRE(found->X == entry.X);
+            REQUIRE(found->Y == entry.Y);
+            REQUIRE(found->Length == entry.Length);
+            count++;
+        }
+    }
+    REQUIRE(count == 60);
+
+    REQUIRE(matches[0].Keyword == 2);
+    REQUIRE(matches[0].Text == "Letterhead");
+    REQUIRE(matches[2].Keyword == 1);
+    REQUIRE(matches[2].Text == "second line");
+
+    PdfTextExtractParams invalid = { };
+    invalid.Flags = PdfTextExtractFlags::IgnoreCase;
+    ASSERT_THROW_WITH_ERROR_CODE(doc.SearchTextTo(matches, matcher, invalid), PdfErrorCode::NotImplemented);
+}
+
+TEST_CASE("TextExtractionGlyphCache")
+{
+    string_view text = "Caff\xC3\xA8 latte caff\xC3\xA8";
+    charbuff buffer;
+    PdfName fontName;
+    {
+        PdfMemDocument doc;
+        auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        auto font = doc.GetFonts().SearchFont("LiberationSans");
+        if (font == nullptr)
+            FAIL("Could not find Arial font");
+
+        fontName = font->GetIdentifier();
+        PdfPainter painter;
+        painter.SetCanvas(page);
+        painter.TextState.SetFont(*font, 12);
+        painter.DrawText(text, 100, 500);
+        painter.FinishDrawing();
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    // The subset font has 1 byte codes. The second
+    // extraction decodes the glyphs from the cache
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto& page = doc.GetPages().GetPageAt(0);
+    vector<PdfTextEntry> entries;
+    page.ExtractTextTo(entries);
+    vector<PdfTextEntry> cachedEntries;
+    page.ExtractTextTo(cachedEntries);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(cachedEntries.size() == 1);
+    REQUIRE(entries[0].Text == text);
+    REQUIRE(cachedEntries[0].Text == text);
+    REQUIRE(cachedEntries[0].Length == entries[0].Length);
+
+    PdfTextState state;
+    state.FontSize = 10;
+    string utf8str;
+    vector<double> lengths;
+    vector<unsigned> positions;
+    auto font = page.GetResources()->GetFont(fontName.GetString());
+    REQUIRE(font != nullptr);
+    auto encoded = font->GetEncoding().ConvertToEncoded(text);
+    REQUIRE(encoded.size() == 17);
+    REQUIRE(font->TryScanEncodedString(PdfString::FromRaw(encoded), state, utf8str, lengths, positions));
+    REQUIRE(utf8str == text);
+    REQUIRE(lengths.size() == 17);
+    REQUIRE(positions[5] == 6);
+    ASSERT_EQUAL(lengths[1], font->GetCharLength(U'a', state));
+
+    // Convert the font to 2 bytes codes, with Identity-H
+    // encoding, and draw the same text with it
+    string toUnicode = "/CIDInit /ProcSet findresource begin\n12 dict begin\nbegincmap\n"
+        "/CMapName /Test-UCS def\n/CMapType 2 def\n"
+        "1 begincodespacerange\n<0000> <FFFF>\nendcodespacerange\n";
+    string codes;
+    string mappings;
+    set<unsigned> mapped;
+    for (unsigned i = 0; i < encoded.size(); i++)
+    {
+        unsigned code = (unsigned char)encoded[i];
+        codes.append(utls::Format("{:04X}", code));
+        if (!mapped.insert(code).second)
+            continue;
+
+        mappings.append(utls::Format("<{:04X}> <{:04X}>\n", code,
+            (unsigned)font->GetEncoding().GetCodePoint(PdfCharCode(code, 1))));
+    }
+    toUnicode.append(utls::Format("{} beginbfchar\n", mapped.size()));
+    toUnicode.append(mappings);
+    toUnicode.append("endbfchar\nendcmap\nCMapName currentdict /CMap defineresource pop\nend\nend\n");
+
+    auto& fontObj = page.MustGetResources().GetDictionary().MustFindKey("Font")
+        .GetDictionary().MustFindKey(fontName.GetString());
+    fontObj.GetDictionary().AddKey("Encoding", PdfName("Identity-H"));
+    auto& toUnicodeObj = doc.GetObjects().CreateDictionaryObject();
+    toUnicodeObj.GetOrCreateStream().SetData(toUnicode);
+    fontObj.GetDictionary().AddKeyIndirect("ToUnicode", toUnicodeObj);
+    auto& contents = doc.GetObjects().CreateDictionaryObject();
+    contents.GetOrCreateStream().SetData(utls::Format("BT\n/{} 12 Tf\n100 500 Td\n<{}> Tj\nET\n",
+        fontName.GetString(), codes));
+    page.GetDictionary().AddKeyIndirect("Contents", contents);
+    buffer.clear();
+    {
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument cidDoc;
+    cidDoc.LoadFromBuffer(buffer);
+    auto& cidPage = cidDoc.GetPages().GetPageAt(0);
+    for (unsigned i = 0; i < 2; i++)
+    {
+        vector<PdfTextEntry> cidEntries;
+        cidPage.ExtractTextTo(cidEntries);
+        REQUIRE(cidEntries.size() == 1);
+        REQUIRE(cidEntries[0].Text == text);
+        ASSERT_EQUAL(cidEntries[0].Length, entries[0].Length);
+    }
+
+    // A truncated trailing code is scanned as well
+    auto cidFont = cidPage.GetResources()->GetFont(fontName.GetString());
+    REQUIRE(cidFont != nullptr);
+    string raw = PdfString::FromHexData(codes).GetRawData();
+    REQUIRE(raw.size() == 34);
+    REQUIRE(cidFont->TryScanEncodedString(PdfString::FromRaw(raw), state, utf8str, lengths, positions));
+    REQUIRE(utf8str == text);
+    REQUIRE(lengths.size() == 17);
+    ASSERT_EQUAL(lengths[1], font->GetCharLength(U'a', state));
+    REQUIRE(!cidFont->TryScanEncodedString(PdfString::FromRaw(string_view(raw).substr(0, 5)),
+        state, utf8str, lengths, positions));
+    REQUIRE(utf8str.substr(0, 2) == "Ca");
+    REQUIRE(lengths.size() == 3);
+}
+
+TEST_CASE("TextIndex")
+{
+    charbuff buffer;
+    createTextDocument(buffer, 20);
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+
+    PdfTextIndex index;
+    index.AddPages(doc, 4);
+    REQUIRE(index.GetPageCount() == 20);
+    // "letterhead", "page", "first", "second", "line" and the page numbers
+    REQUIRE(index.GetTermCount() == 25);
+
+    vector<PdfTextIndexHit> hits;
+    index.Search(hits, "first line");
+    REQUIRE(hits.size() == 20);
+    for (unsigned i = 0; i < hits.size(); i++)
+    {
+        REQUIRE(hits[i].Page == i);
+        REQUIRE(hits[i].Rects.size() == 2);
+        REQUIRE(hits[i].Rects[0].X < hits[i].Rects[1].X);
+        ASSERT_EQUAL(hits[i].Rects[0].Y, hits[i].Rects[1].Y);
+    }
+
+    hits.clear();
+    index.Search(hits, "  PAGE 3\tsecond ");
+    REQUIRE(hits.size() == 1);
+    REQUIRE(hits[0].Page == 2);
+    REQUIRE(hits[0].Rects.size() == 3);
+
+    hits.clear();
+    index.Search(hits, "\"Letterhead\",");
+    REQUIRE(hits.size() == 20);
+
+    hits.clear();
+    index.Search(hits, "second first");
+    REQUIRE(hits.size() == 0);
+    index.Search(hits, "missing");
+    REQUIRE(hits.size() == 0);
+
+    // Build the same index incrementally, in reverse page order
+    PdfTextIndex incremental;
+    auto& pages = doc.GetPages();
+    for (unsigned i = pages.GetCount(); i > 0; i--)
+        incremental.AddPage(pages.GetPageAt(i - 1));
+    incremental.AddPage(pages.GetPageAt(5));
+
+    // Save and load the index back
+    charbuff saved;
+    {
+        BufferStreamDevice device(saved);
+        index.Save(device);
+    }
+    PdfTextIndex loaded;
+    loaded.LoadFromBuffer(saved);
+    REQUIRE(loaded.GetPageCount() == 20);
+    REQUIRE(loaded.GetTermCount() == 25);
+
+    for (auto phrase : { "first line", "page 12 second line", "letterhead page" })
+    {
+        vector<PdfTextIndexHit> expected;
+        index.Search(expected, phrase);
+        REQUIRE(expected.size() != 0);
+
+        vector<PdfTextIndexHit> incrementalHits;
+        incremental.Search(incrementalHits, phrase);
+        vector<PdfTextIndexHit> loadedHits;
+        loaded.Search(loadedHits, phrase);
+        REQUIRE(incrementalHits.size() == expected.size());
+        REQUIRE(loadedHits.size() == expected.size());
+        for (unsigned i = 0; i < expected.size(); i++)
+        {
+            REQUIRE(incrementalHits[i].Page == expected[i].Page);
+            REQUIRE(loadedHits[i].Page == expected[i].Page);
+            REQUIRE(loadedHits[i].Rects.size() == expected[i].Rects.size());
+            for (unsigned j = 0; j < expected[i].Rects.size(); j++)
+            {
+                REQUIRE(incrementalHits[i].Rects[j].X == expected[i].Rects[j].X);
+                REQUIRE(std::abs(loadedHits[i].Rects[j].X - expected[i].Rects[j].X) < 0.001);
+                REQUIRE(std::abs(loadedHits[i].Rects[j].Width - expected[i].Rects[j].Width) < 0.001);
+            }
+        }
+    }
+
+    loaded.RemovePage(0);
+    REQUIRE(loaded.GetPageCount() == 19);
+    REQUIRE(loaded.GetTermCount() == 24);
+    hits.clear();
+    loaded.Search(hits, "first line");
+    REQUIRE(hits.size() == 19);
+    REQUIRE(hits[0].Page == 1);
+
+    ASSERT_THROW_WITH_ERROR_CODE(loaded.LoadFromBuffer(bufferview("PDFTXIDX", 8)), PdfErrorCode::UnexpectedEOF);
+    ASSERT_THROW_WITH_ERROR_CODE(loaded.LoadFromBuffer(bufferview("NOTANIDX\0\0\0\1", 12)), PdfErrorCode::InvalidDataType);
+    // A term length bigger than the remaining data
+    ASSERT_THROW_WITH_ERROR_CODE(loaded.LoadFromBuffer(bufferview("PDFTXIDX\0\0\0\1\0\0\0\1\xFF\xFF\xFF\xFFterm", 24)),
+        PdfErrorCode::InvalidDataType);
+
+    // Moved indices keep the terms valid
+    PdfTextIndex moved(std::move(index));
+    hits.clear();
+    moved.Search(hits, "first line");
+    REQUIRE(hits.size() == 20);
+    index = std::move(moved);
+    hits.clear();
+    index.Search(hits, "letterhead");
+    REQUIRE(hits.size() == 20);
+}
+
+void createTextDocument(charbuff& buffer, unsigned pageCount)
+{
+    PdfMemDocument doc;
+    auto font = doc.GetFonts().SearchFont("LiberationSans");
+    if (font == nullptr)
+        FAIL("Could not find Arial font");
+
+    // A form with text shared by all the pages
+    auto xobj = doc.CreateXObjectForm(Rect(0, 0, 200, 50));
+    PdfPainter painter;
+    painter.SetCanvas(*xobj);
+    painter.TextState.SetFont(*font, 10);
+    painter.DrawText("Letterhead", 10, 10);
+    painter.FinishDrawing();
+
+    for (unsigned i = 0; i < pageCount; i++)
+    {
+        auto& page = doc.GetPages().CreatePage(PdfPage::CreateStandardPageSize(PdfPageSize::A4));
+        painter.SetCanvas(page);
+        painter.DrawXObject(*xobj, 50, 700);
+        painter.TextState.SetFont(*font, 12);
+        painter.DrawText(utls::Format("Page {} first line", i + 1), 100, 500);
+        painter.DrawText(utls::Format("Page {} second line", i + 1), 100, 400);
+        painter.FinishDrawing();
+    }
+
+    BufferStreamDevice device(buffer);
+    doc.Save(device);
+}
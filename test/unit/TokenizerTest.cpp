@@ -181,6 +181,34 @@ TEST_CASE("testLocale")
     setlocale(LC_ALL, old);
 }
 
+TEST_CASE("testOperators")
+{
+    for (unsigned i = 1; i <= (unsigned)PdfOperator::EX; i++)
+    {
+        auto op = (PdfOperator)i;
+        auto name = GetPdfOperatorName(op);
+        REQUIRE(name.length() != 0);
+        REQUIRE(GetPdfOperator(name) == op);
+        int count;
+        REQUIRE(TryGetOperandCount(op, count));
+    }
+
+    REQUIRE(GetPdfOperator("\"") == PdfOperator::DoubleQuote);
+    REQUIRE(GetPdfOperator("scn") == PdfOperator::scn);
+    REQUIRE(GetOperandCount(PdfOperator::cm) == 6);
+    REQUIRE(GetOperandCount(PdfOperator::SCN) == -1);
+
+    PdfOperator op;
+    REQUIRE(!TryGetPdfOperator("", op));
+    REQUIRE(!TryGetPdfOperator("x", op));
+    REQUIRE(!TryGetPdfOperator("BTX", op));
+    REQUIRE(!TryGetPdfOperator("scnx", op));
+    REQUIRE(!TryGetPdfOperator(string_view("s\0", 2), op));
+    REQUIRE(op == PdfOperator::Unknown);
+    int count;
+    REQUIRE(!TryGetOperandCount(PdfOperator::Unknown, count));
+}
+
 void Test(const string_view& buffer, PdfDataType dataType, string_view expected)
 {
     expected = expected.empty() ? buffer : expected;
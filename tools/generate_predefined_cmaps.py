@@ -0,0 +1,301 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: (C) 2024 Francesco Pretto <ceztko@gmail.com>
+# SPDX-License-Identifier: LGPL-2.0-or-later
+# SPDX-License-Identifier: MPL-2.0
+#
+# Generate src/podofo/private/PdfPredefinedCMapFiles.cpp from the
+# Adobe CMap resources, as converted to JSON by pdfminer.six
+#
+# Usage: generate_predefined_cmaps.py <pdfminer/cmap directory> <output file>
+#
+# The CMaps are found in the "pdfminer/cmap" directory of a pdfminer.six
+# installation or source tree, see https://github.com/pdfminer/pdfminer.six
+
+import json, gzip, os, re, zlib, sys
+
+SRC = None
+
+def flat(d, prefix=()):
+    # Flatten the nested code bytes dictionaries
+    for k, v in d.items():
+        if isinstance(v, dict):
+            yield from flat(v, prefix + (int(k),))
+        else:
+            yield prefix + (int(k),), v
+
+def varint(n, out):
+    assert n >= 0
+    while True:
+        b = n & 0x7F
+        n >>= 7
+        if n:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return
+
+def zz(n):
+    # Zigzag encoding of signed deltas
+    return (n << 1) if n >= 0 else ((-n) << 1) - 1
+
+def ordering_of(name):
+    if re.match(r'^(UniJIS|78|83pv|90|Add|EUC|Ext|H$|V$|Hankaku|Hiragana|Katakana|NWP|RKSJ|Roman|WP-Symbol)', name):
+        return 'Japan1'
+    if re.match(r'^(UniCNS|B5|CNS|ETHK|ETen|HK)', name):
+        return 'CNS1'
+    if re.match(r'^(UniGB|GB)', name):
+        return 'GB1'
+    if re.match(r'^(UniKS|KSC)', name):
+        return 'Korea1'
+    raise Exception(name)
+
+FORMS = ['UTF8', 'UTF16', 'UTF32', 'UCS2']
+
+def form_of(name):
+    if not name.startswith('Uni'):
+        return 'Raw'
+    for f in FORMS:
+        if '-' + f + '-' in name:
+            return f
+    raise Exception(name)
+
+def load(name):
+    d = json.load(gzip.open(f'{SRC}/{name}.json.gz'))
+    form = form_of(name)
+    m = {}
+    for k, v in flat(d['CODE2CID']):
+        k = bytes(k)
+        if form == 'Raw':
+            m[(len(k), int.from_bytes(k, 'big'))] = v
+        else:
+            if form == 'UTF32':
+                cp = int.from_bytes(k, 'big')
+            elif form == 'UTF8':
+                s = k.decode('utf-8')
+                assert len(s) == 1
+                cp = ord(s)
+            else:
+                s = k.decode('utf-16-be')
+                assert len(s) == 1
+                cp = ord(s)
+            assert (0, cp) not in m
+            m[(0, cp)] = v
+    return m, bool(d['IS_VERTICAL'])
+
+def load_tounicode(ordering):
+    d = json.load(gzip.open(f'{SRC}/to-unicode-Adobe-{ordering}.json.gz'))
+    m = {}
+    for k, v in d['CID2UNICHR_H'].items():
+        assert len(v) == 1
+        m[(2, int(k))] = ord(v)
+    return m
+
+def encode_ranges(items, out, values):
+    ranges = []
+    for k, v in items:
+        if ranges and k == ranges[-1][0] + ranges[-1][2] and (not values or v == ranges[-1][1] + ranges[-1][2]):
+            ranges[-1][2] += 1
+        else:
+            ranges.append([k, v, 1])
+    varint(len(ranges), out)
+    pc = -1
+    pv = 0
+    for c, v, n in ranges:
+        varint(c - pc - 1, out)
+        varint(n - 1, out)
+        if values:
+            varint(zz(v - pv), out)
+            pv = v + n - 1
+        pc = c + n - 1
+
+def encode(mappings, removals):
+    lens = sorted(set(k[0] for k in mappings) | set(k[0] for k in removals))
+    out = bytearray()
+    varint(len(lens), out)
+    for l in lens:
+        out.append(l)
+        encode_ranges(sorted((k[1], v) for k, v in mappings.items() if k[0] == l), out, True)
+        encode_ranges(sorted((k[1], 0) for k in removals if k[0] == l), out, False)
+    return bytes(out)
+
+def compress(data):
+    if len(data) == 0:
+        return b''
+    return zlib.compress(data, 9)
+
+def diff(base, derived):
+    mappings = {k: v for k, v in derived.items() if base.get(k) != v}
+    removals = [k for k in base if k not in derived]
+    return mappings, removals
+
+def candidates(name, names):
+    ret = []
+    if name.endswith('-V'):
+        ret.append(name[:-1] + 'H')
+    form = form_of(name)
+    if form not in ('Raw', 'UTF32'):
+        ret.append(name.replace('-' + form + '-', '-UTF32-').replace('-HW-', '-'))
+    if '-HW-' in name:
+        ret.append(name.replace('-HW-', '-'))
+    return [c for c in ret if c in names]
+
+def main(outpath):
+    names = sorted(f[:-8] for f in os.listdir(SRC) if f.endswith('.json.gz') and not f.startswith('to-unicode'))
+    maps = {}
+    entries = {}
+    for n in names:
+        m, vertical = load(n)
+        if n.startswith('Uni') and '-HW-' in n:
+            # The half width CMaps contain only the differences from the
+            # proportional ones, that they use with "usecmap"
+            full = dict(load(n.replace('-HW-', '-'))[0])
+            full.update(m)
+            m = full
+        maps[n] = m
+        entries[n] = dict(Ordering=ordering_of(n), Form=form_of(n), Vertical=vertical)
+    for o in ['CNS1', 'GB1', 'Japan1', 'Korea1']:
+        n = f'Adobe-{o}-UCS2'
+        m = load_tounicode(o)
+        # The pdfminer.six tables lack the code points outside the BMP:
+        # complete them with the inverse of the UTF-32 horizontal CMaps
+        for u in sorted(k for k in maps if k.startswith('Uni') and k.endswith('-UTF32-H') and ordering_of(k) == o):
+            for (l, cp), cid in sorted(maps[u].items()):
+                m.setdefault((2, cid), cp)
+        maps[n] = m
+        entries[n] = dict(Ordering=o, Form='Raw', Vertical=False)
+    allnames = sorted(entries)
+    for n in allnames:
+        best = (compress(encode(maps[n], [])), None)
+        for c in candidates(n, allnames):
+            data = compress(encode(*diff(maps[c], maps[n])))
+            if len(data) < len(best[0]):
+                best = (data, c)
+        entries[n]['Data'], entries[n]['Base'] = best
+    total = sum(len(e['Data']) for e in entries.values())
+    print(len(allnames), total, file=sys.stderr)
+    write(outpath, allnames, entries)
+
+def cname(n):
+    return 'CMap_' + re.sub(r'[^A-Za-z0-9]', '_', n)
+
+def write(outpath, names, entries):
+    with open(outpath, 'w', newline='\n') as f:
+        f.write(HEADER)
+        for n in names:
+            data = entries[n]['Data']
+            if len(data) == 0:
+                continue
+            f.write(f'static const unsigned char {cname(n)}[] = {{\n')
+            for i in range(0, len(data), 16):
+                f.write(', '.join(f'0x{b:02X}' for b in data[i:i + 16]))
+                f.write(',\n' if i + 16 < len(data) else '\n')
+            f.write('};\n\n')
+        f.write('// NOTE: Sorted by name\n')
+        f.write('static const PredefinedCMapInfo s_predefinedCMaps[] = {\n')
+        for n in names:
+            e = entries[n]
+            base = names.index(e['Base']) if e['Base'] is not None else -1
+            data = f'{cname(n)}, sizeof({cname(n)})' if len(e['Data']) != 0 else 'nullptr, 0'
+            vertical = 'true' if e['Vertical'] else 'false'
+            f.write(f'    {{ "{n}", "{e["Ordering"]}", {base}, PredefinedCMapForm::{e["Form"]}, {vertical}, {data} }},\n')
+        f.write('};\n\n')
+        f.write(FOOTER)
+
+HEADER = '''#include "PdfDeclarationsPrivate.h"
+#include "PdfPredefinedCMapData.h"
+
+/*
+ * The mappings in this source were generated from the Adobe CMap
+ * resources[1], as converted to JSON by pdfminer.six[2], with the
+ * tools/generate_predefined_cmaps.py script. Every CMap is stored
+ * as deflated ranges of codes, see DecodePredefinedCMap(). CMaps
+ * sharing most of the mappings with another one, such as vertical
+ * variants and the UTF-8/UTF-16/UCS-2 variants of the Unicode CMaps,
+ * store only the differences. The "Adobe-<Ordering>-UCS2" CMaps,
+ * mapping CIDs to unicode, are completed with the code points outside
+ * the BMP found in the UTF-32 CMaps of the same character collection
+ *
+ * Original copyright notice of the Adobe CMap resources:
+ * ------------------------------------
+ * Copyright 1990-2019 Adobe. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * Redistributions of source code must retain the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ *
+ * Neither the name of Adobe nor the names of its contributors
+ * may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ------------------------------------
+ *
+ * Original copyright notice of pdfminer.six:
+ * ------------------------------------
+ * Copyright (c) 2004-2016  Yusuke Shinyama <yusuke at shinyama dot jp>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+ * KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * ------------------------------------
+ *
+ * [1] https://github.com/adobe-type-tools/cmap-resources
+ * [2] https://github.com/pdfminer/pdfminer.six
+ */
+
+using namespace std;
+using namespace PoDoFo;
+
+'''
+
+FOOTER = '''cspan<PredefinedCMapInfo> PoDoFo::GetPredefinedCMaps()
+{
+    return cspan<PredefinedCMapInfo>(s_predefinedCMaps, std::size(s_predefinedCMaps));
+}
+'''
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        print(f'Usage: {sys.argv[0]} <pdfminer/cmap directory> <output file>', file=sys.stderr)
+        sys.exit(1)
+    SRC = sys.argv[1]
+    main(sys.argv[2])
@@ -31,15 +31,10 @@ void Main(const cspan<string_view>& args)
 
     PdfMemDocument doc;
     doc.Load(input);
-    auto& pages = doc.GetPages();
-    for (unsigned i = 0; i < pages.GetCount(); i++)
-    {
-        auto& page = pages.GetPageAt(i);
-
-        vector<PdfTextEntry> entries;
-        page.ExtractTextTo(entries);
 
-        for (auto& entry : entries)
-            printf("(%.3f,%.3f) %s \n", entry.X, entry.Y, entry.Text.data());
-    }
+    // Extract the pages concurrently, entries are in page order
+    vector<PdfTextEntry> entries;
+    doc.ExtractTextTo(entries);
+    for (auto& entry : entries)
+        printf("(%.3f,%.3f) %s \n", entry.X, entry.Y, entry.Text.data());
 }